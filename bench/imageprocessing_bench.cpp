@@ -0,0 +1,1132 @@
+// imageprocessing_bench: Timings for the ImageProcessing kernels and the capture pipeline, as JSON.
+//
+//   imageprocessing_bench                         kernel timings at 640x480 .. 3840x2160
+//   imageprocessing_bench --pipeline --seconds 10 videotestsrc -> appsink -> effects, fps and latency
+//   imageprocessing_bench --pipeline --record DIR same, while recording the processed stream
+//   imageprocessing_bench --pipeline --burst 30   same, with a burst of full-resolution stills after a second
+//   imageprocessing_bench --pipeline --streams 4  four cameras sharing the thread pool, fps per stream
+//   imageprocessing_bench --pipeline --roi 0.25,0.25,0.5,0.5  same, cropped to a region in the pipeline
+//   imageprocessing_bench --pipeline --capture F  same, writing the frames the effects see to a raw capture file
+//   imageprocessing_bench --pipeline --replay F   those frames again, looped, in place of videotestsrc
+//   imageprocessing_bench --startup 10            time to first frame: cold, rebuilt and prepared starts
+//
+// Results go to stdout, or to --output, so runs from two builds can be diffed.
+
+#include "imageprocessing.h"
+#include "imagekernels.h"
+#include "effectchain.h"
+#include "frameprocessor.h"
+#include "framebufferpool.h"
+#include "gstreamerhandler.h"
+#include "recorder.h"
+#include "separablefilter.h"
+#include "snapshotencoder.h"
+#include "camerastream.h"
+#include "threadpool.h"
+#include "yuvconverter.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSize>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+// Allocation counting: every operator new in the process goes through here. QImage allocates its
+// shared data with new, so each image a kernel creates shows up as one allocation; pooled pixel
+// buffers show up as a second one only when the pool misses.
+namespace {
+std::atomic<quint64> allocationCount{ 0 };
+}
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+// Aligned forms: over-allocate and keep the malloc pointer just below the aligned block.
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    const auto align = static_cast<std::size_t>(alignment);
+    void* raw = std::malloc(size + align + sizeof(void*));
+    if (!raw) {
+        throw std::bad_alloc();
+    }
+    const auto address = (reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*) + align - 1) & ~(align - 1);
+    reinterpret_cast<void**>(address)[-1] = raw;
+    return reinterpret_cast<void*>(address);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    if (p) {
+        std::free(static_cast<void**>(p)[-1]);
+    }
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept {
+    operator delete(p, alignment);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    QList<QSize> sizes;
+    QList<int> radii;
+    int minTimeMs = 300; // Per case; at least minIterations runs regardless.
+    int minIterations = 5;
+};
+
+// Timing: Best and mean wall time of one call, and the allocations it made.
+struct Timing {
+    int iterations = 0;
+    double bestNs = 0;
+    double meanNs = 0;
+    double allocationsPerCall = 0;
+};
+
+// measure: Runs the call once to warm up, then repeatedly until both the time and iteration budgets are spent.
+Timing measure(const Options& options, const std::function<void()>& call) {
+    call();
+    Timing timing;
+    double totalNs = 0;
+    const quint64 allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+    const auto deadline = Clock::now() + std::chrono::milliseconds(options.minTimeMs);
+    while (timing.iterations < options.minIterations || Clock::now() < deadline) {
+        const auto start = Clock::now();
+        call();
+        const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        timing.bestNs = timing.iterations == 0 ? ns : std::min(timing.bestNs, ns);
+        totalNs += ns;
+        ++timing.iterations;
+    }
+    timing.meanNs = totalNs / timing.iterations;
+    timing.allocationsPerCall = double(allocationCount.load(std::memory_order_relaxed) - allocationsBefore) / timing.iterations;
+    return timing;
+}
+
+// makeTestImage: Deterministic noise, so runs are comparable and nothing compresses to a constant.
+QImage makeTestImage(int width, int height) {
+    QImage image(width, height, QImage::Format_RGB888);
+    quint32 state = 0x12345678u + width * 31 + height;
+    for (int y = 0; y < height; ++y) {
+        uchar* row = image.scanLine(y);
+        for (int i = 0; i < width * 3; ++i) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            row[i] = static_cast<uchar>(state >> 24);
+        }
+    }
+    return image;
+}
+
+// result: One JSON row; MB/s counts the RGB888 input frame (1 MB = 10^6 bytes).
+QJsonObject result(const QString& op, const QSize& size, const Timing& timing) {
+    const double pixels = double(size.width()) * size.height();
+    return QJsonObject{
+        { "op", op },
+        { "width", size.width() },
+        { "height", size.height() },
+        { "iterations", timing.iterations },
+        { "best_ms", timing.bestNs / 1e6 },
+        { "mean_ms", timing.meanNs / 1e6 },
+        { "ns_per_pixel", timing.bestNs / pixels },
+        { "mean_ns_per_pixel", timing.meanNs / pixels },
+        { "mb_per_s", pixels * 3 / (timing.bestNs / 1e9) / 1e6 },
+        { "allocations_per_call", timing.allocationsPerCall },
+    };
+}
+
+// packedFormats: The packed layouts the kernels specialize on, with the names the rows report.
+const std::pair<const char*, QImage::Format> packedFormats[] = {
+    { "rgb888", QImage::Format_RGB888 },
+    { "rgb32", QImage::Format_RGB32 },
+    { "rgbx8888", QImage::Format_RGBX8888 },
+    { "gray8", QImage::Format_Grayscale8 },
+};
+
+// parseRgbFormat: "rgb32" -> Format_RGB32; unknown names give Format_Invalid.
+QImage::Format parseRgbFormat(const QString& name) {
+    for (const auto& entry : packedFormats) {
+        if (name == QLatin1String(entry.first)) {
+            return entry.second;
+        }
+    }
+    return QImage::Format_Invalid;
+}
+
+QString rgbFormatName(QImage::Format format) {
+    for (const auto& entry : packedFormats) {
+        if (entry.second == format) {
+            return entry.first;
+        }
+    }
+    return "unknown";
+}
+
+// availableTables: Every kernel table the build and the CPU support, scalar first.
+std::vector<const ImageKernels::KernelTable*> availableTables() {
+    std::vector<const ImageKernels::KernelTable*> tables;
+    for (auto isa : { ImageKernels::Isa::Scalar, ImageKernels::Isa::SSE2, ImageKernels::Isa::SSSE3, ImageKernels::Isa::AVX2 }) {
+        if (const auto* table = ImageKernels::forIsa(isa)) {
+            tables.push_back(table);
+        }
+    }
+    return tables;
+}
+
+// benchmarkEffects: The public QImage entry points and the compiled chain, at every size.
+QJsonArray benchmarkEffects(const Options& options) {
+    QJsonArray rows;
+    for (const QSize& size : options.sizes) {
+        const QImage input = makeTestImage(size.width(), size.height());
+
+        rows.append(result("grayscale", size, measure(options, [&] { ImageProcessing::applyGrayscale(input); })));
+        rows.append(result("brightness", size, measure(options, [&] { ImageProcessing::adjustBrightness(input, 40); })));
+        // Cost against radius for every blur quality; all but the exact kernel should stay flat as the
+        // radius grows, and the kernel hands over to the box Gaussian past maxKernelBlurRadius.
+        const std::pair<const char*, ImageProcessing::BlurQuality> qualities[] = {
+            { "box_blur", ImageProcessing::BlurQuality::Box },
+            { "gaussian_blur", ImageProcessing::BlurQuality::Gaussian },
+            { "pyramid_blur", ImageProcessing::BlurQuality::Pyramid },
+            { "kernel_blur", ImageProcessing::BlurQuality::Kernel },
+        };
+        for (const auto& quality : qualities) {
+            for (int radius : options.radii) {
+                QJsonObject row = result(quality.first, size, measure(options, [&] { ImageProcessing::applyBlur(input, radius, quality.second); }));
+                row["radius"] = radius;
+                rows.append(row);
+            }
+        }
+
+        // The convolution engine on the calling thread alone: each effect should fit a 30 fps frame
+        // time at 1080p on one core.
+        {
+            using Detail = ImageProcessing::DetailFilter;
+            SeparableFilter filter;
+            filter.setSingleThreaded(true);
+            QImage output(size, QImage::Format_RGB888);
+            const int stride = static_cast<int>(input.bytesPerLine());
+            const int outputStride = static_cast<int>(output.bytesPerLine());
+            auto add = [&](const char* op, int radius, const std::function<void()>& call) {
+                const Timing timing = measure(options, call);
+                QJsonObject row = result(op, size, timing);
+                if (radius > 0) {
+                    row["radius"] = radius;
+                }
+                row["threads"] = 1;
+                row["realtime_30fps"] = timing.bestNs <= 1e9 / 30;
+                rows.append(row);
+            };
+            for (int radius = 1; radius <= ImageProcessing::maxKernelBlurRadius; ++radius) {
+                add("gaussian_kernel_blur", radius, [&] {
+                    filter.blur(input.constBits(), stride, output.bits(), outputStride, size.width(), size.height(), radius);
+                });
+            }
+            add("sharpen", 0, [&] {
+                filter.apply(Detail::Sharpen, 100, 0, input.constBits(), stride, output.bits(), outputStride, size.width(), size.height());
+            });
+            for (int radius : { 1, 3, ImageProcessing::maxKernelBlurRadius }) {
+                add("unsharp_mask", radius, [&] {
+                    filter.apply(Detail::UnsharpMask, 100, radius, input.constBits(), stride, output.bits(), outputStride,
+                        size.width(), size.height());
+                });
+            }
+            add("edges", 0, [&] {
+                filter.apply(Detail::Edges, 0, 0, input.constBits(), stride, output.bits(), outputStride, size.width(), size.height());
+            });
+        }
+
+        // Everything enabled, through the chain the frame processor uses; steady state should not allocate.
+        // Once per packed layout the appsink can deliver, which is what picks its default RGB format.
+        for (const auto& format : packedFormats) {
+            const QImage formatInput = input.convertToFormat(format.second);
+            for (int radius : options.radii) {
+                EffectChain chain;
+                EffectSettings settings;
+                settings.grayscaleEnabled = true;
+                settings.brightnessEnabled = true;
+                settings.brightnessValue = 40;
+                settings.blurEnabled = true;
+                settings.blurValue = radius;
+                chain.configure(settings);
+                QJsonObject row = result("effect_chain", size, measure(options, [&] { chain.process(formatInput); }));
+                row["radius"] = radius;
+                row["format"] = format.first;
+                rows.append(row);
+            }
+        }
+
+        // Frame statistics gathered inside the effect pass, against the same pass without them; the
+        // overhead should stay within a few percent. Without effects the stats take a pass of their own.
+        {
+            const std::pair<const char*, EffectSettings> configurations[] = {
+                { "brightness", EffectSettings::fromString(QStringLiteral("brightness=40")) },
+                { "brightness_blur", EffectSettings::fromString(QStringLiteral("brightness=40,blur=10")) },
+                { "pyramid_blur", EffectSettings::fromString(QStringLiteral("blur=50,quality=pyramid")) },
+                { "none", EffectSettings() },
+            };
+            for (const auto& configuration : configurations) {
+                EffectChain chain;
+                chain.configure(configuration.second);
+                const Timing without = measure(options, [&] { chain.process(input); });
+                chain.setStatsEnabled(true);
+                const Timing with = measure(options, [&] { chain.process(input); });
+                QJsonObject row = result("effect_chain_stats", size, with);
+                row["effects"] = configuration.first;
+                row["best_ms_without_stats"] = without.bestNs / 1e6;
+                if (chain.isActive()) { // An inactive chain costs nothing, so there is no percentage to take.
+                    row["overhead_percent"] = 100.0 * (with.bestNs - without.bestNs) / without.bestNs;
+                }
+                row["mean_luma"] = chain.stats().meanLuma();
+                rows.append(row);
+            }
+        }
+
+        // A centred region of interest of a quarter and a sixteenth of the frame, halo included; the
+        // time should follow the region's area rather than the frame's.
+        for (const double side : { 0.5, 0.25 }) {
+            EffectChain chain;
+            chain.configure(EffectSettings::fromString(QStringLiteral("brightness=40,blur=10")));
+            RegionOfInterest region;
+            region.area = QRectF((1.0 - side) / 2, (1.0 - side) / 2, side, side);
+            const QRect roi = region.toPixels(size);
+            QJsonObject row = result("effect_chain_roi", size, measure(options, [&] { chain.process(input, roi); }));
+            row["radius"] = 10;
+            row["roi_area"] = side * side;
+            rows.append(row);
+        }
+
+        // Incremental mode on a static scene with one 64x64 patch flickering, as when a small object
+        // moves in front of a fixed camera; a scene with nothing moving costs only the comparison.
+        QImage flickered = input.copy();
+        for (int y = 0; y < std::min(64, size.height()); ++y) {
+            std::memset(flickered.scanLine(y + size.height() / 2 - 32), 255, std::min(64, size.width()) * 3);
+        }
+        for (int radius : options.radii) {
+            EffectChain chain;
+            EffectSettings settings;
+            settings.brightnessEnabled = true;
+            settings.brightnessValue = 40;
+            settings.blurEnabled = true;
+            settings.blurValue = radius;
+            settings.incremental = true;
+            chain.configure(settings);
+            bool flicker = false;
+            QJsonObject row = result("incremental_effect_chain", size, measure(options, [&] {
+                chain.process((flicker = !flicker) ? flickered : input);
+            }));
+            row["radius"] = radius;
+            row["tiles_reprocessed"] = chain.tileStats().tiles > 0 ? double(chain.tileStats().processed) / chain.tileStats().tiles : 0.0;
+            rows.append(row);
+        }
+        {
+            EffectChain chain;
+            EffectSettings settings;
+            settings.blurEnabled = true;
+            settings.blurValue = 10;
+            settings.incremental = true;
+            chain.configure(settings);
+            QJsonObject row = result("incremental_static_scene", size, measure(options, [&] { chain.process(input); }));
+            row["radius"] = 10;
+            rows.append(row);
+        }
+
+        // The native path: an I420 frame through the YUV chain, then to RGB at the view's size.
+        YuvImage yuv(YuvImage::Format::I420, size.width(), size.height());
+        for (int plane = 0; plane < yuv.planeCount(); ++plane) {
+            const QSize planeSize = yuv.planeSize(plane);
+            for (int y = 0; y < planeSize.height(); ++y) {
+                std::memcpy(yuv.plane(plane) + y * yuv.stride(plane), input.constScanLine(y), planeSize.width());
+            }
+        }
+        YuvConverter converter;
+        rows.append(result("yuv_to_rgb_800x600", size, measure(options, [&] { converter.convert(yuv, QSize(800, 600)); })));
+        for (int radius : options.radii) {
+            EffectChain chain;
+            EffectSettings settings;
+            settings.brightnessEnabled = true;
+            settings.brightnessValue = 40;
+            settings.blurEnabled = true;
+            settings.blurValue = radius;
+            chain.configure(settings);
+            QJsonObject row = result("yuv_effect_chain", size, measure(options, [&] { chain.process(yuv); }));
+            row["radius"] = radius;
+            rows.append(row);
+        }
+    }
+    return rows;
+}
+
+// benchmarkKernelTables: Single-threaded row kernels for every instruction set, at the largest size.
+QJsonArray benchmarkKernelTables(const Options& options) {
+    QJsonArray rows;
+    const QSize size = options.sizes.last();
+    const int width = size.width();
+    const int height = size.height();
+    const QImage input = makeTestImage(width, height);
+    QImage output(size, QImage::Format_RGB888);
+    std::vector<int> columnSums(static_cast<size_t>(width) * 3);
+    const auto grayscale = ImageProcessing::PointOps::create(true, 40);
+    const auto brightness = ImageProcessing::PointOps::create(false, 40);
+
+    for (const auto* table : availableTables()) {
+        auto add = [&](const QString& op, int radius, const std::function<void()>& call, const char* format = nullptr) {
+            QJsonObject row = result(op, size, measure(options, call));
+            row["isa"] = table->name;
+            if (radius > 0) {
+                row["radius"] = radius;
+            }
+            if (format) {
+                row["format"] = format;
+            }
+            rows.append(row);
+        };
+        for (const auto& format : packedFormats) {
+            const QImage formatInput = input.convertToFormat(format.second);
+            QImage formatOutput(size, format.second);
+            const auto pointOpsRow = table->pointOpsRow[static_cast<size_t>(PixelFormat::layoutOf(format.second))];
+            for (const auto& ops : { std::pair{ "point_ops_grayscale", &grayscale }, std::pair{ "point_ops_brightness", &brightness } }) {
+                add(ops.first, 0, [&] {
+                    for (int y = 0; y < height; ++y) {
+                        pointOpsRow(formatInput.constScanLine(y), formatOutput.scanLine(y), width, *ops.second);
+                    }
+                }, format.first);
+            }
+        }
+        for (int radius : options.radii) {
+            add("horizontal_blur", radius, [&] {
+                for (int y = 0; y < height; ++y) {
+                    table->horizontalBlurRow(input.constScanLine(y), output.scanLine(y), width, radius, 3);
+                }
+            });
+            add("vertical_blur", radius, [&] {
+                table->verticalBlur(input.constBits(), static_cast<int>(input.bytesPerLine()), output.bits(),
+                    static_cast<int>(output.bytesPerLine()), width, height, radius, columnSums.data(), 3);
+            });
+        }
+        // Planes of the input stand in for Y, U and V; the content does not change the cost.
+        add("yuv_to_rgb", 0, [&] {
+            for (int y = 0; y < height; ++y) {
+                const uchar* row = input.constScanLine(y);
+                table->yuvToRgbRow(row, row + width, row + 2 * width, output.scanLine(y), width);
+            }
+        });
+        add("sum_abs_diff", 0, [&] {
+            int sum = 0;
+            for (int y = 0; y < height; ++y) {
+                sum += table->sumAbsDiff(input.constScanLine(y), output.constScanLine(y), width * 3);
+            }
+            volatile int sink = sum; // Keeps the loop from being optimized away.
+            (void)sink;
+        });
+    }
+    return rows;
+}
+
+// verifyKernelTables: Every SIMD table must match the scalar one byte for byte, including ragged tails.
+QJsonObject verifyKernelTables(bool& ok) {
+    const auto& scalar = ImageKernels::scalarKernels();
+    const QList<QSize> sizes{ { 1, 1 }, { 7, 5 }, { 33, 17 }, { 333, 97 } };
+    const QList<int> radii{ 1, 2, 5, 16, 60 };
+    QJsonObject verify;
+    ok = true;
+
+    for (const auto* table : availableTables()) {
+        int mismatches = 0;
+        for (const QSize& size : sizes) {
+            const int width = size.width();
+            const int height = size.height();
+            const QImage input = makeTestImage(width, height);
+            QImage expected(size, QImage::Format_RGB888);
+            QImage actual(size, QImage::Format_RGB888);
+            std::vector<int> sums(static_cast<size_t>(width) * 3);
+            auto compare = [&](int bytes) {
+                for (int y = 0; y < height; ++y) {
+                    if (std::memcmp(expected.constScanLine(y), actual.constScanLine(y), bytes) != 0) {
+                        ++mismatches;
+                        return;
+                    }
+                }
+            };
+
+            // Every layout reads the same noise rows as pixels of its own size; the noise in the fourth
+            // byte of the 32-bit layouts checks that it comes through untouched.
+            for (int layout = 0; layout < PixelFormat::layoutCount; ++layout) {
+                const int pixels = width * 3 / PixelFormat::bytesPerPixel(static_cast<PixelFormat::Layout>(layout));
+                for (bool gray : { false, true }) {
+                    for (int brightness : { -300, -40, 0, 17, 255 }) {
+                        const auto ops = ImageProcessing::PointOps::create(gray, brightness);
+                        for (int y = 0; y < height; ++y) {
+                            scalar.pointOpsRow[layout](input.constScanLine(y), expected.scanLine(y), pixels, ops);
+                            table->pointOpsRow[layout](input.constScanLine(y), actual.scanLine(y), pixels, ops);
+                        }
+                        compare(pixels * PixelFormat::bytesPerPixel(static_cast<PixelFormat::Layout>(layout)));
+                    }
+                }
+            }
+            for (int brightness : { -40, 17 }) {
+                const auto ops = ImageProcessing::PointOps::create(false, brightness);
+                for (int y = 0; y < height; ++y) {
+                    scalar.lutRow(input.constScanLine(y), expected.scanLine(y), width * 3, ops);
+                    table->lutRow(input.constScanLine(y), actual.scanLine(y), width * 3, ops);
+                }
+                compare(width * 3);
+            }
+            // One, two and four channel layouts cover Y planes, NV12 chroma and YUY2 rows; the
+            // narrower layouts simply blur more elements of the same rows.
+            for (int channels : { 1, 2, 3, 4 }) {
+                const int elements = width * 3 / channels;
+                for (int radius : radii) {
+                    for (int y = 0; y < height; ++y) {
+                        scalar.horizontalBlurRow(input.constScanLine(y), expected.scanLine(y), elements, radius, channels);
+                        table->horizontalBlurRow(input.constScanLine(y), actual.scanLine(y), elements, radius, channels);
+                    }
+                    compare(width * 3);
+                    const int stride = static_cast<int>(input.bytesPerLine());
+                    scalar.verticalBlur(input.constBits(), stride, expected.bits(), static_cast<int>(expected.bytesPerLine()),
+                        elements, height, radius, sums.data(), channels);
+                    table->verticalBlur(input.constBits(), stride, actual.bits(), static_cast<int>(actual.bytesPerLine()),
+                        elements, height, radius, sums.data(), channels);
+                    compare(width * 3);
+                }
+            }
+            // Convolution: symmetric, antisymmetric and lopsided kernels up to maxTaps over one to four
+            // channels. The rows of a wider image stand in for edge-padded rows; the row pass output of
+            // every source row feeds the column pass, and its sums every way of finishing a row.
+            {
+                SeparableKernel lopsided;
+                lopsided.taps = 4;
+                lopsided.weights = { 700, -1300, 1500, 590 };
+                const SeparableKernel kernels[] = { SeparableKernel::binomial(), SeparableKernel::derivative(),
+                    SeparableKernel::gaussian(1.5), SeparableKernel::gaussian(10), lopsided };
+                const QImage padded = makeTestImage(width + 2 * ImageKernels::Convolution::maxTaps, height);
+                const int count = width * 3;
+                std::vector<qint16> scratch(static_cast<size_t>(count) * height);
+                std::vector<qint16> columns(static_cast<size_t>(count) * height);
+                std::vector<qint16> expectedSums(count);
+                std::vector<qint16> actualSums(count);
+                std::vector<const qint16*> taps(ImageKernels::Convolution::maxTaps);
+                auto compareSums = [&] {
+                    if (std::memcmp(expectedSums.data(), actualSums.data(), count * sizeof(qint16)) != 0) {
+                        ++mismatches;
+                    }
+                };
+                for (const auto& kernel : kernels) {
+                    for (int channels : { 1, 2, 3, 4 }) {
+                        for (int y = 0; y < height; ++y) {
+                            scalar.convolveRow(padded.constScanLine(y), expectedSums.data(), count, channels, kernel.weights.data(), kernel.taps);
+                            table->convolveRow(padded.constScanLine(y), actualSums.data(), count, channels, kernel.weights.data(), kernel.taps);
+                            compareSums();
+                            std::copy(expectedSums.begin(), expectedSums.end(), scratch.begin() + static_cast<ptrdiff_t>(y) * count);
+                        }
+                    }
+                    for (int y = 0; y < height; ++y) {
+                        for (int k = 0; k < kernel.taps; ++k) {
+                            taps[k] = scratch.data() + static_cast<size_t>(std::clamp(y + k - kernel.radius(), 0, height - 1)) * count;
+                        }
+                        scalar.convolveColumns(taps.data(), expectedSums.data(), count, kernel.weights.data(), kernel.taps);
+                        table->convolveColumns(taps.data(), actualSums.data(), count, kernel.weights.data(), kernel.taps);
+                        compareSums();
+                        std::copy(expectedSums.begin(), expectedSums.end(), columns.begin() + static_cast<ptrdiff_t>(y) * count);
+                    }
+                    for (int y = 0; y < height; ++y) {
+                        const qint16* sums = columns.data() + static_cast<size_t>(y) * count;
+                        scalar.packRow(sums, expected.scanLine(y), count);
+                        table->packRow(sums, actual.scanLine(y), count);
+                    }
+                    compare(count);
+                    for (int y = 0; y < height; ++y) {
+                        const qint16* gx = columns.data() + static_cast<size_t>(y) * count;
+                        const qint16* gy = columns.data() + static_cast<size_t>(height - 1 - y) * count;
+                        scalar.edgeMagnitudeRow(gx, gy, expected.scanLine(y), count);
+                        table->edgeMagnitudeRow(gx, gy, actual.scanLine(y), count);
+                    }
+                    compare(count);
+                    for (int amount : { 0, 256, 2560 }) {
+                        for (int y = 0; y < height; ++y) {
+                            const qint16* blurred = columns.data() + static_cast<size_t>(y) * count;
+                            scalar.unsharpRow(input.constScanLine(y), blurred, expected.scanLine(y), count, amount);
+                            table->unsharpRow(input.constScanLine(y), blurred, actual.scanLine(y), count, amount);
+                        }
+                        compare(count);
+                    }
+                }
+            }
+            for (int y = 0; y < height; ++y) {
+                const uchar* row = input.constScanLine(y);
+                scalar.yuvToRgbRow(row, row + width, row + 2 * width, expected.scanLine(y), width);
+                table->yuvToRgbRow(row, row + width, row + 2 * width, actual.scanLine(y), width);
+            }
+            compare(width * 3);
+            // Neighbouring rows stand in for the same row of consecutive frames.
+            for (int y = 0; y + 1 < height; ++y) {
+                const uchar* row = input.constScanLine(y);
+                const uchar* next = input.constScanLine(y + 1);
+                if (scalar.sumAbsDiff(row, next, width * 3) != table->sumAbsDiff(row, next, width * 3)) {
+                    ++mismatches;
+                    break;
+                }
+            }
+        }
+        verify[table->name] = mismatches == 0 ? "ok" : QString("%1 mismatching cases").arg(mismatches);
+        ok = ok && mismatches == 0;
+    }
+    return verify;
+}
+
+// percentile: Nearest-rank percentile of sorted samples.
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+// runPipeline: videotestsrc -> appsink -> FrameProcessor, timed from the appsink callback to frameProcessed.
+// A region of interest is cropped by videocrop, or with roiInEffects by the effect chain after the
+// appsink, which shows what the fallback for a missing videocrop costs.
+// With a replay file, qtgstreplaysrc loops it instead: at its original timing when live, as fast as
+// possible otherwise, so runs on different machines see the same frames.
+QJsonObject runPipeline(const QSize& size, const QSize& displaySize, int framerate, bool live, bool rgb, QImage::Format rgbFormat, int seconds,
+    const EffectSettings& effects, const DropPolicy& dropPolicy, const QString& recordDirectory, int burst, const QString& replay, const QString& capture,
+    const RegionOfInterest& region, bool roiInEffects) {
+    Recorder recorder; // Declared first so it outlives the processor feeding it.
+    SnapshotEncoder snapshots; // Likewise for the stills.
+    GStreamerHandler handler;
+    FrameProcessor processor;
+
+    if (replay.isEmpty()) {
+        handler.setSource(QString("videotestsrc is-live=%1 pattern=ball ! video/x-raw,width=%2,height=%3,framerate=%4/1")
+            .arg(live ? "true" : "false").arg(size.width()).arg(size.height()).arg(framerate));
+    } else {
+        handler.setSource(QString("qtgstreplaysrc location=\"%1\" loop=true timing=%2").arg(replay, live ? "original" : "fast"));
+    }
+    handler.setNativeFormats(!rgb); // videotestsrc offers the YUV formats first.
+    handler.setRgbFormat(rgbFormat);
+    handler.setOutputSize(displaySize); // Empty: effects run at the full source size.
+    processor.setDisplaySize(displaySize);
+    const bool cropInPipeline = !roiInEffects && GStreamerHandler::canCrop();
+    handler.setRegionOfInterest(cropInPipeline ? region : RegionOfInterest());
+    processor.setRegionOfInterest(cropInPipeline ? RegionOfInterest() : region);
+    handler.setDropPolicy(dropPolicy);
+    processor.setDropPolicy(dropPolicy);
+    processor.setGrayscale(effects.grayscaleEnabled);
+    processor.setBrightnessEnabled(effects.brightnessEnabled);
+    processor.setBrightness(effects.brightnessValue);
+    processor.setBlurEnabled(effects.blurEnabled);
+    processor.setBlur(effects.blurValue);
+    processor.setBlurQuality(effects.blurQuality);
+    processor.setDetailFilter(effects.detailFilter);
+    processor.setDetailAmount(effects.detailAmount);
+    processor.setDetailRadius(effects.detailRadius);
+    processor.setIncremental(effects.incremental);
+    processor.setChangeThreshold(effects.changeThreshold);
+    processor.setAutoBrightness(effects.autoBrightness, effects.autoBrightnessTarget);
+
+    std::mutex mutex;
+    std::map<GstClockTime, Clock::time_point> arrivals; // Keyed by PTS; dropped frames are pruned as newer ones complete.
+    std::vector<double> latenciesMs;
+    Clock::time_point firstProcessed;
+    Clock::time_point lastProcessed;
+    quint64 measured = 0;
+
+    QObject::connect(&handler, &GStreamerHandler::newFrame, &processor, [&](const VideoFrame& frame) {
+        {
+            std::lock_guard lock(mutex);
+            arrivals[frame.pts()] = Clock::now();
+        }
+        processor.submitFrame(frame);
+    }, Qt::DirectConnection);
+    QObject::connect(&processor, &FrameProcessor::frameProcessed, &handler, [&](const VideoFrame& frame) {
+        const auto now = Clock::now();
+        processor.notifyDelivered(); // Consumed on the spot; there is no GUI to wait for.
+        recorder.pushFrame(frame);
+        std::lock_guard lock(mutex);
+        const auto arrival = arrivals.find(frame.pts());
+        if (arrival == arrivals.end()) {
+            return;
+        }
+        latenciesMs.push_back(std::chrono::duration<double, std::milli>(now - arrival->second).count());
+        arrivals.erase(arrivals.begin(), std::next(arrival));
+        if (measured++ == 0) {
+            firstProcessed = now;
+        }
+        lastProcessed = now;
+    }, Qt::DirectConnection);
+
+    // Stills go to a directory that is removed afterwards; only their timings are kept.
+    QTemporaryDir stillsDirectory;
+    std::vector<double> encodeMs;
+    QObject::connect(&handler, &GStreamerHandler::stillCaptured, &handler, [&](const VideoFrame& frame) {
+        snapshots.submit(frame);
+    }, Qt::DirectConnection);
+    QObject::connect(&snapshots, &SnapshotEncoder::saved, &handler, [&](const QString&, qint64 encodeNs) {
+        std::lock_guard lock(mutex);
+        encodeMs.push_back(encodeNs / 1e6);
+    }, Qt::DirectConnection);
+    if (burst > 0) {
+        SnapshotSettings stills;
+        stills.directory = stillsDirectory.path();
+        stills.applyEffects = true;
+        stills.effects = effects;
+        snapshots.setSettings(stills);
+    }
+
+    if (!recordDirectory.isEmpty()) {
+        RecorderSettings recording;
+        recording.directory = recordDirectory;
+        recorder.start(recording);
+    }
+    const bool capturing = !capture.isEmpty() && handler.startCapture(capture);
+    processor.start();
+    handler.startPipeline();
+    if (burst > 0 && seconds > 1) {
+        // A burst in the middle of the run, so its effect on fps and latency shows in the totals.
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        handler.captureStills(burst);
+        std::this_thread::sleep_for(std::chrono::seconds(seconds - 1));
+    } else {
+        handler.captureStills(burst);
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    }
+    handler.stopPipeline();
+    handler.stopCapture();
+    snapshots.waitForIdle();
+    processor.stop();
+    const bool recorded = recorder.isRecording();
+    recorder.stop();
+
+    const auto counters = processor.counters();
+    const auto pipelineCounters = handler.counters();
+    std::sort(latenciesMs.begin(), latenciesMs.end());
+    const double spanSeconds = std::chrono::duration<double>(lastProcessed - firstProcessed).count();
+
+    QJsonObject pipeline{
+        { "source", handler.source() },
+        { "format", rgb ? "RGB" : "native" },
+        { "rgb_format", rgbFormatName(rgbFormat) },
+        { "display_size", displaySize.isEmpty() ? QString("source") : QString("%1x%2").arg(displaySize.width()).arg(displaySize.height()) },
+        { "roi", region.toString() },
+        { "seconds", seconds },
+        { "received", double(counters.received) },
+        { "processed", double(counters.processed) },
+        { "drop_policy", dropPolicy.toString() },
+        { "dropped", QJsonObject{
+            { "queue", double(pipelineCounters.queueDropped) },
+            { "mailbox", double(counters.dropped) },
+        } },
+        { "blocked", double(counters.blocked) },
+        { "fps", measured > 1 && spanSeconds > 0 ? (measured - 1) / spanSeconds : 0.0 },
+        { "latency_ms", QJsonObject{
+            { "p50", percentile(latenciesMs, 50) },
+            { "p90", percentile(latenciesMs, 90) },
+            { "p99", percentile(latenciesMs, 99) },
+            { "max", latenciesMs.empty() ? 0.0 : latenciesMs.back() },
+        } },
+    };
+    if (!region.isFull()) {
+        pipeline["roi_crop"] = cropInPipeline ? "pipeline" : "effects";
+    }
+    if (replay.isEmpty()) {
+        pipeline["width"] = size.width();
+        pipeline["height"] = size.height();
+    } else {
+        pipeline["replay"] = replay;
+    }
+    if (capturing) {
+        pipeline["capture"] = QJsonObject{
+            { "file", capture },
+            { "captured", double(pipelineCounters.captured) },
+        };
+    } else if (!capture.isEmpty()) {
+        pipeline["error"] = QString("raw capture did not start: %1").arg(handler.captureError());
+    }
+    if (counters.tiles > 0) {
+        pipeline["tiles_reprocessed"] = double(counters.tilesProcessed) / double(counters.tiles);
+    }
+    if (recorded) {
+        const auto recording = recorder.counters();
+        pipeline["recording"] = QJsonObject{
+            { "directory", recordDirectory },
+            { "recorded", double(recording.recorded) },
+            { "dropped", double(recording.dropped) },
+            { "segments", double(recording.segments) },
+        };
+    } else if (!recordDirectory.isEmpty()) {
+        pipeline["error"] = "recording did not start; is an H.264 encoder available?";
+    }
+    if (burst > 0) {
+        const auto stills = snapshots.counters();
+        std::sort(encodeMs.begin(), encodeMs.end());
+        pipeline["burst"] = QJsonObject{
+            { "requested", burst },
+            { "captured", double(pipelineCounters.stills) },
+            { "saved", double(stills.saved) },
+            { "dropped", double(stills.dropped) },
+            { "failed", double(stills.failed) },
+            { "queue_high_water", stills.highWater },
+            { "encode_ms", QJsonObject{
+                { "p50", percentile(encodeMs, 50) },
+                { "p90", percentile(encodeMs, 90) },
+                { "max", encodeMs.empty() ? 0.0 : encodeMs.back() },
+            } },
+        };
+    }
+    if (counters.received == 0) {
+        pipeline["error"] = "no frames received; is the GStreamer pipeline available?";
+    }
+    return pipeline;
+}
+
+// runStartup: Starts and stops one live videotestsrc pipeline cycles times per mode and reports
+// the time from the start call to the first frame. The very first start also pays for gst_init.
+// "rebuild" builds the pipeline on every start, as a plain stop and start does; "prepared" keeps
+// it in READY between runs, as setKeepPrepared does.
+QJsonObject runStartup(int cycles, const QSize& size, int framerate, bool rgb, QImage::Format rgbFormat) {
+    GStreamerHandler handler;
+    handler.setSource(QString("videotestsrc is-live=true pattern=ball ! video/x-raw,width=%1,height=%2,framerate=%3/1")
+        .arg(size.width()).arg(size.height()).arg(framerate));
+    handler.setNativeFormats(!rgb);
+    handler.setRgbFormat(rgbFormat);
+
+    std::mutex mutex;
+    std::condition_variable arrived;
+    bool first = false;
+    QObject::connect(&handler, &GStreamerHandler::firstFrame, &handler, [&](qint64) {
+        std::lock_guard lock(mutex);
+        first = true;
+        arrived.notify_one();
+    }, Qt::DirectConnection);
+
+    // One start: false if no frame came within five seconds.
+    const auto startOnce = [&](GStreamerHandler::Startup& startup) {
+        {
+            std::lock_guard lock(mutex);
+            first = false;
+        }
+        bool ok = handler.startPipeline();
+        if (ok) {
+            std::unique_lock lock(mutex);
+            ok = arrived.wait_for(lock, std::chrono::seconds(5), [&] { return first; });
+        }
+        startup = handler.startup();
+        handler.stopPipeline();
+        return ok;
+    };
+    const auto ms = [](qint64 ns) { return ns < 0 ? -1.0 : ns / 1e6; };
+
+    QJsonObject report{
+        { "source", handler.source() },
+        { "rgb_format", rgbFormatName(rgbFormat) },
+        { "cycles", cycles },
+    };
+    GStreamerHandler::Startup cold;
+    if (!startOnce(cold)) {
+        report["error"] = "no first frame; is the GStreamer pipeline available?";
+        return report;
+    }
+    report["cold"] = QJsonObject{
+        { "init_ms", ms(cold.initNs) },
+        { "build_ms", ms(cold.buildNs) },
+        { "playing_ms", ms(cold.playingNs) },
+        { "first_frame_ms", ms(cold.firstFrameNs) },
+    };
+
+    for (const bool prepared : { false, true }) {
+        handler.setKeepPrepared(prepared);
+        if (prepared) {
+            GStreamerHandler::Startup warmup;
+            startOnce(warmup); // Leaves the pipeline in READY for the first measured start.
+        }
+        std::vector<double> build;
+        std::vector<double> playing;
+        std::vector<double> firstFrame;
+        for (int i = 0; i < cycles; ++i) {
+            GStreamerHandler::Startup startup;
+            if (!startOnce(startup)) {
+                report["error"] = "a restart delivered no frame";
+                break;
+            }
+            build.push_back(ms(startup.buildNs));
+            playing.push_back(ms(startup.playingNs));
+            firstFrame.push_back(ms(startup.firstFrameNs));
+        }
+        std::sort(build.begin(), build.end());
+        std::sort(playing.begin(), playing.end());
+        std::sort(firstFrame.begin(), firstFrame.end());
+        report[prepared ? "prepared" : "rebuild"] = QJsonObject{
+            { "build_ms_p50", percentile(build, 50) },
+            { "playing_ms_p50", percentile(playing, 50) },
+            { "first_frame_ms_p50", percentile(firstFrame, 50) },
+            { "first_frame_ms_max", firstFrame.empty() ? 0.0 : firstFrame.back() },
+        };
+    }
+    handler.setKeepPrepared(false);
+    handler.stopPipeline(); // Releases the prepared pipeline.
+    return report;
+}
+
+// runStreams: count videotestsrc cameras as CameraStreams on the shared pool. A processed frame
+// counts as painted the moment it arrives, so each stream's tracer gives its fps and latency.
+QJsonObject runStreams(int count, const QSize& size, const QSize& displaySize, int framerate, bool rgb, QImage::Format rgbFormat, int seconds,
+    const EffectSettings& effects, const DropPolicy& dropPolicy) {
+    std::vector<std::unique_ptr<CameraStream>> streams;
+    for (int i = 0; i < count; ++i) {
+        auto stream = std::make_unique<CameraStream>(QString("videotestsrc is-live=true pattern=%1 ! video/x-raw,width=%2,height=%3,framerate=%4/1")
+            .arg(i % 25).arg(size.width()).arg(size.height()).arg(framerate));
+        CameraStream* raw = stream.get();
+        raw->handler().setNativeFormats(!rgb);
+        raw->handler().setRgbFormat(rgbFormat);
+        raw->setDisplaySize(displaySize);
+        raw->setDropPolicy(dropPolicy);
+        raw->processor().setGrayscale(effects.grayscaleEnabled);
+        raw->processor().setBrightnessEnabled(effects.brightnessEnabled);
+        raw->processor().setBrightness(effects.brightnessValue);
+        raw->processor().setBlurEnabled(effects.blurEnabled);
+        raw->processor().setBlur(effects.blurValue);
+        raw->processor().setBlurQuality(effects.blurQuality);
+        raw->processor().setDetailFilter(effects.detailFilter);
+        raw->processor().setDetailAmount(effects.detailAmount);
+        raw->processor().setDetailRadius(effects.detailRadius);
+        raw->processor().setIncremental(effects.incremental);
+        raw->processor().setChangeThreshold(effects.changeThreshold);
+        raw->processor().setAutoBrightness(effects.autoBrightness, effects.autoBrightnessTarget);
+        QObject::connect(&raw->processor(), &FrameProcessor::frameProcessed, raw, [raw](VideoFrame frame) {
+            frame.stamp(FrameTimestamps::Delivered);
+            frame.stamp(FrameTimestamps::Painted);
+            raw->tracer().record(frame.timestamps(), frame.sequence());
+            raw->processor().notifyDelivered();
+        }, Qt::DirectConnection);
+        streams.push_back(std::move(stream));
+    }
+
+    for (auto& stream : streams) {
+        stream->start();
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    for (auto& stream : streams) {
+        stream->stop();
+    }
+
+    QJsonArray perStream;
+    double totalFps = 0;
+    quint64 received = 0;
+    for (auto& stream : streams) {
+        const auto counters = stream->processor().counters();
+        const FrameTracer& tracer = stream->tracer();
+        const double fps = double(counters.processed) / seconds;
+        totalFps += fps;
+        received += counters.received;
+        QJsonObject latency;
+        for (const FrameTracer::Stage stage : { FrameTracer::Queue, FrameTracer::Effects, FrameTracer::Total }) {
+            latency[FrameTracer::stageName(stage)] = QJsonObject{
+                { "p50", tracer.histogram(stage).percentile(50) / 1e6 },
+                { "p99", tracer.histogram(stage).percentile(99) / 1e6 },
+            };
+        }
+        perStream.append(QJsonObject{
+            { "received", double(counters.received) },
+            { "processed", double(counters.processed) },
+            { "dropped", QJsonObject{
+                { "queue", double(stream->handler().counters().queueDropped) },
+                { "mailbox", double(counters.dropped) },
+            } },
+            { "fps", fps },
+            { "latency_ms", latency },
+        });
+    }
+
+    QJsonObject report{
+        { "streams", count },
+        { "format", rgb ? "RGB" : "native" },
+        { "rgb_format", rgbFormatName(rgbFormat) },
+        { "width", size.width() },
+        { "height", size.height() },
+        { "framerate", framerate },
+        { "seconds", seconds },
+        { "drop_policy", dropPolicy.toString() },
+        { "total_fps", totalFps },
+        // Below 1, the machine no longer keeps up with every camera.
+        { "fps_ratio", totalFps / (double(count) * framerate) },
+        { "per_stream", perStream },
+    };
+    if (received == 0) {
+        report["error"] = "no frames received; is the GStreamer pipeline available?";
+    }
+    return report;
+}
+
+// parseSizes: "640x480,1280x720" -> sizes; invalid entries are skipped.
+QList<QSize> parseSizes(const QString& text) {
+    QList<QSize> sizes;
+    for (const QString& entry : text.split(',', Qt::SkipEmptyParts)) {
+        const QStringList parts = entry.split('x');
+        if (parts.size() == 2 && parts[0].toInt() > 0 && parts[1].toInt() > 0) {
+            sizes.append(QSize(parts[0].toInt(), parts[1].toInt()));
+        }
+    }
+    return sizes;
+}
+
+QList<int> parseInts(const QString& text) {
+    QList<int> values;
+    for (const QString& entry : text.split(',', Qt::SkipEmptyParts)) {
+        values.append(entry.toInt());
+    }
+    return values;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("imageprocessing_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks the image kernels and the capture pipeline; prints JSON.");
+    parser.addHelpOption();
+    const QCommandLineOption sizesOption("sizes", "Frame sizes for the kernel timings.", "WxH,...", "640x480,1280x720,1920x1080,3840x2160");
+    const QCommandLineOption radiiOption("radii", "Blur radii to sweep.", "r,...", "1,2,5,10,20,50,100");
+    const QCommandLineOption minTimeOption("min-time-ms", "Minimum time spent on each case.", "ms", "300");
+    const QCommandLineOption pipelineOption("pipeline", "Run the videotestsrc pipeline instead of the kernel timings.");
+    const QCommandLineOption secondsOption("seconds", "Pipeline run time.", "N", "10");
+    const QCommandLineOption pipelineSizeOption("pipeline-size", "Pipeline frame size.", "WxH", "1280x720");
+    const QCommandLineOption displaySizeOption("display-size", "Scale frames in the pipeline to fit this size.", "WxH");
+    const QCommandLineOption framerateOption("framerate", "Pipeline frame rate.", "fps", "30");
+    const QCommandLineOption liveOption("live", "Produce frames in real time instead of as fast as possible.");
+    const QCommandLineOption rgbOption("rgb", "Convert to RGB in the pipeline instead of processing YUV natively.");
+    const QCommandLineOption rgbFormatOption("rgb-format", "Layout of RGB frames: rgb888, rgb32, rgbx8888 or gray8.", "name", "rgb888");
+    const QCommandLineOption effectsOption("effects", "Pipeline effects, e.g. grayscale,brightness=40,blur=5,incremental.", "list", "");
+    const QCommandLineOption dropPolicyOption("drop-policy", "Frame-drop policy: latest, queue=N or lossless[=N].", "policy", "latest");
+    const QCommandLineOption streamsOption("streams", "Run N live cameras on the shared thread pool instead of one.", "N", "1");
+    const QCommandLineOption recordOption("record", "Record the processed stream to this directory during the pipeline run.", "dir");
+    const QCommandLineOption burstOption("burst", "Capture N full-resolution stills a second into the pipeline run.", "N", "0");
+    const QCommandLineOption roiOption("roi", "Process only this region of the frame, in fractions of it.", "x,y,w,h");
+    const QCommandLineOption roiEffectsOption("roi-in-effects", "Restrict the effects to the region instead of cropping it in the pipeline.");
+    const QCommandLineOption captureOption("capture", "Write the frames the pipeline delivers to this raw capture file.", "file");
+    const QCommandLineOption replayOption("replay", "Loop this raw capture file instead of videotestsrc; --live keeps its timing.", "file");
+    const QCommandLineOption startupOption("startup", "Measure time to first frame over N restarts per mode instead.", "N");
+    const QCommandLineOption outputOption("output", "Write the JSON report to a file instead of stdout.", "file");
+    parser.addOptions({ sizesOption, radiiOption, minTimeOption, pipelineOption, secondsOption, pipelineSizeOption, displaySizeOption,
+        framerateOption, liveOption, rgbOption, rgbFormatOption, effectsOption, dropPolicyOption, streamsOption, recordOption, burstOption,
+        roiOption, roiEffectsOption, captureOption, replayOption, startupOption, outputOption });
+    parser.process(app);
+
+    QJsonObject report{
+        { "timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate) },
+        { "qt_version", qVersion() },
+        { "kernels", ImageKernels::active().name },
+        { "threads", ThreadPool::global().concurrency() },
+    };
+    bool ok = true;
+    const QImage::Format rgbFormat = parseRgbFormat(parser.value(rgbFormatOption));
+    if (rgbFormat == QImage::Format_Invalid) {
+        qCritical() << "Unknown RGB format" << parser.value(rgbFormatOption);
+        return 2;
+    }
+
+    if (parser.isSet(startupOption)) {
+        const QList<QSize> size = parseSizes(parser.value(pipelineSizeOption));
+        const QJsonObject startup = runStartup(std::max(parser.value(startupOption).toInt(), 1), size.value(0, QSize(1280, 720)),
+            std::max(parser.value(framerateOption).toInt(), 1), parser.isSet(rgbOption), rgbFormat);
+        ok = !startup.contains("error");
+        report["startup"] = startup;
+    } else if (parser.isSet(pipelineOption) && parser.value(streamsOption).toInt() > 1) {
+        const QList<QSize> size = parseSizes(parser.value(pipelineSizeOption));
+        const QSize displaySize = parseSizes(parser.value(displaySizeOption)).value(0, QSize());
+        const QJsonObject streams = runStreams(parser.value(streamsOption).toInt(), size.value(0, QSize(1280, 720)), displaySize,
+            std::max(parser.value(framerateOption).toInt(), 1), parser.isSet(rgbOption), rgbFormat, std::max(parser.value(secondsOption).toInt(), 1),
+            EffectSettings::fromString(parser.value(effectsOption)), DropPolicy::fromString(parser.value(dropPolicyOption)));
+        ok = !streams.contains("error");
+        report["streams"] = streams;
+    } else if (parser.isSet(pipelineOption)) {
+        const QList<QSize> size = parseSizes(parser.value(pipelineSizeOption));
+        const QSize displaySize = parseSizes(parser.value(displaySizeOption)).value(0, QSize());
+        const QJsonObject pipeline = runPipeline(size.value(0, QSize(1280, 720)), displaySize, std::max(parser.value(framerateOption).toInt(), 1),
+            parser.isSet(liveOption), parser.isSet(rgbOption), rgbFormat, std::max(parser.value(secondsOption).toInt(), 1), EffectSettings::fromString(parser.value(effectsOption)),
+            DropPolicy::fromString(parser.value(dropPolicyOption)), parser.value(recordOption), std::max(parser.value(burstOption).toInt(), 0),
+            parser.value(replayOption), parser.value(captureOption), RegionOfInterest::fromString(parser.value(roiOption)), parser.isSet(roiEffectsOption));
+        ok = !pipeline.contains("error");
+        report["pipeline"] = pipeline;
+    } else {
+        Options options;
+        options.sizes = parseSizes(parser.value(sizesOption));
+        options.radii = parseInts(parser.value(radiiOption));
+        options.minTimeMs = std::max(parser.value(minTimeOption).toInt(), 0);
+        if (options.sizes.isEmpty() || options.radii.isEmpty()) {
+            qCritical() << "Need at least one size and one radius.";
+            return 2;
+        }
+        report["verify"] = verifyKernelTables(ok);
+        report["effects"] = benchmarkEffects(options);
+        report["kernel_tables"] = benchmarkKernelTables(options);
+    }
+
+    const auto pool = FrameBufferPool::global().stats();
+    report["buffer_pool"] = QJsonObject{
+        { "hits", double(pool.hits) },
+        { "misses", double(pool.misses) },
+        { "peak_resident_bytes", double(pool.peakResidentBytes) },
+    };
+
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qCritical() << "Cannot write" << file.fileName();
+            return 2;
+        }
+        file.write(json);
+    } else {
+        QTextStream(stdout) << json;
+    }
+    return ok ? 0 : 1;
+}
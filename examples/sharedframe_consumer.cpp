@@ -0,0 +1,144 @@
+// sharedframe_consumer: A stand-in for an analytics process. It reads the frames Qt-Gst-Camera
+// publishes with --export, computes the mean brightness of each one in place, and prints once per
+// second how many frames it saw, skipped and had to discard.
+//
+//   sharedframe_consumer qtgst-camera [--seconds N] [--snapshot frame.ppm]
+//
+// Uses only the shmreader library: no Qt, no GStreamer.
+
+#include "sharedframereader.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// meanLuma: Reads every pixel, as an analysis would; the same weights as the grayscale effect.
+double meanLuma(const SharedFrameReader::Frame& frame) {
+    using SharedFrames::Format;
+    const int bytes = SharedFrames::bytesPerPixel(frame.format);
+    const bool bgr = frame.format == Format::Bgrx8888 || frame.format == Format::Bgra8888;
+    unsigned long long sum = 0;
+    for (int y = 0; y < frame.height; ++y) {
+        const std::uint8_t* row = frame.data + static_cast<std::size_t>(y) * frame.stride;
+        for (int x = 0; x < frame.width; ++x) {
+            const std::uint8_t* pixel = row + x * bytes;
+            if (bytes == 1) {
+                sum += pixel[0];
+            } else {
+                const int r = pixel[bgr ? 2 : 0];
+                const int g = pixel[1];
+                const int b = pixel[bgr ? 0 : 2];
+                sum += (r * 11 + g * 16 + b * 5) >> 5;
+            }
+        }
+    }
+    const double pixels = double(frame.width) * frame.height;
+    return pixels > 0 ? sum / pixels : 0;
+}
+
+// writeSnapshot: The frame as a binary PPM (PGM for gray), which most image viewers open.
+bool writeSnapshot(const SharedFrameReader::Frame& frame, const std::string& path) {
+    using SharedFrames::Format;
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    const bool gray = frame.format == Format::Gray8;
+    const bool bgr = frame.format == Format::Bgrx8888 || frame.format == Format::Bgra8888;
+    const int bytes = SharedFrames::bytesPerPixel(frame.format);
+    std::fprintf(file, "%s\n%d %d\n255\n", gray ? "P5" : "P6", frame.width, frame.height);
+    std::string row(static_cast<std::size_t>(frame.width) * (gray ? 1 : 3), '\0');
+    for (int y = 0; y < frame.height; ++y) {
+        const std::uint8_t* src = frame.data + static_cast<std::size_t>(y) * frame.stride;
+        for (int x = 0; x < frame.width; ++x) {
+            const std::uint8_t* pixel = src + x * bytes;
+            if (gray) {
+                row[x] = static_cast<char>(pixel[0]);
+            } else {
+                row[x * 3] = static_cast<char>(pixel[bgr ? 2 : 0]);
+                row[x * 3 + 1] = static_cast<char>(pixel[1]);
+                row[x * 3 + 2] = static_cast<char>(pixel[bgr ? 0 : 2]);
+            }
+        }
+        std::fwrite(row.data(), 1, row.size(), file);
+    }
+    return std::fclose(file) == 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string name;
+    std::string snapshot;
+    int seconds = 0; // 0 runs until interrupted.
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            snapshot = argv[++i];
+        } else if (argv[i][0] != '-' && name.empty()) {
+            name = argv[i];
+        } else {
+            std::fprintf(stderr, "Usage: %s NAME [--seconds N] [--snapshot frame.ppm]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (name.empty()) {
+        std::fprintf(stderr, "Usage: %s NAME [--seconds N] [--snapshot frame.ppm]\n", argv[0]);
+        return 2;
+    }
+
+    SharedFrameReader reader(name);
+    SharedFrameReader::Frame frame;
+    unsigned long long frames = 0;
+    unsigned long long torn = 0;
+    unsigned long long total = 0;
+    double luma = 0;
+    const auto start = Clock::now();
+    auto reportAt = start + std::chrono::seconds(1);
+
+    while (seconds <= 0 || Clock::now() - start < std::chrono::seconds(seconds)) {
+        switch (reader.next(frame)) {
+        case SharedFrameReader::Status::Ok: {
+            const double value = meanLuma(frame);
+            if (!snapshot.empty() && reader.isIntact(frame)) {
+                std::printf("snapshot %s: %s\n", snapshot.c_str(), writeSnapshot(frame, snapshot) ? "written" : "failed");
+                snapshot.clear();
+            }
+            if (reader.isIntact(frame)) {
+                luma = value;
+                ++frames;
+            } else {
+                ++torn; // The writer lapped this reader while it was reading.
+            }
+            break;
+        }
+        case SharedFrameReader::Status::NoNewFrame:
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            break;
+        case SharedFrameReader::Status::NoWriter:
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            break;
+        }
+
+        if (Clock::now() >= reportAt) {
+            total += frames;
+            std::printf("%llu fps  %dx%d %s  frame %llu  mean luma %.1f  skipped %llu  torn %llu  retries %llu\n",
+                frames, frame.width, frame.height, SharedFrames::formatName(frame.format),
+                static_cast<unsigned long long>(frame.sequence), luma,
+                static_cast<unsigned long long>(reader.skipped()), torn, static_cast<unsigned long long>(reader.retries()));
+            std::fflush(stdout);
+            frames = 0;
+            reportAt += std::chrono::seconds(1);
+        }
+    }
+    total += frames;
+    return total > 0 ? 0 : 1;
+}
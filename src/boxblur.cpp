@@ -0,0 +1,333 @@
+#include "boxblur.h"
+#include "separablefilter.h"
+#include <cmath>
+#include <optional>
+
+namespace {
+
+// Column strips are multiples of this many pixels so the 16- and 32-byte vector loops cover them exactly.
+constexpr int stripAlignment = 32;
+
+// Widest strip: its sums (12 bytes per pixel) plus an entering, an exiting and an output row
+// (9 bytes per pixel) stay under a 32 KB L1 data cache.
+constexpr int maxStripWidth = 1024;
+
+// Rows per band target; more bands than threads keeps the pool balanced.
+constexpr int bandsPerThread = 4;
+
+// The pyramid goes down to 1/16 of the resolution, and only while the reduced radius stays this wide.
+constexpr int maxPyramidShift = 4;
+constexpr int minimumLowRadius = 4;
+
+} // namespace
+
+// Constructor: Binds the blur to a pool; scratch space is allocated on first use.
+BoxBlur::BoxBlur(ThreadPool& pool) : m_pool(pool) {
+}
+
+// stripWidth: Enough strips to give every thread work, none wider than the L1 budget.
+int BoxBlur::stripWidth(int width) const {
+    const int perThread = (width + m_pool.concurrency() - 1) / m_pool.concurrency();
+    const int aligned = (perThread + stripAlignment - 1) / stripAlignment * stripAlignment;
+    return std::clamp(aligned, stripAlignment, maxStripWidth);
+}
+
+// ensureScratch: Grows the scratch buffers; they never shrink, so steady-state frames do not allocate.
+void BoxBlur::ensureScratch(int rowBytes, int height, int bands) {
+    m_scratchStride = (rowBytes + 63) & ~63; // Row starts on a cache line.
+    const size_t scratchSize = static_cast<size_t>(m_scratchStride) * height;
+    if (m_scratch.size() < scratchSize) {
+        m_scratch.resize(scratchSize);
+    }
+    const size_t rowBufferSize = static_cast<size_t>(m_scratchStride) * bands * 2;
+    if (m_rowBuffers.size() < rowBufferSize) {
+        m_rowBuffers.resize(rowBufferSize);
+    }
+    const size_t sumsSize = static_cast<size_t>(rowBytes);
+    if (m_columnSums.size() < sumsSize) {
+        m_columnSums.resize(sumsSize);
+    }
+}
+
+// apply: A whole RGB or gray image with the same radius in both directions. The fourth byte of
+// 32-bit pixels is blurred like the others; padding and opaque alpha stay 255.
+void BoxBlur::apply(const uchar* src, int srcStride, uchar* dst, int dstStride,
+    int width, int height, int blurRadius, const ImageProcessing::PointOps* pointOps, Quality quality,
+    PixelFormat::Layout layout, FrameStatsCollector* stats) {
+    m_layout = layout;
+    blur(src, srcStride, dst, dstStride, width, height, PixelFormat::bytesPerPixel(layout), blurRadius, blurRadius, quality, pointOps, stats);
+}
+
+// applyPlane: Any interleaved byte layout; a zero radius leaves that direction unblurred.
+void BoxBlur::applyPlane(const uchar* src, int srcStride, uchar* dst, int dstStride,
+    int width, int height, int channels, int radiusX, int radiusY, Quality quality) {
+    blur(src, srcStride, dst, dstStride, width, height, channels, radiusX, radiusY, quality, nullptr);
+}
+
+// passes: One box for box quality; otherwise three boxes with the box's variance. Kernel quality
+// ends up here only beyond the exact kernel's largest radius.
+BoxBlur::Passes BoxBlur::passes(int radius, Quality quality) {
+    if (quality == Quality::Box || radius <= 0) {
+        Passes box;
+        box.radii[0] = std::max(radius, 0);
+        return box;
+    }
+    return gaussianPasses(std::sqrt(radius * (radius + 1.0) / 3.0));
+}
+
+// gaussianPasses: Three boxes of odd widths wl and wl + 2, the first m of them narrower, chosen so
+// the sum of their variances (w^2 - 1) / 12 comes closest to sigma^2.
+BoxBlur::Passes BoxBlur::gaussianPasses(double sigma) {
+    constexpr int n = 3;
+    Passes gaussian;
+    gaussian.count = n;
+    const double variance = sigma * sigma;
+    int lower = static_cast<int>(std::floor(std::sqrt(12.0 * variance / n + 1.0)));
+    if (lower % 2 == 0) {
+        --lower;
+    }
+    lower = std::max(lower, 1);
+    const int narrow = static_cast<int>(std::lround((12.0 * variance - n * lower * lower - 4.0 * n * lower - 3.0 * n) / (-4.0 * lower - 4.0)));
+    for (int pass = 0; pass < n; ++pass) {
+        const int boxWidth = pass < narrow ? lower : lower + 2;
+        gaussian.radii[pass] = (boxWidth - 1) / 2;
+    }
+    return gaussian;
+}
+
+// pyramidShift: Halves the resolution while the halved radius stays at least minimumLowRadius.
+int BoxBlur::pyramidShift(int radius) {
+    int shift = 0;
+    while (shift < maxPyramidShift && (radius >> (shift + 1)) >= minimumLowRadius) {
+        ++shift;
+    }
+    return shift;
+}
+
+// reach: Each box carries a change its radius further; the pyramid adds a block for the
+// downsample and one low-resolution pixel for the bilinear upsample. The exact kernel carries it
+// its own radius.
+int BoxBlur::reach(int radius, Quality quality, int otherRadius) {
+    if (quality == Quality::Kernel && radius <= ImageProcessing::maxKernelBlurRadius) {
+        return radius > 0 ? SeparableFilter::blurKernel(radius).radius() : 0;
+    }
+    const int shift = quality == Quality::Pyramid ? pyramidShift(std::max(radius, otherRadius)) : 0;
+    if (radius <= 0) {
+        return shift > 0 ? 2 << shift : 0; // Still downsampled and upsampled along this direction.
+    }
+    const Passes boxes = shift > 0
+        ? gaussianPasses(std::sqrt(radius * (radius + 1.0) / 3.0) / (1 << shift))
+        : passes(radius, quality == Quality::Pyramid ? Quality::Gaussian : quality);
+    int total = 0;
+    for (int pass = 0; pass < boxes.count; ++pass) {
+        total += boxes.radii[pass];
+    }
+    return shift > 0 ? (total + 2) << shift : total;
+}
+
+int BoxBlur::alignment(int radius, Quality quality, int otherRadius) {
+    return quality == Quality::Pyramid ? 1 << pyramidShift(std::max(radius, otherRadius)) : 1;
+}
+
+// blur: Picks the passes and the resolution for the quality.
+void BoxBlur::blur(const uchar* src, int srcStride, uchar* dst, int dstStride, int width, int height,
+    int channels, int radiusX, int radiusY, Quality quality, const ImageProcessing::PointOps* pointOps,
+    FrameStatsCollector* stats) {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    if (quality == Quality::Pyramid) {
+        const int shift = pyramidShift(std::max(radiusX, radiusY));
+        if (shift > 0) {
+            runPyramid(src, srcStride, dst, dstStride, width, height, channels, radiusX, radiusY, shift, pointOps, stats);
+            return;
+        }
+        quality = Quality::Gaussian; // Too small to gain from a lower resolution.
+    }
+    run(src, srcStride, dst, dstStride, width, height, channels, passes(radiusX, quality), passes(radiusY, quality), pointOps, stats);
+}
+
+// run: Horizontal pass by row bands into scratch, then vertical pass by column strips into dst.
+// The horizontal pass finishes before the vertical one writes, so src and dst may alias.
+// Repeated boxes stay inside each pass: rows ping-pong between the band's two row buffers, and
+// strips between scratch and dst, so a Gaussian costs no extra trip through memory per box.
+void BoxBlur::run(const uchar* src, int srcStride, uchar* dst, int dstStride, int width, int height,
+    int channels, const Passes& passesX, const Passes& passesY, const ImageProcessing::PointOps* pointOps,
+    FrameStatsCollector* stats) {
+    const bool hasPointOps = pointOps && !pointOps->isIdentity();
+    const int rowBytes = width * channels;
+    const int bands = std::min(height, m_pool.concurrency() * bandsPerThread);
+    const int rowsPerBand = (height + bands - 1) / bands;
+    ensureScratch(rowBytes, height, bands);
+
+    // Horizontal pass: every band works through its own rows, with its own row buffers.
+    m_pool.parallelFor(bands, [&](int band) {
+        const int begin = band * rowsPerBand;
+        const int end = std::min(begin + rowsPerBand, height);
+        uchar* rowBuffers[2] = {
+            m_rowBuffers.data() + static_cast<size_t>(band) * 2 * m_scratchStride,
+            m_rowBuffers.data() + (static_cast<size_t>(band) * 2 + 1) * m_scratchStride,
+        };
+        std::optional<FrameStats> bandStats; // Only bands with sampled rows pay for the histograms.
+        for (int y = begin; y < end; ++y) {
+            const uchar* row = src + static_cast<ptrdiff_t>(y) * srcStride;
+            uchar* out = m_scratch.data() + static_cast<size_t>(y) * m_scratchStride;
+            if (stats && stats->wantsRow(y)) {
+                (bandStats ? *bandStats : bandStats.emplace()).addRow(row, width, m_layout, stats->step());
+            }
+            if (hasPointOps) {
+                ImageProcessing::pointOpsRow(row, rowBuffers[0], width, *pointOps, m_layout);
+                row = rowBuffers[0];
+            }
+            for (int pass = 0; pass < passesX.count; ++pass) {
+                // The last box lands in scratch; the others in whichever row buffer is not being read.
+                uchar* target = pass + 1 == passesX.count ? out : (row == rowBuffers[0] ? rowBuffers[1] : rowBuffers[0]);
+                if (passesX.radii[pass] > 0) {
+                    ImageProcessing::horizontalBlurRow(row, target, width, passesX.radii[pass], channels);
+                } else {
+                    std::memcpy(target, row, rowBytes);
+                }
+                row = target;
+            }
+        }
+        if (bandStats) {
+            stats->add(*bandStats);
+        }
+    });
+
+    // Vertical pass: each strip slides its own slice of column sums down the whole image.
+    const int strip = stripWidth(width);
+    const int strips = (width + strip - 1) / strip;
+    m_pool.parallelFor(strips, [&](int index) {
+        const int x = index * strip;
+        const int columns = std::min(strip, width - x);
+        uchar* scratch = m_scratch.data() + x * channels;
+        uchar* out = dst + x * channels;
+        for (int pass = 0; pass < passesY.count; ++pass) {
+            const bool fromScratch = pass % 2 == 0;
+            ImageProcessing::verticalBlur(fromScratch ? scratch : out, fromScratch ? m_scratchStride : dstStride,
+                fromScratch ? out : scratch, fromScratch ? dstStride : m_scratchStride,
+                columns, height, passesY.radii[pass], m_columnSums.data() + x * channels, channels);
+        }
+        if (passesY.count % 2 == 0) { // An even number of boxes ends in scratch.
+            for (int y = 0; y < height; ++y) {
+                std::memcpy(out + static_cast<ptrdiff_t>(y) * dstStride, scratch + static_cast<size_t>(y) * m_scratchStride,
+                    static_cast<size_t>(columns) * channels);
+            }
+        }
+    });
+}
+
+// runPyramid: Averages blocks of 2^shift pixels into a low-resolution copy, blurs that with the
+// Gaussian at the reduced radius and upsamples it bilinearly into dst. The work at full resolution
+// is one read and one write per pixel whatever the radius; the blur itself only sees 1 / 4^shift
+// of the pixels. src and dst may alias: the downsample is done before the upsample writes.
+void BoxBlur::runPyramid(const uchar* src, int srcStride, uchar* dst, int dstStride, int width, int height,
+    int channels, int radiusX, int radiusY, int shift, const ImageProcessing::PointOps* pointOps,
+    FrameStatsCollector* stats) {
+    const bool hasPointOps = pointOps && !pointOps->isIdentity();
+    const int factor = 1 << shift;
+    const int lowWidth = (width + factor - 1) >> shift;
+    const int lowHeight = (height + factor - 1) >> shift;
+    const int lowRowBytes = lowWidth * channels;
+    const int lowStride = (lowRowBytes + 63) & ~63;
+    const int rowBytes = width * channels;
+    const int rowStride = (rowBytes + 63) & ~63;
+
+    const int bands = std::min(std::max(lowHeight, height), m_pool.concurrency() * bandsPerThread);
+    if (m_pyramid.size() < static_cast<size_t>(lowStride) * lowHeight) {
+        m_pyramid.resize(static_cast<size_t>(lowStride) * lowHeight);
+    }
+    if (m_pyramidRows.size() < static_cast<size_t>(rowStride) * bands) {
+        m_pyramidRows.resize(static_cast<size_t>(rowStride) * bands);
+    }
+    if (m_pyramidSums.size() < static_cast<size_t>(lowRowBytes) * bands) {
+        m_pyramidSums.resize(static_cast<size_t>(lowRowBytes) * bands);
+    }
+
+    // Downsample: every low row sums its block of source rows, with the point operations applied on the way.
+    const int lowBands = std::min(lowHeight, bands);
+    const int lowRowsPerBand = (lowHeight + lowBands - 1) / lowBands;
+    m_pool.parallelFor(lowBands, [&](int band) {
+        uchar* rowBuffer = m_pyramidRows.data() + static_cast<size_t>(band) * rowStride;
+        int* sums = m_pyramidSums.data() + static_cast<size_t>(band) * lowRowBytes;
+        const int end = std::min((band + 1) * lowRowsPerBand, lowHeight);
+        std::optional<FrameStats> bandStats; // Only bands with sampled rows pay for the histograms.
+        for (int ly = band * lowRowsPerBand; ly < end; ++ly) {
+            std::fill(sums, sums + lowRowBytes, 0);
+            const int rowEnd = std::min((ly + 1) << shift, height);
+            for (int y = ly << shift; y < rowEnd; ++y) {
+                const uchar* row = src + static_cast<ptrdiff_t>(y) * srcStride;
+                if (stats && stats->wantsRow(y)) {
+                    (bandStats ? *bandStats : bandStats.emplace()).addRow(row, width, m_layout, stats->step());
+                }
+                if (hasPointOps) {
+                    ImageProcessing::pointOpsRow(row, rowBuffer, width, *pointOps, m_layout);
+                    row = rowBuffer;
+                }
+                for (int x = 0; x < width; ++x) {
+                    int* sum = sums + (x >> shift) * channels;
+                    const uchar* pixel = row + x * channels;
+                    for (int c = 0; c < channels; ++c) {
+                        sum[c] += pixel[c];
+                    }
+                }
+            }
+            const int blockRows = rowEnd - (ly << shift);
+            uchar* out = m_pyramid.data() + static_cast<size_t>(ly) * lowStride;
+            for (int lx = 0; lx < lowWidth; ++lx) {
+                const int count = (std::min((lx + 1) << shift, width) - (lx << shift)) * blockRows;
+                for (int c = 0; c < channels; ++c) {
+                    out[lx * channels + c] = static_cast<uchar>((sums[lx * channels + c] + count / 2) / count);
+                }
+            }
+        }
+        if (bandStats) {
+            stats->add(*bandStats);
+        }
+    });
+
+    // The Gaussian at the low resolution, in place; its sigma shrinks with the image.
+    const auto lowPasses = [&](int radius) {
+        return radius > 0 ? gaussianPasses(std::sqrt(radius * (radius + 1.0) / 3.0) / factor) : passes(0, Quality::Box);
+    };
+    run(m_pyramid.data(), lowStride, m_pyramid.data(), lowStride, lowWidth, lowHeight, channels,
+        lowPasses(radiusX), lowPasses(radiusY), nullptr);
+
+    // Upsample: sample centers line up, (x + 0.5) / factor - 0.5 in low coordinates, 8-bit weights.
+    const auto sourcePosition = [&](int x, int lowSize, int& left, int& weight) {
+        const int position = std::max(((2 * x + 1) * 256 >> (shift + 1)) - 128, 0); // In 1/256 low pixels.
+        left = std::min(position >> 8, lowSize - 1);
+        weight = left + 1 < lowSize ? position & 255 : 0;
+    };
+    if (m_upsampleX.size() < static_cast<size_t>(width) * 2) {
+        m_upsampleX.resize(static_cast<size_t>(width) * 2);
+    }
+    for (int x = 0; x < width; ++x) {
+        sourcePosition(x, lowWidth, m_upsampleX[x * 2], m_upsampleX[x * 2 + 1]);
+    }
+    const int rowsPerBand = (height + bands - 1) / bands;
+    m_pool.parallelFor(bands, [&](int band) {
+        int* column = m_pyramidSums.data() + static_cast<size_t>(band) * lowRowBytes; // Vertically interpolated low row, x256.
+        const int end = std::min((band + 1) * rowsPerBand, height);
+        for (int y = band * rowsPerBand; y < end; ++y) {
+            int top = 0;
+            int weightY = 0;
+            sourcePosition(y, lowHeight, top, weightY);
+            const uchar* upper = m_pyramid.data() + static_cast<size_t>(top) * lowStride;
+            const uchar* lower = weightY ? upper + lowStride : upper;
+            for (int i = 0; i < lowRowBytes; ++i) {
+                column[i] = upper[i] * (256 - weightY) + lower[i] * weightY;
+            }
+            uchar* out = dst + static_cast<ptrdiff_t>(y) * dstStride;
+            for (int x = 0; x < width; ++x) {
+                const int* left = column + m_upsampleX[x * 2] * channels;
+                const int* right = m_upsampleX[x * 2 + 1] ? left + channels : left;
+                const int weightX = m_upsampleX[x * 2 + 1];
+                for (int c = 0; c < channels; ++c) {
+                    out[x * channels + c] = static_cast<uchar>((left[c] * (256 - weightX) + right[c] * weightX + 32768) >> 16);
+                }
+            }
+        }
+    });
+}
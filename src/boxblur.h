@@ -0,0 +1,80 @@
+#pragma once
+
+#include "imageprocessing.h"
+#include "framestats.h"
+#include "threadpool.h"
+#include <array>
+#include <vector>
+
+// BoxBlur: Separable box blur spread over a thread pool.
+// The horizontal pass is split into bands of rows. The vertical pass is split into strips of
+// adjacent columns narrow enough that a strip's running sums stay in L1 while its rows stream
+// through. Intermediate data lives in scratch buffers that are reused from call to call.
+// Gaussian quality runs three boxes in each direction within the same two passes; pyramid
+// quality runs that on a copy downsampled by a power of two and upsamples the result.
+class BoxBlur {
+public:
+    using Quality = ImageProcessing::BlurQuality;
+
+    explicit BoxBlur(ThreadPool& pool = ThreadPool::global());
+
+    // Blurs src into dst, both in layout. If pointOps is given, it is applied to each source row
+    // as the horizontal pass reads it; if stats is given, the rows it wants are sampled there too,
+    // before the point operations. src and dst may be the same buffer.
+    void apply(const uchar* src, int srcStride, uchar* dst, int dstStride,
+        int width, int height, int blurRadius, const ImageProcessing::PointOps* pointOps = nullptr,
+        Quality quality = Quality::Box, PixelFormat::Layout layout = PixelFormat::Layout::Rgb888,
+        FrameStatsCollector* stats = nullptr);
+
+    // Blurs one plane of channels interleaved bytes per pixel (a Y plane, an NV12 UV plane, YUY2
+    // macropixels), with separate horizontal and vertical radii for subsampled planes.
+    void applyPlane(const uchar* src, int srcStride, uchar* dst, int dstStride,
+        int width, int height, int channels, int radiusX, int radiusY, Quality quality = Quality::Box);
+
+    // Strip width of the vertical pass, in pixels, for a given image width.
+    int stripWidth(int width) const;
+
+    // Passes: The box radii run one after another in one direction.
+    struct Passes {
+        int count = 1;
+        std::array<int, 3> radii{};
+    };
+    // Box radii for a radius at a quality. Gaussian returns three boxes whose combined variance
+    // matches the single box's, r(r + 1) / 3.
+    static Passes passes(int radius, Quality quality);
+    static Passes gaussianPasses(double sigma);
+    // Downsampling factor of the pyramid for a radius, as a shift: the low-resolution copy keeps a
+    // radius of at least a few pixels, so the bilinear upsample does not show.
+    static int pyramidShift(int radius);
+
+    // How far, in elements, a blur at this radius and quality carries a change along one direction,
+    // and the grid a region has to start on to blur like the same pixels of the whole frame (the
+    // pyramid's block size). A region grown by reach and aligned to alignment reproduces the
+    // whole-frame result inside the original region. otherRadius is the radius across, which the
+    // pyramid's factor also depends on.
+    static int reach(int radius, Quality quality, int otherRadius = 0);
+    static int alignment(int radius, Quality quality, int otherRadius = 0);
+
+private:
+    void blur(const uchar* src, int srcStride, uchar* dst, int dstStride, int width, int height,
+        int channels, int radiusX, int radiusY, Quality quality, const ImageProcessing::PointOps* pointOps,
+        FrameStatsCollector* stats = nullptr);
+    void run(const uchar* src, int srcStride, uchar* dst, int dstStride, int width, int height,
+        int channels, const Passes& passesX, const Passes& passesY, const ImageProcessing::PointOps* pointOps,
+        FrameStatsCollector* stats = nullptr);
+    void runPyramid(const uchar* src, int srcStride, uchar* dst, int dstStride, int width, int height,
+        int channels, int radiusX, int radiusY, int shift, const ImageProcessing::PointOps* pointOps,
+        FrameStatsCollector* stats = nullptr);
+    void ensureScratch(int rowBytes, int height, int bands);
+
+    ThreadPool& m_pool;
+    PixelFormat::Layout m_layout = PixelFormat::Layout::Rgb888; // Of the rows the point operations see; set by apply.
+    std::vector<uchar> m_scratch; // Horizontal pass output.
+    int m_scratchStride = 0;
+    std::vector<uchar> m_rowBuffers; // Two rows per band for the fused point operations and repeated boxes.
+    std::vector<int> m_columnSums; // Running sums; every strip owns a disjoint slice.
+    std::vector<uchar> m_pyramid; // Downsampled copy.
+    std::vector<uchar> m_pyramidRows; // One full-resolution row per band for the point operations.
+    std::vector<int> m_pyramidSums; // One low-resolution row of sums per band.
+    std::vector<int> m_upsampleX; // Per output column: left source element and weight, interleaved.
+};
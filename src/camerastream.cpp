@@ -0,0 +1,76 @@
+#include "camerastream.h"
+
+// Constructor: Wires capture to processing and processing to recording; the view is connected by the owner.
+CameraStream::CameraStream(const QString& source, ThreadPool& pool, QObject* parent)
+    : QObject(parent), m_processor(&pool) {
+    if (!source.isEmpty()) {
+        m_handler.setSource(source);
+    }
+    // Frames go straight from the streaming thread into the processor's mailbox.
+    connect(&m_handler, &GStreamerHandler::newFrame, &m_processor, &FrameProcessor::submitFrame, Qt::DirectConnection);
+    // The recorder takes each processed frame by reference on the processing thread and never blocks it.
+    connect(&m_processor, &FrameProcessor::frameProcessed, &m_recorder, &Recorder::pushFrame, Qt::DirectConnection);
+    // So does the shared-memory export, which does nothing until it is started.
+    connect(&m_processor, &FrameProcessor::frameProcessed, this, [this](const VideoFrame& frame) {
+        m_exporter.pushFrame(frame);
+    }, Qt::DirectConnection);
+    // Stills skip the processor: they are queued straight from the stills branch to the encoders.
+    connect(&m_handler, &GStreamerHandler::stillCaptured, this, [this](const VideoFrame& frame) {
+        m_snapshots.submit(frame);
+    }, Qt::DirectConnection);
+}
+
+// Destructor: Stops in the same order as stop().
+CameraStream::~CameraStream() {
+    stop();
+}
+
+// start: Starts processing before capture, so the first frames find the processor ready. The
+// pipeline comes up on the handler's control thread; failures arrive through its error signal.
+void CameraStream::start() {
+    m_tracer.startRecording(); // Keeps the session's frame timings for export.
+    m_processor.start();
+    m_handler.startPipelineAsync();
+}
+
+// stop: Stops processing first; under a lossless policy the streaming thread may be waiting on it,
+// and the pipeline can only stop once that thread is released.
+void CameraStream::stop() {
+    m_processor.stop();
+    m_handler.stopPipeline();
+    m_recorder.stop();
+    m_exporter.stop();
+}
+
+void CameraStream::captureStills(int count, SnapshotSettings settings) {
+    if (settings.applyEffects) {
+        settings.effects = m_processor.settings();
+        if (settings.effects.autoBrightness) {
+            // Stills get the brightness the preview shows, not one of their own.
+            settings.effects.brightnessEnabled = true;
+            settings.effects.brightnessValue = m_processor.autoBrightnessValue();
+        }
+    }
+    m_snapshots.setSettings(settings);
+    m_handler.captureStills(count);
+}
+
+void CameraStream::setDisplaySize(const QSize& size) {
+    m_handler.setOutputSize(size);
+    m_processor.setDisplaySize(size);
+}
+
+// setRegionOfInterest: A crop in the pipeline spares videoscale, the conversion and the effects the
+// rest of the frame. Without videocrop the processor restricts the effects to the region instead,
+// which still leaves the rest of the frame untouched after the appsink.
+void CameraStream::setRegionOfInterest(const RegionOfInterest& region) {
+    const bool inPipeline = GStreamerHandler::canCrop();
+    m_handler.setRegionOfInterest(inPipeline ? region : RegionOfInterest());
+    m_processor.setRegionOfInterest(inPipeline ? RegionOfInterest() : region);
+}
+
+// setDropPolicy: The pipeline and the processor share the policy, so every stage drops or blocks alike.
+void CameraStream::setDropPolicy(const DropPolicy& policy) {
+    m_processor.setDropPolicy(policy);
+    m_handler.setDropPolicy(policy);
+}
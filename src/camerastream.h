@@ -0,0 +1,58 @@
+#pragma once
+
+#include "gstreamerhandler.h"
+#include "frameprocessor.h"
+#include "frametracer.h"
+#include "recorder.h"
+#include "sharedframewriter.h"
+#include "snapshotencoder.h"
+#include "droppolicy.h"
+#include "threadpool.h"
+#include <QObject>
+#include <QSize>
+#include <QString>
+
+// CameraStream: One camera from capture to processed frames. A GStreamerHandler feeds a
+// FrameProcessor whose effects run as tasks on a shared ThreadPool, so any number of streams
+// share the same cores. Each stream has its own Recorder, SharedFrameWriter, SnapshotEncoder and
+// FrameTracer, so fps and latency can be compared stream by stream.
+class CameraStream : public QObject {
+    Q_OBJECT
+
+public:
+    // source is the part of the pipeline before videoconvert, e.g. "v4l2src device=/dev/video0";
+    // empty keeps GStreamerHandler's default camera.
+    explicit CameraStream(const QString& source, ThreadPool& pool = ThreadPool::global(), QObject* parent = nullptr);
+    ~CameraStream() override;
+
+    QString source() const { return m_handler.source(); }
+
+    GStreamerHandler& handler() { return m_handler; }
+    FrameProcessor& processor() { return m_processor; }
+    Recorder& recorder() { return m_recorder; }
+    SharedFrameWriter& exporter() { return m_exporter; }
+    SnapshotEncoder& snapshots() { return m_snapshots; }
+    FrameTracer& tracer() { return m_tracer; }
+
+    void start();
+    void stop();
+
+    // Frames are scaled in the pipeline and converted to RGB at this size.
+    void setDisplaySize(const QSize& size);
+    void setDropPolicy(const DropPolicy& policy);
+    // Digital zoom: only region is processed and shown, cropped in the pipeline when it can be.
+    void setRegionOfInterest(const RegionOfInterest& region);
+
+    // Writes the next count frames at the camera's resolution as settings says. With applyEffects,
+    // the stills get the effects the processor is running now.
+    void captureStills(int count, SnapshotSettings settings);
+
+private:
+    // Declared so destruction runs downstream first: nothing is left feeding a destroyed member.
+    FrameTracer m_tracer;
+    Recorder m_recorder;
+    SharedFrameWriter m_exporter;
+    SnapshotEncoder m_snapshots;
+    FrameProcessor m_processor;
+    GStreamerHandler m_handler;
+};
@@ -0,0 +1,121 @@
+#include "dirtytiles.h"
+#include "imageprocessing.h"
+#include <algorithm>
+#include <cstring>
+
+// Constructor: Binds the comparison to a pool; the reference is allocated with the first frame.
+DirtyTiles::DirtyTiles(ThreadPool& pool) : m_pool(pool) {
+}
+
+void DirtyTiles::setTileSize(int pixels) {
+    const int size = std::max((pixels + 1) & ~1, 2);
+    if (size != m_tileSize) {
+        m_tileSize = size;
+        reset();
+    }
+}
+
+void DirtyTiles::setThreshold(int threshold) {
+    m_threshold = std::max(threshold, 0);
+}
+
+void DirtyTiles::reset() {
+    m_valid = false;
+}
+
+// update: One pass over the frame by tile rows. Every tile row sums its tiles' differences row by
+// row, then refreshes the reference of the tiles that crossed the threshold.
+int DirtyTiles::update(const uchar* bits, int stride, int width, int height, int bytesPerPixel, int halo) {
+    if (!m_valid || width != m_width || height != m_height || bytesPerPixel != m_bytesPerPixel) {
+        m_width = width;
+        m_height = height;
+        m_bytesPerPixel = bytesPerPixel;
+        m_columns = (width + m_tileSize - 1) / m_tileSize;
+        m_rows = (height + m_tileSize - 1) / m_tileSize;
+        m_referenceStride = (width * bytesPerPixel + 63) & ~63;
+        m_reference.resize(static_cast<size_t>(m_referenceStride) * height);
+        m_changed.assign(static_cast<size_t>(count()), 1);
+        m_grown.assign(static_cast<size_t>(count()), 1);
+        m_dirty.assign(static_cast<size_t>(count()), 1);
+        m_sums.resize(static_cast<size_t>(count()));
+        for (int y = 0; y < height; ++y) {
+            std::memcpy(m_reference.data() + static_cast<size_t>(y) * m_referenceStride,
+                bits + static_cast<ptrdiff_t>(y) * stride, static_cast<size_t>(width) * bytesPerPixel);
+        }
+        m_valid = true;
+        m_dirtyCount = count();
+        return m_dirtyCount;
+    }
+
+    const int tileBytes = m_tileSize * bytesPerPixel;
+    m_pool.parallelFor(m_rows, [&](int row) {
+        const int top = row * m_tileSize;
+        const int bottom = std::min(top + m_tileSize, height);
+        uchar* changed = m_changed.data() + static_cast<size_t>(row) * m_columns;
+        qint64* sums = m_sums.data() + static_cast<size_t>(row) * m_columns; // Each tile row owns a slice.
+        std::fill(sums, sums + m_columns, 0);
+        for (int y = top; y < bottom; ++y) {
+            const uchar* current = bits + static_cast<ptrdiff_t>(y) * stride;
+            const uchar* reference = m_reference.data() + static_cast<size_t>(y) * m_referenceStride;
+            for (int column = 0; column < m_columns; ++column) {
+                const int offset = column * tileBytes;
+                const int bytes = std::min(tileBytes, width * bytesPerPixel - offset);
+                sums[column] += ImageProcessing::sumAbsDiff(current + offset, reference + offset, bytes);
+            }
+        }
+        for (int column = 0; column < m_columns; ++column) {
+            const int left = column * m_tileSize;
+            const qint64 tileArea = static_cast<qint64>(std::min(m_tileSize, width - left)) * (bottom - top) * bytesPerPixel;
+            changed[column] = sums[column] > m_threshold * tileArea ? 1 : 0;
+            if (!changed[column]) {
+                continue;
+            }
+            const int offset = column * tileBytes;
+            const int bytes = std::min(tileBytes, width * bytesPerPixel - offset);
+            for (int y = top; y < bottom; ++y) {
+                std::memcpy(m_reference.data() + static_cast<size_t>(y) * m_referenceStride + offset,
+                    bits + static_cast<ptrdiff_t>(y) * stride + offset, bytes);
+            }
+        }
+    });
+
+    // Grow by the halo in tiles: a changed tile alters the output of every tile its blur reaches.
+    const int reach = (std::max(halo, 0) + m_tileSize - 1) / m_tileSize;
+    for (int row = 0; row < m_rows; ++row) {
+        for (int column = 0; column < m_columns; ++column) {
+            uchar any = 0;
+            for (int c = std::max(column - reach, 0); c <= std::min(column + reach, m_columns - 1) && !any; ++c) {
+                any = m_changed[static_cast<size_t>(row) * m_columns + c];
+            }
+            m_grown[static_cast<size_t>(row) * m_columns + column] = any;
+        }
+    }
+    m_dirtyCount = 0;
+    for (int row = 0; row < m_rows; ++row) {
+        for (int column = 0; column < m_columns; ++column) {
+            uchar any = 0;
+            for (int r = std::max(row - reach, 0); r <= std::min(row + reach, m_rows - 1) && !any; ++r) {
+                any = m_grown[static_cast<size_t>(r) * m_columns + column];
+            }
+            m_dirty[static_cast<size_t>(row) * m_columns + column] = any;
+            m_dirtyCount += any;
+        }
+    }
+    return m_dirtyCount;
+}
+
+int DirtyTiles::merge(const DirtyTiles& other) {
+    Q_ASSERT(other.m_columns == m_columns && other.m_rows == m_rows);
+    m_dirtyCount = 0;
+    for (size_t tile = 0; tile < m_dirty.size(); ++tile) {
+        m_dirty[tile] |= other.m_dirty[tile];
+        m_dirtyCount += m_dirty[tile];
+    }
+    return m_dirtyCount;
+}
+
+QRect DirtyTiles::rect(int firstColumn, int firstRow, int lastColumn, int lastRow) const {
+    const QRect tiles(firstColumn * m_tileSize, firstRow * m_tileSize,
+        (lastColumn - firstColumn + 1) * m_tileSize, (lastRow - firstRow + 1) * m_tileSize);
+    return tiles.intersected(QRect(0, 0, m_width, m_height));
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "threadpool.h"
+#include <QRect>
+#include <QtGlobal>
+#include <vector>
+
+// DirtyTiles: Change detection for incremental processing. A frame is split into square tiles and
+// each tile is compared with a reference copy of the input it was last processed from, by the sum of
+// absolute differences. Only tiles that changed take the new input as their reference, so slow drift
+// still adds up until it crosses the threshold instead of being lost frame by frame.
+class DirtyTiles {
+public:
+    explicit DirtyTiles(ThreadPool& pool = ThreadPool::global());
+
+    // Tile edge in pixels; even, so tiles line up with subsampled chroma. Resets the reference.
+    void setTileSize(int pixels);
+    int tileSize() const { return m_tileSize; }
+
+    // Mean absolute difference per byte above which a tile counts as changed; 0 catches any change.
+    void setThreshold(int threshold);
+    int threshold() const { return m_threshold; }
+
+    // Forgets the reference, so the next update marks every tile.
+    void reset();
+
+    // Compares a frame with the reference, marks the changed tiles and every tile within halo pixels
+    // of one, and returns how many are marked. A new frame size marks everything.
+    int update(const uchar* bits, int stride, int width, int height, int bytesPerPixel, int halo);
+    // Also marks the tiles other marked, for a plane tracked on the same grid (a chroma plane with
+    // half the tile size); returns the new count.
+    int merge(const DirtyTiles& other);
+
+    int columns() const { return m_columns; }
+    int rows() const { return m_rows; }
+    int count() const { return m_columns * m_rows; }
+    int dirtyCount() const { return m_dirtyCount; }
+    bool isDirty(int column, int row) const { return m_dirty[static_cast<size_t>(row) * m_columns + column] != 0; }
+
+    // Pixels covered by tiles [firstColumn, lastColumn] x [firstRow, lastRow], clipped to the frame.
+    QRect rect(int firstColumn, int firstRow, int lastColumn, int lastRow) const;
+
+private:
+    ThreadPool& m_pool;
+    int m_tileSize = 32;
+    int m_threshold = 2;
+    int m_width = 0;
+    int m_height = 0;
+    int m_bytesPerPixel = 0;
+    int m_columns = 0;
+    int m_rows = 0;
+    int m_dirtyCount = 0;
+    bool m_valid = false; // The reference holds a whole frame of the current size.
+    std::vector<uchar> m_reference;
+    int m_referenceStride = 0;
+    std::vector<qint64> m_sums; // Per tile, this frame's sum of absolute differences.
+    std::vector<uchar> m_changed; // Per tile, before growing by the halo.
+    std::vector<uchar> m_grown; // Changed tiles grown horizontally.
+    std::vector<uchar> m_dirty;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QString>
+
+// DropPolicy: What happens to frames when a stage downstream of the camera falls behind.
+// The same policy configures the queue in front of the appsink, the appsink itself and
+// the handoffs from the streaming thread to the effects worker and on to the GUI thread.
+struct DropPolicy {
+    enum Mode {
+        LatestOnly, // One frame per stage; a newer frame replaces an older one. Lowest latency.
+        BoundedQueue, // Up to depth frames per stage; when full the oldest frame is dropped.
+        Lossless, // Up to depth frames per stage; when full the producer waits, back to the camera.
+    };
+
+    Mode mode = LatestOnly;
+    int depth = 3; // Frames each stage may hold; LatestOnly always uses 1.
+
+    // Frames a stage may hold under this policy.
+    int capacity() const { return mode == LatestOnly ? 1 : (depth > 0 ? depth : 1); }
+    bool drops() const { return mode != Lossless; }
+
+    // "latest", "queue=N" or "lossless"; anything else is LatestOnly.
+    static DropPolicy fromString(const QString& text) {
+        DropPolicy policy;
+        const QString name = text.section('=', 0, 0).trimmed();
+        const int depth = text.section('=', 1, 1).toInt();
+        if (name == QLatin1String("queue")) {
+            policy.mode = BoundedQueue;
+        } else if (name == QLatin1String("lossless")) {
+            policy.mode = Lossless;
+        }
+        if (depth > 0) {
+            policy.depth = depth;
+        }
+        return policy;
+    }
+
+    QString toString() const {
+        switch (mode) {
+        case BoundedQueue: return QStringLiteral("queue=%1").arg(capacity());
+        case Lossless: return QStringLiteral("lossless=%1").arg(capacity());
+        default: return QStringLiteral("latest");
+        }
+    }
+
+    bool operator==(const DropPolicy&) const = default;
+};
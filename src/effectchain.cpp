@@ -0,0 +1,573 @@
+#include "effectchain.h"
+#include "framebufferpool.h"
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+namespace {
+
+// Above this fraction of dirty tiles the halos overlap so much that one whole-frame pass is cheaper.
+constexpr int maxIncrementalPercent = 60;
+
+// Brightness on the Y bytes of a YUY2 row (Y0 U Y1 V); chroma passes through.
+void yuy2LumaRow(const uchar* src, uchar* dst, int macropixels, const ImageProcessing::PointOps& ops) {
+    for (int i = 0; i < macropixels * 4; i += 2) {
+        dst[i] = ops.lut[src[i]];
+        dst[i + 1] = src[i + 1];
+    }
+}
+
+// The Y bytes of a YUY2 row through the brightness table, as a Gray8 row.
+void yuy2ExtractLumaRow(const uchar* src, uchar* dst, int width, const ImageProcessing::PointOps& ops) {
+    for (int x = 0; x < width; ++x) {
+        dst[x] = ops.lut[src[x * 2]];
+    }
+}
+
+// Address of a pixel in rows of bytes-per-pixel pixels.
+template <typename Byte>
+Byte* pixelAt(Byte* bits, int stride, int bytes, const QPoint& point) {
+    return bits + static_cast<ptrdiff_t>(point.y()) * stride + point.x() * bytes;
+}
+
+// Copies size pixels of rows of bytes-per-pixel pixels.
+void copyPixels(const uchar* src, int srcStride, uchar* dst, int dstStride, int bytes, const QSize& size) {
+    for (int y = 0; y < size.height(); ++y) {
+        std::memcpy(dst + static_cast<ptrdiff_t>(y) * dstStride, src + static_cast<ptrdiff_t>(y) * srcStride,
+            static_cast<size_t>(size.width()) * bytes);
+    }
+}
+
+// Copies every plane of one YUV image to another of the same format and size.
+void copyYuv(const YuvImage& src, YuvImage& dst) {
+    for (int plane = 0; plane < src.planeCount(); ++plane) {
+        const QSize size = src.planeSize(plane);
+        const size_t rowBytes = static_cast<size_t>(size.width()) * src.planeChannels(plane);
+        for (int y = 0; y < size.height(); ++y) {
+            std::memcpy(dst.plane(plane) + static_cast<ptrdiff_t>(y) * dst.stride(plane),
+                src.constPlane(plane) + static_cast<ptrdiff_t>(y) * src.stride(plane), rowBytes);
+        }
+    }
+}
+
+// growRegion: A dirty rect plus every pixel the blur reads to compute it, on the given grid.
+QRect growRegion(const QRect& rect, int reach, int alignment, const QSize& frame) {
+    const int left = std::max(rect.left() - reach, 0) / alignment * alignment;
+    const int top = std::max(rect.top() - reach, 0) / alignment * alignment;
+    const int right = std::min((rect.left() + rect.width() + reach + alignment - 1) / alignment * alignment, frame.width());
+    const int bottom = std::min((rect.top() + rect.height() + reach + alignment - 1) / alignment * alignment, frame.height());
+    return QRect(left, top, right - left, bottom - top);
+}
+
+// imageView: rect of image without a copy; the view keeps image's buffer alive.
+QImage imageView(const QImage& image, const QRect& rect) {
+    if (rect == image.rect()) {
+        return image;
+    }
+    auto* owner = new QImage(image);
+    return QImage(pixelAt(owner->constBits(), static_cast<int>(owner->bytesPerLine()), owner->depth() / 8, rect.topLeft()),
+        rect.width(), rect.height(), owner->bytesPerLine(), owner->format(),
+        [](void* info) { delete static_cast<QImage*>(info); }, owner);
+}
+
+} // namespace
+
+// configure: Compiles the settings into a lookup table, a blur radius and a detail filter, only
+// when they changed. Edges are taken of the grayscale image, so they force grayscale.
+void EffectChain::configure(const EffectSettings& settings) {
+    if (m_configured && settings == m_settings) {
+        return; // Same parameters as the last frame; keep the compiled chain.
+    }
+    m_settings = settings;
+    m_configured = true;
+
+    // Brightness of zero is an identity, exactly as in ImageProcessing::adjustBrightness.
+    const int brightness = settings.brightnessEnabled ? settings.brightnessValue : 0;
+    m_detail = settings.detailFilter;
+    if (m_detail != ImageProcessing::DetailFilter::Edges && settings.detailAmount <= 0) {
+        m_detail = ImageProcessing::DetailFilter::None;
+    }
+    m_detailAmount = settings.detailAmount;
+    m_detailRadius = std::clamp(settings.detailRadius, 1, ImageProcessing::maxKernelBlurRadius);
+    const bool edges = m_detail == ImageProcessing::DetailFilter::Edges;
+    m_pointOps = ImageProcessing::PointOps::create(settings.grayscaleEnabled || edges, brightness);
+    m_lumaOps = ImageProcessing::PointOps::create(false, brightness);
+    m_blurRadius = settings.blurEnabled ? std::max(settings.blurValue, 0) : 0;
+    m_blurQuality = settings.blurQuality;
+
+    // Previous results were made with other settings; the next frame is processed whole.
+    m_tiles.setThreshold(settings.changeThreshold);
+    m_tiles.reset();
+    for (DirtyTiles& tiles : m_chromaTiles) {
+        tiles.setTileSize(m_tiles.tileSize() / 2);
+        tiles.setThreshold(settings.changeThreshold);
+        tiles.reset();
+    }
+    m_previousOutput = QImage();
+    m_previousYuv = YuvImage();
+}
+
+// process: Runs the compiled chain into a recycled destination buffer.
+QImage EffectChain::process(const QImage& input) {
+    m_tileStats = TileStats();
+    if (m_statsEnabled) {
+        m_stats = FrameStats();
+    }
+    if (input.isNull() || !isActive()) {
+        if (m_statsEnabled && !input.isNull() && PixelFormat::layoutOf(input.format()) != PixelFormat::Layout::Unsupported) {
+            m_stats = FrameStats::sample(input.constBits(), static_cast<int>(input.bytesPerLine()), input.width(), input.height(),
+                PixelFormat::layoutOf(input.format()));
+        }
+        return input; // Nothing to do; hand the frame through without touching it.
+    }
+
+    // The kernels work on every PixelFormat layout; other formats are converted to RGB888 once up front.
+    const QImage source = PixelFormat::layoutOf(input.format()) != PixelFormat::Layout::Unsupported
+        ? input
+        : input.convertToFormat(QImage::Format_RGB888);
+    if (m_settings.incremental) {
+        // Clean tiles are never read, so the grid is sampled on its own.
+        if (m_statsEnabled) {
+            m_stats = FrameStats::sample(source.constBits(), static_cast<int>(source.bytesPerLine()), source.width(), source.height(),
+                PixelFormat::layoutOf(source.format()));
+        }
+        return processIncremental(source);
+    }
+    const int width = source.width();
+    const int height = source.height();
+
+    // A pooled buffer in the frame's own format; it returns to the pool once the view has let go of the frame.
+    QImage output = FrameBufferPool::global().acquire(QSize(width, height), source.format());
+    // The buffer is not shared, so bits() does not detach.
+    processInto(source.constBits(), static_cast<int>(source.bytesPerLine()), output.bits(), static_cast<int>(output.bytesPerLine()),
+        width, height, PixelFormat::layoutOf(source.format()), m_statsEnabled ? &m_stats : nullptr);
+    return output;
+}
+
+// process: The grown region is aligned like an incremental one, so even the pyramid blur computes
+// the ROI's pixels exactly as it would in the whole frame.
+QImage EffectChain::process(const QImage& input, const QRect& roi) {
+    const QRect rect = roi & input.rect();
+    if (rect.isEmpty() || rect == input.rect()) {
+        return process(input);
+    }
+    // Views need whole bytes per pixel; other formats are converted to RGB888 once up front.
+    const QImage source = PixelFormat::layoutOf(input.format()) != PixelFormat::Layout::Unsupported
+        ? input
+        : input.convertToFormat(QImage::Format_RGB888);
+    const QRect region = growRegion(rect, BoxBlur::reach(m_blurRadius, m_blurQuality) + detailReach(),
+        BoxBlur::alignment(m_blurRadius, m_blurQuality), source.size());
+    return imageView(process(imageView(source, region)), rect.translated(-region.topLeft()));
+}
+
+// processInto: With blur enabled this is two passes: point operations fused into the horizontal
+// blur, then the vertical blur into the destination. The blur quality only changes what happens
+// inside those passes. A detail filter adds its own two passes, over the destination after a blur
+// or from the frame with the point operations fused in.
+void EffectChain::processInto(const uchar* src, int srcStride, uchar* dst, int dstStride, int width, int height,
+    PixelFormat::Layout layout, FrameStats* stats) {
+    const bool hasPointOps = !m_pointOps.isIdentity();
+    const bool hasDetail = m_detail != ImageProcessing::DetailFilter::None;
+    if (!hasPointOps && m_blurRadius == 0 && !hasDetail) {
+        return;
+    }
+    // Sampled rows are histogrammed right after the kernel has read them, while they are still in cache.
+    std::optional<FrameStatsCollector> collector;
+    if (stats) {
+        collector.emplace(width, height);
+    }
+
+    if (m_blurRadius > 0) {
+        blur(src, srcStride, dst, dstStride, width, height, layout, collector ? &*collector : nullptr);
+        if (hasDetail) {
+            m_filter.apply(m_detail, m_detailAmount, m_detailRadius, dst, dstStride, dst, dstStride, width, height, nullptr, layout);
+        }
+    } else if (hasDetail) {
+        m_filter.apply(m_detail, m_detailAmount, m_detailRadius, src, srcStride, dst, dstStride, width, height,
+            hasPointOps ? &m_pointOps : nullptr, layout, collector ? &*collector : nullptr);
+    } else {
+        // Point operations only: a single pass from the frame into the destination, split into row bands.
+        ThreadPool& pool = ThreadPool::global();
+        const int bands = std::min(height, pool.concurrency());
+        const int rowsPerBand = (height + bands - 1) / bands;
+        pool.parallelFor(bands, [&](int band) {
+            const int end = std::min((band + 1) * rowsPerBand, height);
+            std::optional<FrameStats> bandStats;
+            for (int y = band * rowsPerBand; y < end; ++y) {
+                const uchar* row = src + static_cast<ptrdiff_t>(y) * srcStride;
+                if (collector && collector->wantsRow(y)) {
+                    // Before the kernel, which may write the row in place.
+                    (bandStats ? *bandStats : bandStats.emplace()).addRow(row, width, layout, collector->step());
+                }
+                ImageProcessing::pointOpsRow(row, dst + static_cast<ptrdiff_t>(y) * dstStride, width, m_pointOps, layout);
+            }
+            if (bandStats) {
+                collector->add(*bandStats);
+            }
+        });
+    }
+    if (stats) {
+        *stats = collector->result();
+    }
+}
+
+// blur: Point operations fused into the horizontal pass, then the vertical pass straight into the
+// destination, on the exact kernel while it is small enough and on boxes otherwise.
+void EffectChain::blur(const uchar* src, int srcStride, uchar* dst, int dstStride, int width, int height,
+    PixelFormat::Layout layout, FrameStatsCollector* stats) {
+    const ImageProcessing::PointOps* pointOps = m_pointOps.isIdentity() ? nullptr : &m_pointOps;
+    if (m_blurQuality == ImageProcessing::BlurQuality::Kernel && m_blurRadius <= ImageProcessing::maxKernelBlurRadius) {
+        m_filter.blur(src, srcStride, dst, dstStride, width, height, m_blurRadius, pointOps, layout, stats);
+    } else {
+        m_blur.apply(src, srcStride, dst, dstStride, width, height, m_blurRadius, pointOps, m_blurQuality, layout, stats);
+    }
+}
+
+// process: YUV variant. Chroma is never converted; grayscale simply stops carrying it.
+YuvImage EffectChain::process(const YuvImage& input) {
+    m_tileStats = TileStats();
+    if (m_statsEnabled) {
+        m_stats = FrameStats();
+    }
+    // sampleStats: For the frames no luma pass reads.
+    auto sampleStats = [&] {
+        if (m_statsEnabled && !m_stats.isValid() && !input.isNull()) {
+            m_stats = FrameStats::sampleLuma(input.constPlane(0), input.stride(0), input.width(), input.height(),
+                input.format() == YuvImage::Format::YUY2 ? 2 : 1);
+        }
+    };
+    const bool grayscale = m_pointOps.grayscale;
+    const bool hasDetail = m_detail != ImageProcessing::DetailFilter::None;
+    if (input.isNull() || (!grayscale && m_lumaOps.isIdentity() && m_blurRadius == 0 && !hasDetail)) {
+        sampleStats();
+        return input;
+    }
+
+    // On planar formats the Y plane already is the grayscale image, so grayscale alone costs nothing.
+    const bool packed = input.format() == YuvImage::Format::YUY2;
+    const YuvImage source = grayscale && !packed ? input.lumaView() : input;
+    if (grayscale && !packed && m_lumaOps.isIdentity() && m_blurRadius == 0 && !hasDetail) {
+        sampleStats();
+        return source;
+    }
+
+    const YuvImage::Format outputFormat = grayscale ? YuvImage::Format::Gray8 : input.format();
+    if (m_settings.incremental) {
+        sampleStats();
+        return processIncremental(source, outputFormat);
+    }
+    YuvImage& output = acquireYuvOutput(outputFormat, input.width(), input.height());
+    for (int plane = 0; plane < output.planeCount(); ++plane) {
+        processYuvPlane(source, output, plane, m_statsEnabled ? &m_stats : nullptr);
+    }
+    sampleStats();
+    return output;
+}
+
+YuvImage EffectChain::process(const YuvImage& input, const QRect& roi) {
+    QRect rect = roi & QRect(QPoint(0, 0), input.size());
+    if (input.isNull() || rect.isEmpty() || rect.size() == input.size()) {
+        return process(input);
+    }
+    const int left = rect.left() & ~1;
+    const int top = rect.top() & ~1;
+    rect = QRect(left, top, std::min((rect.left() + rect.width() + 1) & ~1, input.width()) - left,
+        std::min((rect.top() + rect.height() + 1) & ~1, input.height()) - top);
+    int reach = 0;
+    int alignment = 0;
+    yuvReach(input.format(), m_pointOps.grayscale ? YuvImage::Format::Gray8 : input.format(), reach, alignment);
+    const QRect region = growRegion(rect, reach, alignment, input.size());
+    return process(input.region(region)).region(rect.translated(-region.topLeft()));
+}
+
+// processIncremental: Unchanged tiles are copied from the previous output. Each dirty region is
+// recomputed from the input grown by the blur's reach into scratch, and only its own pixels are kept,
+// so the result matches processing the whole frame.
+QImage EffectChain::processIncremental(const QImage& source) {
+    const int width = source.width();
+    const int height = source.height();
+    const PixelFormat::Layout layout = PixelFormat::layoutOf(source.format());
+    const int bytes = PixelFormat::bytesPerPixel(layout);
+    const int reach = BoxBlur::reach(m_blurRadius, m_blurQuality) + detailReach();
+    const int dirty = m_tiles.update(source.constBits(), static_cast<int>(source.bytesPerLine()), width, height, bytes, reach);
+    const bool reusable = !m_previousOutput.isNull() && m_previousOutput.size() == source.size()
+        && m_previousOutput.format() == source.format();
+    m_tileStats = { m_tiles.count(), reusable ? dirty : m_tiles.count() };
+    if (reusable && dirty == 0) {
+        return m_previousOutput; // Nothing moved; the last result still stands.
+    }
+
+    QImage output = FrameBufferPool::global().acquire(source.size(), source.format());
+    const uchar* src = source.constBits();
+    const int srcStride = static_cast<int>(source.bytesPerLine());
+    uchar* dst = output.bits();
+    const int dstStride = static_cast<int>(output.bytesPerLine());
+    if (!reusable || reprocessesWholeFrame(dirty)) {
+        m_tileStats.processed = m_tileStats.tiles;
+        processInto(src, srcStride, dst, dstStride, width, height, layout);
+    } else {
+        const uchar* previous = m_previousOutput.constBits();
+        const int previousStride = static_cast<int>(m_previousOutput.bytesPerLine());
+        const int alignment = BoxBlur::alignment(m_blurRadius, m_blurQuality);
+        forEachTileRegion(
+            [&](const QRect& rect) {
+                copyPixels(pixelAt(previous, previousStride, bytes, rect.topLeft()), previousStride,
+                    pixelAt(dst, dstStride, bytes, rect.topLeft()), dstStride, bytes, rect.size());
+            },
+            [&](const QRect& rect) {
+                const QRect region = growRegion(rect, reach, alignment, source.size());
+                const uchar* regionSrc = pixelAt(src, srcStride, bytes, region.topLeft());
+                if (region == rect) { // Point operations only: straight into the output.
+                    processInto(regionSrc, srcStride, pixelAt(dst, dstStride, bytes, rect.topLeft()), dstStride,
+                        rect.width(), rect.height(), layout);
+                    return;
+                }
+                const int scratchStride = (region.width() * bytes + 63) & ~63;
+                const size_t scratchBytes = static_cast<size_t>(scratchStride) * region.height();
+                if (m_regionScratch.size() < scratchBytes) {
+                    m_regionScratch.resize(scratchBytes);
+                }
+                processInto(regionSrc, srcStride, m_regionScratch.data(), scratchStride, region.width(), region.height(), layout);
+                copyPixels(pixelAt(m_regionScratch.data(), scratchStride, bytes, rect.topLeft() - region.topLeft()), scratchStride,
+                    pixelAt(dst, dstStride, bytes, rect.topLeft()), dstStride, bytes, rect.size());
+            });
+    }
+    m_previousOutput = output;
+    return output;
+}
+
+// yuvReach: The blur of every plane at that plane's resolution, in pixels, and the detail filter
+// on top. Regions start on even pixels, where chroma samples and YUY2 macropixels start.
+void EffectChain::yuvReach(YuvImage::Format source, YuvImage::Format output, int& reach, int& alignment) const {
+    const int halfRadius = (m_blurRadius + 1) / 2;
+    const bool packed = source == YuvImage::Format::YUY2;
+    reach = BoxBlur::reach(m_blurRadius, m_blurQuality);
+    alignment = std::max(2, BoxBlur::alignment(m_blurRadius, m_blurQuality));
+    if (packed) { // Macropixels: half the radius across, over two pixels each.
+        reach = std::max(reach, 2 * BoxBlur::reach(halfRadius, m_blurQuality, m_blurRadius));
+        alignment = std::max(alignment, 2 * BoxBlur::alignment(halfRadius, m_blurQuality, m_blurRadius));
+    } else if (output != YuvImage::Format::Gray8) {
+        reach = std::max(reach, 2 * BoxBlur::reach(halfRadius, m_blurQuality));
+        alignment = std::max(alignment, 2 * BoxBlur::alignment(halfRadius, m_blurQuality));
+    }
+    reach += detailReach() * (packed ? 2 : 1);
+}
+
+// processIncremental: YUV variant. Every plane of the output is compared on one grid of tiles: chroma
+// planes with half-size tiles, YUY2 as packed rows, with the reach and alignment of yuvReach.
+YuvImage EffectChain::processIncremental(const YuvImage& source, YuvImage::Format outputFormat) {
+    const int width = source.width();
+    const int height = source.height();
+    const bool packed = source.format() == YuvImage::Format::YUY2;
+    int reach = 0;
+    int alignment = 0;
+    yuvReach(source.format(), outputFormat, reach, alignment);
+    int dirty = m_tiles.update(source.constPlane(0), source.stride(0), width, height, packed ? 2 : 1, reach);
+    for (int plane = 1; plane < source.planeCount(); ++plane) {
+        const QSize size = source.planeSize(plane);
+        DirtyTiles& tiles = m_chromaTiles[plane - 1];
+        tiles.update(source.constPlane(plane), source.stride(plane), size.width(), size.height(), source.planeChannels(plane),
+            (reach + 1) / 2);
+        dirty = m_tiles.merge(tiles);
+    }
+    const bool reusable = m_previousYuv.format() == outputFormat && m_previousYuv.width() == width && m_previousYuv.height() == height;
+    m_tileStats = { m_tiles.count(), reusable ? dirty : m_tiles.count() };
+    if (reusable && dirty == 0) {
+        return m_previousYuv;
+    }
+
+    // m_previousYuv still references its slot, so the output is never the buffer being copied from.
+    YuvImage& output = acquireYuvOutput(outputFormat, width, height);
+    if (!reusable || reprocessesWholeFrame(dirty)) {
+        m_tileStats.processed = m_tileStats.tiles;
+        for (int plane = 0; plane < output.planeCount(); ++plane) {
+            processYuvPlane(source, output, plane);
+        }
+    } else {
+        if (m_regionYuv.format() != outputFormat || m_regionYuv.width() != width || m_regionYuv.height() != height) {
+            m_regionYuv = YuvImage(outputFormat, width, height);
+        }
+        forEachTileRegion(
+            [&](const QRect& rect) {
+                YuvImage target = output.region(rect);
+                copyYuv(m_previousYuv.region(rect), target);
+            },
+            [&](const QRect& rect) {
+                const QRect region = growRegion(rect, reach, alignment, QSize(width, height));
+                const YuvImage regionSource = source.region(region);
+                YuvImage scratch = m_regionYuv.region(QRect(QPoint(0, 0), region.size()));
+                for (int plane = 0; plane < scratch.planeCount(); ++plane) {
+                    processYuvPlane(regionSource, scratch, plane);
+                }
+                YuvImage target = output.region(rect);
+                copyYuv(scratch.region(rect.translated(-region.topLeft())), target);
+            });
+    }
+    m_previousYuv = output;
+    return output;
+}
+
+bool EffectChain::reprocessesWholeFrame(int dirtyTiles) const {
+    return dirtyTiles * 100 > m_tiles.count() * maxIncrementalPercent;
+}
+
+// forEachTileRegion: Clean runs of each tile row are copied in parallel; they never overlap. Dirty
+// runs are stacked while the run below spans exactly the same tiles, so a block pays its blur reach
+// once instead of once per tile row. Each dirty block is processed in turn, with the pool inside.
+template <typename CopyClean, typename ProcessDirty>
+void EffectChain::forEachTileRegion(CopyClean&& copyClean, ProcessDirty&& processDirty) {
+    const int columns = m_tiles.columns();
+    const int rows = m_tiles.rows();
+    ThreadPool::global().parallelFor(rows, [&](int row) {
+        for (int column = 0; column < columns; ++column) {
+            if (m_tiles.isDirty(column, row)) {
+                continue;
+            }
+            const int first = column;
+            while (column + 1 < columns && !m_tiles.isDirty(column + 1, row)) {
+                ++column;
+            }
+            copyClean(m_tiles.rect(first, row, column, row));
+        }
+    });
+
+    m_openRuns.clear();
+    for (int row = 0; row <= rows; ++row) {
+        m_nextRuns.clear();
+        for (int column = 0; row < rows && column < columns; ++column) {
+            if (!m_tiles.isDirty(column, row)) {
+                continue;
+            }
+            const int first = column;
+            while (column + 1 < columns && m_tiles.isDirty(column + 1, row)) {
+                ++column;
+            }
+            TileRun run{ first, column, row };
+            const auto above = std::find_if(m_openRuns.begin(), m_openRuns.end(),
+                [&](const TileRun& open) { return open.first == first && open.last == column; });
+            if (above != m_openRuns.end()) {
+                run.top = above->top;
+                above->top = -1; // Carried on; not finished yet.
+            }
+            m_nextRuns.push_back(run);
+        }
+        for (const TileRun& open : m_openRuns) {
+            if (open.top >= 0) {
+                processDirty(m_tiles.rect(open.first, open.top, open.last, row - 1));
+            }
+        }
+        std::swap(m_openRuns, m_nextRuns);
+    }
+}
+
+// processInPlace: Neutral chroma is flat, so grayscale needs no blur on those planes.
+void EffectChain::processInPlace(YuvImage& frame) {
+    const YuvImage::Format format = frame.format();
+    if (!isActive() || (format != YuvImage::Format::NV12 && format != YuvImage::Format::I420)) {
+        return;
+    }
+    for (int plane = 0; plane < frame.planeCount(); ++plane) {
+        if (plane > 0 && m_pointOps.grayscale) {
+            const QSize size = frame.planeSize(plane);
+            const size_t rowBytes = static_cast<size_t>(size.width()) * frame.planeChannels(plane);
+            for (int y = 0; y < size.height(); ++y) {
+                std::memset(frame.plane(plane) + static_cast<ptrdiff_t>(y) * frame.stride(plane), 128, rowBytes);
+            }
+        } else {
+            processYuvPlane(frame, frame, plane);
+        }
+    }
+}
+
+// processYuvPlane: Luma lookup (or a copy) by row bands, then the blur at the plane's own resolution,
+// then the detail filter on plane 0. Stats come from the Y bytes the row pass reads on plane 0;
+// without a row pass they stay unset.
+void EffectChain::processYuvPlane(const YuvImage& source, YuvImage& output, int plane, FrameStats* stats) {
+    const bool packed = source.format() == YuvImage::Format::YUY2;
+    const bool extractLuma = packed && output.format() == YuvImage::Format::Gray8;
+    const bool lumaLookup = plane == 0 && (!m_lumaOps.isIdentity() || extractLuma);
+    const bool detail = plane == 0 && m_detail != ImageProcessing::DetailFilter::None;
+    const QSize size = output.planeSize(plane);
+    const int channels = output.planeChannels(plane);
+    const uchar* src = source.constPlane(plane);
+    int srcStride = source.stride(plane);
+    uchar* dst = output.plane(plane);
+    const int dstStride = output.stride(plane);
+
+    if (lumaLookup || (m_blurRadius == 0 && !detail && src != dst)) { // In place, an untouched plane stays as it is.
+        ThreadPool& pool = ThreadPool::global();
+        const int bands = std::min(size.height(), pool.concurrency());
+        const int rowsPerBand = (size.height() + bands - 1) / bands;
+        std::optional<FrameStatsCollector> collector;
+        if (stats && plane == 0) {
+            collector.emplace(source.width(), source.height());
+        }
+        pool.parallelFor(bands, [&](int band) {
+            const int end = std::min((band + 1) * rowsPerBand, size.height());
+            std::optional<FrameStats> bandStats;
+            for (int y = band * rowsPerBand; y < end; ++y) {
+                const uchar* in = src + static_cast<ptrdiff_t>(y) * srcStride;
+                uchar* out = dst + static_cast<ptrdiff_t>(y) * dstStride;
+                if (collector && collector->wantsRow(y)) {
+                    (bandStats ? *bandStats : bandStats.emplace()).addLumaRow(in, source.width(), collector->step(), packed ? 2 : 1);
+                }
+                if (extractLuma) {
+                    yuy2ExtractLumaRow(in, out, size.width(), m_lumaOps);
+                } else if (lumaLookup && packed) {
+                    yuy2LumaRow(in, out, size.width(), m_lumaOps);
+                } else if (lumaLookup) {
+                    ImageProcessing::lutRow(in, out, size.width(), m_lumaOps);
+                } else {
+                    std::memcpy(out, in, static_cast<size_t>(size.width()) * channels); // Chroma is untouched.
+                }
+            }
+            if (bandStats) {
+                collector->add(*bandStats);
+            }
+        });
+        if (collector) {
+            *stats = collector->result();
+        }
+        src = dst; // The blur continues in place.
+        srcStride = dstStride;
+    }
+
+    if (m_blurRadius > 0) {
+        // Radii are in elements of this plane: half-resolution chroma and YUY2 macropixels cover two pixels each.
+        const int halfRadius = (m_blurRadius + 1) / 2;
+        const bool subsampled = plane > 0 && output.format() != YuvImage::Format::YUY2;
+        const int radiusX = subsampled || output.format() == YuvImage::Format::YUY2 ? halfRadius : m_blurRadius;
+        const int radiusY = subsampled ? halfRadius : m_blurRadius;
+        if (m_blurQuality == ImageProcessing::BlurQuality::Kernel && m_blurRadius <= ImageProcessing::maxKernelBlurRadius) {
+            m_filter.blurPlane(src, srcStride, dst, dstStride, size.width(), size.height(), channels, radiusX, radiusY);
+        } else {
+            m_blur.applyPlane(src, srcStride, dst, dstStride, size.width(), size.height(), channels, radiusX, radiusY, m_blurQuality);
+        }
+        src = dst;
+        srcStride = dstStride;
+    }
+
+    if (detail) {
+        m_filter.applyPlane(m_detail, m_detailAmount, m_detailRadius, src, srcStride, dst, dstStride, size.width(), size.height(), channels);
+    }
+}
+
+// acquireYuvOutput: Returns a destination nobody else references, allocating only on a format or size change.
+YuvImage& EffectChain::acquireYuvOutput(YuvImage::Format format, int width, int height) {
+    auto matches = [&](const YuvImage& image) {
+        return image.format() == format && image.width() == width && image.height() == height;
+    };
+    for (auto& output : m_yuvOutputs) {
+        if (output.isDetached() && matches(output)) {
+            return output;
+        }
+    }
+    for (auto& output : m_yuvOutputs) {
+        if (output.isNull() || output.isDetached() || !matches(output)) {
+            output = YuvImage(format, width, height);
+            return output;
+        }
+    }
+    m_yuvOutputs[0] = YuvImage(format, width, height); // Every slot is still in use downstream.
+    return m_yuvOutputs[0];
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "effectsettings.h"
+#include "imageprocessing.h"
+#include "boxblur.h"
+#include "separablefilter.h"
+#include "dirtytiles.h"
+#include "framestats.h"
+#include "yuvimage.h"
+#include <QImage>
+#include <array>
+#include <vector>
+
+// EffectChain: The enabled effects compiled into the fewest passes over a frame.
+// Grayscale and brightness fold into one lookup that is applied while the horizontal
+// blur reads its input, and the result lands in a recycled destination buffer. A detail filter
+// (sharpen, unsharp mask, edges) runs after the blur, in place in the destination, or takes the
+// lookup into its own row pass when there is no blur.
+// The chain is only rebuilt when the settings actually change.
+// In incremental mode the chain keeps its last result and only recomputes the tiles whose input
+// changed, grown by the blur's and the detail filter's reach, copying the rest from the previous output.
+class EffectChain {
+public:
+    EffectChain() = default;
+
+    // Rebuilds the chain if the settings differ from the ones it was built with.
+    void configure(const EffectSettings& settings);
+
+    // Runs the chain. The result has the input's format if that has a PixelFormat layout, RGB888
+    // otherwise. Returns the input unchanged when no effect is active.
+    QImage process(const QImage& input);
+
+    // Runs the chain on roi alone and returns that part of the result. roi grown by the effects'
+    // reach is processed as a frame of its own, so the cost follows the ROI's area while its pixels
+    // match the whole frame's; stats describe the grown region. roi is clipped to the frame, and an
+    // empty one processes the whole frame. With no effect active the result is a view of the input.
+    QImage process(const QImage& input, const QRect& roi);
+
+    // Runs the chain on rows of a PixelFormat layout the caller owns, from src into dst; src and dst
+    // may be the same buffer. Does nothing when no effect is active. If stats is given, it receives
+    // the histograms of src, sampled by the pass as it reads the rows; it stays invalid when no
+    // effect is active, since then nothing reads the rows.
+    void processInto(const uchar* src, int srcStride, uchar* dst, int dstStride, int width, int height,
+        PixelFormat::Layout layout = PixelFormat::Layout::Rgb888, FrameStats* stats = nullptr);
+
+    // Runs the chain on a writable NV12 or I420 frame in place. Grayscale keeps the frame's format
+    // and sets the chroma planes to neutral instead of dropping them.
+    void processInPlace(YuvImage& frame);
+
+    // True when configured with at least one effect that changes pixels.
+    bool isActive() const { return !m_pointOps.isIdentity() || m_blurRadius > 0 || m_detail != ImageProcessing::DetailFilter::None; }
+
+    // Runs the chain on a native YUV frame: grayscale keeps only the Y plane, brightness is a
+    // lookup on Y alone, blur runs on every plane at that plane's resolution and the detail filter
+    // on Y alone (on YUY2 macropixels, at half the resolution across).
+    YuvImage process(const YuvImage& input);
+    // YUV variant of the ROI process; the ROI is grown to even coordinates for the chroma planes.
+    YuvImage process(const YuvImage& input, const QRect& roi);
+
+    // TileStats: What the last process call did in incremental mode; zero tiles otherwise.
+    // A frame processed whole counts every tile.
+    struct TileStats {
+        int tiles = 0;
+        int processed = 0;
+    };
+    TileStats tileStats() const { return m_tileStats; }
+
+    // With stats on, every process call fills stats() with the histograms of its input. They are
+    // sampled inside the effect pass; only frames no full pass reads (no effect active, incremental
+    // mode, a blurred or filtered YUV plane without a luma lookup) get a sparse pass of their own.
+    void setStatsEnabled(bool enabled) { m_statsEnabled = enabled; }
+    const FrameStats& stats() const { return m_stats; }
+
+private:
+    // TileRun: Dirty tiles [first, last] of one tile row, stacked from tile row top down.
+    struct TileRun {
+        int first;
+        int last;
+        int top;
+    };
+
+    YuvImage& acquireYuvOutput(YuvImage::Format format, int width, int height);
+    void processYuvPlane(const YuvImage& source, YuvImage& output, int plane, FrameStats* stats = nullptr);
+    void blur(const uchar* src, int srcStride, uchar* dst, int dstStride, int width, int height,
+        PixelFormat::Layout layout, FrameStatsCollector* stats);
+    int detailReach() const { return SeparableFilter::reach(m_detail, m_detailRadius); }
+    // How far the chain carries a change on a YUV source, in pixels, and the grid a region of it has
+    // to start on, covering every plane of output.
+    void yuvReach(YuvImage::Format source, YuvImage::Format output, int& reach, int& alignment) const;
+    QImage processIncremental(const QImage& source);
+    YuvImage processIncremental(const YuvImage& source, YuvImage::Format outputFormat);
+    bool reprocessesWholeFrame(int dirtyTiles) const;
+    template <typename CopyClean, typename ProcessDirty>
+    void forEachTileRegion(CopyClean&& copyClean, ProcessDirty&& processDirty);
+
+    EffectSettings m_settings;
+    bool m_configured = false;
+    bool m_statsEnabled = false;
+    FrameStats m_stats; // Of the last process call's input.
+
+    ImageProcessing::PointOps m_pointOps; // Grayscale and brightness folded together.
+    ImageProcessing::PointOps m_lumaOps; // Brightness alone, for the Y plane of YUV frames.
+    int m_blurRadius = 0; // Zero when blur is off.
+    ImageProcessing::BlurQuality m_blurQuality = ImageProcessing::BlurQuality::Box;
+    ImageProcessing::DetailFilter m_detail = ImageProcessing::DetailFilter::None; // None when the amount is zero.
+    int m_detailAmount = 0;
+    int m_detailRadius = 1;
+
+    // YUV destinations; the converter may still be reading the previous one, so a few are rotated.
+    // RGB destinations come from FrameBufferPool.
+    std::array<YuvImage, 3> m_yuvOutputs;
+    BoxBlur m_blur; // Owns the scratch buffers of both blur passes.
+    SeparableFilter m_filter; // The exact-kernel blur and the detail filters, with scratch of their own.
+
+    // Incremental mode.
+    DirtyTiles m_tiles;
+    std::array<DirtyTiles, 2> m_chromaTiles; // Planar YUV: the chroma planes on the same grid.
+    TileStats m_tileStats;
+    QImage m_previousOutput; // Last RGB result, the source of unchanged tiles.
+    YuvImage m_previousYuv;
+    std::vector<uchar> m_regionScratch; // An RGB region grown by the blur reach.
+    YuvImage m_regionYuv; // Frame-sized; regions of it hold grown YUV regions.
+    std::vector<TileRun> m_openRuns;
+    std::vector<TileRun> m_nextRuns;
+};
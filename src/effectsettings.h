@@ -0,0 +1,82 @@
+#pragma once
+
+#include "imageprocessing.h"
+#include <QString>
+#include <QStringList>
+
+// EffectSettings: Snapshot of the user-selected effects and their parameters.
+struct EffectSettings {
+    bool grayscaleEnabled = false;
+    bool brightnessEnabled = false;
+    int brightnessValue = 0;
+    bool autoBrightness = false; // FrameProcessor sets the brightness from each frame's mean luma.
+    int autoBrightnessTarget = 118; // Mean luma auto brightness aims for.
+    bool blurEnabled = false;
+    int blurValue = 0;
+    ImageProcessing::BlurQuality blurQuality = ImageProcessing::BlurQuality::Box;
+    ImageProcessing::DetailFilter detailFilter = ImageProcessing::DetailFilter::None;
+    int detailAmount = 100; // Percent of the removed detail sharpen and unsharp mask add back.
+    int detailRadius = 3; // Blur radius of the unsharp mask, up to ImageProcessing::maxKernelBlurRadius.
+    bool incremental = false; // Reprocess only the tiles that changed since the last frame.
+    int changeThreshold = 2; // Mean absolute difference per byte at which a tile counts as changed.
+
+    // "grayscale,brightness=40,blur=5,quality=gaussian,incremental=4,auto-brightness=110,unsharp=150,
+    // unsharp-radius=4" ("gray" also works; quality is box, gaussian, pyramid or kernel; incremental
+    // takes an optional change threshold and auto-brightness an optional target mean luma; sharpen
+    // and unsharp an optional amount; edges none); unknown names are ignored.
+    static EffectSettings fromString(const QString& text) {
+        EffectSettings settings;
+        for (const QString& entry : text.split(',', Qt::SkipEmptyParts)) {
+            const QString name = entry.section('=', 0, 0).trimmed();
+            const int value = entry.section('=', 1, 1).toInt();
+            if (name == QLatin1String("grayscale") || name == QLatin1String("gray")) {
+                settings.grayscaleEnabled = true;
+            } else if (name == QLatin1String("brightness")) {
+                settings.brightnessEnabled = true;
+                settings.brightnessValue = value;
+            } else if (name == QLatin1String("blur")) {
+                settings.blurEnabled = true;
+                settings.blurValue = value;
+            } else if (name == QLatin1String("quality")) {
+                settings.blurQuality = blurQualityFromString(entry.section('=', 1, 1).trimmed());
+            } else if (name == QLatin1String("incremental")) {
+                settings.incremental = true;
+                if (entry.contains('=')) {
+                    settings.changeThreshold = value;
+                }
+            } else if (name == QLatin1String("auto-brightness")) {
+                settings.autoBrightness = true;
+                if (entry.contains('=')) {
+                    settings.autoBrightnessTarget = value;
+                }
+            } else if (name == QLatin1String("sharpen") || name == QLatin1String("unsharp")) {
+                settings.detailFilter = name == QLatin1String("sharpen")
+                    ? ImageProcessing::DetailFilter::Sharpen
+                    : ImageProcessing::DetailFilter::UnsharpMask;
+                if (entry.contains('=')) {
+                    settings.detailAmount = value;
+                }
+            } else if (name == QLatin1String("unsharp-radius")) {
+                settings.detailRadius = value;
+            } else if (name == QLatin1String("edges")) {
+                settings.detailFilter = ImageProcessing::DetailFilter::Edges;
+            }
+        }
+        return settings;
+    }
+
+    static ImageProcessing::BlurQuality blurQualityFromString(const QString& text) {
+        if (text == QLatin1String("gaussian")) {
+            return ImageProcessing::BlurQuality::Gaussian;
+        }
+        if (text == QLatin1String("pyramid")) {
+            return ImageProcessing::BlurQuality::Pyramid;
+        }
+        if (text == QLatin1String("kernel")) {
+            return ImageProcessing::BlurQuality::Kernel;
+        }
+        return ImageProcessing::BlurQuality::Box;
+    }
+
+    bool operator==(const EffectSettings&) const = default;
+};
@@ -0,0 +1,141 @@
+#include "framebufferpool.h"
+#include <algorithm>
+#include <new>
+
+namespace {
+
+constexpr std::align_val_t bufferAlignment{ 64 }; // One cache line; also suits every SIMD load width.
+
+} // namespace
+
+// State: Free lists and counters, guarded by one mutex.
+struct FrameBufferPool::State {
+    std::mutex mutex;
+    std::map<Key, std::vector<Buffer*>> free; // Buffers ready to be handed out again.
+    Stats stats;
+    bool closed = false; // The pool object is gone; returning buffers are freed.
+};
+
+// Buffer: One pixel allocation and the bookkeeping needed to give it back.
+struct FrameBufferPool::Buffer {
+    std::shared_ptr<State> state;
+    Key key;
+    uchar* data = nullptr;
+
+    qint64 size() const { return static_cast<qint64>(key.stride) * key.height; }
+
+    ~Buffer() {
+        ::operator delete(data, bufferAlignment);
+    }
+};
+
+FrameBufferPool::FrameBufferPool() : m_state(std::make_shared<State>()) {
+}
+
+// Destructor: Frees the idle buffers; buffers still in use are freed when their images go.
+FrameBufferPool::~FrameBufferPool() {
+    trim();
+    std::lock_guard lock(m_state->mutex);
+    m_state->closed = true;
+}
+
+// acquire: Reuses a free buffer of the same layout, or allocates one.
+QImage FrameBufferPool::acquire(const QSize& size, QImage::Format format) {
+    if (size.isEmpty() || format == QImage::Format_Invalid) {
+        return QImage();
+    }
+    const Key key = makeKey(size, format);
+    Buffer* buffer = nullptr;
+    {
+        std::lock_guard lock(m_state->mutex);
+        auto it = m_state->free.find(key);
+        if (it != m_state->free.end() && !it->second.empty()) {
+            buffer = it->second.back();
+            it->second.pop_back();
+            m_state->stats.freeBytes -= buffer->size();
+            ++m_state->stats.hits;
+        } else {
+            ++m_state->stats.misses;
+        }
+    }
+
+    if (!buffer) {
+        buffer = new Buffer{ m_state, key, nullptr };
+        buffer->data = static_cast<uchar*>(::operator new(static_cast<size_t>(buffer->size()), bufferAlignment));
+        std::lock_guard lock(m_state->mutex);
+        m_state->stats.residentBytes += buffer->size();
+        m_state->stats.peakResidentBytes = std::max(m_state->stats.peakResidentBytes, m_state->stats.residentBytes);
+    }
+
+    // Writable data, so bits() does not copy; release() runs when the last copy of the image is gone.
+    return QImage(buffer->data, key.width, key.height, key.stride, format, &FrameBufferPool::release, buffer);
+}
+
+// prewarm: Tops the free list for this layout up to count buffers.
+void FrameBufferPool::prewarm(const QSize& size, QImage::Format format, int count) {
+    if (size.isEmpty() || format == QImage::Format_Invalid) {
+        return;
+    }
+    const Key key = makeKey(size, format);
+    std::lock_guard lock(m_state->mutex);
+    auto& list = m_state->free[key];
+    while (static_cast<int>(list.size()) < count) {
+        auto* buffer = new Buffer{ m_state, key, nullptr };
+        buffer->data = static_cast<uchar*>(::operator new(static_cast<size_t>(buffer->size()), bufferAlignment));
+        list.push_back(buffer);
+        m_state->stats.residentBytes += buffer->size();
+        m_state->stats.freeBytes += buffer->size();
+    }
+    m_state->stats.peakResidentBytes = std::max(m_state->stats.peakResidentBytes, m_state->stats.residentBytes);
+}
+
+// trim: Hands idle memory back to the heap, e.g. after a resolution change.
+void FrameBufferPool::trim() {
+    std::map<Key, std::vector<Buffer*>> idle;
+    {
+        std::lock_guard lock(m_state->mutex);
+        idle.swap(m_state->free);
+        m_state->stats.residentBytes -= m_state->stats.freeBytes;
+        m_state->stats.freeBytes = 0;
+    }
+    for (auto& [key, buffers] : idle) {
+        for (Buffer* buffer : buffers) {
+            delete buffer; // Outside the lock; the buffers hold the state alive.
+        }
+    }
+}
+
+FrameBufferPool::Stats FrameBufferPool::stats() const {
+    std::lock_guard lock(m_state->mutex);
+    return m_state->stats;
+}
+
+int FrameBufferPool::alignedStride(int width, QImage::Format format) {
+    const int bytes = (width * QImage::toPixelFormat(format).bitsPerPixel() + 7) / 8;
+    return (bytes + 63) & ~63;
+}
+
+FrameBufferPool& FrameBufferPool::global() {
+    static FrameBufferPool pool;
+    return pool;
+}
+
+FrameBufferPool::Key FrameBufferPool::makeKey(const QSize& size, QImage::Format format) {
+    return Key{ size.width(), size.height(), static_cast<int>(format), alignedStride(size.width(), format) };
+}
+
+// release: QImage cleanup function. Puts the buffer back on its free list.
+void FrameBufferPool::release(void* info) {
+    auto* buffer = static_cast<Buffer*>(info);
+    const std::shared_ptr<State> state = buffer->state; // Keeps the state alive past the buffer.
+    {
+        std::lock_guard lock(state->mutex);
+        if (!state->closed) {
+            state->free[buffer->key].push_back(buffer);
+            state->stats.freeBytes += buffer->size();
+            return;
+        }
+        state->stats.residentBytes -= buffer->size();
+    }
+    delete buffer;
+}
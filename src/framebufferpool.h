@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QImage>
+#include <QSize>
+#include <compare>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// FrameBufferPool: Recycles the pixel buffers of processed frames.
+// acquire() hands out a QImage over a 64-byte aligned buffer; when the last copy of that image
+// is destroyed, on whatever thread, the buffer goes back to the pool instead of to the heap.
+// Buffers are kept per (width, height, format, stride), so a stream at a fixed resolution
+// reaches a steady state where no pixel memory is allocated at all.
+class FrameBufferPool {
+public:
+    // Stats: Pool activity since startup.
+    struct Stats {
+        quint64 hits = 0; // Acquires served from a free buffer.
+        quint64 misses = 0; // Acquires that had to allocate.
+        qint64 residentBytes = 0; // Pixel memory held by the pool, free or in use.
+        qint64 peakResidentBytes = 0;
+        qint64 freeBytes = 0; // Part of residentBytes waiting in the pool.
+    };
+
+    FrameBufferPool();
+    ~FrameBufferPool();
+
+    FrameBufferPool(const FrameBufferPool&) = delete;
+    FrameBufferPool& operator=(const FrameBufferPool&) = delete;
+
+    // Returns a writable image backed by a pooled buffer. Its contents are undefined.
+    QImage acquire(const QSize& size, QImage::Format format);
+
+    // Allocates buffers up front so the first frames of a stream at this size hit the pool.
+    void prewarm(const QSize& size, QImage::Format format, int count);
+
+    // Frees every buffer that is not in use.
+    void trim();
+
+    Stats stats() const;
+
+    // Bytes per line used for pooled images: whole cache lines.
+    static int alignedStride(int width, QImage::Format format);
+
+    // Pool shared by everything that produces frames.
+    static FrameBufferPool& global();
+
+private:
+    struct Key {
+        int width;
+        int height;
+        int format;
+        int stride;
+        auto operator<=>(const Key&) const = default;
+    };
+    struct State;
+    struct Buffer;
+
+    static Key makeKey(const QSize& size, QImage::Format format);
+    static void release(void* info);
+
+    // Shared with every handed-out buffer, so images may outlive the pool object.
+    std::shared_ptr<State> m_state;
+};
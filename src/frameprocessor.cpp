@@ -0,0 +1,337 @@
+#include "frameprocessor.h"
+#include <QMetaMethod>
+#include <algorithm>
+
+// Constructor: The worker is started separately so connections can be made first.
+FrameProcessor::FrameProcessor(QObject* parent) : FrameProcessor(nullptr, parent) {
+}
+
+FrameProcessor::FrameProcessor(ThreadPool* pool, QObject* parent) : QObject(parent), m_pool(pool) {
+    qRegisterMetaType<FrameStats>(); // Stats reach a histogram view through queued connections.
+}
+
+// Destructor: Joins the worker thread.
+FrameProcessor::~FrameProcessor() {
+    stop();
+}
+
+// start: Launches the worker thread, or starts posting pool tasks, if it is not running yet.
+void FrameProcessor::start() {
+    std::lock_guard lock(m_mutex);
+    if (m_running) {
+        return;
+    }
+    m_running = true;
+    m_inFlight = 0; // Deliveries still queued from a previous run are not waited for.
+    if (m_pool) {
+        schedule(); // Frames may have arrived before the start.
+    } else {
+        m_thread = std::thread(&FrameProcessor::run, this);
+    }
+}
+
+// stop: Wakes the worker and any blocked producer, lets the worker finish the current frame and joins it.
+void FrameProcessor::stop() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_running = false;
+    }
+    m_wakeup.notify_one();
+    m_space.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    std::unique_lock lock(m_mutex);
+    m_idle.wait(lock, [this] { return !m_scheduled; }); // A queued pool task sees m_running and returns.
+}
+
+// drain: m_inFlight covers a frame from the moment it leaves the mailbox until its delivery is confirmed.
+void FrameProcessor::drain() {
+    std::unique_lock lock(m_mutex);
+    m_idle.wait(lock, [this] { return !m_running || (m_pending.empty() && !m_refresh && m_inFlight == 0); });
+}
+
+// submitFrame: Posts a frame into the mailbox. When the mailbox is full the oldest frame the worker
+// has not started yet is dropped or, under a lossless policy, the caller waits for the worker.
+void FrameProcessor::submitFrame(const VideoFrame& frame) {
+    m_received.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::unique_lock lock(m_mutex);
+        const auto full = [this] { return static_cast<int>(m_pending.size()) >= m_dropPolicy.capacity(); };
+        if (!m_dropPolicy.drops() && m_running && full()) {
+            // Holding the streaming thread fills the queue in front of the appsink, which then holds the source.
+            m_blocked.fetch_add(1, std::memory_order_relaxed);
+            m_space.wait(lock, [&] { return !m_running || !full() || m_dropPolicy.drops(); });
+        }
+        while (full()) {
+            m_pending.pop_front();
+            m_dropped.fetch_add(1, std::memory_order_relaxed); // The older frame is never processed.
+        }
+        m_pending.push_back(frame);
+        schedule();
+    }
+    m_wakeup.notify_one();
+}
+
+// notifyPainted: Called by the view each time a processed frame reaches the screen.
+void FrameProcessor::notifyPainted() {
+    m_painted.fetch_add(1, std::memory_order_relaxed);
+}
+
+// notifyDelivered: Called on the GUI thread as each processed frame arrives; makes room for the next one.
+void FrameProcessor::notifyDelivered() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_inFlight = std::max(m_inFlight - 1, 0);
+        schedule();
+    }
+    m_wakeup.notify_one();
+    m_idle.notify_all();
+}
+
+void FrameProcessor::setDropPolicy(const DropPolicy& policy) {
+    {
+        std::lock_guard lock(m_mutex);
+        m_dropPolicy = policy;
+        schedule();
+    }
+    m_wakeup.notify_one();
+    m_space.notify_all(); // A blocked producer re-checks against the new bound.
+}
+
+DropPolicy FrameProcessor::dropPolicy() const {
+    std::lock_guard lock(m_mutex);
+    return m_dropPolicy;
+}
+
+// requestRefresh: Asks for a refresh of the last frame so a change is visible immediately, even on a
+// paused stream. The refresh stays out of the mailbox.
+void FrameProcessor::requestRefresh() {
+    ++m_generation; // Lets the view tell a re-processed frame from the one it has cached.
+    m_refresh = m_lastFrame.isValid() && isSignalConnected(QMetaMethod::fromSignal(&FrameProcessor::frameRefreshed));
+    schedule();
+}
+
+// updateSettings: Applies a change to the effect parameters under the lock and refreshes the last frame.
+template <typename Update>
+void FrameProcessor::updateSettings(Update&& update) {
+    {
+        std::lock_guard lock(m_mutex);
+        update(m_settings);
+        requestRefresh();
+    }
+    m_wakeup.notify_one();
+}
+
+void FrameProcessor::setGrayscale(bool enabled) {
+    updateSettings([enabled](EffectSettings& settings) { settings.grayscaleEnabled = enabled; });
+}
+
+void FrameProcessor::setBrightness(int value) {
+    updateSettings([value](EffectSettings& settings) { settings.brightnessValue = value; });
+}
+
+void FrameProcessor::setBrightnessEnabled(bool enabled) {
+    updateSettings([enabled](EffectSettings& settings) {
+        settings.brightnessEnabled = enabled;
+        settings.brightnessValue = 0; // Matches the slider reset when the effect is toggled.
+    });
+}
+
+// setAutoBrightness: The manual brightness is kept and comes back when auto brightness is turned off.
+void FrameProcessor::setAutoBrightness(bool enabled, int target) {
+    updateSettings([enabled, target](EffectSettings& settings) {
+        settings.autoBrightness = enabled;
+        settings.autoBrightnessTarget = target;
+    });
+}
+
+void FrameProcessor::setBlur(int value) {
+    updateSettings([value](EffectSettings& settings) { settings.blurValue = value; });
+}
+
+void FrameProcessor::setBlurEnabled(bool enabled) {
+    updateSettings([enabled](EffectSettings& settings) { settings.blurEnabled = enabled; });
+}
+
+void FrameProcessor::setBlurQuality(ImageProcessing::BlurQuality quality) {
+    updateSettings([quality](EffectSettings& settings) { settings.blurQuality = quality; });
+}
+
+void FrameProcessor::setDetailFilter(ImageProcessing::DetailFilter filter) {
+    updateSettings([filter](EffectSettings& settings) { settings.detailFilter = filter; });
+}
+
+void FrameProcessor::setDetailAmount(int percent) {
+    updateSettings([percent](EffectSettings& settings) { settings.detailAmount = percent; });
+}
+
+void FrameProcessor::setDetailRadius(int radius) {
+    updateSettings([radius](EffectSettings& settings) { settings.detailRadius = radius; });
+}
+
+void FrameProcessor::setIncremental(bool enabled) {
+    updateSettings([enabled](EffectSettings& settings) { settings.incremental = enabled; });
+}
+
+void FrameProcessor::setChangeThreshold(int threshold) {
+    updateSettings([threshold](EffectSettings& settings) { settings.changeThreshold = threshold; });
+}
+
+// setDisplaySize: Takes effect with the next frame.
+void FrameProcessor::setDisplaySize(const QSize& size) {
+    std::lock_guard lock(m_mutex);
+    m_displaySize = size;
+}
+
+void FrameProcessor::setRegionOfInterest(const RegionOfInterest& region) {
+    {
+        std::lock_guard lock(m_mutex);
+        m_region = region;
+        requestRefresh();
+    }
+    m_wakeup.notify_one();
+}
+
+// setStatsEnabled: Takes effect with the next frame.
+void FrameProcessor::setStatsEnabled(bool enabled) {
+    m_statsEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+// settings: Returns a consistent copy of the current effect parameters.
+EffectSettings FrameProcessor::settings() const {
+    std::lock_guard lock(m_mutex);
+    return m_settings;
+}
+
+// counters: Returns the frame accounting counters.
+FrameProcessor::Counters FrameProcessor::counters() const {
+    Counters counters;
+    counters.received = m_received.load(std::memory_order_relaxed);
+    counters.processed = m_processed.load(std::memory_order_relaxed);
+    counters.dropped = m_dropped.load(std::memory_order_relaxed);
+    counters.blocked = m_blocked.load(std::memory_order_relaxed);
+    counters.painted = m_painted.load(std::memory_order_relaxed);
+    counters.tiles = m_tiles.load(std::memory_order_relaxed);
+    counters.tilesProcessed = m_tilesProcessed.load(std::memory_order_relaxed);
+    return counters;
+}
+
+// canTakeFrame: A frame or a refresh is waiting and the GUI has room for its result.
+bool FrameProcessor::canTakeFrame() const {
+    return (!m_pending.empty() || m_refresh) && m_inFlight < m_dropPolicy.capacity();
+}
+
+// takeFrame: Takes the oldest waiting frame with a snapshot of the settings. A live frame shows the
+// new settings as well, so it supersedes a pending refresh; otherwise the last frame is refreshed.
+FrameProcessor::Job FrameProcessor::takeFrame() {
+    Job job;
+    if (m_pending.empty()) {
+        job.frame = m_lastFrame;
+        job.refresh = true;
+    } else {
+        job.frame = std::move(m_pending.front());
+        m_pending.pop_front();
+        m_lastFrame = job.frame;
+    }
+    m_refresh = false;
+    ++m_inFlight; // Counted before the emit, which may deliver synchronously.
+    job.settings = m_settings; // Snapshot so a slider drag cannot change parameters mid-frame.
+    job.displaySize = m_displaySize;
+    job.region = m_region;
+    job.generation = m_generation;
+    return job;
+}
+
+// processFrame: Runs the effects and publishes the result. Auto brightness applies what the
+// previous frames' stats asked for, and this frame's stats steer the ones after it.
+void FrameProcessor::processFrame(Job& job) {
+    job.frame.stamp(FrameTimestamps::EffectStart);
+    const bool emitStats = m_statsEnabled.load(std::memory_order_relaxed);
+    if (job.settings.autoBrightness) {
+        job.settings.brightnessEnabled = true;
+        job.settings.brightnessValue = m_autoBrightness.value();
+    } else {
+        m_autoBrightness.reset(); // The next time it is turned on it starts from this scene.
+    }
+    m_chain.setStatsEnabled(emitStats || job.settings.autoBrightness);
+    m_chain.configure(job.settings); // Recompiles only when a parameter changed.
+    // Only the region and its halo are processed, and a YUV frame is only converted within the region.
+    const QRect region = job.region.isFull() ? QRect() : job.region.toPixels(job.frame.size());
+    QImage processed = job.frame.isYuv()
+        ? m_converter.convert(m_chain.process(job.frame.yuv(), region), job.displaySize) // Effects on the native planes, then RGB at display size.
+        : m_chain.process(job.frame.image(), region);
+    if (!job.refresh) { // A refresh is the same frame again: not counted, and not a new sample for auto brightness.
+        m_processed.fetch_add(1, std::memory_order_relaxed);
+        if (job.settings.autoBrightness) {
+            m_autoBrightnessValue.store(m_autoBrightness.update(m_chain.stats(), job.settings.autoBrightnessTarget), std::memory_order_relaxed);
+        } else {
+            m_autoBrightnessValue.store(0, std::memory_order_relaxed);
+        }
+        const EffectChain::TileStats tiles = m_chain.tileStats();
+        if (tiles.tiles > 0) {
+            m_tiles.fetch_add(static_cast<quint64>(tiles.tiles), std::memory_order_relaxed);
+            m_tilesProcessed.fetch_add(static_cast<quint64>(tiles.processed), std::memory_order_relaxed);
+        }
+    }
+    if (emitStats && m_chain.stats().isValid()) {
+        emit frameStats(m_chain.stats());
+    }
+    VideoFrame result = job.frame.withImage(processed, job.generation);
+    result.stamp(FrameTimestamps::EffectEnd);
+    if (job.refresh) {
+        emit frameRefreshed(result); // The view only; recorder and exporter already have this frame.
+    } else {
+        emit frameProcessed(result); // Queued to the GUI thread.
+    }
+}
+
+// schedule: Keeps at most one task per processor in the pool, so a stream never runs on two cores at once.
+void FrameProcessor::schedule() {
+    if (!m_pool || !m_running || m_scheduled || !canTakeFrame()) {
+        return;
+    }
+    m_scheduled = true;
+    m_pool->post([this] { runPooled(); });
+}
+
+// runPooled: Processes one frame, then re-posts itself if there is more, letting other streams' tasks in between.
+void FrameProcessor::runPooled() {
+    Job job;
+    {
+        std::lock_guard lock(m_mutex);
+        if (!m_running || !canTakeFrame()) {
+            m_scheduled = false;
+            m_idle.notify_all();
+            return;
+        }
+        job = takeFrame();
+    }
+    m_space.notify_one();
+
+    processFrame(job);
+
+    std::lock_guard lock(m_mutex);
+    m_scheduled = false;
+    schedule();
+    if (!m_scheduled) {
+        m_idle.notify_all();
+    }
+}
+
+// run: Worker loop; once the GUI has room, takes the oldest waiting frame and processes it.
+void FrameProcessor::run() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wakeup.wait(lock, [this] { return !m_running || canTakeFrame(); });
+            if (!m_running) {
+                return;
+            }
+            job = takeFrame();
+        }
+        m_space.notify_one();
+        processFrame(job);
+    }
+}
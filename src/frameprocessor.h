@@ -0,0 +1,150 @@
+#pragma once
+
+#include "videoframe.h"
+#include "effectsettings.h"
+#include "effectchain.h"
+#include "droppolicy.h"
+#include "regionofinterest.h"
+#include "yuvconverter.h"
+#include "threadpool.h"
+#include <QObject>
+#include <QImage>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// FrameProcessor: Applies the enabled effects on a dedicated worker thread or, when given a
+// ThreadPool, as pool tasks: at most one per processor at a time, so many cameras share the cores
+// while each stream's frames stay in order.
+// Incoming frames go into a mailbox bounded by the drop policy: by default a single slot where the
+// latest frame wins, so a slow effect never backs up the appsink callback or the GUI thread.
+// Processed frames are handed to the GUI under the same bound: the worker does not take the next
+// frame while that many are still waiting in the event loop, so the backlog stays in the mailbox,
+// where the policy decides whether to drop or to block the streaming thread.
+class FrameProcessor : public QObject {
+    Q_OBJECT
+
+public:
+    // Counters: Where frames went, sampled at a single point in time.
+    struct Counters {
+        quint64 received = 0; // Frames handed to submitFrame.
+        quint64 processed = 0; // Frames that went through the effects; refreshes after a settings change are not counted.
+        quint64 dropped = 0; // Frames pushed out of the mailbox before the worker got to them.
+        quint64 blocked = 0; // Lossless only: submitFrame calls that had to wait for room in the mailbox.
+        quint64 painted = 0; // Processed frames that reached the screen.
+        quint64 tiles = 0; // Incremental only: tiles seen over all processed frames.
+        quint64 tilesProcessed = 0; // Of those, tiles whose effects were recomputed.
+    };
+
+    explicit FrameProcessor(QObject* parent = nullptr);
+    explicit FrameProcessor(ThreadPool* pool, QObject* parent = nullptr); // nullptr: dedicated thread.
+    ~FrameProcessor() override;
+
+    void start();
+    void stop();
+    // Waits until every frame in the mailbox has been processed and delivered. For offline runs
+    // whose source has ended; a live source keeps refilling the mailbox.
+    void drain();
+
+    // Thread-safe: called from the GStreamer streaming thread.
+    // Under a lossless policy this waits while the mailbox is full.
+    void submitFrame(const VideoFrame& frame);
+    void notifyPainted();
+    // Must be called by whoever receives frameProcessed or frameRefreshed, once per frame, so the
+    // worker can hand out the next one.
+    void notifyDelivered();
+
+    // Bounds the mailbox and the frames in flight to the GUI. Takes effect with the next frame.
+    void setDropPolicy(const DropPolicy& policy);
+    DropPolicy dropPolicy() const;
+
+    void setGrayscale(bool enabled);
+    void setBrightness(int value);
+    void setBrightnessEnabled(bool enabled);
+    // Overrides the brightness with one steered from each frame's mean luma towards target.
+    void setAutoBrightness(bool enabled, int target = EffectSettings().autoBrightnessTarget);
+    void setBlur(int value);
+    void setBlurEnabled(bool enabled);
+    void setBlurQuality(ImageProcessing::BlurQuality quality);
+    void setDetailFilter(ImageProcessing::DetailFilter filter);
+    void setDetailAmount(int percent);
+    void setDetailRadius(int radius);
+    void setIncremental(bool enabled);
+    void setChangeThreshold(int threshold);
+    EffectSettings settings() const;
+
+    // Size the view draws frames at. YUV frames are converted to RGB once, at this size.
+    void setDisplaySize(const QSize& size);
+    // Processes and delivers only this part of each frame, the effects' halo aside, for frames the
+    // pipeline did not crop already. Re-processes the last frame like a settings change.
+    void setRegionOfInterest(const RegionOfInterest& region);
+
+    // Emits frameStats for every processed frame. Auto brightness gathers the stats either way.
+    void setStatsEnabled(bool enabled);
+    // Brightness auto brightness applies right now.
+    int autoBrightnessValue() const { return m_autoBrightnessValue.load(std::memory_order_relaxed); }
+
+    Counters counters() const;
+
+signals:
+    void frameProcessed(VideoFrame frame);
+    // The last frame again, re-processed after a settings change. Only requested while connected.
+    void frameRefreshed(VideoFrame frame);
+    // Histograms of the frame's input, before the effects. Emitted from the worker.
+    void frameStats(FrameStats stats);
+
+private:
+    // Job: A frame taken from the mailbox and the parameters it is processed with.
+    struct Job {
+        VideoFrame frame;
+        EffectSettings settings;
+        QSize displaySize;
+        RegionOfInterest region;
+        quint64 generation = 0;
+        bool refresh = false; // The last frame again, for the view only.
+    };
+
+    bool canTakeFrame() const; // Called with m_mutex held.
+    Job takeFrame(); // Called with m_mutex held.
+    void processFrame(Job& job);
+    void schedule(); // Called with m_mutex held; posts a pool task if there is work and none is queued.
+    void requestRefresh(); // Called with m_mutex held.
+    void runPooled();
+    void run();
+    template <typename Update>
+    void updateSettings(Update&& update);
+
+    ThreadPool* m_pool = nullptr;
+    std::thread m_thread; // Unused with a pool.
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::condition_variable m_idle; // Signalled when a pool task finishes and none is queued, and on every delivery.
+    bool m_running = false;
+    bool m_scheduled = false; // Guarded by m_mutex; a pool task is queued or running.
+
+    std::deque<VideoFrame> m_pending; // Mailbox, oldest first; bounded by m_dropPolicy.
+    DropPolicy m_dropPolicy; // Guarded by m_mutex.
+    int m_inFlight = 0; // Guarded by m_mutex; emitted frames not yet confirmed by notifyDelivered.
+    std::condition_variable m_space; // Signalled when the mailbox or the GUI handoff has room.
+    VideoFrame m_lastFrame; // Re-processed when the settings change on a paused stream.
+    bool m_refresh = false; // Guarded by m_mutex; m_lastFrame is due for a refresh.
+    EffectSettings m_settings; // Guarded by m_mutex; the worker copies it once per frame.
+    quint64 m_generation = 1; // Guarded by m_mutex; bumped on every settings change.
+    QSize m_displaySize; // Guarded by m_mutex; empty converts at the frame's own size.
+    RegionOfInterest m_region; // Guarded by m_mutex.
+    EffectChain m_chain; // Only touched by the worker thread or the one running pool task.
+    YuvConverter m_converter; // Likewise.
+    AutoBrightness m_autoBrightness; // Likewise.
+    std::atomic<bool> m_statsEnabled{ false };
+    std::atomic<int> m_autoBrightnessValue{ 0 };
+
+    std::atomic<quint64> m_received{ 0 };
+    std::atomic<quint64> m_processed{ 0 };
+    std::atomic<quint64> m_dropped{ 0 };
+    std::atomic<quint64> m_blocked{ 0 };
+    std::atomic<quint64> m_painted{ 0 };
+    std::atomic<quint64> m_tiles{ 0 };
+    std::atomic<quint64> m_tilesProcessed{ 0 };
+};
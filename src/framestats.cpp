@@ -0,0 +1,136 @@
+#include "framestats.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Samples per frame: plenty for the mean and for percentiles to a tenth of a percent. The cost is the
+// scattered histogram increments, not the reads, so this is what keeps the stats within a few
+// percent of even the cheapest effect pass, a brightness lookup at 1080p.
+constexpr double targetSamples = 8192;
+
+template <typename Layout>
+void addPixels(FrameStats& stats, const uchar* row, int width, int step) {
+    for (int x = 0; x < width; x += step) {
+        const uchar* pixel = row + x * Layout::bytes;
+        if constexpr (Layout::layout == PixelFormat::Layout::Gray8) {
+            ++stats.luma[pixel[0]];
+        } else {
+            const int r = pixel[Layout::red];
+            const int g = pixel[Layout::green];
+            const int b = pixel[Layout::blue];
+            ++stats.red[r];
+            ++stats.green[g];
+            ++stats.blue[b];
+            ++stats.luma[(r * 11 + g * 16 + b * 5) >> 5];
+        }
+    }
+}
+
+} // namespace
+
+double FrameStats::meanLuma() const {
+    if (samples == 0) {
+        return 0;
+    }
+    quint64 sum = 0;
+    for (int value = 0; value < 256; ++value) {
+        sum += static_cast<quint64>(luma[value]) * value;
+    }
+    return static_cast<double>(sum) / samples;
+}
+
+int FrameStats::lumaPercentile(double percent) const {
+    const quint64 rank = static_cast<quint64>(std::ceil(std::clamp(percent, 0.0, 100.0) / 100.0 * samples));
+    quint64 seen = 0;
+    for (int value = 0; value < 256; ++value) {
+        seen += luma[value];
+        if (seen >= rank && seen > 0) {
+            return value;
+        }
+    }
+    return 255;
+}
+
+void FrameStats::merge(const FrameStats& other) {
+    if (other.samples == 0) {
+        return;
+    }
+    for (int value = 0; value < 256; ++value) {
+        luma[value] += other.luma[value];
+    }
+    if (other.color) {
+        for (int value = 0; value < 256; ++value) {
+            red[value] += other.red[value];
+            green[value] += other.green[value];
+            blue[value] += other.blue[value];
+        }
+    }
+    samples += other.samples;
+    color = color || other.color;
+}
+
+void FrameStats::addRow(const uchar* row, int width, PixelFormat::Layout layout, int step) {
+    switch (layout) {
+    case PixelFormat::Layout::Rgb888: addPixels<PixelFormat::Rgb888>(*this, row, width, step); break;
+    case PixelFormat::Layout::Rgbx8888: addPixels<PixelFormat::Rgbx8888>(*this, row, width, step); break;
+    case PixelFormat::Layout::Xrgb32: addPixels<PixelFormat::Xrgb32>(*this, row, width, step); break;
+    case PixelFormat::Layout::Gray8: addPixels<PixelFormat::Gray8>(*this, row, width, step); break;
+    case PixelFormat::Layout::Unsupported: return;
+    }
+    samples += static_cast<quint32>((width + step - 1) / step);
+    color = color || layout != PixelFormat::Layout::Gray8;
+}
+
+void FrameStats::addLumaRow(const uchar* row, int width, int step, int pixelBytes) {
+    for (int x = 0; x < width; x += step) {
+        ++luma[row[x * pixelBytes]];
+    }
+    samples += static_cast<quint32>((width + step - 1) / step);
+}
+
+// sampleStep: Square grid, so rows and columns are sampled alike.
+int FrameStats::sampleStep(int width, int height) {
+    return std::max(1, static_cast<int>(std::sqrt(static_cast<double>(width) * height / targetSamples)));
+}
+
+// sample: Only the grid's rows are touched, one in step of the frame's rows.
+FrameStats FrameStats::sample(const uchar* bits, int stride, int width, int height, PixelFormat::Layout layout) {
+    FrameStats stats;
+    const int step = sampleStep(width, height);
+    for (int y = 0; y < height; y += step) {
+        stats.addRow(bits + static_cast<ptrdiff_t>(y) * stride, width, layout, step);
+    }
+    return stats;
+}
+
+FrameStats FrameStats::sampleLuma(const uchar* bits, int stride, int width, int height, int pixelBytes) {
+    FrameStats stats;
+    const int step = sampleStep(width, height);
+    for (int y = 0; y < height; y += step) {
+        stats.addLumaRow(bits + static_cast<ptrdiff_t>(y) * stride, width, step, pixelBytes);
+    }
+    return stats;
+}
+
+// update: Exponential smoothing, then a dead band around the applied value.
+int AutoBrightness::update(const FrameStats& stats, int target) {
+    constexpr double smoothing = 0.1;
+    constexpr double hysteresis = 0.75;
+    if (!stats.isValid()) {
+        return m_applied;
+    }
+    const double goal = std::clamp(target - stats.meanLuma(), -100.0, 100.0); // The brightness slider's range.
+    m_offset = m_primed ? m_offset + smoothing * (goal - m_offset) : goal;
+    m_primed = true;
+    if (std::abs(m_offset - m_applied) >= hysteresis) {
+        m_applied = static_cast<int>(std::lround(m_offset));
+    }
+    return m_applied;
+}
+
+void AutoBrightness::reset() {
+    m_offset = 0;
+    m_applied = 0;
+    m_primed = false;
+}
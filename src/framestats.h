@@ -0,0 +1,77 @@
+#pragma once
+
+#include "pixelformat.h"
+#include <QMetaType>
+#include <array>
+#include <mutex>
+
+// FrameStats: Histograms of a frame's input pixels and the statistics derived from them. Pixels
+// are sampled on a sparse grid, every step-th pixel of every step-th row, about 8k samples at
+// any resolution. The effect passes fill it from rows they are reading anyway, so the frame is
+// not read a second time for it.
+struct FrameStats {
+    std::array<quint32, 256> luma{}; // Same weights as the grayscale effect.
+    std::array<quint32, 256> red{};
+    std::array<quint32, 256> green{};
+    std::array<quint32, 256> blue{};
+    quint32 samples = 0;
+    bool color = false; // red, green and blue are filled; gray and YUV frames only have luma.
+
+    bool isValid() const { return samples > 0; }
+    double meanLuma() const;
+    // The smallest luma at or below which percent of the samples lie.
+    int lumaPercentile(double percent) const;
+
+    void merge(const FrameStats& other);
+    // Adds every step-th pixel of a row in layout.
+    void addRow(const uchar* row, int width, PixelFormat::Layout layout, int step);
+    // Adds every step-th luma byte of a Y plane (pixelBytes 1) or a YUY2 row (pixelBytes 2).
+    void addLumaRow(const uchar* row, int width, int step, int pixelBytes = 1);
+
+    // Grid spacing for a frame size.
+    static int sampleStep(int width, int height);
+    // A pass of its own over the grid's rows, for frames no effect pass reads.
+    static FrameStats sample(const uchar* bits, int stride, int width, int height, PixelFormat::Layout layout);
+    static FrameStats sampleLuma(const uchar* bits, int stride, int width, int height, int pixelBytes = 1);
+};
+
+Q_DECLARE_METATYPE(FrameStats)
+
+// FrameStatsCollector: Gathers FrameStats from a row loop split into parallel bands. Each band
+// fills a FrameStats of its own from the rows wantsRow picks and hands it in once, at its end.
+class FrameStatsCollector {
+public:
+    FrameStatsCollector(int width, int height) : m_step(FrameStats::sampleStep(width, height)) {}
+
+    bool wantsRow(int y) const { return y % m_step == 0; }
+    int step() const { return m_step; }
+
+    void add(const FrameStats& band) {
+        std::lock_guard lock(m_mutex);
+        m_stats.merge(band);
+    }
+    const FrameStats& result() const { return m_stats; } // Once every band has finished.
+
+private:
+    int m_step;
+    std::mutex m_mutex;
+    FrameStats m_stats;
+};
+
+// AutoBrightness: Steers the brightness offset so the mean luma of the output approaches a target.
+// It looks at the input's statistics, so the offset follows from the scene alone and cannot
+// oscillate against its own output. The offset moves a tenth of the way to its goal per frame,
+// and the applied value changes only once it is most of a step away, so flicker and noise in the
+// scene neither make the picture pump nor recompile the chain on every frame.
+class AutoBrightness {
+public:
+    // Takes a frame's statistics and returns the brightness value to apply from the next frame.
+    int update(const FrameStats& stats, int target);
+    int value() const { return m_applied; }
+    void reset();
+
+private:
+    double m_offset = 0;
+    int m_applied = 0;
+    bool m_primed = false; // The first frame jumps straight to its goal.
+};
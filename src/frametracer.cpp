@@ -0,0 +1,206 @@
+#include "frametracer.h"
+#include <QFile>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+
+namespace {
+
+// Start and end point of each stage.
+constexpr std::array<std::pair<FrameTimestamps::Point, FrameTimestamps::Point>, FrameTracer::StageCount> stageSpans{ {
+    { FrameTimestamps::Capture, FrameTimestamps::Callback },
+    { FrameTimestamps::Callback, FrameTimestamps::EffectStart },
+    { FrameTimestamps::EffectStart, FrameTimestamps::EffectEnd },
+    { FrameTimestamps::EffectEnd, FrameTimestamps::Delivered },
+    { FrameTimestamps::Delivered, FrameTimestamps::Painted },
+    { FrameTimestamps::Capture, FrameTimestamps::Painted },
+} };
+
+constexpr qint64 nanosecondsPerSecond = 1000000000;
+
+} // namespace
+
+// bucketFor: Bucket 0 is below 1 us; then four buckets per power of two microseconds.
+int LatencyHistogram::bucketFor(qint64 nanoseconds) {
+    const quint64 micros = static_cast<quint64>(std::max<qint64>(nanoseconds, 0)) / 1000;
+    if (micros == 0) {
+        return 0;
+    }
+    const int octave = std::bit_width(micros) - 1;
+    // The two bits below the leading one pick the quarter within the octave.
+    const int quarter = octave >= 2 ? static_cast<int>((micros >> (octave - 2)) & 3) : static_cast<int>((micros << (2 - octave)) & 3);
+    return std::min(1 + octave * 4 + quarter, bucketCount - 1);
+}
+
+qint64 LatencyHistogram::upperBound(int bucket) {
+    if (bucket == 0) {
+        return 1000;
+    }
+    const int octave = (bucket - 1) / 4;
+    const int quarter = (bucket - 1) % 4;
+    return (static_cast<qint64>(4 + quarter + 1) << octave) / 4 * 1000;
+}
+
+void LatencyHistogram::add(qint64 nanoseconds) {
+    m_buckets[bucketFor(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+// percentile: Reads the buckets without stopping writers; good enough for a live display.
+qint64 LatencyHistogram::percentile(double p) const {
+    std::array<quint64, bucketCount> counts;
+    quint64 total = 0;
+    for (int i = 0; i < bucketCount; ++i) {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    const quint64 rank = std::max<quint64>(1, static_cast<quint64>(p / 100.0 * total + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < bucketCount; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return upperBound(i);
+        }
+    }
+    return upperBound(bucketCount - 1);
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+}
+
+FrameTracer& FrameTracer::global() {
+    static FrameTracer tracer;
+    return tracer;
+}
+
+qint64 FrameTracer::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char* FrameTracer::stageName(Stage stage) {
+    switch (stage) {
+    case Camera:
+        return "camera";
+    case Queue:
+        return "queue";
+    case Effects:
+        return "effects";
+    case Delivery:
+        return "delivery";
+    case Paint:
+        return "paint";
+    case Total:
+        return "total";
+    case StageCount:
+        break;
+    }
+    return "";
+}
+
+// record: Stages with a missing end point, e.g. effects of a frame that skipped the worker, are left out.
+void FrameTracer::record(const FrameTimestamps& frame, quint64 sequence) {
+    for (int stage = 0; stage < StageCount; ++stage) {
+        const qint64 start = frame.at[stageSpans[stage].first];
+        const qint64 end = frame.at[stageSpans[stage].second];
+        if (start > 0 && end >= start) {
+            m_histograms[stage].add(end - start);
+        }
+    }
+
+    // Frames per second over windows of about one second.
+    const qint64 painted = frame.at[FrameTimestamps::Painted];
+    const int frames = m_fpsFrames.fetch_add(1, std::memory_order_relaxed) + 1;
+    qint64 windowStart = m_fpsWindowStart.load(std::memory_order_relaxed);
+    if (windowStart == 0) {
+        m_fpsWindowStart.compare_exchange_strong(windowStart, painted, std::memory_order_relaxed);
+    } else if (painted - windowStart >= nanosecondsPerSecond
+        && m_fpsWindowStart.compare_exchange_strong(windowStart, painted, std::memory_order_relaxed)) {
+        m_fps.store(frames * double(nanosecondsPerSecond) / (painted - windowStart), std::memory_order_relaxed);
+        m_fpsFrames.fetch_sub(frames, std::memory_order_relaxed);
+    }
+
+    if (!m_recording.load(std::memory_order_acquire)) {
+        return;
+    }
+    const int slot = m_recordCount.fetch_add(1, std::memory_order_relaxed);
+    if (slot < m_capacity) {
+        m_records[slot] = Record{ frame, sequence };
+    }
+}
+
+// startRecording: Call before frames flow; recording cannot be restarted while record() may run.
+void FrameTracer::startRecording(int capacity) {
+    if (m_recording.load(std::memory_order_acquire)) {
+        return;
+    }
+    m_records = std::make_unique<Record[]>(capacity);
+    m_capacity = capacity;
+    m_recordCount.store(0, std::memory_order_relaxed);
+    m_recording.store(true, std::memory_order_release);
+}
+
+// exportChromeTrace: One complete ("X") event per stage per frame, one track per stage.
+// Open the file in chrome://tracing or ui.perfetto.dev.
+bool FrameTracer::exportChromeTrace(const QString& path) const {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    const int count = std::min(m_recordCount.load(std::memory_order_acquire), m_capacity);
+    qint64 origin = 0; // Earliest stamp, so the trace starts at zero.
+    for (int i = 0; i < count; ++i) {
+        for (const qint64 stamp : m_records[i].timestamps.at) {
+            if (stamp > 0 && (origin == 0 || stamp < origin)) {
+                origin = stamp;
+            }
+        }
+    }
+
+    QByteArray json("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (int stage = 0; stage < Total; ++stage) {
+        json += QStringLiteral("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%1,\"args\":{\"name\":\"%2\"}},\n")
+                    .arg(stage)
+                    .arg(QLatin1String(stageName(Stage(stage))))
+                    .toUtf8();
+    }
+    for (int i = 0; i < count; ++i) {
+        const Record& record = m_records[i];
+        for (int stage = 0; stage < Total; ++stage) {
+            const qint64 start = record.timestamps.at[stageSpans[stage].first];
+            const qint64 end = record.timestamps.at[stageSpans[stage].second];
+            if (start <= 0 || end < start) {
+                continue;
+            }
+            json += QStringLiteral("{\"name\":\"%1\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":%2,"
+                                   "\"ts\":%3,\"dur\":%4,\"args\":{\"frame\":%5,\"running_time_ns\":%6}},\n")
+                        .arg(QLatin1String(stageName(Stage(stage))))
+                        .arg(stage)
+                        .arg((start - origin) / 1000.0, 0, 'f', 3)
+                        .arg((end - start) / 1000.0, 0, 'f', 3)
+                        .arg(record.sequence)
+                        .arg(record.timestamps.runningTime)
+                        .toUtf8();
+        }
+    }
+    if (json.endsWith(",\n")) {
+        json.chop(2);
+    }
+    json += "\n]}\n";
+    return file.write(json) == json.size();
+}
+
+void FrameTracer::reset() {
+    for (auto& histogram : m_histograms) {
+        histogram.reset();
+    }
+    m_fps.store(0.0, std::memory_order_relaxed);
+    m_fpsWindowStart.store(0, std::memory_order_relaxed);
+    m_fpsFrames.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+#include <memory>
+
+// FrameTimestamps: Where one frame was when, from capture to paint, in FrameTracer::now() nanoseconds.
+// Zero means the frame never reached that point.
+struct FrameTimestamps {
+    enum Point {
+        Capture, // Sensor time, derived from the buffer's running time.
+        Callback, // newFrameCallback pulled the sample.
+        EffectStart, // The worker took the frame out of the mailbox.
+        EffectEnd, // Effects done; the frame is queued to the GUI thread.
+        Delivered, // The view received the frame on the GUI thread.
+        Painted, // paintEvent drew it.
+        PointCount
+    };
+
+    std::array<qint64, PointCount> at{};
+    qint64 runningTime = -1; // Buffer PTS as pipeline running time, in nanoseconds; -1 if unknown.
+};
+
+// LatencyHistogram: Lock-free log-scale histogram of durations. Buckets are a quarter octave wide
+// from 1 us to about 16 s, so percentiles are accurate to roughly 20%.
+class LatencyHistogram {
+public:
+    static constexpr int bucketCount = 1 + 24 * 4;
+
+    void add(qint64 nanoseconds); // Safe from any thread.
+    quint64 count() const { return m_count.load(std::memory_order_relaxed); }
+    qint64 percentile(double p) const; // Upper bound of the bucket holding the p-th percentile, in ns.
+    void reset();
+
+private:
+    static int bucketFor(qint64 nanoseconds);
+    static qint64 upperBound(int bucket);
+
+    std::array<std::atomic<quint64>, bucketCount> m_buckets{};
+    std::atomic<quint64> m_count{ 0 };
+};
+
+// FrameTracer: Collects the timestamps of every painted frame into per-stage histograms and,
+// optionally, into a trace that can be exported as Chrome trace-event JSON.
+class FrameTracer {
+public:
+    enum Stage {
+        Camera, // Capture to callback.
+        Queue, // Callback to effect start: mailbox wait.
+        Effects, // Effect start to end.
+        Delivery, // Effect end to the view: the queued signal.
+        Paint, // Delivery to paint.
+        Total, // Capture to paint.
+        StageCount
+    };
+
+    static FrameTracer& global();
+    static qint64 now(); // Monotonic nanoseconds.
+    static const char* stageName(Stage stage);
+
+    // Adds one painted frame. Lock-free; meant to be called from paintEvent.
+    void record(const FrameTimestamps& frame, quint64 sequence);
+
+    const LatencyHistogram& histogram(Stage stage) const { return m_histograms[stage]; }
+    double fps() const { return m_fps.load(std::memory_order_relaxed); }
+
+    // Keeps up to capacity frames for export; the buffer is allocated here, not while streaming.
+    void startRecording(int capacity = 100000);
+    bool isRecording() const { return m_recording.load(std::memory_order_acquire); }
+    bool exportChromeTrace(const QString& path) const;
+
+    void reset();
+
+private:
+    struct Record {
+        FrameTimestamps timestamps;
+        quint64 sequence = 0;
+    };
+
+    std::array<LatencyHistogram, StageCount> m_histograms;
+
+    std::atomic<double> m_fps{ 0.0 };
+    std::atomic<qint64> m_fpsWindowStart{ 0 };
+    std::atomic<int> m_fpsFrames{ 0 };
+
+    std::unique_ptr<Record[]> m_records;
+    int m_capacity = 0;
+    std::atomic<int> m_recordCount{ 0 }; // Slots claimed; may exceed m_capacity once full.
+    std::atomic<bool> m_recording{ false };
+};
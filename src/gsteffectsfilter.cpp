@@ -0,0 +1,294 @@
+#include "gsteffectsfilter.h"
+#include "effectchain.h"
+#include <gst/video/video.h>
+#include <gst/video/gstvideofilter.h>
+#include <algorithm>
+#include <mutex>
+
+namespace {
+
+constexpr int maxBrightness = 255;
+constexpr int maxBlurRadius = 200; // The blur slider's range.
+constexpr int maxDetailAmount = 1000; // Percent; SeparableFilter clamps to this too.
+
+enum Property {
+    PropertyNone,
+    PropertyGray,
+    PropertyBrightness,
+    PropertyBlur,
+    PropertyBlurQuality,
+    PropertyDetail,
+    PropertyDetailAmount,
+    PropertyDetailRadius,
+};
+
+// blurQualityType: ImageProcessing::BlurQuality as a GEnum, so gst-launch syntax takes the names.
+GType blurQualityType() {
+    static const GType type = [] {
+        static const GEnumValue values[] = {
+            { static_cast<gint>(ImageProcessing::BlurQuality::Box), "One box pass", "box" },
+            { static_cast<gint>(ImageProcessing::BlurQuality::Gaussian), "Three box passes approximating a Gaussian", "gaussian" },
+            { static_cast<gint>(ImageProcessing::BlurQuality::Pyramid), "Gaussian at a reduced resolution", "pyramid" },
+            { static_cast<gint>(ImageProcessing::BlurQuality::Kernel), "Exact Gaussian kernel", "kernel" },
+            { 0, nullptr, nullptr },
+        };
+        return g_enum_register_static("QtGstEffectsBlurQuality", values);
+    }();
+    return type;
+}
+
+GType detailFilterType() {
+    static const GType type = [] {
+        static const GEnumValue values[] = {
+            { static_cast<gint>(ImageProcessing::DetailFilter::None), "No detail filter", "none" },
+            { static_cast<gint>(ImageProcessing::DetailFilter::Sharpen), "3x3 sharpen", "sharpen" },
+            { static_cast<gint>(ImageProcessing::DetailFilter::UnsharpMask), "Unsharp mask", "unsharp" },
+            { static_cast<gint>(ImageProcessing::DetailFilter::Edges), "Sobel edge magnitude", "edges" },
+            { 0, nullptr, nullptr },
+        };
+        return g_enum_register_static("QtGstEffectsDetailFilter", values);
+    }();
+    return type;
+}
+
+// FilterState: The C++ side of an element instance. GObject allocates the instance struct
+// without running constructors, so it only holds a pointer to this.
+struct FilterState {
+    std::mutex mutex; // Guards settings; properties are set from any thread.
+    EffectSettings settings;
+    EffectChain chain; // Streaming thread only.
+};
+
+struct QtGstEffects {
+    GstVideoFilter parent;
+    FilterState* state;
+};
+
+struct QtGstEffectsClass {
+    GstVideoFilterClass parent_class;
+};
+
+GType qt_gst_effects_get_type();
+G_DEFINE_TYPE(QtGstEffects, qt_gst_effects, GST_TYPE_VIDEO_FILTER)
+
+// rgbLayout: The kernel layout of a packed RGB frame format, or Unsupported. The 0xffRRGGBB words
+// of Format_RGB32 are BGRx bytes on little-endian CPUs and xRGB bytes on big-endian ones.
+PixelFormat::Layout rgbLayout(GstVideoFormat format) {
+    switch (format) {
+    case GST_VIDEO_FORMAT_RGB: return PixelFormat::Layout::Rgb888;
+    case GST_VIDEO_FORMAT_RGBx: return PixelFormat::Layout::Rgbx8888;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    case GST_VIDEO_FORMAT_BGRx: return PixelFormat::Layout::Xrgb32;
+#else
+    case GST_VIDEO_FORMAT_xRGB: return PixelFormat::Layout::Xrgb32;
+#endif
+    case GST_VIDEO_FORMAT_GRAY8: return PixelFormat::Layout::Gray8;
+    default: return PixelFormat::Layout::Unsupported;
+    }
+}
+
+QtGstEffects* toEffects(gpointer object) {
+    return reinterpret_cast<QtGstEffects*>(object);
+}
+
+// updatePassthrough: With nothing to do GstBaseTransform forwards buffers untouched and never asks
+// for a writable one, so an idle filter costs no copy.
+void updatePassthrough(QtGstEffects* self) {
+    bool active = false;
+    {
+        std::lock_guard lock(self->state->mutex);
+        const EffectSettings& settings = self->state->settings;
+        active = settings.grayscaleEnabled
+            || (settings.brightnessEnabled && settings.brightnessValue != 0)
+            || (settings.blurEnabled && settings.blurValue > 0)
+            || settings.detailFilter == ImageProcessing::DetailFilter::Edges
+            || (settings.detailFilter != ImageProcessing::DetailFilter::None && settings.detailAmount > 0);
+    }
+    gst_base_transform_set_passthrough(GST_BASE_TRANSFORM(self), !active);
+}
+
+void setProperty(GObject* object, guint id, const GValue* value, GParamSpec* spec) {
+    QtGstEffects* self = toEffects(object);
+    {
+        std::lock_guard lock(self->state->mutex);
+        EffectSettings& settings = self->state->settings;
+        switch (id) {
+        case PropertyGray:
+            settings.grayscaleEnabled = g_value_get_boolean(value);
+            break;
+        case PropertyBrightness:
+            settings.brightnessValue = g_value_get_int(value);
+            settings.brightnessEnabled = settings.brightnessValue != 0;
+            break;
+        case PropertyBlur:
+            settings.blurValue = g_value_get_int(value);
+            settings.blurEnabled = settings.blurValue > 0;
+            break;
+        case PropertyBlurQuality:
+            settings.blurQuality = static_cast<ImageProcessing::BlurQuality>(g_value_get_enum(value));
+            break;
+        case PropertyDetail:
+            settings.detailFilter = static_cast<ImageProcessing::DetailFilter>(g_value_get_enum(value));
+            break;
+        case PropertyDetailAmount:
+            settings.detailAmount = g_value_get_int(value);
+            break;
+        case PropertyDetailRadius:
+            settings.detailRadius = g_value_get_int(value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, id, spec);
+            return;
+        }
+    }
+    updatePassthrough(self);
+}
+
+void getProperty(GObject* object, guint id, GValue* value, GParamSpec* spec) {
+    QtGstEffects* self = toEffects(object);
+    std::lock_guard lock(self->state->mutex);
+    const EffectSettings& settings = self->state->settings;
+    switch (id) {
+    case PropertyGray:
+        g_value_set_boolean(value, settings.grayscaleEnabled);
+        break;
+    case PropertyBrightness:
+        g_value_set_int(value, settings.brightnessEnabled ? settings.brightnessValue : 0);
+        break;
+    case PropertyBlur:
+        g_value_set_int(value, settings.blurEnabled ? settings.blurValue : 0);
+        break;
+    case PropertyBlurQuality:
+        g_value_set_enum(value, static_cast<gint>(settings.blurQuality));
+        break;
+    case PropertyDetail:
+        g_value_set_enum(value, static_cast<gint>(settings.detailFilter));
+        break;
+    case PropertyDetailAmount:
+        g_value_set_int(value, settings.detailAmount);
+        break;
+    case PropertyDetailRadius:
+        g_value_set_int(value, settings.detailRadius);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, id, spec);
+        break;
+    }
+}
+
+void finalize(GObject* object) {
+    delete toEffects(object)->state;
+    G_OBJECT_CLASS(qt_gst_effects_parent_class)->finalize(object);
+}
+
+// transformFrameIp: Runs on the streaming thread with the frame mapped for writing.
+GstFlowReturn transformFrameIp(GstVideoFilter* filter, GstVideoFrame* frame) {
+    QtGstEffects* self = toEffects(filter);
+    if (!(frame->map[0].flags & GST_MAP_WRITE)) {
+        return GST_FLOW_OK; // Passthrough when the buffer was mapped; an effect switched on takes over from the next one.
+    }
+    EffectSettings settings;
+    {
+        std::lock_guard lock(self->state->mutex);
+        settings = self->state->settings;
+    }
+    EffectChain& chain = self->state->chain;
+    chain.configure(settings);
+
+    const int width = GST_VIDEO_FRAME_WIDTH(frame);
+    const int height = GST_VIDEO_FRAME_HEIGHT(frame);
+    auto plane = [frame](int index) { return static_cast<uchar*>(GST_VIDEO_FRAME_PLANE_DATA(frame, index)); };
+    auto stride = [frame](int index) { return GST_VIDEO_FRAME_PLANE_STRIDE(frame, index); };
+
+    const GstVideoFormat format = GST_VIDEO_FRAME_FORMAT(frame);
+    if (const PixelFormat::Layout layout = rgbLayout(format); layout != PixelFormat::Layout::Unsupported) {
+        chain.processInto(plane(0), stride(0), plane(0), stride(0), width, height, layout);
+        return GST_FLOW_OK;
+    }
+    switch (format) {
+    case GST_VIDEO_FORMAT_NV12: {
+        YuvImage image = YuvImage::wrapWritable(YuvImage::Format::NV12, width, height,
+            { plane(0), plane(1), nullptr }, { stride(0), stride(1), 0 });
+        chain.processInPlace(image);
+        break;
+    }
+    case GST_VIDEO_FORMAT_I420: {
+        YuvImage image = YuvImage::wrapWritable(YuvImage::Format::I420, width, height,
+            { plane(0), plane(1), plane(2) }, { stride(0), stride(1), stride(2) });
+        chain.processInPlace(image);
+        break;
+    }
+    default:
+        return GST_FLOW_NOT_NEGOTIATED; // The pad templates only allow the formats above.
+    }
+    return GST_FLOW_OK;
+}
+
+void qt_gst_effects_class_init(QtGstEffectsClass* klass) {
+    GObjectClass* objectClass = G_OBJECT_CLASS(klass);
+    objectClass->set_property = &setProperty;
+    objectClass->get_property = &getProperty;
+    objectClass->finalize = &finalize;
+
+    const auto flags = static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_CONTROLLABLE);
+    g_object_class_install_property(objectClass, PropertyGray,
+        g_param_spec_boolean("gray", "Gray", "Replace every pixel with its luma", FALSE, flags));
+    g_object_class_install_property(objectClass, PropertyBrightness,
+        g_param_spec_int("brightness", "Brightness", "Offset added to every channel (0 is off)",
+            -maxBrightness, maxBrightness, 0, flags));
+    g_object_class_install_property(objectClass, PropertyBlur,
+        g_param_spec_int("blur", "Blur", "Box blur radius in pixels (0 is off)", 0, maxBlurRadius, 0, flags));
+    g_object_class_install_property(objectClass, PropertyBlurQuality,
+        g_param_spec_enum("blur-quality", "Blur quality", "How the blur radius is realized", blurQualityType(),
+            static_cast<gint>(ImageProcessing::BlurQuality::Box), flags));
+    g_object_class_install_property(objectClass, PropertyDetail,
+        g_param_spec_enum("detail", "Detail", "Sharpen, unsharp mask or edges after the blur", detailFilterType(),
+            static_cast<gint>(ImageProcessing::DetailFilter::None), flags));
+    g_object_class_install_property(objectClass, PropertyDetailAmount,
+        g_param_spec_int("detail-amount", "Detail amount", "Percent of the detail sharpen and unsharp add back",
+            0, maxDetailAmount, 100, flags));
+    g_object_class_install_property(objectClass, PropertyDetailRadius,
+        g_param_spec_int("detail-radius", "Detail radius", "Blur radius of the unsharp mask",
+            1, ImageProcessing::maxKernelBlurRadius, 3, flags));
+
+    GstElementClass* elementClass = GST_ELEMENT_CLASS(klass);
+    gst_element_class_set_static_metadata(elementClass, "Qt-Gst-Camera effects", "Filter/Effect/Video",
+        "Grayscale, brightness, blur, sharpen and edges, applied in place", "Qt-Gst-Camera");
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    GstCaps* caps = gst_caps_from_string(GST_VIDEO_CAPS_MAKE("{ BGRx, RGBx, RGB, GRAY8, NV12, I420 }"));
+#else
+    GstCaps* caps = gst_caps_from_string(GST_VIDEO_CAPS_MAKE("{ xRGB, RGBx, RGB, GRAY8, NV12, I420 }"));
+#endif
+    gst_element_class_add_pad_template(elementClass, gst_pad_template_new("sink", GST_PAD_SINK, GST_PAD_ALWAYS, caps));
+    gst_element_class_add_pad_template(elementClass, gst_pad_template_new("src", GST_PAD_SRC, GST_PAD_ALWAYS, caps));
+    gst_caps_unref(caps);
+
+    GST_VIDEO_FILTER_CLASS(klass)->transform_frame_ip = &transformFrameIp;
+}
+
+void qt_gst_effects_init(QtGstEffects* self) {
+    self->state = new FilterState;
+    gst_base_transform_set_in_place(GST_BASE_TRANSFORM(self), TRUE);
+    gst_base_transform_set_passthrough(GST_BASE_TRANSFORM(self), TRUE); // No effect until a property is set.
+}
+
+} // namespace
+
+// registerElement: gst_element_register with no plugin makes the element available to
+// gst_parse_launch and gst_element_factory_make in this process only.
+bool GstEffectsFilter::registerElement() {
+    static const bool registered = gst_element_register(nullptr, "qtgsteffects", GST_RANK_NONE, qt_gst_effects_get_type());
+    return registered;
+}
+
+void GstEffectsFilter::applySettings(GstElement* element, const EffectSettings& settings) {
+    g_object_set(element,
+        "gray", settings.grayscaleEnabled ? TRUE : FALSE,
+        "brightness", settings.brightnessEnabled ? std::clamp(settings.brightnessValue, -maxBrightness, maxBrightness) : 0,
+        "blur", settings.blurEnabled ? std::clamp(settings.blurValue, 0, maxBlurRadius) : 0,
+        "blur-quality", static_cast<gint>(settings.blurQuality),
+        "detail", static_cast<gint>(settings.detailFilter),
+        "detail-amount", std::clamp(settings.detailAmount, 0, maxDetailAmount),
+        "detail-radius", std::clamp(settings.detailRadius, 1, ImageProcessing::maxKernelBlurRadius),
+        nullptr);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "effectsettings.h"
+#include <gst/gst.h>
+
+// GstEffectsFilter: The EffectChain packaged as a GStreamer video filter, "qtgsteffects".
+// It runs on the streaming thread and writes into the buffer it receives; when that buffer is
+// shared, GstBaseTransform hands it a writable copy from the downstream pool first. With no effect
+// active the element is in passthrough and never touches the pixels. Accepts RGB, BGRx (xRGB on
+// big-endian CPUs), RGBx, GRAY8, NV12 and I420.
+//
+//   v4l2src ! videoconvert ! qtgsteffects gray=true brightness=10 blur=3 ! tee name=t ! ...
+//
+// Properties: gray (boolean), brightness (-255..255, 0 is off), blur (radius, 0 is off),
+// blur-quality (box, gaussian, pyramid or kernel), detail (none, sharpen, unsharp or edges),
+// detail-amount (percent) and detail-radius (the unsharp mask's, 1..6).
+// All of them can be changed while playing.
+class GstEffectsFilter {
+public:
+    // Registers the element for this process, without a plugin file. Needs gst_init first;
+    // later calls do nothing. Returns false if GStreamer refused the registration.
+    static bool registerElement();
+
+    // Sets an element's properties from the settings, e.g. one found by name in a parsed pipeline.
+    static void applySettings(GstElement* element, const EffectSettings& settings);
+
+private:
+    GstEffectsFilter() = delete; // Prevent instantiation
+};
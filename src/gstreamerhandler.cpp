@@ -1,35 +1,362 @@
 #include "gstreamerhandler.h"
+#include "framebufferpool.h"
+#include "gsteffectsfilter.h"
+#include "gstreplaysource.h"
 
-// Constructor: Initializes GStreamer and sets up the object within a Qt parent-child hierarchy.
+namespace {
+
+// GstQueueLeaky values of the queue's "leaky" property.
+constexpr gint queueNotLeaky = 0;
+constexpr gint queueLeakyDownstream = 2; // Drops the oldest buffer, keeping the newest.
+
+// Processed frames alive at once: one being made, one queued to the view, one on screen, one spare.
+constexpr int framesInFlight = 4;
+
+// rgbCapsFormat: The GStreamer name of an RGB format the appsink can ask for.
+const char* rgbCapsFormat(QImage::Format format) {
+    switch (format) {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    case QImage::Format_RGB32: return "BGRx"; // 0xffRRGGBB words.
+#else
+    case QImage::Format_RGB32: return "xRGB";
+#endif
+    case QImage::Format_RGBX8888: return "RGBx";
+    case QImage::Format_Grayscale8: return "GRAY8";
+    default: return "RGB";
+    }
+}
+
+// stampCapture: Dates the frame back to capture. The buffer's running time says when it was
+// captured on the pipeline clock and the clock says what time it is now; the difference is the
+// frame's age, which carries over to the steady clock the tracer uses.
+void stampCapture(GstAppSink* appsink, GstSample* sample, VideoFrame& frame, qint64 pulled) {
+    GstBuffer* buffer = gst_sample_get_buffer(sample);
+    const GstSegment* segment = gst_sample_get_segment(sample);
+    if (!buffer || !segment || !GST_BUFFER_PTS_IS_VALID(buffer)) {
+        return;
+    }
+    const guint64 runningTime = gst_segment_to_running_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+    if (!GST_CLOCK_TIME_IS_VALID(runningTime)) {
+        return;
+    }
+    frame.setRunningTime(static_cast<qint64>(runningTime));
+
+    GstClock* clock = gst_element_get_clock(GST_ELEMENT(appsink));
+    if (!clock) {
+        return; // Not playing yet.
+    }
+    const GstClockTime now = gst_clock_get_time(clock);
+    const GstClockTime baseTime = gst_element_get_base_time(GST_ELEMENT(appsink));
+    gst_object_unref(clock);
+    const qint64 age = static_cast<qint64>(now - baseTime) - static_cast<qint64>(runningTime);
+    if (age >= 0) { // A source running ahead of the clock (not live) has no meaningful capture time.
+        frame.stamp(FrameTimestamps::Capture, pulled - age);
+    }
+}
+
+} // namespace
+
+// Constructor: Sets up the object within a Qt parent-child hierarchy. GStreamer itself is
+// initialized by the first start, so constructing the handler costs nothing on the GUI thread.
 GStreamerHandler::GStreamerHandler(QObject* parent) : QObject(parent) {
-    gst_init(nullptr, nullptr); 
+    qRegisterMetaType<VideoFrame>(); // Frames are delivered across threads through queued connections.
 }
 
-// Destructor: Ensures the GStreamer pipeline is stopped properly to free resources.
+// Destructor: Ensures the GStreamer pipeline is torn down, prepared or not, to free resources.
 GStreamerHandler::~GStreamerHandler() {
-    stopPipeline(); 
+    joinControl();
+    teardown();
+}
+
+// initialize: gst_init scans the plugin registry, which takes from milliseconds (cached) to seconds
+// (first run after an install), so it is timed and kept off the GUI thread by startPipelineAsync.
+qint64 GStreamerHandler::initialize() {
+    static std::once_flag once;
+    qint64 elapsed = 0;
+    std::call_once(once, [&elapsed] {
+        const qint64 begin = FrameTracer::now();
+        gst_init(nullptr, nullptr);
+        GstEffectsFilter::registerElement(); // qtgsteffects can be used in any source or branch string.
+        GstReplaySource::registerElement(); // As can qtgstreplaysrc.
+        elapsed = FrameTracer::now() - begin;
+    });
+    return elapsed;
+}
+
+bool GStreamerHandler::canCrop() {
+    initialize();
+    static const bool available = [] {
+        GstElementFactory* factory = gst_element_factory_find("videocrop");
+        if (factory) {
+            gst_object_unref(factory);
+        }
+        return factory != nullptr;
+    }();
+    return available;
+}
+
+// setSource: Replaces the capture source, e.g. "videotestsrc is-live=true" for headless runs.
+void GStreamerHandler::setSource(const QString& source) {
+    std::lock_guard lock(m_mutex);
+    m_configChanged = m_configChanged || source != m_source;
+    m_source = source;
+}
+
+QString GStreamerHandler::source() const {
+    std::lock_guard lock(m_mutex);
+    return m_source;
+}
+
+void GStreamerHandler::setNativeFormats(bool enabled) {
+    std::lock_guard lock(m_mutex);
+    m_configChanged = m_configChanged || enabled != m_nativeFormats;
+    m_nativeFormats = enabled;
+}
+
+void GStreamerHandler::setRgbFormat(QImage::Format format) {
+    switch (format) {
+    case QImage::Format_RGB32:
+    case QImage::Format_RGBX8888:
+    case QImage::Format_Grayscale8:
+        break;
+    default:
+        format = QImage::Format_RGB888;
+        break;
+    }
+    std::lock_guard lock(m_mutex);
+    m_configChanged = m_configChanged || format != m_rgbFormat;
+    m_rgbFormat = format;
+}
+
+QImage::Format GStreamerHandler::rgbFormat() const {
+    std::lock_guard lock(m_mutex);
+    return m_rgbFormat;
+}
+
+void GStreamerHandler::setOutputSize(const QSize& size) {
+    std::lock_guard lock(m_mutex);
+    if (size == m_outputSize) {
+        return;
+    }
+    m_outputSize = size;
+    applyOutputSize();
+}
+
+// applyOutputSize: Bounds the size after videoscale. With ranges and a square pixel aspect ratio,
+// videoscale picks the largest size inside the bounds that keeps the picture's shape.
+void GStreamerHandler::applyOutputSize() {
+    if (!m_scaleFilter) {
+        return; // Applied when the pipeline is built.
+    }
+    const QByteArray capsStr = m_outputSize.isEmpty()
+        ? QByteArray("video/x-raw")
+        : QStringLiteral("video/x-raw, width=(int)[1, %1], height=(int)[1, %2], pixel-aspect-ratio=(fraction)1/1")
+            .arg(m_outputSize.width()).arg(m_outputSize.height()).toUtf8();
+    GstCaps* caps = gst_caps_from_string(capsStr.constData());
+    g_object_set(m_scaleFilter.get(), "caps", caps, nullptr); // The capsfilter asks upstream to renegotiate.
+    gst_caps_unref(caps);
 }
 
-// startPipeline: Configures and starts the GStreamer pipeline for video processing.
-void GStreamerHandler::startPipeline() {
+void GStreamerHandler::setRegionOfInterest(const RegionOfInterest& region) {
+    std::lock_guard lock(m_mutex);
+    if (region == m_region) {
+        return;
+    }
+    m_region = region;
+    applyCrop();
+}
+
+RegionOfInterest GStreamerHandler::regionOfInterest() const {
+    std::lock_guard lock(m_mutex);
+    return m_region;
+}
+
+// applyCrop: videocrop takes margins in pixels, so the region is converted at the size of the frames
+// entering it, on an even grid so that 4:2:0 and 4:2:2 chroma stays whole. New margins make
+// videocrop renegotiate with the next buffer.
+void GStreamerHandler::applyCrop() {
+    if (!m_crop || m_cropInput.isEmpty()) {
+        return; // Applied when the caps arrive.
+    }
+    const QRect rect = m_region.toPixels(m_cropInput, 2);
+    g_object_set(m_crop.get(),
+        "left", rect.left(),
+        "top", rect.top(),
+        "right", m_cropInput.width() - rect.left() - rect.width(),
+        "bottom", m_cropInput.height() - rect.top() - rect.height(),
+        nullptr);
+}
+
+// cropCapsProbe: Sees each caps event before videocrop does, so frames at a new source resolution
+// are cropped with margins made for it.
+GstPadProbeReturn GStreamerHandler::cropCapsProbe(GstPad*, GstPadProbeInfo* info, gpointer data) {
+    GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+    if (GST_EVENT_TYPE(event) != GST_EVENT_CAPS) {
+        return GST_PAD_PROBE_OK;
+    }
+    GstCaps* caps = nullptr;
+    gst_event_parse_caps(event, &caps);
+    const GstStructure* structure = caps && !gst_caps_is_empty(caps) ? gst_caps_get_structure(caps, 0) : nullptr;
+    int width = 0;
+    int height = 0;
+    if (structure && gst_structure_get_int(structure, "width", &width) && gst_structure_get_int(structure, "height", &height)) {
+        auto* handler = static_cast<GStreamerHandler*>(data);
+        std::lock_guard lock(handler->m_mutex);
+        handler->m_cropInput = QSize(width, height);
+        handler->applyCrop();
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+void GStreamerHandler::setPipelineEffects(bool enabled) {
+    std::lock_guard lock(m_mutex);
+    m_configChanged = m_configChanged || enabled != m_pipelineEffects;
+    m_pipelineEffects = enabled;
+}
+
+bool GStreamerHandler::pipelineEffects() const {
+    std::lock_guard lock(m_mutex);
+    return m_pipelineEffects;
+}
+
+void GStreamerHandler::setEffects(const EffectSettings& settings) {
+    std::lock_guard lock(m_mutex);
+    m_effectSettings = settings;
+    if (m_effects) {
+        GstEffectsFilter::applySettings(m_effects.get(), m_effectSettings);
+    }
+}
+
+void GStreamerHandler::setBranches(const QStringList& branches) {
+    std::lock_guard lock(m_mutex);
+    m_configChanged = m_configChanged || branches != m_branches;
+    m_branches = branches;
+}
+
+void GStreamerHandler::setDropPolicy(const DropPolicy& policy) {
+    std::lock_guard lock(m_mutex);
+    m_dropPolicy = policy;
+    applyDropPolicy();
+}
+
+DropPolicy GStreamerHandler::dropPolicy() const {
+    std::lock_guard lock(m_mutex);
+    return m_dropPolicy;
+}
+
+// applyDropPolicy: The queue holds the policy's capacity in buffers and, unless lossless, leaks the
+// oldest one when full. Lossless lets the full queue block the source instead. The appsink gets the
+// same bound; newFrameCallback pulls every sample as it arrives, so it rarely holds more than one.
+void GStreamerHandler::applyDropPolicy() {
+    m_queueLeaky.store(m_dropPolicy.drops(), std::memory_order_relaxed);
+    const guint capacity = static_cast<guint>(m_dropPolicy.capacity());
+    if (m_queue) {
+        g_object_set(m_queue.get(),
+            "max-size-buffers", capacity,
+            "max-size-bytes", 0u,
+            "max-size-time", static_cast<guint64>(0),
+            "leaky", m_dropPolicy.drops() ? queueLeakyDownstream : queueNotLeaky,
+            nullptr);
+    }
+    if (m_sink) {
+        g_object_set(m_sink, "max-buffers", capacity, "drop", m_dropPolicy.drops() ? TRUE : FALSE, nullptr);
+    }
+}
+
+void GStreamerHandler::setKeepPrepared(bool enabled) {
+    std::lock_guard lock(m_mutex);
+    m_keepPrepared = enabled;
+}
+
+// buildPipeline: Parses the pipeline from the current configuration and wires up its elements,
+// leaving it in NULL. The parse runs without the lock, so setters never wait for it.
+bool GStreamerHandler::buildPipeline(QString& failure) {
     // Pipeline configuration string.
-    const char* pipelineStr = "mfvideosrc device-index=0 ! videoconvert ! video/x-raw,format=RGB ! appsink name=sink";
+    // videoconvert is a passthrough whenever the source already produces a format the appsink accepts,
+    // and videoscale whenever no output size is set.
+    // videocrop, when installed, cuts the region of interest out before anything else touches the
+    // pixels, and is a passthrough while the region is the whole frame.
+    // The queue gives the appsink callback its own streaming thread; the drop policy decides whether it leaks or blocks.
+    // In-pipeline effects run after videoscale, on as few pixels as possible, and before the tee,
+    // so every branch gets the processed frame without processing it again.
+    // Stills branch off before videoscale through a valve that drops everything outside a burst;
+    // its videoconvert copies each still into a buffer of its own, so stills waiting to be encoded
+    // never hold the camera's buffers. Its appsink does not preroll, since it usually gets nothing.
+    QString pipeline;
+    QByteArray capsStr;
+    {
+        std::lock_guard lock(m_mutex);
+        pipeline = QStringLiteral("%1 ! videoconvert ! tee name=stilltee ! %2videoscale ! capsfilter name=scale ! ")
+            .arg(m_source, canCrop() ? QStringLiteral("videocrop name=crop ! ") : QString());
+        if (m_pipelineEffects) {
+            pipeline += QStringLiteral("qtgsteffects name=effects ! ");
+        }
+        if (!m_branches.isEmpty()) {
+            pipeline += QStringLiteral("tee name=fanout ! ");
+        }
+        pipeline += QStringLiteral("queue name=queue ! appsink name=sink");
+        for (const QString& branch : m_branches) {
+            // A slow branch leaks its own frames instead of holding the camera and the other branches.
+            pipeline += QStringLiteral(" fanout. ! queue leaky=downstream max-size-buffers=%1 ! %2").arg(framesInFlight).arg(branch);
+        }
+        pipeline += QStringLiteral(" stilltee. ! valve name=stillvalve drop=true ! queue leaky=downstream max-size-buffers=%1"
+            " ! videoconvert ! appsink name=stills async=false emit-signals=true sync=false caps=\"video/x-raw, format=(string)%2\"")
+            .arg(framesInFlight).arg(QLatin1String(rgbCapsFormat(m_rgbFormat)));
+        // Formats the frame processor can work on directly; the first one the source offers wins.
+        capsStr = (m_nativeFormats
+            ? QStringLiteral("video/x-raw, format=(string){ YUY2, NV12, I420, %1 }")
+            : QStringLiteral("video/x-raw, format=(string)%1")).arg(QLatin1String(rgbCapsFormat(m_rgbFormat))).toUtf8();
+        m_configChanged = false;
+    }
+    const QByteArray pipelineStr = pipeline.toUtf8();
     GError* error = nullptr;
     // Creates the pipeline from the configuration string and checks for errors.
-    m_pipeline.reset(gst_parse_launch(pipelineStr, &error));
-    if (!m_pipeline) {
-        qDebug() << "Failed to create pipeline: " << error->message;
-        g_error_free(error); // Frees the error object if pipeline creation failed.
-        return;
+    GstElement* element = gst_parse_launch(pipelineStr.constData(), &error);
+    if (!element) {
+        failure = QStringLiteral("Failed to create pipeline: %1").arg(QString::fromUtf8(error ? error->message : "unknown error"));
+        if (error) {
+            g_error_free(error); // Frees the error object if pipeline creation failed.
+        }
+        return false;
+    }
+    if (error) {
+        g_error_free(error); // A recoverable error, e.g. a missing property, still yields a pipeline.
     }
 
+    std::lock_guard lock(m_mutex);
+    m_pipeline.reset(element);
     // Retrieves the appsink element by its name to configure it and connect signals.
     m_sink = gst_bin_get_by_name(GST_BIN(m_pipeline.get()), "sink");
     if (!m_sink) {
-        qDebug() << "Failed to find sink element"; // Error handling if the sink element is not found.
-        return;
+        failure = QStringLiteral("Failed to find sink element"); // Error handling if the sink element is not found.
+        return false;
+    }
+
+    m_scaleFilter.reset(gst_bin_get_by_name(GST_BIN(m_pipeline.get()), "scale"));
+    applyOutputSize();
+
+    m_crop.reset(gst_bin_get_by_name(GST_BIN(m_pipeline.get()), "crop"));
+    m_cropInput = QSize();
+    if (m_crop) {
+        GstPad* pad = gst_element_get_static_pad(m_crop.get(), "sink");
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, &GStreamerHandler::cropCapsProbe, this, nullptr);
+        gst_object_unref(pad);
+    }
+
+    m_effects.reset(gst_bin_get_by_name(GST_BIN(m_pipeline.get()), "effects"));
+    if (m_effects) {
+        GstEffectsFilter::applySettings(m_effects.get(), m_effectSettings);
     }
 
+    m_queue.reset(gst_bin_get_by_name(GST_BIN(m_pipeline.get()), "queue"));
+    applyDropPolicy();
+    // A full queue emits overrun before it leaks, so every overrun of a leaky queue is one dropped frame.
+    g_signal_connect(m_queue.get(), "overrun", G_CALLBACK(&GStreamerHandler::queueOverrunCallback), this);
+
+    GstCaps* caps = gst_caps_from_string(capsStr.constData());
+    gst_app_sink_set_caps(GST_APP_SINK(m_sink), caps);
+    gst_caps_unref(caps);
+
     // Configure the appsink to emit signals for new samples and operate asynchronously.
     g_object_set(m_sink, "emit-signals", TRUE, "sync", FALSE, nullptr);
     // Connects the "new-sample" signal of the appsink to the newFrameCallback function.
@@ -38,55 +365,367 @@ void GStreamerHandler::startPipeline() {
         return handler->newFrameCallback(sink, handler); // Calls the member function to handle the new sample.
     }), this);
 
-    // Sets the pipeline state to PLAYING, starting the video capture and processing.
-    gst_element_set_state(m_pipeline.get(), GST_STATE_PLAYING);
+    m_stillValve.reset(gst_bin_get_by_name(GST_BIN(m_pipeline.get()), "stillvalve"));
+    m_stillSink.reset(gst_bin_get_by_name(GST_BIN(m_pipeline.get()), "stills"));
+    m_stillsRemaining.store(0, std::memory_order_relaxed);
+    if (m_stillSink) {
+        g_signal_connect(m_stillSink.get(), "new-sample", G_CALLBACK(&GStreamerHandler::stillCallback), this);
+    }
+
+    // Errors, end-of-stream and the pipeline's state changes are reported as signals; nothing else on the bus is kept.
+    GstBus* bus = gst_element_get_bus(m_pipeline.get());
+    gst_bus_set_sync_handler(bus, &GStreamerHandler::busCallback, this, nullptr);
+    gst_object_unref(bus);
+    return true;
+}
+
+// teardown: Takes the pipeline to NULL, which closes the camera, and releases it.
+void GStreamerHandler::teardown() {
+    GstElement* pipeline = nullptr;
+    {
+        std::lock_guard lock(m_mutex);
+        pipeline = m_pipeline.get();
+        m_prepared = false;
+    }
+    if (pipeline) {
+        gst_element_set_state(pipeline, GST_STATE_NULL); // Sets the pipeline state to NULL, stopping it.
+    }
+    std::lock_guard lock(m_mutex);
+    if (m_sink) {
+        gst_object_unref(m_sink);
+        m_sink = nullptr;
+    }
+    m_scaleFilter.reset();
+    m_crop.reset();
+    m_cropInput = QSize();
+    m_effects.reset();
+    m_queue.reset();
+    m_stillValve.reset();
+    m_stillSink.reset();
+    m_stillsRemaining.store(0, std::memory_order_relaxed);
+    m_pipeline.reset();
+}
+
+// startNow: Reuses a prepared pipeline when nothing that needs a rebuild changed, and builds a new
+// one otherwise.
+bool GStreamerHandler::startNow(QString& failure) {
+    m_initNs.store(initialize(), std::memory_order_relaxed);
+    bool reuse = false;
+    {
+        std::lock_guard lock(m_mutex);
+        reuse = m_prepared && !m_configChanged && m_pipeline;
+    }
+    if (reuse) {
+        m_buildNs.store(0, std::memory_order_relaxed);
+    } else {
+        teardown();
+        const qint64 buildStart = FrameTracer::now();
+        if (!buildPipeline(failure)) {
+            teardown();
+            return false;
+        }
+        m_buildNs.store(FrameTracer::now() - buildStart, std::memory_order_relaxed);
+    }
+    m_startedPrepared.store(reuse, std::memory_order_relaxed);
+
+    GstElement* pipeline = nullptr;
+    {
+        std::lock_guard lock(m_mutex);
+        m_prepared = false;
+        pipeline = m_pipeline.get();
+    }
+    // Sets the pipeline state to PLAYING, starting the video capture and processing. The change
+    // usually completes asynchronously; the bus reports PLAYING and the appsink the first frame.
+    if (gst_element_set_state(pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+        failure = QStringLiteral("Failed to start pipeline");
+        m_awaitingFirstFrame.store(false, std::memory_order_relaxed);
+        teardown();
+        return false;
+    }
+    return true;
+}
+
+// markStart: Time to first frame counts from here, the moment the start was asked for.
+void GStreamerHandler::markStart() {
+    m_playingNs.store(-1, std::memory_order_relaxed);
+    m_firstFrameNs.store(-1, std::memory_order_relaxed);
+    m_startTime.store(FrameTracer::now(), std::memory_order_relaxed);
+    m_awaitingFirstFrame.store(true, std::memory_order_release);
+}
+
+// startPipeline: Configures and starts the GStreamer pipeline for video processing. Returns false if it could not be built or started.
+bool GStreamerHandler::startPipeline() {
+    joinControl();
+    markStart();
+    QString failure;
+    if (!startNow(failure)) {
+        qDebug() << failure;
+        return false;
+    }
+    return true;
+}
+
+// startPipelineAsync: The GUI thread only records when the start was asked for and hands the rest,
+// gst_init included, to the control thread.
+void GStreamerHandler::startPipelineAsync() {
+    joinControl();
+    markStart();
+    m_control = std::thread([this] {
+        QString failure;
+        if (!startNow(failure)) {
+            qDebug() << failure;
+            emit error(failure);
+        }
+    });
 }
 
-// stopPipeline: Stops the GStreamer pipeline, transitioning it to the NULL state.
+// prepareNow: READY allocates the pipeline's resources and opens the device, but moves no data.
+bool GStreamerHandler::prepareNow(QString& failure) {
+    initialize();
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_prepared && !m_configChanged && m_pipeline) {
+            return true;
+        }
+    }
+    teardown();
+    if (!buildPipeline(failure)) {
+        teardown();
+        return false;
+    }
+    GstElement* pipeline = nullptr;
+    {
+        std::lock_guard lock(m_mutex);
+        pipeline = m_pipeline.get();
+    }
+    if (gst_element_set_state(pipeline, GST_STATE_READY) == GST_STATE_CHANGE_FAILURE) {
+        failure = QStringLiteral("Failed to prepare pipeline");
+        teardown();
+        return false;
+    }
+    std::lock_guard lock(m_mutex);
+    m_prepared = true;
+    return true;
+}
+
+// prepareAsync: Called from the owner's thread, usually the GUI; waits only for a previous control
+// thread to finish, then builds the pipeline and takes it to READY on a new control thread. A
+// failure is reported through error from that thread.
+void GStreamerHandler::prepareAsync() {
+    joinControl();
+    m_control = std::thread([this] {
+        QString failure;
+        if (!prepareNow(failure)) {
+            qDebug() << failure;
+            emit error(failure);
+        }
+    });
+}
+
+// joinControl: Called from the owner's thread before anything that touches the pipeline; blocks until
+// a pending start or prepare on the control thread has finished, so the two never run at once.
+void GStreamerHandler::joinControl() {
+    if (m_control.joinable()) {
+        m_control.join();
+    }
+}
+
+// stopPipeline: Stops the GStreamer pipeline. With keep-prepared it only goes back to READY, so the
+// next start skips the rebuild; otherwise it goes to NULL and is released.
 void GStreamerHandler::stopPipeline() {
-    if (m_pipeline) {
-        gst_element_set_state(m_pipeline.get(), GST_STATE_NULL); // Sets the pipeline state to NULL, stopping it.
+    joinControl();
+    m_awaitingFirstFrame.store(false, std::memory_order_relaxed);
+    GstElement* pipeline = nullptr;
+    bool keep = false;
+    {
+        std::lock_guard lock(m_mutex);
+        pipeline = m_pipeline.get();
+        keep = m_keepPrepared && !m_configChanged;
+    }
+    if (!pipeline) {
+        return;
+    }
+    if (keep && gst_element_set_state(pipeline, GST_STATE_READY) != GST_STATE_CHANGE_FAILURE) {
+        std::lock_guard lock(m_mutex);
+        m_prepared = true;
+        m_stillsRemaining.store(0, std::memory_order_relaxed); // A burst does not carry over to the next start.
+        if (m_stillValve) {
+            g_object_set(m_stillValve.get(), "drop", TRUE, nullptr);
+        }
+        return;
+    }
+    teardown();
+}
+
+// captureStills: Opens the valve; stillCallback closes it again once the burst is complete.
+void GStreamerHandler::captureStills(int count) {
+    if (count <= 0) {
+        return;
+    }
+    std::lock_guard lock(m_mutex);
+    if (!m_stillValve) {
+        return;
+    }
+    m_stillsRemaining.fetch_add(count, std::memory_order_acq_rel);
+    g_object_set(m_stillValve.get(), "drop", FALSE, nullptr);
+}
+
+// counters: Returns the pipeline's frame accounting counters.
+GStreamerHandler::Counters GStreamerHandler::counters() const {
+    Counters counters;
+    counters.queueDropped = m_queueDropped.load(std::memory_order_relaxed);
+    counters.delivered = m_delivered.load(std::memory_order_relaxed);
+    counters.stills = m_stills.load(std::memory_order_relaxed);
+    counters.captured = m_capture.counters().frames;
+    return counters;
+}
+
+bool GStreamerHandler::startCapture(const QString& path) {
+    return m_capture.start(path);
+}
+
+void GStreamerHandler::stopCapture() {
+    m_capture.stop();
+}
+
+QString GStreamerHandler::captureError() const {
+    return m_capture.error();
+}
+
+GStreamerHandler::Startup GStreamerHandler::startup() const {
+    Startup startup;
+    startup.initNs = m_initNs.load(std::memory_order_relaxed);
+    startup.buildNs = m_buildNs.load(std::memory_order_relaxed);
+    startup.playingNs = m_playingNs.load(std::memory_order_relaxed);
+    startup.firstFrameNs = m_firstFrameNs.load(std::memory_order_relaxed);
+    startup.prepared = m_startedPrepared.load(std::memory_order_relaxed);
+    return startup;
+}
+
+// busCallback: Runs on the thread that posts the message.
+GstBusSyncReply GStreamerHandler::busCallback(GstBus*, GstMessage* message, gpointer data) {
+    auto* handler = static_cast<GStreamerHandler*>(data);
+    switch (GST_MESSAGE_TYPE(message)) {
+    case GST_MESSAGE_EOS:
+        emit handler->endOfStream();
+        break;
+    case GST_MESSAGE_ERROR: {
+        GError* error = nullptr;
+        gst_message_parse_error(message, &error, nullptr);
+        const QString text = QString::fromUtf8(error ? error->message : "unknown error");
+        if (error) {
+            g_error_free(error);
+        }
+        qDebug() << "Pipeline error:" << text;
+        emit handler->error(text);
+        break;
+    }
+    case GST_MESSAGE_STATE_CHANGED: {
+        if (!GST_IS_PIPELINE(GST_MESSAGE_SRC(message))) {
+            break; // Every element posts its own; only the pipeline's describe the whole.
+        }
+        GstState newState = GST_STATE_VOID_PENDING;
+        gst_message_parse_state_changed(message, nullptr, &newState, nullptr);
+        const qint64 begin = handler->m_startTime.load(std::memory_order_relaxed);
+        qint64 unknown = -1;
+        if (newState == GST_STATE_PLAYING && begin >= 0) {
+            handler->m_playingNs.compare_exchange_strong(unknown, FrameTracer::now() - begin, std::memory_order_relaxed);
+        }
+        emit handler->stateChanged(QString::fromUtf8(gst_element_state_get_name(newState)));
+        break;
+    }
+    default:
+        break;
+    }
+    return GST_BUS_DROP;
+}
+
+// queueOverrunCallback: Called on the source's streaming thread when the queue is full.
+void GStreamerHandler::queueOverrunCallback(GstElement*, gpointer data) {
+    auto* handler = static_cast<GStreamerHandler*>(data);
+    if (handler->m_queueLeaky.load(std::memory_order_relaxed)) {
+        handler->m_queueDropped.fetch_add(1, std::memory_order_relaxed);
     }
 }
 
 // Callback function called by GStreamer when a new frame is available in the appsink.
 GstFlowReturn GStreamerHandler::newFrameCallback(GstAppSink* appsink, gpointer data) {
     auto* handler = static_cast<GStreamerHandler*>(data); // Casts the gpointer back to the GStreamerHandler instance.
+    const qint64 pulled = FrameTracer::now();
     auto* sample = gst_app_sink_pull_sample(appsink); // Pulls the sample from the appsink.
     if (!sample) {
         return GST_FLOW_ERROR; // Returns an error if no sample is available.
     }
 
-    // If a sample is available, convert it to QImage and emit the newFrame signal.
-    if (sample) {
-        QImage frame = convertToQImage(sample); // Converts the GstSample to QImage.
-        gst_sample_unref(sample); // Unreferences the sample after processing.
+    // Wrap the sample without copying; the frame keeps the buffer mapped until its last view is gone.
+    VideoFrame frame = VideoFrame::fromSample(sample, handler->m_sequence.fetch_add(1, std::memory_order_relaxed) + 1);
+    frame.stamp(FrameTimestamps::Callback, pulled);
+    stampCapture(appsink, sample, frame, pulled);
+    handler->m_capture.append(sample); // Does nothing unless a capture is running.
+    gst_sample_unref(sample); // The frame holds its own reference to the sample.
+
+    if (frame.isValid() && frame.size() != handler->m_frameSize) {
+        // New resolution: drop buffers sized for the old one and pre-allocate the effect outputs.
+        handler->m_frameSize = frame.size();
+        FrameBufferPool::global().trim();
+        if (!frame.isYuv()) {
+            FrameBufferPool::global().prewarm(frame.size(), frame.format(), framesInFlight);
+        }
+    }
 
-        emit handler->newFrame(frame); // Emits the newFrame signal with the QImage.
+    if (frame.isValid() && handler->m_awaitingFirstFrame.load(std::memory_order_relaxed)
+        && handler->m_awaitingFirstFrame.exchange(false, std::memory_order_acq_rel)) {
+        handler->reportFirstFrame(pulled);
+    }
+
+    if (frame.isValid()) {
+        handler->m_delivered.fetch_add(1, std::memory_order_relaxed);
+        emit handler->newFrame(frame); // Emits the newFrame signal with the zero-copy frame handle.
     }
 
     return GST_FLOW_OK; // Indicates successful processing of the sample.
 }
 
-// Converts a GstSample to a QImage for use in Qt applications.
-QImage GStreamerHandler::convertToQImage(GstSample* sample) {
-    auto* buffer = gst_sample_get_buffer(sample); // Retrieves the buffer from the sample.
-    GstMapInfo map;
-    // Maps the buffer to access its data.
-    if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
-        auto* caps = gst_sample_get_caps(sample); // Retrieves the capabilities of the sample.
-        auto* structure = gst_caps_get_structure(caps, 0); // Retrieves the structure from the caps.
-
-        int width, height;
-        // Extracts the width and height of the video frame from the caps structure.
-        gst_structure_get_int(structure, "width", &width);
-        gst_structure_get_int(structure, "height", &height);
+// reportFirstFrame: Logs time to first frame with its breakdown, once per start.
+void GStreamerHandler::reportFirstFrame(qint64 pulled) {
+    const qint64 elapsed = pulled - m_startTime.load(std::memory_order_relaxed);
+    m_firstFrameNs.store(elapsed, std::memory_order_relaxed);
+    const Startup times = startup();
+    const auto ms = [](qint64 ns) { return ns < 0 ? QStringLiteral("?") : QString::number(ns / 1e6, 'f', 1); };
+    qInfo().noquote() << QStringLiteral("First frame after %1 ms (init %2 ms, build %3 ms, playing after %4 ms%5)")
+        .arg(ms(elapsed), ms(times.initNs), ms(times.buildNs), ms(times.playingNs),
+            times.prepared ? QStringLiteral(", prepared pipeline") : QString());
+    emit firstFrame(elapsed);
+}
 
-        // Creates a QImage from the buffer data with the specified width, height, and format.
-        QImage image(map.data, width, height, QImage::Format_RGB888);
-        gst_buffer_unmap(buffer, &map); // Unmaps the buffer after accessing its data.
+// stillCallback: Called on the stills branch's streaming thread. Frames that were already queued
+// behind the valve when the burst completed are let go.
+GstFlowReturn GStreamerHandler::stillCallback(GstAppSink* appsink, gpointer data) {
+    auto* handler = static_cast<GStreamerHandler*>(data);
+    GstSample* sample = gst_app_sink_pull_sample(appsink);
+    if (!sample) {
+        return GST_FLOW_ERROR;
+    }
+    int remaining = handler->m_stillsRemaining.load(std::memory_order_acquire);
+    while (remaining > 0 && !handler->m_stillsRemaining.compare_exchange_weak(remaining, remaining - 1, std::memory_order_acq_rel)) {
+    }
+    if (remaining <= 0) {
+        gst_sample_unref(sample);
+        return GST_FLOW_OK;
+    }
+    if (remaining == 1) {
+        // The element pointers only change while no data flows, so the valve is safe to use here.
+        g_object_set(handler->m_stillValve.get(), "drop", TRUE, nullptr);
+        if (handler->m_stillsRemaining.load(std::memory_order_acquire) > 0) {
+            g_object_set(handler->m_stillValve.get(), "drop", FALSE, nullptr); // captureStills raced the close.
+        }
+    }
 
-        return image; // Returns the constructed QImage.
+    VideoFrame frame = VideoFrame::fromSample(sample, handler->m_stills.fetch_add(1, std::memory_order_relaxed) + 1);
+    frame.stamp(FrameTimestamps::Callback);
+    gst_sample_unref(sample);
+    if (frame.isValid()) {
+        emit handler->stillCaptured(frame);
     }
-    return QImage(); // Returns an empty QImage if the buffer could not be mapped.
+    return GST_FLOW_OK;
 }
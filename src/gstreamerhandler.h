@@ -4,26 +4,197 @@
 #include <gst/app/gstappsink.h>
 #include <QObject>
 #include <QImage>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include "videoframe.h"
+#include "droppolicy.h"
+#include "effectsettings.h"
+#include "rawcapturewriter.h"
+#include "regionofinterest.h"
 #include <QDebug>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <thread>
 
+// GStreamerHandler: One capture pipeline from a source to an appsink, delivering zero-copy frames.
+// Building and starting the pipeline can take seconds on a cold start (the registry scan in gst_init,
+// opening the camera), so startPipelineAsync does it on a control thread of its own and reports
+// the outcome through error, stateChanged and firstFrame.
 class GStreamerHandler : public QObject {
     Q_OBJECT
 
 public:
+    // Counters: Frames lost or handed out by the pipeline, sampled at a single point in time.
+    struct Counters {
+        quint64 queueDropped = 0; // Frames the leaky queue in front of the appsink threw away.
+        quint64 delivered = 0; // Frames emitted through newFrame.
+        quint64 stills = 0; // Frames emitted through stillCaptured.
+        quint64 captured = 0; // Frames written to the raw capture file since startCapture.
+    };
+
+    // Startup: Where the time before the first frame went, for the last start; -1 until known.
+    struct Startup {
+        qint64 initNs = -1; // gst_init and registering qtgsteffects; only the first start in a process pays.
+        qint64 buildNs = -1; // gst_parse_launch and element setup; 0 when a prepared pipeline was reused.
+        qint64 playingNs = -1; // From the start call until the pipeline reported PLAYING.
+        qint64 firstFrameNs = -1; // From the start call until the first frame reached the appsink.
+        bool prepared = false; // Started from a pipeline kept in READY.
+    };
+
     explicit GStreamerHandler(QObject* parent = nullptr);
     ~GStreamerHandler() override;
 
-    void startPipeline();
+    // Source part of the pipeline, everything before videoconvert. Takes effect on the next startPipeline.
+    void setSource(const QString& source);
+    QString source() const;
+
+    // With native formats on (the default) the appsink accepts YUY2, NV12 and I420 as well as RGB,
+    // so videoconvert passes the camera's own format through untouched. Off forces RGB.
+    void setNativeFormats(bool enabled);
+    // The packed layout RGB frames are delivered in: Format_RGB888 (the default), Format_RGB32,
+    // Format_RGBX8888 or Format_Grayscale8. Other formats fall back to the default.
+    // Takes effect on the next startPipeline.
+    void setRgbFormat(QImage::Format format);
+    QImage::Format rgbFormat() const;
+
+    // Has videoscale deliver frames that fit in size, keeping the aspect ratio and never upscaling,
+    // so effects run at display resolution. Can be called while playing; the caps renegotiate.
+    // An empty size delivers the camera resolution.
+    void setOutputSize(const QSize& size);
+
+    // Crops every frame to region in a videocrop element before videoscale, so scaling, the
+    // in-pipeline effects and everything after the appsink only handle the region. Stills keep the
+    // whole frame. Can be called while playing; the caps renegotiate. Without videocrop (see
+    // canCrop) the region is ignored and frames arrive whole.
+    void setRegionOfInterest(const RegionOfInterest& region);
+    RegionOfInterest regionOfInterest() const;
+
+    // Sizes the queue and the appsink and picks whether they drop or block when full.
+    // Can be called while playing. Consumers of newFrame apply the same policy to their own handoffs.
+    void setDropPolicy(const DropPolicy& policy);
+    DropPolicy dropPolicy() const;
+
+    // Runs the effects inside the pipeline, in a qtgsteffects element after videoscale, so newFrame
+    // delivers frames that are already processed. Takes effect on the next startPipeline.
+    void setPipelineEffects(bool enabled);
+    bool pipelineEffects() const;
+    // Settings of the qtgsteffects element. Can be called while playing.
+    void setEffects(const EffectSettings& settings);
+
+    // Extra sink branches fed by a tee after the effects, each behind its own leaky queue, e.g.
+    // "x264enc tune=zerolatency ! mp4mux ! filesink location=out.mp4". Frames are processed once
+    // and shared by the appsink and every branch. Takes effect on the next startPipeline.
+    void setBranches(const QStringList& branches);
+
+    bool startPipeline(); // False if the pipeline could not be built or started. Blocks until PLAYING was requested.
+    // startPipeline on the control thread; returns at once. A failure is reported through error.
+    void startPipelineAsync();
+    // Builds the pipeline on the control thread and brings it to READY without starting it, which
+    // opens a camera, so the next start only has to go to PLAYING.
+    void prepareAsync();
+    // With keep-prepared on, stopPipeline leaves the pipeline in READY instead of tearing it down, so
+    // a restart is as quick as a prepared start. The camera stays open meanwhile. Off by default.
+    void setKeepPrepared(bool enabled);
+    // Waits for the control thread; then stops the pipeline.
     void stopPipeline();
 
+    // Delivers the next count frames through stillCaptured at the source's resolution, before
+    // videoscale and the in-pipeline effects, in the RGB format. Can be called while playing; a call
+    // during a burst extends it. Does nothing until a pipeline is built.
+    void captureStills(int count);
+
+    // Appends every frame the appsink receives, after videoscale and the in-pipeline effects, to a
+    // raw capture file that qtgstreplaysrc plays back. Can be called while playing; false, with
+    // captureError set, if the file cannot be created. stopCapture finishes the file.
+    bool startCapture(const QString& path);
+    void stopCapture();
+    QString captureError() const;
+
+    Counters counters() const;
+    Startup startup() const;
+
+    // gst_init and the registration of qtgsteffects and qtgstreplaysrc, once per process and from any thread. Returns
+    // the time it took, 0 after the first call.
+    static qint64 initialize();
+    // Whether pipelines can crop to a region of interest: videocrop comes with gst-plugins-good,
+    // which a minimal install may lack. Calls initialize.
+    static bool canCrop();
+
 signals:
-    void newFrame(QImage frame);
+    void newFrame(VideoFrame frame);
+    // The pipeline's own state changes ("READY", "PAUSED", "PLAYING", ...), emitted from a GStreamer thread.
+    void stateChanged(const QString& state);
+    // Full-resolution frames asked for with captureStills, emitted from the stills branch's streaming
+    // thread. The frame references the branch's own buffer, never one of the camera's.
+    void stillCaptured(VideoFrame frame);
+    // Emitted from the streaming thread with the time from the start call to the first frame.
+    void firstFrame(qint64 timeToFirstFrameNs);
+    // Emitted from a GStreamer thread: the source ran out (files, num-buffers) or the pipeline failed.
+    void endOfStream();
+    void error(const QString& message);
 
 private:
+    std::thread m_control; // Builds and starts the pipeline off the caller's thread; joined before the next use.
+    // Guards the configuration and the element pointers between the caller and the control thread;
+    // never held while GStreamer builds the pipeline or changes its state.
+    mutable std::mutex m_mutex;
     std::unique_ptr<GstElement, decltype(&gst_object_unref)> m_pipeline{ nullptr, gst_object_unref };
     GstElement* m_sink = nullptr;
+    std::unique_ptr<GstElement, decltype(&gst_object_unref)> m_scaleFilter{ nullptr, gst_object_unref }; // Caps after videoscale.
+    std::unique_ptr<GstElement, decltype(&gst_object_unref)> m_crop{ nullptr, gst_object_unref }; // videocrop, if available.
+    std::unique_ptr<GstElement, decltype(&gst_object_unref)> m_queue{ nullptr, gst_object_unref }; // Decouples the source from the appsink.
+    std::unique_ptr<GstElement, decltype(&gst_object_unref)> m_effects{ nullptr, gst_object_unref }; // qtgsteffects, if in the pipeline.
+    std::unique_ptr<GstElement, decltype(&gst_object_unref)> m_stillValve{ nullptr, gst_object_unref }; // Closed except during a burst.
+    std::unique_ptr<GstElement, decltype(&gst_object_unref)> m_stillSink{ nullptr, gst_object_unref };
+    QString m_source = QStringLiteral("mfvideosrc device-index=0");
+    bool m_nativeFormats = true;
+    // 24-bit pixels: the effects are bound by memory traffic, and a third more bytes per pixel costs
+    // more than 32-bit lanes save (imageprocessing_bench's effect_chain rows per format).
+    QImage::Format m_rgbFormat = QImage::Format_RGB888;
+    QSize m_outputSize;
+    RegionOfInterest m_region;
+    QSize m_cropInput; // Size of the frames entering videocrop, from its caps.
+    bool m_pipelineEffects = false;
+    EffectSettings m_effectSettings;
+    QStringList m_branches;
+    DropPolicy m_dropPolicy;
+    std::atomic<bool> m_queueLeaky{ true }; // Read by the overrun callback on the streaming thread.
+    std::atomic<quint64> m_queueDropped{ 0 };
+    std::atomic<quint64> m_delivered{ 0 };
+    std::atomic<quint64> m_sequence{ 0 }; // Numbers the frames handed out.
+    std::atomic<int> m_stillsRemaining{ 0 }; // Frames the current burst still wants.
+    std::atomic<quint64> m_stills{ 0 };
+    RawCaptureWriter m_capture; // Thread-safe; fed from the streaming thread.
+    QSize m_frameSize; // Last negotiated frame size; only touched on the streaming thread.
+    bool m_keepPrepared = false;
+    bool m_prepared = false; // m_pipeline is in READY and was built from the current configuration.
+    bool m_configChanged = false; // A setting that only takes effect on a rebuild changed since the last build.
+
+    // Startup timing; written by the control, bus and streaming threads.
+    std::atomic<qint64> m_startTime{ -1 }; // FrameTracer::now() at the start call.
+    std::atomic<bool> m_awaitingFirstFrame{ false };
+    std::atomic<qint64> m_initNs{ -1 };
+    std::atomic<qint64> m_buildNs{ -1 };
+    std::atomic<qint64> m_playingNs{ -1 };
+    std::atomic<qint64> m_firstFrameNs{ -1 };
+    std::atomic<bool> m_startedPrepared{ false };
+
+    void joinControl();
+    void markStart();
+    bool startNow(QString& failure);
+    bool prepareNow(QString& failure);
+    bool buildPipeline(QString& failure);
+    void teardown();
+    void reportFirstFrame(qint64 pulled);
+    void applyOutputSize(); // Called with m_mutex held.
+    void applyDropPolicy(); // Called with m_mutex held.
+    void applyCrop(); // Called with m_mutex held.
 
     static GstFlowReturn newFrameCallback(GstAppSink* appsink, gpointer user_data);
-    static QImage convertToQImage(GstSample* sample);
+    static GstFlowReturn stillCallback(GstAppSink* appsink, gpointer user_data);
+    static void queueOverrunCallback(GstElement* queue, gpointer user_data);
+    static GstPadProbeReturn cropCapsProbe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
+    static GstBusSyncReply busCallback(GstBus* bus, GstMessage* message, gpointer user_data);
 };
\ No newline at end of file
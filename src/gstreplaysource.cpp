@@ -0,0 +1,333 @@
+#include "gstreplaysource.h"
+#include "rawcapture.h"
+#include <gst/base/gstpushsrc.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+enum Property {
+    PropertyNone,
+    PropertyLocation,
+    PropertyTiming,
+    PropertyLoop,
+};
+
+enum class Timing {
+    Original,
+    Fast,
+};
+
+// Frame interval assumed when the capture says nothing about it: a single frame without a duration.
+constexpr GstClockTime fallbackInterval = GST_SECOND / 30;
+
+GType timingType() {
+    static const GType type = [] {
+        static const GEnumValue values[] = {
+            { static_cast<gint>(Timing::Original), "Live, at the intervals the frames were captured at", "original" },
+            { static_cast<gint>(Timing::Fast), "As fast as downstream takes the frames", "fast" },
+            { 0, nullptr, nullptr },
+        };
+        return g_enum_register_static("QtGstReplayTiming", values);
+    }();
+    return type;
+}
+
+// ReplayState: The C++ side of an element instance; see FilterState in gsteffectsfilter.cpp.
+struct ReplayState {
+    std::mutex mutex; // Guards the properties and caps; caps queries come from any thread.
+    std::string location;
+    Timing timing = Timing::Original;
+    bool loop = false;
+    GstCaps* caps = nullptr; // Of the frame played next, referenced.
+
+    // Set up by start, then used by the streaming thread alone.
+    std::shared_ptr<const RawCapture::Reader> reader; // Every buffer handed out holds a reference.
+    std::vector<GstClockTime> times; // Of every frame, from the first one.
+    GstClockTime period = 0; // Of one pass through the capture.
+    size_t next = 0;
+    guint64 pass = 0;
+    std::uint32_t capsIndex = 0;
+    GstClockTime base = GST_CLOCK_TIME_NONE; // Running time the first frame is timestamped at.
+};
+
+struct QtGstReplay {
+    GstPushSrc parent;
+    ReplayState* state;
+};
+
+struct QtGstReplayClass {
+    GstPushSrcClass parent_class;
+};
+
+GType qt_gst_replay_get_type();
+G_DEFINE_TYPE(QtGstReplay, qt_gst_replay, GST_TYPE_PUSH_SRC)
+
+QtGstReplay* toReplay(gpointer object) {
+    return reinterpret_cast<QtGstReplay*>(object);
+}
+
+// captureTimes: PTS differences when every frame has a PTS and they never go back, which is what a
+// camera gives; the times the frames reached the writer otherwise.
+std::vector<GstClockTime> captureTimes(const std::vector<RawCapture::Frame>& frames) {
+    bool usePts = true;
+    for (size_t i = 0; i < frames.size() && usePts; ++i) {
+        usePts = frames[i].pts >= 0 && (i == 0 || frames[i].pts >= frames[i - 1].pts);
+    }
+    std::vector<GstClockTime> times;
+    times.reserve(frames.size());
+    for (const RawCapture::Frame& frame : frames) {
+        times.push_back(static_cast<GstClockTime>(usePts ? frame.pts - frames.front().pts : frame.arrival));
+    }
+    return times;
+}
+
+// passPeriod: The last frame lasts its duration, or the mean interval, before the next pass starts.
+GstClockTime passPeriod(const std::vector<RawCapture::Frame>& frames, const std::vector<GstClockTime>& times) {
+    const GstClockTime last = times.back();
+    GstClockTime interval = frames.back().duration > 0 ? static_cast<GstClockTime>(frames.back().duration)
+        : frames.size() > 1 ? last / (frames.size() - 1) : 0;
+    return last + (interval > 0 ? interval : fallbackInterval);
+}
+
+void setCaps(ReplayState& state, GstCaps* caps) {
+    std::lock_guard lock(state.mutex);
+    gst_caps_replace(&state.caps, caps);
+}
+
+void setProperty(GObject* object, guint id, const GValue* value, GParamSpec* spec) {
+    QtGstReplay* self = toReplay(object);
+    std::lock_guard lock(self->state->mutex);
+    switch (id) {
+    case PropertyLocation:
+        self->state->location = g_value_get_string(value) ? g_value_get_string(value) : "";
+        break;
+    case PropertyTiming:
+        self->state->timing = static_cast<Timing>(g_value_get_enum(value));
+        // Before READY to PAUSED, which is when GstBaseSrc decides whether the source prerolls.
+        gst_base_src_set_live(GST_BASE_SRC(self), self->state->timing == Timing::Original);
+        break;
+    case PropertyLoop:
+        self->state->loop = g_value_get_boolean(value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, id, spec);
+        break;
+    }
+}
+
+void getProperty(GObject* object, guint id, GValue* value, GParamSpec* spec) {
+    QtGstReplay* self = toReplay(object);
+    std::lock_guard lock(self->state->mutex);
+    switch (id) {
+    case PropertyLocation:
+        g_value_set_string(value, self->state->location.c_str());
+        break;
+    case PropertyTiming:
+        g_value_set_enum(value, static_cast<gint>(self->state->timing));
+        break;
+    case PropertyLoop:
+        g_value_set_boolean(value, self->state->loop);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, id, spec);
+        break;
+    }
+}
+
+void finalize(GObject* object) {
+    QtGstReplay* self = toReplay(object);
+    gst_caps_replace(&self->state->caps, nullptr);
+    delete self->state;
+    G_OBJECT_CLASS(qt_gst_replay_parent_class)->finalize(object);
+}
+
+// start: Maps the file and reads its index; negotiation then offers the first frame's caps.
+gboolean start(GstBaseSrc* base) {
+    QtGstReplay* self = toReplay(base);
+    ReplayState& state = *self->state;
+    std::string location;
+    {
+        std::lock_guard lock(state.mutex);
+        location = state.location;
+    }
+    auto reader = std::make_shared<RawCapture::Reader>();
+    if (location.empty() || !reader->open(location)) {
+        GST_ELEMENT_ERROR(self, RESOURCE, OPEN_READ, ("Cannot replay \"%s\".", location.c_str()),
+            ("%s", location.empty() ? "No location set" : reader->error().c_str()));
+        return FALSE;
+    }
+    const RawCapture::Frame& first = reader->frames().front();
+    GstCaps* caps = gst_caps_from_string(reader->caps()[first.caps].c_str());
+    if (!caps) {
+        GST_ELEMENT_ERROR(self, STREAM, FORMAT, ("Cannot replay \"%s\".", location.c_str()), ("Unreadable caps in the capture"));
+        return FALSE;
+    }
+    setCaps(state, caps);
+    gst_caps_unref(caps);
+    state.times = captureTimes(reader->frames());
+    state.period = passPeriod(reader->frames(), state.times);
+    state.reader = std::move(reader);
+    state.next = 0;
+    state.pass = 0;
+    state.capsIndex = first.caps;
+    state.base = GST_CLOCK_TIME_NONE;
+    state.reader->prefetch(first);
+    return TRUE;
+}
+
+// stop: Buffers still downstream keep the mapping until they are freed.
+gboolean stop(GstBaseSrc* base) {
+    ReplayState& state = *toReplay(base)->state;
+    state.reader.reset();
+    state.times.clear();
+    setCaps(state, nullptr);
+    return TRUE;
+}
+
+GstCaps* getCaps(GstBaseSrc* base, GstCaps* filter) {
+    ReplayState& state = *toReplay(base)->state;
+    GstCaps* caps = nullptr;
+    {
+        std::lock_guard lock(state.mutex);
+        caps = state.caps ? gst_caps_ref(state.caps) : nullptr;
+    }
+    if (!caps) {
+        caps = gst_pad_get_pad_template_caps(GST_BASE_SRC_PAD(base)); // Not started: anything the template allows.
+    }
+    if (filter) {
+        GstCaps* intersection = gst_caps_intersect_full(filter, caps, GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref(caps);
+        caps = intersection;
+    }
+    return caps;
+}
+
+gboolean isSeekable(GstBaseSrc*) {
+    return FALSE;
+}
+
+// getTimes: GstBaseSrc waits on the clock until the running time these give, which is what paces
+// a live replay; a fast one is not synchronized at all.
+void getTimes(GstBaseSrc* base, GstBuffer* buffer, GstClockTime* start, GstClockTime* end) {
+    *start = GST_CLOCK_TIME_NONE;
+    *end = GST_CLOCK_TIME_NONE;
+    if (gst_base_src_is_live(base)) {
+        *start = GST_BUFFER_PTS(buffer);
+        if (GST_BUFFER_DURATION_IS_VALID(buffer)) {
+            *end = *start + GST_BUFFER_DURATION(buffer);
+        }
+    }
+}
+
+void releaseReader(gpointer reader) {
+    delete static_cast<std::shared_ptr<const RawCapture::Reader>*>(reader);
+}
+
+// runningTime: The pipeline's running time now, so a live replay starts without a backlog however
+// long the pipeline took to reach PLAYING.
+GstClockTime runningTime(GstElement* element) {
+    GstClock* clock = gst_element_get_clock(element);
+    if (!clock) {
+        return 0;
+    }
+    const GstClockTime now = gst_clock_get_time(clock);
+    gst_object_unref(clock);
+    const GstClockTime baseTime = gst_element_get_base_time(element);
+    return now > baseTime ? now - baseTime : 0;
+}
+
+// create: Wraps the next frame's bytes in the mapping, read-only, so an element that writes in
+// place, such as qtgsteffects, gets a copy instead. The frame after it is read ahead meanwhile.
+GstFlowReturn create(GstPushSrc* src, GstBuffer** out) {
+    QtGstReplay* self = toReplay(src);
+    ReplayState& state = *self->state;
+    const std::vector<RawCapture::Frame>& frames = state.reader->frames();
+    if (state.next == frames.size()) {
+        bool loop = false;
+        {
+            std::lock_guard lock(state.mutex);
+            loop = state.loop;
+        }
+        if (!loop) {
+            return GST_FLOW_EOS;
+        }
+        state.next = 0;
+        ++state.pass;
+    }
+    const RawCapture::Frame& frame = frames[state.next];
+    if (frame.caps != state.capsIndex) {
+        GstCaps* caps = gst_caps_from_string(state.reader->caps()[frame.caps].c_str());
+        const bool accepted = caps && gst_base_src_set_caps(GST_BASE_SRC(src), caps);
+        if (caps) {
+            setCaps(state, caps);
+            gst_caps_unref(caps);
+        }
+        if (!accepted) {
+            GST_ELEMENT_ERROR(self, CORE, NEGOTIATION, (nullptr), ("Downstream refused the caps of frame %zu", state.next));
+            return GST_FLOW_NOT_NEGOTIATED;
+        }
+        state.capsIndex = frame.caps;
+    }
+    if (!GST_CLOCK_TIME_IS_VALID(state.base)) {
+        state.base = gst_base_src_is_live(GST_BASE_SRC(src)) ? runningTime(GST_ELEMENT(src)) : 0;
+    }
+
+    auto* reader = new std::shared_ptr<const RawCapture::Reader>(state.reader);
+    GstBuffer* buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY, const_cast<std::uint8_t*>(state.reader->data(frame)),
+        frame.bytes, 0, frame.bytes, reader, &releaseReader);
+    GST_BUFFER_PTS(buffer) = state.base + state.pass * state.period + state.times[state.next];
+    GST_BUFFER_DURATION(buffer) = frame.duration >= 0 ? static_cast<GstClockTime>(frame.duration) : GST_CLOCK_TIME_NONE;
+    GST_BUFFER_OFFSET(buffer) = state.pass * frames.size() + state.next;
+    ++state.next;
+    state.reader->prefetch(frames[state.next < frames.size() ? state.next : 0]);
+    *out = buffer;
+    return GST_FLOW_OK;
+}
+
+void qt_gst_replay_class_init(QtGstReplayClass* klass) {
+    GObjectClass* objectClass = G_OBJECT_CLASS(klass);
+    objectClass->set_property = &setProperty;
+    objectClass->get_property = &getProperty;
+    objectClass->finalize = &finalize;
+
+    const auto flags = static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY);
+    g_object_class_install_property(objectClass, PropertyLocation,
+        g_param_spec_string("location", "Location", "Raw capture file to play", nullptr, flags));
+    g_object_class_install_property(objectClass, PropertyTiming,
+        g_param_spec_enum("timing", "Timing", "Pace of the replay", timingType(), static_cast<gint>(Timing::Original), flags));
+    g_object_class_install_property(objectClass, PropertyLoop,
+        g_param_spec_boolean("loop", "Loop", "Start over at the end instead of ending the stream", FALSE,
+            static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
+
+    GstElementClass* elementClass = GST_ELEMENT_CLASS(klass);
+    gst_element_class_set_static_metadata(elementClass, "Qt-Gst-Camera replay", "Source/Video",
+        "Plays back raw frames captured by Qt-Gst-Camera, without copying them", "Qt-Gst-Camera");
+    GstCaps* caps = gst_caps_from_string("video/x-raw");
+    gst_element_class_add_pad_template(elementClass, gst_pad_template_new("src", GST_PAD_SRC, GST_PAD_ALWAYS, caps));
+    gst_caps_unref(caps);
+
+    GstBaseSrcClass* baseClass = GST_BASE_SRC_CLASS(klass);
+    baseClass->start = &start;
+    baseClass->stop = &stop;
+    baseClass->get_caps = &getCaps;
+    baseClass->is_seekable = &isSeekable;
+    baseClass->get_times = &getTimes;
+    GST_PUSH_SRC_CLASS(klass)->create = &create;
+}
+
+void qt_gst_replay_init(QtGstReplay* self) {
+    self->state = new ReplayState;
+    gst_base_src_set_format(GST_BASE_SRC(self), GST_FORMAT_TIME);
+    gst_base_src_set_live(GST_BASE_SRC(self), TRUE); // Original timing is the default.
+}
+
+} // namespace
+
+bool GstReplaySource::registerElement() {
+    static const bool registered = gst_element_register(nullptr, "qtgstreplaysrc", GST_RANK_NONE, qt_gst_replay_get_type());
+    return registered;
+}
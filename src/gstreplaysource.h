@@ -0,0 +1,24 @@
+#pragma once
+
+#include <gst/gst.h>
+
+// GstReplaySource: Plays a RawCapture file back as a GStreamer source, "qtgstreplaysrc", with the
+// caps and bytes the frames were captured with. Buffers wrap the read-only mapping of the file,
+// so no frame is copied on the way out; each keeps the mapping alive until it is freed. Caps
+// changes in the capture are replayed as caps events.
+//
+//   qtgstreplaysrc location=clip.qgraw ! videoconvert ! ...
+//   qtgstreplaysrc location=clip.qgraw timing=fast loop=true ! ...
+//
+// Properties: location (the file), timing (original, a live source paced by the pipeline clock at
+// the intervals the frames were captured at; or fast, as fast as downstream takes them) and loop
+// (start over at the end instead of ending the stream). Timestamps keep increasing across loops.
+class GstReplaySource {
+public:
+    // Registers the element for this process, without a plugin file. Needs gst_init first;
+    // later calls do nothing. Returns false if GStreamer refused the registration.
+    static bool registerElement();
+
+private:
+    GstReplaySource() = delete; // Prevent instantiation
+};
@@ -0,0 +1,163 @@
+#include "headlessrunner.h"
+#include "gstreamerhandler.h"
+#include "frameprocessor.h"
+#include "sharedframewriter.h"
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QUrl>
+#include <condition_variable>
+#include <mutex>
+
+HeadlessRunner::HeadlessRunner(const HeadlessOptions& options) : m_options(options) {
+}
+
+// run: Source -> effects -> optional encoder, timed from pipeline start until the output file is complete.
+int HeadlessRunner::run() {
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    Recorder recorder; // Declared first so they outlive the processor feeding them.
+    SharedFrameWriter exporter;
+    FrameProcessor processor;
+    GStreamerHandler handler;
+
+    const QString source = !m_options.source.isEmpty() ? m_options.source
+        : !m_options.replay.isEmpty() ? QStringLiteral("qtgstreplaysrc location=\"%1\" timing=fast").arg(m_options.replay)
+        : QStringLiteral("uridecodebin uri=%1").arg(QString::fromLatin1(QUrl::fromLocalFile(QFileInfo(m_options.input).absoluteFilePath()).toEncoded()));
+    handler.setSource(source);
+    handler.setOutputSize(m_options.size);
+    processor.setDisplaySize(m_options.size);
+    const bool cropInPipeline = GStreamerHandler::canCrop();
+    handler.setRegionOfInterest(cropInPipeline ? m_options.region : RegionOfInterest());
+    processor.setRegionOfInterest(cropInPipeline ? RegionOfInterest() : m_options.region);
+
+    // Offline, a full stage waits rather than drops, so the run covers every frame of the input.
+    DropPolicy lossless;
+    lossless.mode = DropPolicy::Lossless;
+    handler.setDropPolicy(lossless);
+    processor.setDropPolicy(lossless);
+
+    if (m_options.pipelineEffects) {
+        // Frames come out of the pipeline processed; the processor only hands them on.
+        handler.setPipelineEffects(true);
+        handler.setEffects(m_options.effects);
+    } else {
+        processor.setGrayscale(m_options.effects.grayscaleEnabled);
+        processor.setBrightnessEnabled(m_options.effects.brightnessEnabled);
+        processor.setBrightness(m_options.effects.brightnessValue);
+        processor.setBlurEnabled(m_options.effects.blurEnabled);
+        processor.setBlur(m_options.effects.blurValue);
+        processor.setBlurQuality(m_options.effects.blurQuality);
+        processor.setDetailFilter(m_options.effects.detailFilter);
+        processor.setDetailAmount(m_options.effects.detailAmount);
+        processor.setDetailRadius(m_options.effects.detailRadius);
+        processor.setIncremental(m_options.effects.incremental);
+        processor.setChangeThreshold(m_options.effects.changeThreshold);
+        processor.setAutoBrightness(m_options.effects.autoBrightness, m_options.effects.autoBrightnessTarget);
+    }
+
+    std::mutex mutex;
+    std::condition_variable ended;
+    bool finished = false;
+    QString failure;
+
+    // Everything runs on the GStreamer and worker threads; there is no event loop to queue to.
+    QObject::connect(&handler, &GStreamerHandler::newFrame, &processor, &FrameProcessor::submitFrame, Qt::DirectConnection);
+    QObject::connect(&processor, &FrameProcessor::frameProcessed, &processor, [&](const VideoFrame& frame) {
+        recorder.pushFrame(frame); // Waits for the encoder when it is behind.
+        exporter.pushFrame(frame); // Never waits: readers that fall behind skip frames.
+        processor.notifyDelivered();
+    }, Qt::DirectConnection);
+    QObject::connect(&handler, &GStreamerHandler::endOfStream, &processor, [&] {
+        std::lock_guard lock(mutex);
+        finished = true;
+        ended.notify_all();
+    }, Qt::DirectConnection);
+    QObject::connect(&handler, &GStreamerHandler::error, &processor, [&](const QString& message) {
+        std::lock_guard lock(mutex);
+        failure = message;
+        finished = true;
+        ended.notify_all();
+    }, Qt::DirectConnection);
+
+    if (!m_options.output.isEmpty()) {
+        RecorderSettings settings;
+        settings.file = m_options.output;
+        settings.encoder = m_options.encoder;
+        settings.bitrateKbps = m_options.bitrateKbps;
+        settings.blockWhenFull = true;
+        if (!recorder.start(settings)) {
+            err << "Cannot write " << m_options.output << Qt::endl;
+            return 1;
+        }
+    }
+
+    if (!m_options.exportName.isEmpty()) {
+        exporter.start(m_options.exportName);
+    }
+
+    if (!m_options.capture.isEmpty() && !handler.startCapture(m_options.capture)) {
+        err << "Cannot capture to " << m_options.capture << ": " << handler.captureError() << Qt::endl;
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    processor.start();
+    if (!handler.startPipeline()) {
+        err << "Cannot start " << source << Qt::endl;
+        return 1;
+    }
+    {
+        std::unique_lock lock(mutex);
+        ended.wait(lock, [&] { return finished; });
+    }
+    processor.drain(); // Frames still in the mailbox when the source ended.
+    handler.stopPipeline();
+    const quint64 captured = handler.counters().captured;
+    handler.stopCapture();
+    processor.stop();
+    recorder.stop(); // Finalizes the output file.
+    exporter.stop();
+    const double seconds = timer.nsecsElapsed() / 1e9;
+
+    if (!failure.isEmpty()) {
+        err << "Pipeline error: " << failure << Qt::endl;
+        return 1;
+    }
+
+    const auto counters = processor.counters();
+    out << QStringLiteral("%1 frames in %2 s: %3 frames/s")
+               .arg(counters.processed)
+               .arg(seconds, 0, 'f', 2)
+               .arg(seconds > 0 ? counters.processed / seconds : 0.0, 0, 'f', 1);
+    const qint64 firstFrame = handler.startup().firstFrameNs;
+    if (firstFrame >= 0) {
+        out << QStringLiteral(", first frame after %1 ms").arg(firstFrame / 1e6, 0, 'f', 1);
+    }
+    if (!m_options.output.isEmpty()) {
+        out << QStringLiteral(", written to %1").arg(m_options.output);
+    }
+    if (!m_options.exportName.isEmpty()) {
+        out << QStringLiteral(", %1 published to %2").arg(exporter.counters().published).arg(m_options.exportName);
+    }
+    if (!m_options.capture.isEmpty()) {
+        out << QStringLiteral(", %1 captured to %2").arg(captured).arg(m_options.capture);
+    }
+    if (counters.tiles > 0) {
+        out << QStringLiteral(", %1% of tiles reprocessed").arg(100.0 * counters.tilesProcessed / counters.tiles, 0, 'f', 1);
+    }
+    out << Qt::endl;
+    if (!exporter.error().isEmpty()) {
+        err << "Shared-memory export failed: " << exporter.error() << Qt::endl;
+    }
+    if (!handler.captureError().isEmpty()) {
+        err << "Raw capture failed: " << handler.captureError() << Qt::endl;
+    }
+    if (counters.dropped != 0 || recorder.counters().dropped != 0) {
+        err << "Dropped " << counters.dropped + recorder.counters().dropped << " frames" << Qt::endl;
+        return 1;
+    }
+    return counters.processed > 0 ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "effectsettings.h"
+#include "recorder.h"
+#include "regionofinterest.h"
+#include <QSize>
+#include <QString>
+
+// HeadlessOptions: One offline run: where frames come from, what is done to them and where they go.
+struct HeadlessOptions {
+    QString input; // Media file, decoded with uridecodebin.
+    QString source; // Source pipeline instead of input, e.g. "videotestsrc num-buffers=600".
+    QString replay; // Raw capture file played by qtgstreplaysrc as fast as possible, instead of input.
+    QString output; // Encoded result; empty only measures throughput.
+    EffectSettings effects;
+    bool pipelineEffects = false; // Apply effects in the qtgsteffects element instead of the FrameProcessor.
+    RecorderSettings::Encoder encoder = RecorderSettings::X264;
+    int bitrateKbps = 8000;
+    QSize size; // Scale frames to fit this size first; empty keeps the source resolution.
+    RegionOfInterest region; // Process only this part of each frame, cropped before the scaling when videocrop is installed.
+    QString exportName; // Publish processed frames to shared memory under this name; empty does not.
+    QString capture; // Append the frames the pipeline delivers to this raw capture file; empty does not.
+};
+
+// HeadlessRunner: Runs the capture and effects pipeline without any widget, as fast as the machine
+// allows. The appsink does not sync to the clock, nothing throttles to a display, and every frame is
+// processed: the drop policy is lossless and the encoder, if any, blocks instead of dropping.
+class HeadlessRunner {
+public:
+    explicit HeadlessRunner(const HeadlessOptions& options);
+
+    // Runs until the source ends or fails, then prints frames, wall time and frames/s to stdout.
+    // Returns a process exit code.
+    int run();
+
+private:
+    HeadlessOptions m_options;
+};
@@ -0,0 +1,67 @@
+#include "histogramwidget.h"
+#include <QPainter>
+#include <QPainterPath>
+#include <algorithm>
+
+namespace {
+
+// Outline of one histogram scaled to the rectangle, bins left to right, counts bottom to top.
+QPainterPath histogramPath(const std::array<quint32, 256>& bins, quint32 peak, const QRectF& rect) {
+    QPainterPath path(rect.bottomLeft());
+    for (int value = 0; value < 256; ++value) {
+        const qreal x = rect.left() + rect.width() * value / 255.0;
+        path.lineTo(x, rect.bottom() - rect.height() * bins[value] / peak);
+    }
+    path.lineTo(rect.bottomRight());
+    path.closeSubpath();
+    return path;
+}
+
+} // namespace
+
+// Constructor: Nothing is drawn until the first stats arrive.
+HistogramWidget::HistogramWidget(QWidget* parent)
+    : QWidget(parent) {
+    setMinimumHeight(48);
+}
+
+HistogramWidget::~HistogramWidget() = default;
+
+void HistogramWidget::setStats(const FrameStats& frameStats) {
+    stats = frameStats;
+    update();
+}
+
+// paintEvent: Every curve shares the tallest bin's scale, so the channels can be compared.
+void HistogramWidget::paintEvent(QPaintEvent* event) {
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+    if (!stats.isValid()) {
+        return;
+    }
+    quint32 peak = *std::max_element(stats.luma.begin(), stats.luma.end());
+    if (stats.color) {
+        for (const auto* bins : { &stats.red, &stats.green, &stats.blue }) {
+            peak = std::max(peak, *std::max_element(bins->begin(), bins->end()));
+        }
+    }
+    const QRectF area = QRectF(rect()).adjusted(1, 1, -1, -1);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    if (stats.color) {
+        painter.setCompositionMode(QPainter::CompositionMode_Plus); // Overlapping channels add up to white.
+        painter.setBrush(QColor(160, 0, 0));
+        painter.drawPath(histogramPath(stats.red, peak, area));
+        painter.setBrush(QColor(0, 160, 0));
+        painter.drawPath(histogramPath(stats.green, peak, area));
+        painter.setBrush(QColor(0, 0, 160));
+        painter.drawPath(histogramPath(stats.blue, peak, area));
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    }
+    painter.setPen(palette().text().color());
+    painter.setBrush(Qt::NoBrush);
+    painter.drawPath(histogramPath(stats.luma, peak, area));
+    const qreal mean = area.left() + area.width() * stats.meanLuma() / 255.0;
+    painter.drawLine(QPointF(mean, area.top()), QPointF(mean, area.bottom()));
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QWidget>
+#include "framestats.h"
+
+// HistogramWidget: Draws the luma histogram of the last FrameStats it was given, with the RGB
+// channels behind it when the frame had color, and the mean luma as a vertical line.
+class HistogramWidget : public QWidget
+{
+	Q_OBJECT
+
+public:
+	HistogramWidget(QWidget *parent = nullptr);
+	~HistogramWidget();
+
+	void setStats(const FrameStats& frameStats);
+
+	QSize sizeHint() const override { return QSize(256, 64); }
+
+protected:
+	void paintEvent(QPaintEvent* event) override;
+
+private:
+	FrameStats stats;
+};
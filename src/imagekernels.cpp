@@ -0,0 +1,313 @@
+#include "imagekernels.h"
+#include <QByteArray>
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace ImageKernels {
+
+namespace {
+
+// Divider: floor(sum / windowSize) as a multiply and shift. For sums of 8-bit values it is
+// exact for windows up to 4095 pixels; larger windows fall back to a division.
+struct Divider {
+    explicit Divider(int windowSize)
+        : divisor(windowSize),
+        multiplier(windowSize <= 4095 ? (std::uint64_t{ 1 } << 32) / windowSize + 1 : 0) {
+    }
+
+    uchar operator()(int sum) const {
+        if (multiplier) {
+            return static_cast<uchar>((static_cast<std::uint64_t>(sum) * multiplier) >> 32);
+        }
+        return static_cast<uchar>(sum / divisor);
+    }
+
+    int divisor;
+    std::uint64_t multiplier;
+};
+
+// Applies a brightness-only lookup to count bytes. src and dst may alias.
+void lutRow(const uchar* src, uchar* dst, int count, const ImageProcessing::PointOps& ops) {
+    const uchar* lut = ops.lut.data();
+    for (int i = 0; i < count; ++i) {
+        dst[i] = lut[src[i]];
+    }
+}
+
+// Applies grayscale and/or the brightness lookup to one row of Format pixels. The channel offsets
+// are constants, so each instance is a loop with a fixed stride. src and dst may alias.
+template <typename Format>
+void pointOpsRow(const uchar* src, uchar* dst, int width, const ImageProcessing::PointOps& ops) {
+    constexpr int bytes = Format::bytes;
+    if constexpr (bytes == 1) {
+        lutRow(src, dst, width, ops); // Already gray; the luma of a gray pixel is itself.
+    } else {
+        const uchar* lut = ops.lut.data();
+        if (!ops.grayscale && Format::filler < 0) {
+            lutRow(src, dst, width * bytes, ops); // Every byte is a channel and goes through the same table.
+            return;
+        }
+        for (int x = 0; x < width; ++x) {
+            const uchar* pixel = src + x * bytes; // Access the pixel at x.
+            uchar* out = dst + x * bytes;
+            if constexpr (Format::filler >= 0) {
+                out[Format::filler] = pixel[Format::filler]; // Padding or alpha is carried through.
+            }
+            if (ops.grayscale) {
+                // Calculate the grayscale value using weighted sum method.
+                const int r = pixel[Format::red];
+                const int g = pixel[Format::green];
+                const int b = pixel[Format::blue];
+                const int grayValue = (r * 11 + g * 16 + b * 5) >> 5; // Weighted sum and bit-shift for performance.
+
+                // Set the RGB values of the pixel to the adjusted grayscale value.
+                out[Format::red] = out[Format::green] = out[Format::blue] = lut[grayValue];
+            } else {
+                out[Format::red] = lut[pixel[Format::red]];
+                out[Format::green] = lut[pixel[Format::green]];
+                out[Format::blue] = lut[pixel[Format::blue]];
+            }
+        }
+    }
+}
+
+// Blurs one row of interleaved Channels-byte pixels horizontally with a sliding window.
+// src and dst must not alias.
+template <int Channels>
+void horizontalBlurRowN(const uchar* src, uchar* dst, int width, int blurRadius) {
+    const Divider divide(2 * blurRadius + 1); // Normalizes by the size of the blur window.
+    int sums[Channels] = {}; // Sum of every channel in the window (RGB for RGB888).
+
+    // Pre-compute the sum for the initial window.
+    for (int kx = -blurRadius; kx <= blurRadius; ++kx) {
+        const int pixelX = std::clamp(kx, 0, width - 1); // Clamp the x-coordinate to the image bounds.
+        const uchar* pixel = src + pixelX * Channels; // Access the pixel.
+        for (int c = 0; c < Channels; ++c) {
+            sums[c] += pixel[c];
+        }
+    }
+
+    // Apply the blur effect across the row.
+    for (int x = 0; x < width; ++x) {
+        // Adjust window sums for the current position.
+        if (x > 0) {
+            const int exitPixelX = std::max(x - blurRadius - 1, 0); // X-coordinate of the pixel exiting the window.
+            const int enterPixelX = std::min(x + blurRadius, width - 1); // X-coordinate of the pixel entering the window.
+            const uchar* exitPixel = src + exitPixelX * Channels; // Exiting pixel.
+            const uchar* enterPixel = src + enterPixelX * Channels; // Entering pixel.
+
+            // Update sums by removing the exit pixel's contribution and adding the enter pixel's.
+            for (int c = 0; c < Channels; ++c) {
+                sums[c] += enterPixel[c] - exitPixel[c];
+            }
+        }
+
+        // Compute the average for the current window and set the pixel's channels.
+        uchar* pixel = dst + x * Channels;
+        for (int c = 0; c < Channels; ++c) {
+            pixel[c] = divide(sums[c]);
+        }
+    }
+}
+
+void horizontalBlurRow(const uchar* src, uchar* dst, int width, int blurRadius, int channels) {
+    switch (channels) {
+    case 1: horizontalBlurRowN<1>(src, dst, width, blurRadius); break;
+    case 2: horizontalBlurRowN<2>(src, dst, width, blurRadius); break;
+    case 3: horizontalBlurRowN<3>(src, dst, width, blurRadius); break;
+    case 4: horizontalBlurRowN<4>(src, dst, width, blurRadius); break;
+    }
+}
+
+// Blurs a whole image vertically. Instead of walking one column at a time, a row of running
+// column sums slides down the image, so both source and destination are read row by row.
+// columnSums must hold width * channels ints. src and dst must not alias.
+void verticalBlur(const uchar* src, int srcStride, uchar* dst, int dstStride,
+    int width, int height, int blurRadius, int* columnSums, int channels) {
+    const Divider divide(2 * blurRadius + 1); // Normalizes by the size of the blur window.
+    const int count = width * channels; // Bytes per row.
+
+    // Pre-compute the sums for the initial window.
+    std::fill(columnSums, columnSums + count, 0);
+    for (int ky = -blurRadius; ky <= blurRadius; ++ky) {
+        const uchar* row = src + std::clamp(ky, 0, height - 1) * srcStride; // Clamp the y-coordinate to the image bounds.
+        for (int i = 0; i < count; ++i) {
+            columnSums[i] += row[i];
+        }
+    }
+
+    // Apply the blur effect down the image.
+    for (int y = 0; y < height; ++y) {
+        // Adjust window sums for the current position.
+        if (y > 0) {
+            const uchar* exitRow = src + std::max(y - blurRadius - 1, 0) * srcStride; // Row exiting the window.
+            const uchar* enterRow = src + std::min(y + blurRadius, height - 1) * srcStride; // Row entering the window.
+            for (int i = 0; i < count; ++i) {
+                columnSums[i] += enterRow[i] - exitRow[i];
+            }
+        }
+
+        // Compute the average for the current window.
+        uchar* out = dst + y * dstStride;
+        for (int i = 0; i < count; ++i) {
+            out[i] = divide(columnSums[i]);
+        }
+    }
+}
+
+// Converts one row of BT.601 limited-range YUV, one U and V sample per pixel, to RGB888.
+void yuvToRgbRow(const uchar* y, const uchar* u, const uchar* v, uchar* dst, int width) {
+    for (int x = 0; x < width; ++x) {
+        uchar* pixel = dst + x * 3;
+        const YuvToRgb::Rgb rgb = YuvToRgb::convert(y[x], u[x], v[x]);
+        pixel[0] = rgb.r;
+        pixel[1] = rgb.g;
+        pixel[2] = rgb.b;
+    }
+}
+
+// Sum of absolute differences of count bytes; at most 255 per byte, so a row of any frame fits an int.
+int sumAbsDiff(const uchar* a, const uchar* b, int count) {
+    int sum = 0;
+    for (int i = 0; i < count; ++i) {
+        sum += std::abs(a[i] - b[i]);
+    }
+    return sum;
+}
+
+// Weighted sum of taps bytes step apart for each of count elements of an edge-padded row.
+void convolveRow(const uchar* src, qint16* dst, int count, int step, const qint16* weights, int taps) {
+    for (int i = 0; i < count; ++i) {
+        int sum = Convolution::rowRound;
+        for (int k = 0; k < taps; ++k) {
+            sum += src[i + k * step] * weights[k];
+        }
+        dst[i] = static_cast<qint16>(sum >> Convolution::rowShift);
+    }
+}
+
+// Weighted sum of the same element of taps rows of convolveRow output.
+void convolveColumns(const qint16* const* rows, qint16* dst, int count, const qint16* weights, int taps) {
+    for (int i = 0; i < count; ++i) {
+        int sum = Convolution::columnRound;
+        for (int k = 0; k < taps; ++k) {
+            sum += rows[k][i] * weights[k];
+        }
+        dst[i] = static_cast<qint16>(sum >> Convolution::columnShift);
+    }
+}
+
+void packRow(const qint16* src, uchar* dst, int count) {
+    for (int i = 0; i < count; ++i) {
+        dst[i] = static_cast<uchar>(std::clamp<int>(src[i], 0, 255));
+    }
+}
+
+// Adds amount / 256 times the detail the blur removed back to the original.
+void unsharpRow(const uchar* original, const qint16* blurred, uchar* dst, int count, int amount) {
+    for (int i = 0; i < count; ++i) {
+        const int detail = ((original[i] - blurred[i]) * amount + Convolution::amountRound) >> Convolution::amountBits;
+        dst[i] = static_cast<uchar>(std::clamp(original[i] + detail, 0, 255));
+    }
+}
+
+void edgeMagnitudeRow(const qint16* gx, const qint16* gy, uchar* dst, int count) {
+    for (int i = 0; i < count; ++i) {
+        dst[i] = static_cast<uchar>(std::min(2 * (std::abs(gx[i]) + std::abs(gy[i])), 255));
+    }
+}
+
+// cpuSupports: Queries the CPU (and, for AVX2, the OS) for an instruction set.
+bool cpuSupports(Isa isa) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4] = {};
+    __cpuid(info, 1);
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    const bool ssse3 = (info[2] & (1 << 9)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    bool avx2 = false;
+    if (osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) { // The OS saves the YMM registers.
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    const bool sse2 = __builtin_cpu_supports("sse2");
+    const bool ssse3 = __builtin_cpu_supports("ssse3");
+    const bool avx2 = __builtin_cpu_supports("avx2");
+#else
+    const bool sse2 = false, ssse3 = false, avx2 = false;
+#endif
+    switch (isa) {
+    case Isa::Scalar: return true;
+    case Isa::SSE2: return sse2;
+    case Isa::SSSE3: return sse2 && ssse3;
+    case Isa::AVX2: return sse2 && ssse3 && avx2;
+    }
+    return false;
+}
+
+// selectTable: Picks the best supported table, capped by the QTGST_KERNELS override.
+const KernelTable& selectTable() {
+    Isa isa = detectIsa();
+    const QByteArray forced = qgetenv("QTGST_KERNELS").toLower();
+    const std::pair<const char*, Isa> names[] = {
+        { "scalar", Isa::Scalar }, { "sse2", Isa::SSE2 }, { "ssse3", Isa::SSSE3 }, { "avx2", Isa::AVX2 },
+    };
+    for (const auto& [name, value] : names) {
+        if (forced == name && value < isa) {
+            isa = value; // Only ever lower the level; forcing an unsupported ISA would crash.
+        }
+    }
+
+    const KernelTable* table = forIsa(isa);
+    while (!table) {
+        isa = static_cast<Isa>(static_cast<int>(isa) - 1); // Fall back to the next lower level.
+        table = forIsa(isa);
+    }
+    return *table;
+}
+
+} // namespace
+
+const KernelTable& active() {
+    static const KernelTable& table = selectTable(); // Selected once, on first use.
+    return table;
+}
+
+const KernelTable* forIsa(Isa isa) {
+    if (!cpuSupports(isa)) {
+        return nullptr;
+    }
+    switch (isa) {
+    case Isa::Scalar: return &scalarKernels();
+    case Isa::SSE2: return sse2Kernels();
+    case Isa::SSSE3: return ssse3Kernels();
+    case Isa::AVX2: return avx2Kernels();
+    }
+    return nullptr;
+}
+
+Isa detectIsa() {
+    for (Isa isa : { Isa::AVX2, Isa::SSSE3, Isa::SSE2 }) {
+        if (cpuSupports(isa)) {
+            return isa;
+        }
+    }
+    return Isa::Scalar;
+}
+
+const KernelTable& scalarKernels() {
+    static const KernelTable table{ Isa::Scalar, "scalar",
+        { &pointOpsRow<PixelFormat::Rgb888>, &pointOpsRow<PixelFormat::Rgbx8888>, &pointOpsRow<PixelFormat::Xrgb32>, &pointOpsRow<PixelFormat::Gray8> },
+        &lutRow, &horizontalBlurRow, &verticalBlur, &yuvToRgbRow, &sumAbsDiff,
+        &convolveRow, &convolveColumns, &packRow, &unsharpRow, &edgeMagnitudeRow };
+    return table;
+}
+
+} // namespace ImageKernels
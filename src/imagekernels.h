@@ -0,0 +1,105 @@
+#pragma once
+
+#include "imageprocessing.h"
+
+// ImageKernels: Instruction-set specific implementations of the ImageProcessing row kernels.
+// One table is selected at startup from the CPU features; every table produces bit-identical
+// output to the scalar one.
+namespace ImageKernels {
+
+enum class Isa {
+    Scalar,
+    SSE2,
+    SSSE3,
+    AVX2,
+};
+
+using PointOpsRow = void (*)(const uchar* src, uchar* dst, int width, const ImageProcessing::PointOps& ops);
+
+// Blur kernels take the number of interleaved bytes per pixel: 3 for RGB888, 1 for a Y plane,
+// 2 for an NV12 UV plane, 4 for YUY2 macropixels and 32-bit RGB.
+// Point operations depend on where the channels sit, so there is one per PixelFormat::Layout,
+// each a template instance specialized for that layout.
+struct KernelTable {
+    Isa isa;
+    const char* name;
+    std::array<PointOpsRow, PixelFormat::layoutCount> pointOpsRow; // Indexed by PixelFormat::Layout.
+    void (*lutRow)(const uchar* src, uchar* dst, int count, const ImageProcessing::PointOps& ops);
+    void (*horizontalBlurRow)(const uchar* src, uchar* dst, int width, int blurRadius, int channels);
+    void (*verticalBlur)(const uchar* src, int srcStride, uchar* dst, int dstStride,
+        int width, int height, int blurRadius, int* columnSums, int channels);
+    void (*yuvToRgbRow)(const uchar* y, const uchar* u, const uchar* v, uchar* dst, int width);
+    int (*sumAbsDiff)(const uchar* a, const uchar* b, int count);
+    // Separable convolution, see Convolution below. convolveRow reads tap k of element i at
+    // src[i + k * step] of an edge-padded row; convolveColumns reads it from rows[k][i].
+    void (*convolveRow)(const uchar* src, qint16* dst, int count, int step, const qint16* weights, int taps);
+    void (*convolveColumns)(const qint16* const* rows, qint16* dst, int count, const qint16* weights, int taps);
+    void (*packRow)(const qint16* src, uchar* dst, int count);
+    void (*unsharpRow)(const uchar* original, const qint16* blurred, uchar* dst, int count, int amount);
+    void (*edgeMagnitudeRow)(const qint16* gx, const qint16* gy, uchar* dst, int count);
+};
+
+// Convolution: Fixed point of the separable convolution kernels. Weights are in 12-bit fixed point
+// and a kernel's absolute weights add up to at most one, so a row sum of 8-bit pixels is within
+// +-16320 after rowShift, and even two of those added fit 16 bits. The SIMD kernels use that to fold
+// symmetric and antisymmetric kernels, adding or subtracting the two taps that share a weight
+// before one multiply; the sums are exact 32-bit multiply-adds either way, so they match these.
+//   convolveRow:      dst = (sum(src * w) + rowRound) >> rowShift, pixels in 6-bit fixed point
+//   convolveColumns:  dst = (sum(rows * w) + columnRound) >> columnShift, whole pixels, signed
+//   unsharpRow:       dst = clamp(o + (((o - blurred) * amount + amountRound) >> amountBits))
+//   edgeMagnitudeRow: dst = min(2 * (|gx| + |gy|), 255), so a black-to-white step turns white
+namespace Convolution {
+
+constexpr int weightBits = 12;
+constexpr int maxWeightSum = 1 << weightBits; // Of the absolute weights.
+constexpr int rowShift = 6;
+constexpr int rowRound = 1 << (rowShift - 1);
+constexpr int columnShift = 2 * weightBits - rowShift;
+constexpr int columnRound = 1 << (columnShift - 1);
+constexpr int amountBits = 8; // unsharpRow's amount: 256 adds the difference to the blur once.
+constexpr int amountRound = 1 << (amountBits - 1);
+constexpr int maxTaps = 25; // The Gaussian of ImageProcessing::maxKernelBlurRadius.
+
+} // namespace Convolution
+
+// YuvToRgb: BT.601 limited-range conversion in 6-bit fixed point. Every intermediate fits in
+// 16 bits except the blue sum, which only overflows when the result saturates anyway, so the
+// SIMD kernels can use saturating 16-bit arithmetic and still match this bit for bit.
+namespace YuvToRgb {
+
+constexpr int yScale = 74; // 1.164 * 64
+constexpr int vToR = 102; // 1.596 * 64
+constexpr int uToG = 25; // 0.391 * 64
+constexpr int vToG = 52; // 0.813 * 64
+constexpr int uToB = 129; // 2.018 * 64
+
+struct Rgb {
+    uchar r, g, b;
+};
+
+inline Rgb convert(int y, int u, int v) {
+    const int c = (y - 16) * yScale;
+    const int d = u - 128;
+    const int e = v - 128;
+    auto clamp = [](int value) { return static_cast<uchar>(std::clamp(value >> 6, 0, 255)); };
+    return { clamp(c + vToR * e + 32), clamp(c - uToG * d - vToG * e + 32), clamp(c + uToB * d + 32) };
+}
+
+} // namespace YuvToRgb
+
+// The table picked at startup. QTGST_KERNELS=scalar|sse2|ssse3|avx2 forces a lower level.
+const KernelTable& active();
+
+// The table for a given instruction set, or nullptr if the build or the CPU lacks it.
+const KernelTable* forIsa(Isa isa);
+
+// The best instruction set this CPU supports.
+Isa detectIsa();
+
+// Per-ISA tables; the SIMD ones return nullptr on non-x86 builds.
+const KernelTable& scalarKernels();
+const KernelTable* sse2Kernels();
+const KernelTable* ssse3Kernels();
+const KernelTable* avx2Kernels();
+
+} // namespace ImageKernels
@@ -0,0 +1,448 @@
+#include "imagekernels_p.h"
+
+#if IMAGEKERNELS_X86
+#include <immintrin.h>
+#include <cstdlib>
+
+namespace ImageKernels::Avx2 {
+
+namespace {
+
+// Broadcasts a 16-byte pshufb control to both 128-bit lanes.
+inline __m256i loadMask(const signed char* mask) {
+    return _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(mask)));
+}
+
+// Loads two 16-byte blocks, 48 bytes apart, into the low and high lanes.
+inline __m256i loadLanes(const uchar* p) {
+    const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 48));
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+// Stores the low and high lanes back 48 bytes apart.
+inline void storeLanes(uchar* p, __m256i value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_castsi256_si128(value));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 48), _mm256_extracti128_si256(value, 1));
+}
+
+inline __m256i gatherChannel(__m256i a, __m256i b, __m256i c, int channel) {
+    const auto& masks = Ssse3::rgbShuffleMasks.deinterleave[channel];
+    return _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(a, loadMask(masks[0])), _mm256_shuffle_epi8(b, loadMask(masks[1]))),
+        _mm256_shuffle_epi8(c, loadMask(masks[2])));
+}
+
+inline __m256i weightedLuma(__m256i r, __m256i g, __m256i b) {
+    const __m256i sum = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(11)), _mm256_slli_epi16(g, 4)),
+        _mm256_mullo_epi16(b, _mm256_set1_epi16(5)));
+    return _mm256_srli_epi16(sum, 5);
+}
+
+// Same exact reciprocal division as the SSE2 kernel, eight sums at a time.
+inline __m256i divide(__m256i sums, __m256 reciprocal) {
+    const __m256 sum = _mm256_add_ps(_mm256_cvtepi32_ps(sums), _mm256_set1_ps(0.5f));
+    return _mm256_cvttps_epi32(_mm256_mul_ps(sum, reciprocal));
+}
+
+// Adds 32 row bytes to 32 running sums.
+inline void accumulate32(int* sums, const uchar* row) {
+    auto* s = reinterpret_cast<__m256i*>(sums);
+    for (int part = 0; part < 4; ++part) {
+        const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + part * 8));
+        _mm256_storeu_si256(s + part, _mm256_add_epi32(_mm256_loadu_si256(s + part), _mm256_cvtepu8_epi32(bytes)));
+    }
+}
+
+// Slides 32 running sums by one row (optional) and writes their averages.
+inline void slideAndAverage32(int* sums, const uchar* enter, const uchar* exit, uchar* out, __m256 reciprocal) {
+    auto* s = reinterpret_cast<__m256i*>(sums);
+    __m256i s0 = _mm256_loadu_si256(s + 0);
+    __m256i s1 = _mm256_loadu_si256(s + 1);
+    __m256i s2 = _mm256_loadu_si256(s + 2);
+    __m256i s3 = _mm256_loadu_si256(s + 3);
+
+    if (enter) {
+        const __m256i e = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(enter));
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(exit));
+        const __m256i dlo = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(e)), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(x)));
+        const __m256i dhi = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(e, 1)), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(x, 1)));
+        s0 = _mm256_add_epi32(s0, _mm256_cvtepi16_epi32(_mm256_castsi256_si128(dlo)));
+        s1 = _mm256_add_epi32(s1, _mm256_cvtepi16_epi32(_mm256_extracti128_si256(dlo, 1)));
+        s2 = _mm256_add_epi32(s2, _mm256_cvtepi16_epi32(_mm256_castsi256_si128(dhi)));
+        s3 = _mm256_add_epi32(s3, _mm256_cvtepi16_epi32(_mm256_extracti128_si256(dhi, 1)));
+        _mm256_storeu_si256(s + 0, s0);
+        _mm256_storeu_si256(s + 1, s1);
+        _mm256_storeu_si256(s + 2, s2);
+        _mm256_storeu_si256(s + 3, s3);
+    }
+
+    // The AVX2 packs work per 128-bit lane, so each pack is followed by a cross-lane fix-up.
+    const __m256i q01 = _mm256_permute4x64_epi64(_mm256_packs_epi32(divide(s0, reciprocal), divide(s1, reciprocal)), 0xD8);
+    const __m256i q23 = _mm256_permute4x64_epi64(_mm256_packs_epi32(divide(s2, reciprocal), divide(s3, reciprocal)), 0xD8);
+    const __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(q01, q23), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), bytes);
+}
+
+// Two 16-bit weights side by side, as vpmaddwd multiplies an interleaved pair of terms.
+inline int weightPairs(const qint16* weights, int terms, __m256i* pairs) {
+    for (int j = 0; j < terms; j += 2) {
+        const int second = j + 1 < terms ? weights[j + 1] : 0;
+        pairs[j / 2] = _mm256_set1_epi32(static_cast<int>(static_cast<quint16>(weights[j]) | static_cast<quint32>(second) << 16));
+    }
+    return (terms + 1) / 2;
+}
+
+inline __m256i loadWidened(const uchar* p) {
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+// Saturates 16 words to bytes; vpackuswb packs within lanes, so the middle quarters swap back.
+inline __m128i packBytes(__m256i words) {
+    return _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0xD8));
+}
+
+// Term j of 16 elements of a row convolution, with both taps of a folded kernel combined.
+template <int Sign>
+inline __m256i rowTerm(const uchar* src, int step, int j, int taps) {
+    const __m256i a = loadWidened(src + j * step);
+    if (Sign == 0 || j == taps / 2) {
+        return a;
+    }
+    const __m256i b = loadWidened(src + (taps - 1 - j) * step);
+    return Sign > 0 ? _mm256_add_epi16(a, b) : _mm256_sub_epi16(a, b);
+}
+
+template <int Sign>
+inline __m256i columnTerm(const qint16* const* rows, int i, int j, int taps) {
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[j] + i));
+    if (Sign == 0 || j == taps / 2) {
+        return a;
+    }
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[taps - 1 - j] + i));
+    return Sign > 0 ? _mm256_add_epi16(a, b) : _mm256_sub_epi16(a, b);
+}
+
+// 16 elements and two terms per step. Unpacking and packing both work within lanes, so the
+// elements come back out in order.
+template <int Sign>
+void convolveRowFolded(const uchar* src, qint16* dst, int count, int step, const qint16* weights, int taps) {
+    const int terms = foldedTerms(Sign, taps);
+    __m256i pairs[(Convolution::maxTaps + 1) / 2];
+    const int pairCount = weightPairs(weights, terms, pairs);
+    const __m256i round = _mm256_set1_epi32(Convolution::rowRound);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i lo = round;
+        __m256i hi = round;
+        for (int pair = 0; pair < pairCount; ++pair) {
+            const int j = pair * 2;
+            const __m256i a = rowTerm<Sign>(src + i, step, j, taps);
+            const __m256i b = j + 1 < terms ? rowTerm<Sign>(src + i, step, j + 1, taps) : _mm256_setzero_si256();
+            lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), pairs[pair]));
+            hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), pairs[pair]));
+        }
+        lo = _mm256_srai_epi32(lo, Convolution::rowShift);
+        hi = _mm256_srai_epi32(hi, Convolution::rowShift);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_packs_epi32(lo, hi));
+    }
+    if (i < count) {
+        Sse2::convolveRow(src + i, dst + i, count - i, step, weights, taps); // Up to 15 remaining elements.
+    }
+}
+
+template <int Sign>
+void convolveColumnsFolded(const qint16* const* rows, qint16* dst, int count, const qint16* weights, int taps) {
+    const int terms = foldedTerms(Sign, taps);
+    __m256i pairs[(Convolution::maxTaps + 1) / 2];
+    const int pairCount = weightPairs(weights, terms, pairs);
+    const __m256i round = _mm256_set1_epi32(Convolution::columnRound);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i lo = round;
+        __m256i hi = round;
+        for (int pair = 0; pair < pairCount; ++pair) {
+            const int j = pair * 2;
+            const __m256i a = columnTerm<Sign>(rows, i, j, taps);
+            const __m256i b = j + 1 < terms ? columnTerm<Sign>(rows, i, j + 1, taps) : _mm256_setzero_si256();
+            lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), pairs[pair]));
+            hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), pairs[pair]));
+        }
+        lo = _mm256_srai_epi32(lo, Convolution::columnShift);
+        hi = _mm256_srai_epi32(hi, Convolution::columnShift);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_packs_epi32(lo, hi));
+    }
+    if (i < count) {
+        const qint16* tail[Convolution::maxTaps];
+        for (int k = 0; k < taps; ++k) {
+            tail[k] = rows[k] + i;
+        }
+        Sse2::convolveColumns(tail, dst + i, count - i, weights, taps);
+    }
+}
+
+} // namespace
+
+// The brightness table as a saturating add or subtract, 32 bytes at a time.
+void lutRow(const uchar* src, uchar* dst, int count, const ImageProcessing::PointOps& ops) {
+    const int brightness = std::clamp(ops.brightness, -255, 255);
+    const __m256i delta = _mm256_set1_epi8(static_cast<char>(std::abs(brightness)));
+    int i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        const __m256i adjusted = brightness >= 0 ? _mm256_adds_epu8(bytes, delta) : _mm256_subs_epu8(bytes, delta);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), adjusted);
+    }
+    for (; i < count; ++i) {
+        dst[i] = ops.lut[src[i]];
+    }
+}
+
+// Grayscale 32 pixels per iteration (two 16-pixel groups, one per lane); brightness 32 bytes per iteration.
+void pointOpsRow(const uchar* src, uchar* dst, int width, const ImageProcessing::PointOps& ops) {
+    const int brightness = std::clamp(ops.brightness, -255, 255);
+    const __m256i delta = _mm256_set1_epi8(static_cast<char>(std::abs(brightness)));
+
+    if (!ops.grayscale) {
+        lutRow(src, dst, width * 3, ops);
+        return;
+    }
+
+    const __m256i zero = _mm256_setzero_si256();
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        const uchar* in = src + x * 3;
+        const __m256i a = loadLanes(in);
+        const __m256i b = loadLanes(in + 16);
+        const __m256i c = loadLanes(in + 32);
+
+        const __m256i red = gatherChannel(a, b, c, 0);
+        const __m256i green = gatherChannel(a, b, c, 1);
+        const __m256i blue = gatherChannel(a, b, c, 2);
+
+        // Unpack and pack are both per lane, so each lane keeps its own 16 pixels in order.
+        const __m256i lumaLo = weightedLuma(_mm256_unpacklo_epi8(red, zero), _mm256_unpacklo_epi8(green, zero), _mm256_unpacklo_epi8(blue, zero));
+        const __m256i lumaHi = weightedLuma(_mm256_unpackhi_epi8(red, zero), _mm256_unpackhi_epi8(green, zero), _mm256_unpackhi_epi8(blue, zero));
+        __m256i luma = _mm256_packus_epi16(lumaLo, lumaHi);
+        luma = brightness >= 0 ? _mm256_adds_epu8(luma, delta) : _mm256_subs_epu8(luma, delta);
+
+        uchar* out = dst + x * 3;
+        storeLanes(out, _mm256_shuffle_epi8(luma, loadMask(Ssse3::rgbShuffleMasks.interleave[0])));
+        storeLanes(out + 16, _mm256_shuffle_epi8(luma, loadMask(Ssse3::rgbShuffleMasks.interleave[1])));
+        storeLanes(out + 32, _mm256_shuffle_epi8(luma, loadMask(Ssse3::rgbShuffleMasks.interleave[2])));
+    }
+    if (x < width) {
+        Ssse3::pointOpsRow(src + x * 3, dst + x * 3, width - x, ops); // Up to 31 remaining pixels.
+    }
+}
+
+// Eight 32-bit pixels at a time, as in Sse2::pointOpsRow32.
+template <typename Format>
+void pointOpsRow32(const uchar* src, uchar* dst, int width, const ImageProcessing::PointOps& ops) {
+    constexpr int red = Format::red * 8, green = Format::green * 8, blue = Format::blue * 8;
+    const int brightness = std::clamp(ops.brightness, -255, 255);
+    const int magnitude = std::abs(brightness);
+    const __m256i delta = _mm256_set1_epi32(magnitude << red | magnitude << green | magnitude << blue);
+    const __m256i byteMask = _mm256_set1_epi32(0xff);
+    const __m256i fillerMask = _mm256_set1_epi32(static_cast<int>(0xffu << (Format::filler * 8)));
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+        if (ops.grayscale) {
+            const __m256i r = _mm256_and_si256(_mm256_srli_epi32(pixels, red), byteMask);
+            const __m256i g = _mm256_and_si256(_mm256_srli_epi32(pixels, green), byteMask);
+            const __m256i b = _mm256_and_si256(_mm256_srli_epi32(pixels, blue), byteMask);
+            const __m256i sum = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi16(r, _mm256_set1_epi32(11)), _mm256_slli_epi32(g, 4)),
+                _mm256_mullo_epi16(b, _mm256_set1_epi32(5)));
+            const __m256i luma = _mm256_srli_epi32(sum, 5);
+            pixels = _mm256_or_si256(_mm256_and_si256(pixels, fillerMask),
+                _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(luma, red), _mm256_slli_epi32(luma, green)), _mm256_slli_epi32(luma, blue)));
+        }
+        pixels = brightness >= 0 ? _mm256_adds_epu8(pixels, delta) : _mm256_subs_epu8(pixels, delta);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), pixels);
+    }
+    if (x < width) {
+        Sse2::pointOpsRow32<Format>(src + x * 4, dst + x * 4, width - x, ops); // Up to 7 remaining pixels.
+    }
+}
+
+// Vectorized across the row, 32 channels of running column sums per iteration.
+void verticalBlur(const uchar* src, int srcStride, uchar* dst, int dstStride,
+    int width, int height, int blurRadius, int* columnSums, int channels) {
+    const int windowSize = 2 * blurRadius + 1;
+    if (windowSize > Sse2::maxReciprocalWindow) {
+        scalarKernels().verticalBlur(src, srcStride, dst, dstStride, width, height, blurRadius, columnSums, channels);
+        return;
+    }
+    const __m256 reciprocal = _mm256_set1_ps(1.0f / static_cast<float>(windowSize));
+    const int count = width * channels;
+    const int vectorCount = count & ~31;
+
+    // Pre-compute the sums for the initial window.
+    std::fill(columnSums, columnSums + count, 0);
+    for (int ky = -blurRadius; ky <= blurRadius; ++ky) {
+        const uchar* row = src + std::clamp(ky, 0, height - 1) * srcStride;
+        int i = 0;
+        for (; i < vectorCount; i += 32) {
+            accumulate32(columnSums + i, row + i);
+        }
+        for (; i < count; ++i) {
+            columnSums[i] += row[i];
+        }
+    }
+
+    for (int y = 0; y < height; ++y) {
+        const uchar* exitRow = nullptr;
+        const uchar* enterRow = nullptr;
+        if (y > 0) {
+            exitRow = src + std::max(y - blurRadius - 1, 0) * srcStride;
+            enterRow = src + std::min(y + blurRadius, height - 1) * srcStride;
+        }
+        uchar* out = dst + y * dstStride;
+
+        int i = 0;
+        for (; i < vectorCount; i += 32) {
+            slideAndAverage32(columnSums + i, enterRow ? enterRow + i : nullptr, exitRow ? exitRow + i : nullptr, out + i, reciprocal);
+        }
+        for (; i < count; ++i) {
+            if (enterRow) {
+                columnSums[i] += enterRow[i] - exitRow[i];
+            }
+            out[i] = static_cast<uchar>(columnSums[i] / windowSize);
+        }
+    }
+}
+
+// 32 pixels per iteration, one 16-pixel group per lane; the same arithmetic as the SSSE3 kernel.
+void yuvToRgbRow(const uchar* y, const uchar* u, const uchar* v, uchar* dst, int width) {
+    const __m256i zero = _mm256_setzero_si256();
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        const __m256i luma = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + x));
+        const __m256i cb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(u + x));
+        const __m256i cr = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + x));
+
+        __m256i r[2], g[2], b[2];
+        for (int half = 0; half < 2; ++half) {
+            const __m256i y16 = half ? _mm256_unpackhi_epi8(luma, zero) : _mm256_unpacklo_epi8(luma, zero);
+            const __m256i u16 = half ? _mm256_unpackhi_epi8(cb, zero) : _mm256_unpacklo_epi8(cb, zero);
+            const __m256i v16 = half ? _mm256_unpackhi_epi8(cr, zero) : _mm256_unpacklo_epi8(cr, zero);
+            const __m256i c = _mm256_mullo_epi16(_mm256_sub_epi16(y16, _mm256_set1_epi16(16)), _mm256_set1_epi16(YuvToRgb::yScale));
+            const __m256i d = _mm256_sub_epi16(u16, _mm256_set1_epi16(128));
+            const __m256i e = _mm256_sub_epi16(v16, _mm256_set1_epi16(128));
+            const __m256i round = _mm256_set1_epi16(32);
+            r[half] = _mm256_srai_epi16(_mm256_add_epi16(_mm256_add_epi16(c, _mm256_mullo_epi16(e, _mm256_set1_epi16(YuvToRgb::vToR))), round), 6);
+            g[half] = _mm256_srai_epi16(_mm256_add_epi16(_mm256_sub_epi16(_mm256_sub_epi16(c, _mm256_mullo_epi16(d, _mm256_set1_epi16(YuvToRgb::uToG))),
+                _mm256_mullo_epi16(e, _mm256_set1_epi16(YuvToRgb::vToG))), round), 6);
+            b[half] = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(c, _mm256_mullo_epi16(d, _mm256_set1_epi16(YuvToRgb::uToB))), round), 6);
+        }
+        const __m256i red = _mm256_packus_epi16(r[0], r[1]);
+        const __m256i green = _mm256_packus_epi16(g[0], g[1]);
+        const __m256i blue = _mm256_packus_epi16(b[0], b[1]);
+
+        uchar* out = dst + x * 3;
+        for (int vector = 0; vector < 3; ++vector) {
+            const auto& masks = Ssse3::rgbShuffleMasks.merge;
+            const __m256i merged = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(red, loadMask(masks[0][vector])),
+                _mm256_shuffle_epi8(green, loadMask(masks[1][vector]))), _mm256_shuffle_epi8(blue, loadMask(masks[2][vector])));
+            storeLanes(out + vector * 16, merged);
+        }
+    }
+    if (x < width) {
+        Ssse3::yuvToRgbRow(y + x, u + x, v + x, dst + x * 3, width - x); // Up to 31 remaining pixels.
+    }
+}
+
+// vpsadbw: 32 bytes per iteration into four 64-bit sums.
+int sumAbsDiff(const uchar* a, const uchar* b, int count) {
+    __m256i sums = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        sums = _mm256_add_epi64(sums, _mm256_sad_epu8(x, y));
+    }
+    const __m128i halves = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+    const int sum = _mm_cvtsi128_si32(halves) + _mm_cvtsi128_si32(_mm_srli_si128(halves, 8));
+    return sum + Sse2::sumAbsDiff(a + i, b + i, count - i); // Up to 31 remaining bytes.
+}
+
+void convolveRow(const uchar* src, qint16* dst, int count, int step, const qint16* weights, int taps) {
+    switch (foldSign(weights, taps)) {
+    case 1: convolveRowFolded<1>(src, dst, count, step, weights, taps); break;
+    case -1: convolveRowFolded<-1>(src, dst, count, step, weights, taps); break;
+    default: convolveRowFolded<0>(src, dst, count, step, weights, taps); break;
+    }
+}
+
+void convolveColumns(const qint16* const* rows, qint16* dst, int count, const qint16* weights, int taps) {
+    switch (foldSign(weights, taps)) {
+    case 1: convolveColumnsFolded<1>(rows, dst, count, weights, taps); break;
+    case -1: convolveColumnsFolded<-1>(rows, dst, count, weights, taps); break;
+    default: convolveColumnsFolded<0>(rows, dst, count, weights, taps); break;
+    }
+}
+
+void packRow(const qint16* src, uchar* dst, int count) {
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packBytes(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i))));
+    }
+    if (i < count) {
+        Sse2::packRow(src + i, dst + i, count - i);
+    }
+}
+
+void unsharpRow(const uchar* original, const qint16* blurred, uchar* dst, int count, int amount) {
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m256i factors = _mm256_set1_epi32(amount | Convolution::amountRound << 16);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i o = loadWidened(original + i);
+        const __m256i d = _mm256_sub_epi16(o, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blurred + i)));
+        const __m256i lo = _mm256_srai_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(d, one), factors), Convolution::amountBits);
+        const __m256i hi = _mm256_srai_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(d, one), factors), Convolution::amountBits);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packBytes(_mm256_add_epi16(o, _mm256_packs_epi32(lo, hi))));
+    }
+    if (i < count) {
+        Sse2::unsharpRow(original + i, blurred + i, dst + i, count - i, amount);
+    }
+}
+
+void edgeMagnitudeRow(const qint16* gx, const qint16* gy, uchar* dst, int count) {
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(gx + i));
+        const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(gy + i));
+        const __m256i sum = _mm256_adds_epi16(_mm256_abs_epi16(x), _mm256_abs_epi16(y));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packBytes(_mm256_adds_epi16(sum, sum)));
+    }
+    if (i < count) {
+        Sse2::edgeMagnitudeRow(gx + i, gy + i, dst + i, count - i);
+    }
+}
+
+} // namespace ImageKernels::Avx2
+
+namespace ImageKernels {
+
+const KernelTable* avx2Kernels() {
+    static const KernelTable table{ Isa::AVX2, "avx2",
+        { &Avx2::pointOpsRow, &Avx2::pointOpsRow32<PixelFormat::Rgbx8888>, &Avx2::pointOpsRow32<PixelFormat::Xrgb32>, &Avx2::lutRow },
+        &Avx2::lutRow, scalarKernels().horizontalBlurRow, &Avx2::verticalBlur, &Avx2::yuvToRgbRow, &Avx2::sumAbsDiff,
+        &Avx2::convolveRow, &Avx2::convolveColumns, &Avx2::packRow, &Avx2::unsharpRow, &Avx2::edgeMagnitudeRow };
+    return &table;
+}
+
+} // namespace ImageKernels
+
+#else
+
+namespace ImageKernels {
+
+const KernelTable* avx2Kernels() {
+    return nullptr; // Not an x86 build.
+}
+
+} // namespace ImageKernels
+
+#endif
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "imagekernels.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define IMAGEKERNELS_X86 1
+#else
+#define IMAGEKERNELS_X86 0
+#endif
+
+namespace ImageKernels {
+
+// foldSign: 1 if an odd-sized kernel is symmetric, -1 if it is antisymmetric, 0 otherwise. Tap k and tap
+// taps - 1 - k of a folded kernel are added (or subtracted) and multiplied once, by weights[k];
+// the centre tap of an antisymmetric kernel is zero and left out.
+inline int foldSign(const qint16* weights, int taps) {
+    if (taps % 2 == 0) {
+        return 0;
+    }
+    bool symmetric = true;
+    bool antisymmetric = weights[taps / 2] == 0;
+    for (int k = 0; k < taps / 2; ++k) {
+        symmetric = symmetric && weights[k] == weights[taps - 1 - k];
+        antisymmetric = antisymmetric && weights[k] == -weights[taps - 1 - k];
+    }
+    return symmetric ? 1 : antisymmetric ? -1 : 0;
+}
+
+// foldedTerms: Products per element after folding.
+inline int foldedTerms(int sign, int taps) {
+    return sign > 0 ? taps / 2 + 1 : sign < 0 ? taps / 2 : taps;
+}
+
+} // namespace ImageKernels
+
+// Internal: SSE2/SSSE3 kernels that the higher instruction-set tables reuse where they have nothing better.
+namespace ImageKernels::Sse2 {
+
+void pointOpsRow(const uchar* src, uchar* dst, int width, const ImageProcessing::PointOps& ops);
+// 32-bit layouts; instantiated for PixelFormat::Rgbx8888 and PixelFormat::Xrgb32.
+template <typename Format>
+void pointOpsRow32(const uchar* src, uchar* dst, int width, const ImageProcessing::PointOps& ops);
+void lutRow(const uchar* src, uchar* dst, int count, const ImageProcessing::PointOps& ops);
+void verticalBlur(const uchar* src, int srcStride, uchar* dst, int dstStride,
+    int width, int height, int blurRadius, int* columnSums, int channels);
+int sumAbsDiff(const uchar* a, const uchar* b, int count);
+void convolveRow(const uchar* src, qint16* dst, int count, int step, const qint16* weights, int taps);
+void convolveColumns(const qint16* const* rows, qint16* dst, int count, const qint16* weights, int taps);
+void packRow(const qint16* src, uchar* dst, int count);
+void unsharpRow(const uchar* original, const qint16* blurred, uchar* dst, int count, int amount);
+void edgeMagnitudeRow(const qint16* gx, const qint16* gy, uchar* dst, int count);
+
+// Largest window for which (sum + 0.5) * (1 / windowSize) in float truncates to sum / windowSize.
+constexpr int maxReciprocalWindow = 4095;
+
+} // namespace ImageKernels::Sse2
+
+namespace ImageKernels::Ssse3 {
+
+// ShuffleMasks: pshufb controls that split 48 bytes of RGB24 into R, G and B planes and back.
+struct ShuffleMasks {
+    signed char deinterleave[3][3][16]; // [channel][source vector][byte]
+    signed char interleave[3][16]; // [destination vector][byte]; one plane into all three channels.
+    signed char merge[3][3][16]; // [channel][destination vector][byte]; three planes into RGB24.
+};
+
+constexpr ShuffleMasks makeShuffleMasks() {
+    ShuffleMasks masks{};
+    for (int channel = 0; channel < 3; ++channel) {
+        for (int vector = 0; vector < 3; ++vector) {
+            for (int pixel = 0; pixel < 16; ++pixel) {
+                const int index = pixel * 3 + channel - vector * 16; // Byte of this channel inside the vector.
+                masks.deinterleave[channel][vector][pixel] = static_cast<signed char>(index >= 0 && index < 16 ? index : -128);
+            }
+        }
+    }
+    for (int vector = 0; vector < 3; ++vector) {
+        for (int byte = 0; byte < 16; ++byte) {
+            masks.interleave[vector][byte] = static_cast<signed char>((vector * 16 + byte) / 3); // Pixel this byte belongs to.
+            for (int channel = 0; channel < 3; ++channel) {
+                const bool owns = (vector * 16 + byte) % 3 == channel;
+                masks.merge[channel][vector][byte] = static_cast<signed char>(owns ? (vector * 16 + byte) / 3 : -128);
+            }
+        }
+    }
+    return masks;
+}
+
+inline constexpr ShuffleMasks rgbShuffleMasks = makeShuffleMasks();
+
+void pointOpsRow(const uchar* src, uchar* dst, int width, const ImageProcessing::PointOps& ops);
+void yuvToRgbRow(const uchar* y, const uchar* u, const uchar* v, uchar* dst, int width);
+
+} // namespace ImageKernels::Ssse3
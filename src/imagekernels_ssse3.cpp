@@ -0,0 +1,135 @@
+#include "imagekernels_p.h"
+
+#if IMAGEKERNELS_X86
+#include <tmmintrin.h>
+#include <cstdlib>
+
+namespace ImageKernels::Ssse3 {
+
+namespace {
+
+inline __m128i loadMask(const signed char* mask) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask));
+}
+
+// Gathers one channel of 16 pixels spread across three vectors.
+inline __m128i gatherChannel(__m128i a, __m128i b, __m128i c, int channel) {
+    const auto& masks = rgbShuffleMasks.deinterleave[channel];
+    return _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, loadMask(masks[0])), _mm_shuffle_epi8(b, loadMask(masks[1]))),
+        _mm_shuffle_epi8(c, loadMask(masks[2])));
+}
+
+// (r * 11 + g * 16 + b * 5) >> 5 on eight 16-bit lanes; the largest sum, 8160, fits.
+inline __m128i weightedLuma(__m128i r, __m128i g, __m128i b) {
+    const __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(11)), _mm_slli_epi16(g, 4)),
+        _mm_mullo_epi16(b, _mm_set1_epi16(5)));
+    return _mm_srli_epi16(sum, 5);
+}
+
+} // namespace
+
+// Grayscale 16 pixels at a time: deinterleave with pshufb, weight in 16 bits, apply the brightness
+// as a saturating add and re-interleave the luma into all three channels.
+void pointOpsRow(const uchar* src, uchar* dst, int width, const ImageProcessing::PointOps& ops) {
+    if (!ops.grayscale) {
+        Sse2::pointOpsRow(src, dst, width, ops);
+        return;
+    }
+
+    const int brightness = std::clamp(ops.brightness, -255, 255);
+    const __m128i delta = _mm_set1_epi8(static_cast<char>(std::abs(brightness)));
+    const __m128i zero = _mm_setzero_si128();
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const auto* in = reinterpret_cast<const __m128i*>(src + x * 3);
+        const __m128i a = _mm_loadu_si128(in + 0);
+        const __m128i b = _mm_loadu_si128(in + 1);
+        const __m128i c = _mm_loadu_si128(in + 2);
+
+        const __m128i red = gatherChannel(a, b, c, 0);
+        const __m128i green = gatherChannel(a, b, c, 1);
+        const __m128i blue = gatherChannel(a, b, c, 2);
+
+        const __m128i lumaLo = weightedLuma(_mm_unpacklo_epi8(red, zero), _mm_unpacklo_epi8(green, zero), _mm_unpacklo_epi8(blue, zero));
+        const __m128i lumaHi = weightedLuma(_mm_unpackhi_epi8(red, zero), _mm_unpackhi_epi8(green, zero), _mm_unpackhi_epi8(blue, zero));
+        __m128i luma = _mm_packus_epi16(lumaLo, lumaHi);
+        luma = brightness >= 0 ? _mm_adds_epu8(luma, delta) : _mm_subs_epu8(luma, delta);
+
+        auto* out = reinterpret_cast<__m128i*>(dst + x * 3);
+        _mm_storeu_si128(out + 0, _mm_shuffle_epi8(luma, loadMask(rgbShuffleMasks.interleave[0])));
+        _mm_storeu_si128(out + 1, _mm_shuffle_epi8(luma, loadMask(rgbShuffleMasks.interleave[1])));
+        _mm_storeu_si128(out + 2, _mm_shuffle_epi8(luma, loadMask(rgbShuffleMasks.interleave[2])));
+    }
+    if (x < width) {
+        scalarKernels().pointOpsRow[static_cast<size_t>(PixelFormat::Layout::Rgb888)](src + x * 3, dst + x * 3, width - x, ops); // Remaining pixels.
+    }
+}
+
+// BT.601 to RGB 16 pixels at a time: 16-bit fixed point per channel, packed with unsigned
+// saturation and merged into RGB24 with pshufb.
+void yuvToRgbRow(const uchar* y, const uchar* u, const uchar* v, uchar* dst, int width) {
+    const __m128i zero = _mm_setzero_si128();
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m128i luma = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x));
+        const __m128i cb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + x));
+        const __m128i cr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + x));
+
+        __m128i r[2], g[2], b[2];
+        for (int half = 0; half < 2; ++half) {
+            const __m128i y16 = half ? _mm_unpackhi_epi8(luma, zero) : _mm_unpacklo_epi8(luma, zero);
+            const __m128i u16 = half ? _mm_unpackhi_epi8(cb, zero) : _mm_unpacklo_epi8(cb, zero);
+            const __m128i v16 = half ? _mm_unpackhi_epi8(cr, zero) : _mm_unpacklo_epi8(cr, zero);
+            const __m128i c = _mm_mullo_epi16(_mm_sub_epi16(y16, _mm_set1_epi16(16)), _mm_set1_epi16(YuvToRgb::yScale));
+            const __m128i d = _mm_sub_epi16(u16, _mm_set1_epi16(128));
+            const __m128i e = _mm_sub_epi16(v16, _mm_set1_epi16(128));
+            const __m128i round = _mm_set1_epi16(32);
+            r[half] = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(c, _mm_mullo_epi16(e, _mm_set1_epi16(YuvToRgb::vToR))), round), 6);
+            g[half] = _mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(_mm_sub_epi16(c, _mm_mullo_epi16(d, _mm_set1_epi16(YuvToRgb::uToG))),
+                _mm_mullo_epi16(e, _mm_set1_epi16(YuvToRgb::vToG))), round), 6);
+            // Blue can exceed 16 bits, but only where it saturates to 255 anyway.
+            b[half] = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(c, _mm_mullo_epi16(d, _mm_set1_epi16(YuvToRgb::uToB))), round), 6);
+        }
+        const __m128i red = _mm_packus_epi16(r[0], r[1]);
+        const __m128i green = _mm_packus_epi16(g[0], g[1]);
+        const __m128i blue = _mm_packus_epi16(b[0], b[1]);
+
+        auto* out = reinterpret_cast<__m128i*>(dst + x * 3);
+        for (int vector = 0; vector < 3; ++vector) {
+            const auto& masks = rgbShuffleMasks.merge;
+            _mm_storeu_si128(out + vector, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(red, loadMask(masks[0][vector])),
+                _mm_shuffle_epi8(green, loadMask(masks[1][vector]))), _mm_shuffle_epi8(blue, loadMask(masks[2][vector]))));
+        }
+    }
+    if (x < width) {
+        scalarKernels().yuvToRgbRow(y + x, u + x, v + x, dst + x * 3, width - x); // Remaining pixels.
+    }
+}
+
+} // namespace ImageKernels::Ssse3
+
+namespace ImageKernels {
+
+const KernelTable* ssse3Kernels() {
+    // 32-bit pixels need no shuffles; the SSE2 kernels are as good.
+    static const KernelTable table{ Isa::SSSE3, "ssse3",
+        { &Ssse3::pointOpsRow, &Sse2::pointOpsRow32<PixelFormat::Rgbx8888>, &Sse2::pointOpsRow32<PixelFormat::Xrgb32>, &Sse2::lutRow },
+        &Sse2::lutRow, scalarKernels().horizontalBlurRow, &Sse2::verticalBlur, &Ssse3::yuvToRgbRow, &Sse2::sumAbsDiff,
+        &Sse2::convolveRow, &Sse2::convolveColumns, &Sse2::packRow, &Sse2::unsharpRow, &Sse2::edgeMagnitudeRow };
+    return &table;
+}
+
+} // namespace ImageKernels
+
+#else
+
+namespace ImageKernels {
+
+const KernelTable* ssse3Kernels() {
+    return nullptr; // Not an x86 build.
+}
+
+} // namespace ImageKernels
+
+#endif
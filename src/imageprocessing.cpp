@@ -1,26 +1,51 @@
 #include "imageprocessing.h"
+#include "imagekernels.h"
+#include "boxblur.h"
+#include "separablefilter.h"
+#include "framebufferpool.h"
+
+namespace {
+
+// toSupported: Formats with a PixelFormat layout are processed as they are; others are converted
+// to RGB888 once up front.
+QImage toSupported(const QImage& image) {
+    return PixelFormat::layoutOf(image.format()) != PixelFormat::Layout::Unsupported
+        ? image
+        : image.convertToFormat(QImage::Format_RGB888);
+}
+
+// applyDetail: One SeparableFilter pass from the source into a pooled destination.
+QImage applyDetail(const QImage& original, ImageProcessing::DetailFilter detail, int amount, int radius,
+    const ImageProcessing::PointOps* pointOps) {
+    if (original.isNull()) {
+        return original;
+    }
+    const QImage source = toSupported(original);
+    QImage filtered = FrameBufferPool::global().acquire(source.size(), source.format());
+    thread_local SeparableFilter filter;
+    filter.apply(detail, amount, radius, source.constBits(), static_cast<int>(source.bytesPerLine()),
+        filtered.bits(), static_cast<int>(filtered.bytesPerLine()), source.width(), source.height(),
+        pointOps, PixelFormat::layoutOf(source.format()));
+    return filtered;
+}
+
+} // namespace
 
 // Function to apply grayscale effect to an image.
 QImage ImageProcessing::applyGrayscale(const QImage& original) {
-    QImage grayImage = original.copy(); // Create a copy of the original image to modify.
+    if (original.isNull()) {
+        return original;
+    }
+    const QImage source = toSupported(original);
+    QImage grayImage = FrameBufferPool::global().acquire(source.size(), source.format()); // Pooled destination.
+    const PixelFormat::Layout layout = PixelFormat::layoutOf(source.format());
     const int width = grayImage.width(); // Get the width of the image.
     const int height = grayImage.height(); // Get the height of the image.
-    uchar* bits = grayImage.bits(); // Access the raw image data.
+    const PointOps ops = PointOps::create(true, 0); // Grayscale with an identity lookup.
 
-    // Iterate over each pixel in the image.
+    // Convert each row straight into the destination.
     for (int y = 0; y < height; ++y) {
-        uchar* row = bits + y * grayImage.bytesPerLine(); // Calculate the start of the row.
-        for (int x = 0; x < width; ++x) {
-            uchar* pixel = row + x * 3; // Access the pixel at (x, y).
-            // Calculate the grayscale value using weighted sum method.
-            const int r = pixel[0];
-            const int g = pixel[1];
-            const int b = pixel[2];
-            const int grayValue = (r * 11 + g * 16 + b * 5) >> 5; // Weighted sum and bit-shift for performance.
-
-            // Set the RGB values of the pixel to the grayscale value.
-            pixel[0] = pixel[1] = pixel[2] = static_cast<uchar>(grayValue);
-        }
+        pointOpsRow(source.constScanLine(y), grayImage.scanLine(y), width, ops, layout);
     }
 
     return grayImage; // Return the modified image.
@@ -28,28 +53,20 @@ QImage ImageProcessing::applyGrayscale(const QImage& original) {
 
 // Function to adjust the brightness of an image.
 QImage ImageProcessing::adjustBrightness(const QImage& original, int brightnessValue) {
-    if (brightnessValue == 0) {
+    if (brightnessValue == 0 || original.isNull()) {
         return original; // Return the original image if brightness adjustment is not needed.
     }
 
-    QImage adjusted = original.copy(); // Copy the original image to modify.
+    const QImage source = toSupported(original);
+    QImage adjusted = FrameBufferPool::global().acquire(source.size(), source.format()); // Pooled destination.
+    const PixelFormat::Layout layout = PixelFormat::layoutOf(source.format());
     const auto width = adjusted.width(); // Get the width of the image.
     const auto height = adjusted.height(); // Get the height of the image.
-    uchar* bits = adjusted.bits(); // Access the raw image data.
-    std::array<uchar, 256> lut{}; // Lookup table for brightness adjustment.
+    const PointOps ops = PointOps::create(false, brightnessValue); // Lookup table for brightness adjustment.
 
-    // Initialize the lookup table with adjusted brightness values.
-    for (size_t i = 0; i < lut.size(); ++i) {
-        const int adjustedValue = static_cast<int>(i) + brightnessValue; // Adjust the value.
-        lut[i] = static_cast<uchar>(std::clamp(adjustedValue, 0, 255)); // Clamp the value to valid range.
-    }
-
-    // Apply the brightness adjustment to each pixel using the lookup table.
-    const auto end = bits + width * height * 3;
-    for (uchar* p = bits; p != end; p += 3) {
-        p[0] = lut[p[0]]; // Adjust the red component.
-        p[1] = lut[p[1]]; // Adjust the green component.
-        p[2] = lut[p[2]]; // Adjust the blue component.
+    // Apply the brightness adjustment row by row so padding at the end of each line is skipped.
+    for (int y = 0; y < height; ++y) {
+        pointOpsRow(source.constScanLine(y), adjusted.scanLine(y), width, ops, layout);
     }
 
     return adjusted; // Return the brightness-adjusted image.
@@ -57,111 +74,102 @@ QImage ImageProcessing::adjustBrightness(const QImage& original, int brightnessV
 
 // Function to apply a box blur effect to an image.
 QImage ImageProcessing::applyBoxBlur(const QImage& original, int blurValue) {
-    if (blurValue < 1) {
+    return applyBlur(original, blurValue, BlurQuality::Box);
+}
+
+// applyBlur: The same passes at any quality; only the number of passes and the resolution differ.
+QImage ImageProcessing::applyBlur(const QImage& original, int blurRadius, BlurQuality quality) {
+    if (blurRadius < 1 || original.isNull()) {
         return original; // Return the original image if no blur is applied.
     }
-    QImage tempImage = original.copy(); // Copy the original image for processing.
-
-    horizontalBlurPass(tempImage, blurValue); // Apply horizontal blur pass.
-    verticalBlurPass(tempImage, blurValue); // Apply vertical blur pass.
+    const QImage source = toSupported(original);
+    QImage blurred = FrameBufferPool::global().acquire(source.size(), source.format()); // Destination; the source is only read.
+
+    if (quality == BlurQuality::Kernel && blurRadius <= maxKernelBlurRadius) {
+        thread_local SeparableFilter filter; // Row and column convolutions on the shared thread pool.
+        filter.blur(source.constBits(), static_cast<int>(source.bytesPerLine()),
+            blurred.bits(), static_cast<int>(blurred.bytesPerLine()),
+            source.width(), source.height(), blurRadius, nullptr, PixelFormat::layoutOf(source.format()));
+        return blurred;
+    }
+    thread_local BoxBlur blur; // Horizontal and vertical passes on the shared thread pool; scratch is kept between calls.
+    blur.apply(source.constBits(), static_cast<int>(source.bytesPerLine()),
+        blurred.bits(), static_cast<int>(blurred.bytesPerLine()),
+        source.width(), source.height(), blurRadius, nullptr, quality, PixelFormat::layoutOf(source.format()));
 
-    return tempImage; // Return the blurred image.
+    return blurred; // Return the blurred image.
 }
 
-// Apply horizontal blur to an image.
-void ImageProcessing::horizontalBlurPass(QImage& image, int blurRadius) {
-    const int width = image.width(); // Image width.
-    const int height = image.height(); // Image height.
-    const int bytesPerLine = image.bytesPerLine(); // Bytes per line in the image data.
-    uchar* data = image.bits(); // Raw image data.
+// applySharpen: amount is the percentage of the removed detail added back; 100 doubles it.
+QImage ImageProcessing::applySharpen(const QImage& original, int amount) {
+    return amount > 0 ? applyDetail(original, DetailFilter::Sharpen, amount, 1, nullptr) : original;
+}
 
-    QImage tempImage = image.copy(); // Copy of the image for reading during blur.
-    const uchar* tempData = tempImage.constBits(); // Constant raw data of the copied image.
+QImage ImageProcessing::applyUnsharpMask(const QImage& original, int radius, int amount) {
+    return amount > 0 ? applyDetail(original, DetailFilter::UnsharpMask, amount, radius, nullptr) : original;
+}
 
-    const int windowSize = 2 * blurRadius + 1; // Size of the blur window.
+// applyEdges: Color images are converted to gray on the way in, so every channel carries the same magnitude.
+QImage ImageProcessing::applyEdges(const QImage& original) {
+    const PointOps gray = PointOps::create(true, 0);
+    return applyDetail(original, DetailFilter::Edges, 0, 0, &gray);
+}
 
-    // Iterate over each row.
-    for (int y = 0; y < height; ++y) {
-        int sumRed = 0, sumGreen = 0, sumBlue = 0; // Sum of RGB components in the window.
-
-        // Pre-compute the sum for the initial window.
-        for (int kx = -blurRadius; kx <= blurRadius; ++kx) {
-            int pixelX = std::clamp(kx, 0, width - 1); // Clamp the x-coordinate to the image bounds.
-            const uchar* pixel = tempData + y * bytesPerLine + pixelX * 3; // Access the pixel.
-            sumRed += pixel[0]; // Add the red component to the sum.
-            sumGreen += pixel[1]; // Add the green component to the sum.
-            sumBlue += pixel[2]; // Add the blue component to the sum.
-        }
-
-        // Apply the blur effect across the row.
-        for (int x = 0; x < width; ++x) {
-            // Adjust window sums for the current position.
-            if (x > 0) {
-                int exitPixelX = std::max(x - blurRadius - 1, 0); // X-coordinate of the pixel exiting the window.
-                int enterPixelX = std::min(x + blurRadius, width - 1); // X-coordinate of the pixel entering the window.
-                const uchar* exitPixel = tempData + y * bytesPerLine + exitPixelX * 3; // Exiting pixel.
-                const uchar* enterPixel = tempData + y * bytesPerLine + enterPixelX * 3; // Entering pixel.
-
-                // Update sums by removing the exit pixel's contribution and adding the enter pixel's.
-                sumRed += enterPixel[0] - exitPixel[0];
-                sumGreen += enterPixel[1] - exitPixel[1];
-                sumBlue += enterPixel[2] - exitPixel[2];
-            }
-
-            // Compute the average for the current window and set the pixel's color.
-            uchar* pixel = data + y * bytesPerLine + x * 3;
-            pixel[0] = static_cast<uchar>(sumRed / windowSize);
-            pixel[1] = static_cast<uchar>(sumGreen / windowSize);
-            pixel[2] = static_cast<uchar>(sumBlue / windowSize);
-        }
+// Builds the lookup table for the given point operations.
+ImageProcessing::PointOps ImageProcessing::PointOps::create(bool grayscale, int brightness) {
+    PointOps ops;
+    ops.grayscale = grayscale;
+    ops.brightness = brightness;
+    // Initialize the lookup table with adjusted brightness values.
+    for (size_t i = 0; i < ops.lut.size(); ++i) {
+        const int adjustedValue = static_cast<int>(i) + brightness; // Adjust the value.
+        ops.lut[i] = static_cast<uchar>(std::clamp(adjustedValue, 0, 255)); // Clamp the value to valid range.
     }
+    return ops;
 }
 
-// Apply vertical blur to an image.
-void ImageProcessing::verticalBlurPass(QImage& image, int blurRadius) {
-    const int width = image.width(); // Image width.
-    const int height = image.height(); // Image height.
-    const int bytesPerLine = image.bytesPerLine(); // Bytes per line in the image data.
-    uchar* data = image.bits(); // Raw image data.
-
-    QImage tempImage = image.copy(); // Copy of the image for reading during blur.
-    const uchar* tempData = tempImage.constBits(); // Constant raw data of the copied image.
-
-    const int windowSize = 2 * blurRadius + 1; // Size of the blur window.
-
-    // Iterate over each column.
-    for (int x = 0; x < width; ++x) {
-        int sumRed = 0, sumGreen = 0, sumBlue = 0; // Sum of RGB components in the window.
-
-        // Pre-compute the sum for the initial window.
-        for (int ky = -blurRadius; ky <= blurRadius; ++ky) {
-            int pixelY = std::clamp(ky, 0, height - 1); // Clamp the y-coordinate to the image bounds.
-            const uchar* pixel = tempData + pixelY * bytesPerLine + x * 3; // Access the pixel.
-            sumRed += pixel[0]; // Add the red component to the sum.
-            sumGreen += pixel[1]; // Add the green component to the sum.
-            sumBlue += pixel[2]; // Add the blue component to the sum.
-        }
-
-        // Apply the blur effect down the column.
-        for (int y = 0; y < height; ++y) {
-            // Adjust window sums for the current position.
-            if (y > 0) {
-                int exitPixelY = std::max(y - blurRadius - 1, 0); // Y-coordinate of the pixel exiting the window.
-                int enterPixelY = std::min(y + blurRadius, height - 1); // Y-coordinate of the pixel entering the window.
-                const uchar* exitPixel = tempData + exitPixelY * bytesPerLine + x * 3; // Exiting pixel.
-                const uchar* enterPixel = tempData + enterPixelY * bytesPerLine + x * 3; // Entering pixel.
-
-                // Update sums by removing the exit pixel's contribution and adding the enter pixel's.
-                sumRed += enterPixel[0] - exitPixel[0];
-                sumGreen += enterPixel[1] - exitPixel[1];
-                sumBlue += enterPixel[2] - exitPixel[2];
-            }
-
-            // Compute the average for the current window and set the pixel's color.
-            uchar* pixel = data + y * bytesPerLine + x * 3;
-            pixel[0] = static_cast<uchar>(sumRed / windowSize);
-            pixel[1] = static_cast<uchar>(sumGreen / windowSize);
-            pixel[2] = static_cast<uchar>(sumBlue / windowSize);
-        }
-    }
+// The row kernels forward to the table chosen for this CPU at startup.
+void ImageProcessing::pointOpsRow(const uchar* src, uchar* dst, int width, const PointOps& ops, PixelFormat::Layout layout) {
+    ImageKernels::active().pointOpsRow[static_cast<size_t>(layout)](src, dst, width, ops);
+}
+
+void ImageProcessing::lutRow(const uchar* src, uchar* dst, int count, const PointOps& ops) {
+    ImageKernels::active().lutRow(src, dst, count, ops);
+}
+
+void ImageProcessing::horizontalBlurRow(const uchar* src, uchar* dst, int width, int blurRadius, int channels) {
+    ImageKernels::active().horizontalBlurRow(src, dst, width, blurRadius, channels);
+}
+
+void ImageProcessing::verticalBlur(const uchar* src, int srcStride, uchar* dst, int dstStride,
+    int width, int height, int blurRadius, int* columnSums, int channels) {
+    ImageKernels::active().verticalBlur(src, srcStride, dst, dstStride, width, height, blurRadius, columnSums, channels);
+}
+
+void ImageProcessing::yuvToRgbRow(const uchar* y, const uchar* u, const uchar* v, uchar* dst, int width) {
+    ImageKernels::active().yuvToRgbRow(y, u, v, dst, width);
+}
+
+int ImageProcessing::sumAbsDiff(const uchar* a, const uchar* b, int count) {
+    return ImageKernels::active().sumAbsDiff(a, b, count);
+}
+
+void ImageProcessing::convolveRow(const uchar* src, qint16* dst, int count, int step, const qint16* weights, int taps) {
+    ImageKernels::active().convolveRow(src, dst, count, step, weights, taps);
+}
+
+void ImageProcessing::convolveColumns(const qint16* const* rows, qint16* dst, int count, const qint16* weights, int taps) {
+    ImageKernels::active().convolveColumns(rows, dst, count, weights, taps);
+}
+
+void ImageProcessing::packRow(const qint16* src, uchar* dst, int count) {
+    ImageKernels::active().packRow(src, dst, count);
+}
+
+void ImageProcessing::unsharpRow(const uchar* original, const qint16* blurred, uchar* dst, int count, int amount) {
+    ImageKernels::active().unsharpRow(original, blurred, dst, count, amount);
+}
+
+void ImageProcessing::edgeMagnitudeRow(const qint16* gx, const qint16* gy, uchar* dst, int count) {
+    ImageKernels::active().edgeMagnitudeRow(gx, gy, dst, count);
 }
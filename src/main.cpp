@@ -1,10 +1,114 @@
 #include "mainwindow.h"
+#include "headlessrunner.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Looked for before any application object exists: a headless run must not need a display.
+bool isHeadless(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// runHeadless: Qt-Gst-Camera --headless --input file.mp4 --effects gray,brightness=20,blur=5 --output out.mkv
+// or, without a camera or decoder, Qt-Gst-Camera --headless --replay clip.qgraw --effects blur=5
+int runHeadless(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs the effects over a file or source pipeline as fast as possible.");
+    parser.addHelpOption();
+    const QCommandLineOption headlessOption("headless", "Run without a window.");
+    const QCommandLineOption inputOption("input", "Media file to process.", "file");
+    const QCommandLineOption sourceOption("source", "Source pipeline instead of --input, e.g. \"videotestsrc num-buffers=600\".", "pipeline");
+    const QCommandLineOption outputOption("output", "Encode the result to this file (.mkv, .mp4).", "file");
+    const QCommandLineOption effectsOption("effects", "Effects, e.g. gray,brightness=20,blur=5.", "list", "");
+    const QCommandLineOption encoderOption("encoder", "x264, openh264 or lossless.", "name", "x264");
+    const QCommandLineOption bitrateOption("bitrate", "Encoder bitrate.", "kbps", "8000");
+    const QCommandLineOption sizeOption("size", "Scale frames to fit this size before the effects.", "WxH");
+    const QCommandLineOption pipelineEffectsOption("pipeline-effects", "Run the effects in the qtgsteffects element on the streaming thread.");
+    const QCommandLineOption exportOption("export", "Publish processed frames to shared memory under this name.", "name");
+    const QCommandLineOption roiOption("roi", "Process only this region, in fractions of the frame, e.g. 0.25,0.25,0.5,0.5.", "x,y,w,h");
+    const QCommandLineOption replayOption("replay", "Raw capture file to play as fast as possible instead of --input.", "file");
+    const QCommandLineOption captureOption("capture", "Append the frames the pipeline delivers to a raw capture file.", "file");
+    parser.addOptions({ headlessOption, inputOption, sourceOption, outputOption, effectsOption, encoderOption, bitrateOption, sizeOption,
+        pipelineEffectsOption, exportOption, roiOption, replayOption, captureOption });
+    parser.process(app);
+
+    HeadlessOptions options;
+    options.input = parser.value(inputOption);
+    options.source = parser.value(sourceOption);
+    options.output = parser.value(outputOption);
+    options.effects = EffectSettings::fromString(parser.value(effectsOption));
+    options.pipelineEffects = parser.isSet(pipelineEffectsOption);
+    options.exportName = parser.value(exportOption);
+    options.region = RegionOfInterest::fromString(parser.value(roiOption));
+    options.replay = parser.value(replayOption);
+    options.capture = parser.value(captureOption);
+    options.bitrateKbps = std::max(parser.value(bitrateOption).toInt(), 1);
+    const QString encoder = parser.value(encoderOption);
+    options.encoder = encoder == "openh264" ? RecorderSettings::OpenH264
+        : encoder == "lossless" ? RecorderSettings::Lossless
+        : RecorderSettings::X264;
+    const QStringList size = parser.value(sizeOption).split('x');
+    if (size.size() == 2) {
+        options.size = QSize(size[0].toInt(), size[1].toInt());
+    }
+    if (options.input.isEmpty() && options.source.isEmpty() && options.replay.isEmpty()) {
+        qCritical("Need --input, --source or --replay.");
+        return 2;
+    }
+
+    return HeadlessRunner(options).run();
+}
+
+} // namespace
 
 
 int main(int argc, char* argv[])
 {
+    if (isHeadless(argc, argv)) {
+        return runHeadless(argc, argv);
+    }
+
     QApplication app(argc, argv);
-    MainWindow main;
+
+    // Cameras to open: every --camera is one stream, e.g. "v4l2src device=/dev/video0" or
+    // "filesrc location=clip.mp4 ! decodebin"; --test-cameras adds videotestsrc streams.
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption cameraOption(QStringList{ "c", "camera" }, "Source pipeline of one camera; repeat for more.", "pipeline");
+    const QCommandLineOption testCamerasOption("test-cameras", "Add N videotestsrc cameras.", "N", "0");
+    const QCommandLineOption headlessOption("headless", "Process --input or --source without a window; see --headless --help.");
+    const QCommandLineOption exportOption("export", "Publish processed frames to shared memory under this name (NAME-0, NAME-1, ... for several cameras).", "name");
+    const QCommandLineOption replayOption("replay", "Play a raw capture file as a camera, at its original timing; repeat for more.", "file");
+    const QCommandLineOption captureOption("capture", "Append every camera's frames to a raw capture file (FILE-0, FILE-1, ... for several cameras).", "file");
+    parser.addOptions({ cameraOption, testCamerasOption, headlessOption, exportOption, replayOption, captureOption });
+    parser.process(app);
+
+    QStringList sources = parser.values(cameraOption);
+    for (const QString& file : parser.values(replayOption)) {
+        sources << QStringLiteral("qtgstreplaysrc location=\"%1\"").arg(file);
+    }
+    const int testCameras = parser.value(testCamerasOption).toInt();
+    for (int i = 0; i < testCameras; ++i) {
+        sources << QStringLiteral("videotestsrc is-live=true pattern=%1 ! video/x-raw,width=1280,height=720,framerate=30/1").arg(i % 25);
+    }
+
+    MainWindow main(sources);
+    if (parser.isSet(exportOption)) {
+        main.exportFrames(parser.value(exportOption));
+    }
+    if (parser.isSet(captureOption)) {
+        main.captureFrames(parser.value(captureOption));
+    }
     main.show();
     return app.exec();
 }
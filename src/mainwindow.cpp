@@ -1,18 +1,31 @@
 #include "mainwindow.h"
 #include "styleloader.h"
+#include "frametracer.h"
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <algorithm>
 
-// Constructor: Sets up the main window, video player, and GStreamer handler.
-MainWindow::MainWindow(QWidget* parent)
-    : QMainWindow(parent),
-    gstreamerHandler(std::make_unique<GStreamerHandler>(this)), // Initialize GStreamer handler with the MainWindow as parent.
-    videoPlayer(std::make_unique<VideoPlayer>()) { // Initialize the video player.
+// Constructor: Sets up the main window and one camera stream, with its tile, per source.
+MainWindow::MainWindow(const QStringList& sources, QWidget* parent)
+    : QMainWindow(parent) {
+    for (const QString& source : sources.isEmpty() ? QStringList{ QString() } : sources) {
+        streams.push_back(std::make_unique<CameraStream>(source)); // An empty source keeps the handler's default camera.
+    }
     setupUI(); // Setup the user interface elements.
     setupConnections(); // Connect UI signals to slots.
-    initializeVideoPlayer(); // Initialize the video player with GStreamer.
+    initializeStreams(); // Connect every stream to its tile and start it.
 }
 
-// Destructor: Default implementation suffices since smart pointers handle cleanup.
-MainWindow::~MainWindow() = default;
+// Destructor: Stops the streams before the tiles they deliver to are destroyed.
+MainWindow::~MainWindow() {
+    for (auto& stream : streams) {
+        stream->stop();
+    }
+}
 
 // setupUI: Constructs and arranges UI components.
 void MainWindow::setupUI() {
@@ -28,16 +41,20 @@ void MainWindow::setupUI() {
     auto* mainLayout = new QVBoxLayout(centralWidget);
 
     // Add video player and control elements to the layout.
-    setupVideoPlayer(mainLayout);
+    setupVideoGrid(mainLayout);
     setupControls(mainLayout);
 
     centralWidget->setLayout(mainLayout); // Set the layout for the central widget.
     setCentralWidget(centralWidget); // Make the central widget the main window's central widget.
 }
 
-// setupVideoPlayer: Adds the video player widget to the main layout.
-void MainWindow::setupVideoPlayer(QVBoxLayout* mainLayout) {
-    mainLayout->addWidget(videoPlayer.get(), 1); // Add the video player to the layout with a stretch factor.
+// setupVideoGrid: Adds the grid of video tiles to the main layout, one tile per stream.
+void MainWindow::setupVideoGrid(QVBoxLayout* mainLayout) {
+    videoGrid = new VideoGrid();
+    for (const auto& stream : streams) {
+        videoGrid->addPlayer()->setTracer(&stream->tracer()); // Each tile shows its own stream's fps and latency.
+    }
+    mainLayout->addWidget(videoGrid, 1); // Add the grid to the layout with a stretch factor.
 }
 
 // setupControls: Creates and adds UI controls for video effects to the layout.
@@ -47,6 +64,11 @@ void MainWindow::setupControls(QVBoxLayout* mainLayout) {
     controlsLayout->addWidget(ui.grayscaleCheckBox);
     controlsLayout->addWidget(ui.enableBrightness);
     controlsLayout->addWidget(ui.brightnessSlider);
+    // Auto brightness steers the brightness from each frame's histogram, shown below it.
+    autoBrightnessCheckBox = new QCheckBox(tr("Auto brightness"), this);
+    histogram = new HistogramWidget(this);
+    controlsLayout->addWidget(autoBrightnessCheckBox);
+    controlsLayout->addWidget(histogram);
     controlsLayout->addWidget(ui.enableBlur);
     controlsLayout->addWidget(ui.blurSlider);
 
@@ -56,6 +78,65 @@ void MainWindow::setupControls(QVBoxLayout* mainLayout) {
     ui.brightnessSlider->setValue(0);
 
     ui.blurSlider->setEnabled(false);
+    ui.blurSlider->setRange(0, 200); // Every quality but the exact kernel costs the same per pixel at any radius.
+
+    // Blur quality: one box, a three-box Gaussian, the Gaussian at a reduced resolution, or the
+    // exact Gaussian kernel, which falls back to three boxes past ImageProcessing::maxKernelBlurRadius.
+    blurQualityComboBox = new QComboBox(this);
+    blurQualityComboBox->addItem(tr("Box blur"), QStringLiteral("box"));
+    blurQualityComboBox->addItem(tr("Gaussian blur"), QStringLiteral("gaussian"));
+    blurQualityComboBox->addItem(tr("Gaussian blur, large radius"), QStringLiteral("pyramid"));
+    blurQualityComboBox->addItem(tr("Gaussian blur, exact kernel"), QStringLiteral("kernel"));
+    controlsLayout->addWidget(blurQualityComboBox);
+
+    // Detail filters, applied after the blur: how much detail sharpening adds back, and how wide
+    // the unsharp mask's blur is.
+    detailComboBox = new QComboBox(this);
+    detailComboBox->addItem(tr("No detail filter"), static_cast<int>(ImageProcessing::DetailFilter::None));
+    detailComboBox->addItem(tr("Sharpen"), static_cast<int>(ImageProcessing::DetailFilter::Sharpen));
+    detailComboBox->addItem(tr("Unsharp mask"), static_cast<int>(ImageProcessing::DetailFilter::UnsharpMask));
+    detailComboBox->addItem(tr("Edges"), static_cast<int>(ImageProcessing::DetailFilter::Edges));
+    detailAmountSlider = new QSlider(Qt::Horizontal, this);
+    detailAmountSlider->setRange(0, 300);
+    detailAmountSlider->setValue(EffectSettings().detailAmount);
+    detailAmountSlider->setEnabled(false);
+    detailRadiusSlider = new QSlider(Qt::Horizontal, this);
+    detailRadiusSlider->setRange(1, ImageProcessing::maxKernelBlurRadius);
+    detailRadiusSlider->setValue(EffectSettings().detailRadius);
+    detailRadiusSlider->setEnabled(false);
+    controlsLayout->addWidget(detailComboBox);
+    controlsLayout->addWidget(detailAmountSlider);
+    controlsLayout->addWidget(detailRadiusSlider);
+
+    // Incremental processing: for mostly static scenes, only the tiles that changed are recomputed.
+    incrementalCheckBox = new QCheckBox(tr("Process changed tiles only"), this);
+    controlsLayout->addWidget(incrementalCheckBox);
+
+    // Latency tracing: an on-screen overlay and an export of the recorded session.
+    overlayCheckBox = new QCheckBox(tr("Latency overlay"), this);
+    exportTraceButton = new QPushButton(tr("Export trace..."), this);
+    controlsLayout->addWidget(overlayCheckBox);
+    controlsLayout->addWidget(exportTraceButton);
+
+    // Frame-drop policy: what the pipeline does when processing or drawing falls behind.
+    dropPolicyComboBox = new QComboBox(this);
+    dropPolicyComboBox->addItem(tr("Latest frame only"), QStringLiteral("latest"));
+    dropPolicyComboBox->addItem(tr("Bounded queue (3 frames)"), QStringLiteral("queue=3"));
+    dropPolicyComboBox->addItem(tr("Lossless"), QStringLiteral("lossless=3"));
+    controlsLayout->addWidget(dropPolicyComboBox);
+
+    // Recording of the processed stream, effects included.
+    recordButton = new QPushButton(tr("Record"), this);
+    recordButton->setCheckable(true);
+    controlsLayout->addWidget(recordButton);
+
+    // Full-resolution stills, encoded in the background.
+    snapshotButton = new QPushButton(tr("Snapshot"), this);
+    burstButton = new QPushButton(tr("Burst (%1)").arg(burstLength), this);
+    stillEffectsCheckBox = new QCheckBox(tr("Stills with effects"), this);
+    controlsLayout->addWidget(snapshotButton);
+    controlsLayout->addWidget(burstButton);
+    controlsLayout->addWidget(stillEffectsCheckBox);
     // Add a spacer item for aesthetic spacing in the UI.
     controlsLayout->addSpacerItem(new QSpacerItem(20, 20, QSizePolicy::Minimum, QSizePolicy::Expanding));
 
@@ -76,43 +157,320 @@ void MainWindow::setupConnections() {
     connect(ui.grayscaleCheckBox, &QCheckBox::stateChanged, this, &MainWindow::applyGrayscaleEffect);
     connect(ui.enableBrightness, &QCheckBox::stateChanged, this, &MainWindow::enableBrightnessAdjustment);
     connect(ui.brightnessSlider, &QSlider::valueChanged, this, &MainWindow::adjustBrightnessEffect);
+    connect(autoBrightnessCheckBox, &QCheckBox::toggled, this, &MainWindow::applyAutoBrightness);
     connect(ui.enableBlur, &QCheckBox::stateChanged, this, &MainWindow::enableBlurAdjustment);
     connect(ui.blurSlider, &QSlider::valueChanged, this, &MainWindow::applyBlurEffect);
+    connect(blurQualityComboBox, &QComboBox::currentIndexChanged, this, &MainWindow::applyBlurQuality);
+    connect(detailComboBox, &QComboBox::currentIndexChanged, this, &MainWindow::applyDetailFilter);
+    connect(detailAmountSlider, &QSlider::valueChanged, this, &MainWindow::applyDetailAmount);
+    connect(detailRadiusSlider, &QSlider::valueChanged, this, &MainWindow::applyDetailRadius);
+    connect(incrementalCheckBox, &QCheckBox::toggled, this, &MainWindow::applyIncremental);
+
+    for (VideoPlayer* player : videoGrid->players()) {
+        connect(overlayCheckBox, &QCheckBox::toggled, player, &VideoPlayer::setOverlayEnabled);
+    }
+    connect(exportTraceButton, &QPushButton::clicked, this, &MainWindow::exportTrace);
+    connect(dropPolicyComboBox, &QComboBox::currentIndexChanged, this, &MainWindow::applyDropPolicy);
+    connect(recordButton, &QPushButton::toggled, this, &MainWindow::toggleRecording);
+    connect(snapshotButton, &QPushButton::clicked, this, [this] { captureStills(1); });
+    connect(burstButton, &QPushButton::clicked, this, [this] { captureStills(burstLength); });
+    for (const auto& stream : streams) {
+        connect(&stream->recorder(), &Recorder::error, this, [this](const QString& message) {
+            if (recordButton->isChecked()) {
+                recordButton->setChecked(false); // Stops every recorder.
+                QMessageBox::warning(this, tr("Record"), tr("Recording failed: %1").arg(message));
+            }
+        }, Qt::QueuedConnection);
+        // Pipelines come up on their own threads after the window is shown; until the first frame
+        // the status bar follows their progress.
+        GStreamerHandler* handler = &stream->handler();
+        connect(handler, &GStreamerHandler::error, this, [this](const QString& message) {
+            QMessageBox::warning(this, tr("Camera"), tr("Camera pipeline failed: %1").arg(message));
+        }, Qt::QueuedConnection);
+        connect(handler, &GStreamerHandler::stateChanged, this, [this, handler](const QString& state) {
+            if (handler->startup().firstFrameNs < 0) {
+                statusBar()->showMessage(tr("Starting camera: %1").arg(state));
+            }
+        }, Qt::QueuedConnection);
+        connect(handler, &GStreamerHandler::firstFrame, this, [this](qint64 elapsed) {
+            statusBar()->showMessage(tr("First frame after %1 ms").arg(elapsed / 1e6, 0, 'f', 1));
+        }, Qt::QueuedConnection);
+        connect(&stream->snapshots(), &SnapshotEncoder::saved, this, [this](const QString& path, qint64 encodeNs) {
+            statusBar()->showMessage(tr("Saved %1 in %2 ms").arg(QDir::toNativeSeparators(path)).arg(encodeNs / 1e6, 0, 'f', 1));
+        }, Qt::QueuedConnection);
+    }
+}
+
+// initializeStreams: Connects each stream to its tile and starts it.
+void MainWindow::initializeStreams() {
+    for (size_t i = 0; i < streams.size(); ++i) {
+        CameraStream* stream = streams[i].get();
+        VideoPlayer* player = videoGrid->players()[static_cast<int>(i)];
+        FrameProcessor* processor = &stream->processor();
+        // Processed frames are queued to the GUI thread, where the player only has to draw them.
+        connect(processor, &FrameProcessor::frameProcessed, player, &VideoPlayer::setImage, Qt::QueuedConnection);
+        connect(processor, &FrameProcessor::frameRefreshed, player, &VideoPlayer::refreshImage, Qt::QueuedConnection);
+        connect(player, &VideoPlayer::framePainted, processor, &FrameProcessor::notifyPainted, Qt::DirectConnection);
+        connect(player, &VideoPlayer::frameDelivered, processor, &FrameProcessor::notifyDelivered, Qt::DirectConnection);
+        if (i == 0) {
+            // The stats are gathered in the effect pass; the widget only draws 4 × 256 bins per frame.
+            connect(processor, &FrameProcessor::frameStats, histogram, &HistogramWidget::setStats, Qt::QueuedConnection);
+            processor->setStatsEnabled(true);
+        }
+
+        // Frames are scaled to the tile in the pipeline, so effects only process the pixels that are shown.
+        connect(player, &VideoPlayer::displaySizeChanged, stream, &CameraStream::setDisplaySize);
+        stream->setDisplaySize(player->displaySize());
+        // Digital zoom: a region dragged on the tile is cropped in the pipeline, or processed alone.
+        connect(player, &VideoPlayer::regionOfInterestChanged, stream, &CameraStream::setRegionOfInterest);
+    }
+
+    // Show the frame counters once per second so losses at each stage are visible.
+    connect(&statisticsTimer, &QTimer::timeout, this, &MainWindow::updateFrameStatistics);
+    statisticsTimer.start(1000);
+
+    applyDropPolicy(dropPolicyComboBox->currentIndex());
+    statusBar()->showMessage(tr("Starting camera..."));
+    for (auto& stream : streams) {
+        stream->start(); // Starts the effects before the pipeline, so the first frames find them ready; returns at once.
+    }
+}
+
+// applyDropPolicy: Gives the pipeline and the processor the same policy, so every stage drops or blocks alike.
+void MainWindow::applyDropPolicy(int index) {
+    const DropPolicy policy = DropPolicy::fromString(dropPolicyComboBox->itemData(index).toString());
+    for (auto& stream : streams) {
+        stream->setDropPolicy(policy);
+    }
+}
+
+// updateFrameStatistics: Shows how many frames were received, processed and painted over all streams,
+// where frames were dropped, and each stream's fps so the point where the machine saturates is visible.
+void MainWindow::updateFrameStatistics() {
+    FrameProcessor::Counters counters;
+    GStreamerHandler::Counters pipeline;
+    Recorder::Counters recording;
+    SnapshotEncoder::Counters stills;
+    QStringList fps;
+    qint64 firstFrame = -1; // Slowest stream's time to first frame; -1 while any is still starting.
+    bool starting = false;
+    for (const auto& stream : streams) {
+        const auto streamCounters = stream->processor().counters();
+        counters.received += streamCounters.received;
+        counters.processed += streamCounters.processed;
+        counters.dropped += streamCounters.dropped;
+        counters.blocked += streamCounters.blocked;
+        counters.painted += streamCounters.painted;
+        counters.tiles += streamCounters.tiles;
+        counters.tilesProcessed += streamCounters.tilesProcessed;
+        pipeline.queueDropped += stream->handler().counters().queueDropped;
+        const qint64 streamFirstFrame = stream->handler().startup().firstFrameNs;
+        starting = starting || streamFirstFrame < 0;
+        firstFrame = std::max(firstFrame, streamFirstFrame);
+        const auto streamRecording = stream->recorder().counters();
+        recording.recorded += streamRecording.recorded;
+        recording.dropped += streamRecording.dropped;
+        recording.segments += streamRecording.segments;
+        const auto streamStills = stream->snapshots().counters();
+        stills.saved += streamStills.saved;
+        stills.dropped += streamStills.dropped;
+        stills.highWater = std::max(stills.highWater, streamStills.highWater);
+        stills.maxEncodeNs = std::max(stills.maxEncodeNs, streamStills.maxEncodeNs);
+        stills.totalEncodeNs += streamStills.totalEncodeNs;
+        fps << QString::number(stream->tracer().fps(), 'f', 1);
+    }
+    if (starting && counters.received == 0) {
+        return; // Leaves the startup progress on screen.
+    }
+    const auto pool = FrameBufferPool::global().stats();
+    QString message = tr("Received %1 | Processed %2 | Dropped %3 queue / %4 mailbox | Blocked %5 | Painted %6 | Buffers %7 hit / %8 miss, %9 MB peak")
+        .arg(counters.received)
+        .arg(counters.processed)
+        .arg(pipeline.queueDropped)
+        .arg(counters.dropped)
+        .arg(counters.blocked)
+        .arg(counters.painted)
+        .arg(pool.hits)
+        .arg(pool.misses)
+        .arg(pool.peakResidentBytes / (1024.0 * 1024.0), 0, 'f', 1);
+    if (streams.size() > 1) {
+        message += tr(" | fps %1").arg(fps.join(QLatin1String(" / ")));
+    }
+    if (counters.tiles > 0) {
+        message += tr(" | Tiles reprocessed %1%").arg(100.0 * counters.tilesProcessed / counters.tiles, 0, 'f', 1);
+    }
+    if (!starting) {
+        message += tr(" | First frame %1 ms").arg(firstFrame / 1e6, 0, 'f', 1);
+    }
+    if (autoBrightnessCheckBox->isChecked()) {
+        message += tr(" | Auto brightness %1").arg(streams.front()->processor().autoBrightnessValue());
+    }
+    if (recordButton->isChecked()) {
+        // Frames the encoders could not keep up with are dropped here, never in the preview.
+        message += tr(" | Recorded %1, dropped %2, %3 segments")
+            .arg(recording.recorded)
+            .arg(recording.dropped)
+            .arg(recording.segments);
+    }
+    if (stills.saved + stills.dropped > 0) {
+        message += tr(" | Stills %1 saved, %2 dropped, queue peak %3, encode %4 ms avg / %5 ms max")
+            .arg(stills.saved)
+            .arg(stills.dropped)
+            .arg(stills.highWater)
+            .arg(stills.saved > 0 ? stills.totalEncodeNs / 1e6 / stills.saved : 0.0, 0, 'f', 1)
+            .arg(stills.maxEncodeNs / 1e6, 0, 'f', 1);
+    }
+    statusBar()->showMessage(message);
+}
+
+// captureStills: Writes the next count frames of every camera at full resolution into a new
+// timestamped folder under the user's pictures directory, with a subfolder per camera when there are several.
+void MainWindow::captureStills(int count) {
+    const QDir session(QDir(QStandardPaths::writableLocation(QStandardPaths::PicturesLocation))
+        .filePath(QStringLiteral("Qt-Gst-Camera/%1").arg(QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-HHmmss-zzz")))));
+    for (size_t i = 0; i < streams.size(); ++i) {
+        SnapshotSettings settings;
+        settings.directory = streams.size() > 1 ? session.filePath(QStringLiteral("camera%1").arg(i)) : session.path();
+        settings.applyEffects = stillEffectsCheckBox->isChecked();
+        streams[i]->captureStills(count, settings);
+    }
+}
+
+// toggleRecording: Records into a new timestamped folder under the user's videos directory,
+// with a subfolder per camera when there are several.
+void MainWindow::toggleRecording(bool enabled) {
+    if (!enabled) {
+        for (auto& stream : streams) {
+            stream->recorder().stop();
+        }
+        recordButton->setText(tr("Record"));
+        return;
+    }
+    const QDir session(QDir(QStandardPaths::writableLocation(QStandardPaths::MoviesLocation))
+        .filePath(QStringLiteral("Qt-Gst-Camera/%1").arg(QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-HHmmss")))));
+    for (size_t i = 0; i < streams.size(); ++i) {
+        RecorderSettings settings;
+        settings.directory = streams.size() > 1 ? session.filePath(QStringLiteral("camera%1").arg(i)) : session.path();
+        if (!streams[i]->recorder().start(settings)) {
+            QSignalBlocker blocker(recordButton);
+            recordButton->setChecked(false);
+            for (auto& stream : streams) {
+                stream->recorder().stop();
+            }
+            QMessageBox::warning(this, tr("Record"), tr("Could not start recording to %1").arg(settings.directory));
+            return;
+        }
+    }
+    recordButton->setText(tr("Stop recording"));
+}
+
+// exportFrames: Starts publishing each stream's processed frames to shared memory under name; with
+// several cameras, each gets its index after the name.
+void MainWindow::exportFrames(const QString& name) {
+    for (size_t i = 0; i < streams.size(); ++i) {
+        streams[i]->exporter().start(streams.size() > 1 ? QStringLiteral("%1-%2").arg(name).arg(i) : name);
+    }
 }
 
-// initializeVideoPlayer: Connects the GStreamer handler to the video player for frame updates.
-void MainWindow::initializeVideoPlayer() {
-    // Connect the newFrame signal from GStreamer to the setImage slot of the video player.
-    connect(gstreamerHandler.get(), &GStreamerHandler::newFrame, videoPlayer.get(), &VideoPlayer::setImage);
-    gstreamerHandler->startPipeline(); // Start the GStreamer pipeline for video streaming.
+// captureFrames: Starts a raw capture of every frame each stream's appsink receives, to path; with
+// several cameras, one file per camera with the camera's index before the extension. A stream that
+// cannot open its file is reported and keeps running without a capture.
+void MainWindow::captureFrames(const QString& path) {
+    const QFileInfo info(path);
+    for (size_t i = 0; i < streams.size(); ++i) {
+        const QString streamPath = streams.size() > 1
+            ? info.dir().filePath(QStringLiteral("%1-%2.%3").arg(info.baseName()).arg(i).arg(info.completeSuffix()))
+            : path;
+        if (!streams[i]->handler().startCapture(streamPath)) {
+            qWarning().noquote() << "Cannot capture to" << streamPath << ":" << streams[i]->handler().captureError();
+        }
+    }
+}
+
+// exportTrace: Saves the recorded frame timings as Chrome trace-event JSON; with several cameras,
+// one file per camera with the camera's index before the extension.
+void MainWindow::exportTrace() {
+    const QString path = QFileDialog::getSaveFileName(this, tr("Export trace"), QStringLiteral("frames.trace.json"), tr("Trace files (*.json)"));
+    if (path.isEmpty()) {
+        return;
+    }
+    const QFileInfo info(path);
+    for (size_t i = 0; i < streams.size(); ++i) {
+        const QString streamPath = streams.size() > 1
+            ? info.dir().filePath(QStringLiteral("%1-camera%2.%3").arg(info.baseName()).arg(i).arg(info.completeSuffix()))
+            : path;
+        if (!streams[i]->tracer().exportChromeTrace(streamPath)) {
+            QMessageBox::warning(this, tr("Export trace"), tr("Could not write %1").arg(streamPath));
+            return;
+        }
+    }
 }
 
 // Function implementations for enabling/disabling video effects based on UI interactions.
+// The controls apply to every stream.
 void MainWindow::applyGrayscaleEffect(int state) {
-    if (videoPlayer)
-        videoPlayer->setGrayscale(state == Qt::Checked); // Apply or remove grayscale effect based on checkbox state.
+    for (auto& stream : streams)
+        stream->processor().setGrayscale(state == Qt::Checked); // Apply or remove grayscale effect based on checkbox state.
 }
 
 void MainWindow::enableBrightnessAdjustment(int state) {
     if (ui.brightnessSlider)
         ui.brightnessSlider->setEnabled(state == Qt::Checked); // Enable/disable brightness slider based on checkbox state.
-    if (videoPlayer)
-        videoPlayer->setBrightnessEnabled(state == Qt::Checked); // Enable/disable brightness effect in the video player.
+    for (auto& stream : streams)
+        stream->processor().setBrightnessEnabled(state == Qt::Checked); // Enable/disable brightness effect in the frame processor.
 }
 
 void MainWindow::adjustBrightnessEffect(int value) {
-    if (videoPlayer)
-        videoPlayer->setBrightness(value); // Adjust video brightness based on slider value.
+    for (auto& stream : streams)
+        stream->processor().setBrightness(value); // Adjust video brightness based on slider value.
+}
+
+// applyAutoBrightness: The slider keeps the manual value, which comes back when auto brightness is turned off.
+void MainWindow::applyAutoBrightness(bool enabled) {
+    ui.enableBrightness->setEnabled(!enabled);
+    ui.brightnessSlider->setEnabled(!enabled && ui.enableBrightness->isChecked());
+    for (auto& stream : streams)
+        stream->processor().setAutoBrightness(enabled);
 }
 
 void MainWindow::enableBlurAdjustment(int state) {
     if (ui.blurSlider)
         ui.blurSlider->setEnabled(state == Qt::Checked); // Enable/disable blur slider based on checkbox state.
-    if (videoPlayer)
-        videoPlayer->setBlurEnabled(state == Qt::Checked); // Enable/disable blur effect in the video player.
+    for (auto& stream : streams)
+        stream->processor().setBlurEnabled(state == Qt::Checked); // Enable/disable blur effect in the frame processor.
 }
 
 void MainWindow::applyBlurEffect(int value) {
-    if (videoPlayer)
-        videoPlayer->setBlur(value); // Apply blur effect based on slider value.
+    for (auto& stream : streams)
+        stream->processor().setBlur(value); // Apply blur effect based on slider value.
+}
+
+void MainWindow::applyBlurQuality(int index) {
+    const auto quality = EffectSettings::blurQualityFromString(blurQualityComboBox->itemData(index).toString());
+    for (auto& stream : streams)
+        stream->processor().setBlurQuality(quality); // Same radius, different passes.
+}
+
+// applyDetailFilter: Edges have no amount, and only the unsharp mask has a radius.
+void MainWindow::applyDetailFilter(int index) {
+    const auto detail = static_cast<ImageProcessing::DetailFilter>(detailComboBox->itemData(index).toInt());
+    detailAmountSlider->setEnabled(detail == ImageProcessing::DetailFilter::Sharpen || detail == ImageProcessing::DetailFilter::UnsharpMask);
+    detailRadiusSlider->setEnabled(detail == ImageProcessing::DetailFilter::UnsharpMask);
+    for (auto& stream : streams)
+        stream->processor().setDetailFilter(detail);
+}
+
+void MainWindow::applyDetailAmount(int value) {
+    for (auto& stream : streams)
+        stream->processor().setDetailAmount(value); // Percent of the detail added back.
+}
+
+void MainWindow::applyDetailRadius(int value) {
+    for (auto& stream : streams)
+        stream->processor().setDetailRadius(value);
+}
+
+void MainWindow::applyIncremental(bool enabled) {
+    for (auto& stream : streams)
+        stream->processor().setIncremental(enabled); // The next frame is processed whole either way.
 }
@@ -1,34 +1,79 @@
 #pragma once
-#include "gstreamerhandler.h"
-#include "videoplayer.h"
+#include "camerastream.h"
+#include "framebufferpool.h"
+#include "videogrid.h"
+#include "histogramwidget.h"
 #include "ui_mainwindow.h"
 #include "styleloader.h"
 #include <QMainWindow>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QPushButton>
+#include <QSlider>
 #include <QVBoxLayout>
 #include <QSpacerItem>
+#include <QStatusBar>
+#include <QTimer>
+#include <QStringList>
 #include <memory>
+#include <vector>
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
 
 public:
-    explicit MainWindow(QWidget* parent = nullptr);
+    // One stream per source, shown in a grid; no sources opens the default camera.
+    explicit MainWindow(const QStringList& sources = {}, QWidget* parent = nullptr);
     ~MainWindow() override;
 
+    // Publishes every stream's processed frames to shared memory under name, or name-0, name-1, ...
+    // with several cameras; see SharedFrameReader.
+    void exportFrames(const QString& name);
+    // Appends every stream's frames to a raw capture file at path, or path-0.ext, path-1.ext, ...
+    // with several cameras, for qtgstreplaysrc to play back; see GStreamerHandler::startCapture.
+    void captureFrames(const QString& path);
+
 private:
     void setupUI();
-    void setupVideoPlayer(QVBoxLayout* mainLayout);
+    void setupVideoGrid(QVBoxLayout* mainLayout);
     void setupControls(QVBoxLayout* mainLayout);
     void setupConnections();
-    void initializeVideoPlayer();
+    void initializeStreams();
+    void updateFrameStatistics();
+    void exportTrace();
+    void applyDropPolicy(int index);
+    void toggleRecording(bool enabled);
+    void captureStills(int count);
 
     void applyGrayscaleEffect(int state);
     void enableBrightnessAdjustment(int state);
     void adjustBrightnessEffect(int value);
+    void applyAutoBrightness(bool enabled);
     void enableBlurAdjustment(int state);
     void applyBlurEffect(int value);
+    void applyBlurQuality(int index);
+    void applyDetailFilter(int index);
+    void applyDetailAmount(int value);
+    void applyDetailRadius(int value);
+    void applyIncremental(bool enabled);
 
     Ui::MainWindowClass ui;
-    std::unique_ptr<GStreamerHandler> gstreamerHandler;
-    std::unique_ptr<VideoPlayer> videoPlayer;
+    std::vector<std::unique_ptr<CameraStream>> streams; // Effects of every stream run on ThreadPool::global().
+    VideoGrid* videoGrid = nullptr; // One tile per stream, in the same order; owned by the central widget.
+    QTimer statisticsTimer;
+    QCheckBox* overlayCheckBox = nullptr; // Owned by the controls layout.
+    QPushButton* exportTraceButton = nullptr;
+    QComboBox* dropPolicyComboBox = nullptr;
+    QComboBox* blurQualityComboBox = nullptr;
+    QComboBox* detailComboBox = nullptr;
+    QSlider* detailAmountSlider = nullptr;
+    QSlider* detailRadiusSlider = nullptr; // Only the unsharp mask has a radius.
+    QCheckBox* incrementalCheckBox = nullptr;
+    QPushButton* recordButton = nullptr;
+    QPushButton* snapshotButton = nullptr;
+    QPushButton* burstButton = nullptr;
+    QCheckBox* stillEffectsCheckBox = nullptr;
+    QCheckBox* autoBrightnessCheckBox = nullptr;
+    HistogramWidget* histogram = nullptr; // Shows the first stream's input.
+    static constexpr int burstLength = 30; // Frames per burst, one second at 30 fps.
 };
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QImage>
+#include <QtGlobal>
+
+// PixelFormat: Byte layouts of the QImage formats the effects run on, as compile-time traits for
+// the kernels. A layout says where red, green and blue sit in a pixel and, for 32-bit layouts,
+// which byte is the fourth one (padding or alpha), which point operations carry through untouched.
+namespace PixelFormat {
+
+enum class Layout {
+    Rgb888, // Format_RGB888: R G B.
+    Rgbx8888, // Format_RGBX8888 and Format_RGBA8888: R G B X.
+    Xrgb32, // Format_RGB32 and Format_ARGB32: 0xAARRGGBB words, so B G R A on little-endian CPUs.
+    Gray8, // Format_Grayscale8.
+    Unsupported,
+};
+
+constexpr int layoutCount = static_cast<int>(Layout::Unsupported);
+
+struct Rgb888 {
+    static constexpr Layout layout = Layout::Rgb888;
+    static constexpr int bytes = 3;
+    static constexpr int red = 0, green = 1, blue = 2, filler = -1;
+};
+
+struct Rgbx8888 {
+    static constexpr Layout layout = Layout::Rgbx8888;
+    static constexpr int bytes = 4;
+    static constexpr int red = 0, green = 1, blue = 2, filler = 3;
+};
+
+struct Xrgb32 {
+    static constexpr Layout layout = Layout::Xrgb32;
+    static constexpr int bytes = 4;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    static constexpr int red = 2, green = 1, blue = 0, filler = 3;
+#else
+    static constexpr int red = 1, green = 2, blue = 3, filler = 0;
+#endif
+};
+
+struct Gray8 {
+    static constexpr Layout layout = Layout::Gray8;
+    static constexpr int bytes = 1;
+    static constexpr int red = 0, green = 0, blue = 0, filler = -1;
+};
+
+constexpr int bytesPerPixel(Layout layout) {
+    switch (layout) {
+    case Layout::Rgb888: return Rgb888::bytes;
+    case Layout::Rgbx8888: return Rgbx8888::bytes;
+    case Layout::Xrgb32: return Xrgb32::bytes;
+    case Layout::Gray8: return Gray8::bytes;
+    case Layout::Unsupported: break;
+    }
+    return 0;
+}
+
+// layoutOf: The layout an image format is processed in, or Unsupported for formats that are
+// converted to RGB888 first (premultiplied alpha, 16-bit, indexed, ...).
+constexpr Layout layoutOf(QImage::Format format) {
+    switch (format) {
+    case QImage::Format_RGB888: return Layout::Rgb888;
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGBA8888: return Layout::Rgbx8888;
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32: return Layout::Xrgb32;
+    case QImage::Format_Grayscale8: return Layout::Gray8;
+    default: return Layout::Unsupported;
+    }
+}
+
+} // namespace PixelFormat
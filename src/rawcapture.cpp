@@ -0,0 +1,205 @@
+#include "rawcapture.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace RawCapture {
+
+namespace {
+
+#ifndef _WIN32
+std::string systemError(const char* call, int error = errno) {
+    return std::string(call) + ": " + std::strerror(error);
+}
+#endif
+
+} // namespace
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)),
+      m_fd(std::exchange(other.m_fd, -1)), m_error(std::move(other.m_error)) {
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_fd = std::exchange(other.m_fd, -1);
+        m_error = std::move(other.m_error);
+    }
+    return *this;
+}
+
+#ifndef _WIN32
+
+bool MappedFile::create(const std::string& path) {
+    close();
+    m_fd = ::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        m_error = systemError("open");
+        return false;
+    }
+    return true;
+}
+
+// open: Read-only and shared, so replaying never copies the file, and a capture replayed again,
+// or by several pipelines at once, plays from the page cache.
+bool MappedFile::open(const std::string& path) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        m_error = systemError("open");
+        return false;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+        m_error = info.st_size <= 0 ? std::string("empty file") : systemError("fstat");
+        ::close(fd);
+        return false;
+    }
+    const auto bytes = static_cast<std::uint64_t>(info.st_size);
+    void* data = ::mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the file open.
+    if (data == MAP_FAILED) {
+        m_error = systemError("mmap");
+        return false;
+    }
+    m_data = static_cast<std::uint8_t*>(data);
+    m_size = bytes;
+    return true;
+}
+
+// reserve: posix_fallocate both extends the file and backs it with blocks. Filesystems that cannot
+// allocate ahead fall back to a sparse extension.
+bool MappedFile::reserve(std::uint64_t bytes) {
+    if (m_fd < 0) {
+        m_error = "not open for writing";
+        return false;
+    }
+    if (bytes <= m_size) {
+        return true;
+    }
+    const int allocated = ::posix_fallocate(m_fd, static_cast<off_t>(m_size), static_cast<off_t>(bytes - m_size));
+    if (allocated != 0 && (allocated != EOPNOTSUPP && allocated != EINVAL)) {
+        m_error = systemError("posix_fallocate", allocated);
+        return false;
+    }
+    if (allocated != 0 && ::ftruncate(m_fd, static_cast<off_t>(bytes)) != 0) {
+        m_error = systemError("ftruncate");
+        return false;
+    }
+    if (m_data) {
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+    }
+    void* data = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED) {
+        m_error = systemError("mmap");
+        m_size = 0;
+        return false;
+    }
+    m_data = static_cast<std::uint8_t*>(data);
+    m_size = bytes;
+    return true;
+}
+
+void MappedFile::close(std::uint64_t used) {
+    if (m_data) {
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+    }
+    if (m_fd >= 0) {
+        if (::ftruncate(m_fd, static_cast<off_t>(used)) != 0) {
+            m_error = systemError("ftruncate"); // The file keeps its reserved tail; readers stop at the header's end.
+        }
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_size = 0;
+}
+
+void MappedFile::prefetch(std::uint64_t offset, std::uint64_t bytes) const {
+    if (!m_data || offset >= m_size) {
+        return;
+    }
+    const std::uint64_t begin = offset / pageBytes * pageBytes; // madvise wants a page-aligned start.
+    ::madvise(m_data + begin, std::min(offset + bytes, m_size) - begin, MADV_WILLNEED);
+}
+
+#else
+
+bool MappedFile::create(const std::string&) {
+    m_error = "Raw capture files are not available on this platform";
+    return false;
+}
+
+bool MappedFile::open(const std::string&) {
+    m_error = "Raw capture files are not available on this platform";
+    return false;
+}
+
+bool MappedFile::reserve(std::uint64_t) {
+    return false;
+}
+
+void MappedFile::close(std::uint64_t) {
+}
+
+void MappedFile::prefetch(std::uint64_t, std::uint64_t) const {
+}
+
+#endif
+
+// open: Walks the record headers up to the header's end; a record that points outside the file or
+// backwards ends the walk, so a damaged file still plays its frames up to the damage.
+bool Reader::open(const std::string& path) {
+    m_frames.clear();
+    m_caps.clear();
+    if (!m_file.open(path)) {
+        m_error = m_file.error();
+        return false;
+    }
+    const std::uint64_t size = m_file.size();
+    const auto* header = reinterpret_cast<const FileHeader*>(m_file.data());
+    if (size < pageBytes || header->magic != magic || header->version != version || header->pageBytes != pageBytes) {
+        m_error = "not a raw capture file";
+        m_file.close();
+        return false;
+    }
+    const std::uint64_t end = std::min(header->end.load(std::memory_order_acquire), size);
+    std::uint64_t offset = pageBytes;
+    while (offset + sizeof(RecordHeader) <= end) {
+        const auto* record = reinterpret_cast<const RecordHeader*>(m_file.data() + offset);
+        if (record->payload < offset + sizeof(RecordHeader) || record->payload + record->bytes > end || record->next <= offset) {
+            break;
+        }
+        const auto* payload = m_file.data() + record->payload;
+        if (record->type == RecordType::Caps) {
+            m_caps.emplace_back(reinterpret_cast<const char*>(payload), strnlen(reinterpret_cast<const char*>(payload), record->bytes));
+        } else if (record->type == RecordType::Frame && record->caps < m_caps.size()) {
+            m_frames.push_back(Frame{ record->payload, record->bytes, record->pts, record->duration, record->arrival, record->caps });
+        }
+        offset = record->next;
+    }
+    if (m_frames.empty()) {
+        m_error = "no frames";
+        m_file.close();
+        return false;
+    }
+    return true;
+}
+
+} // namespace RawCapture
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// RawCapture: The layout of a file of raw frames exactly as the appsink received them, written by
+// RawCaptureWriter and played back by the qtgstreplaysrc element, so the same input can be run
+// again on any machine without a camera. Plain C++ with no Qt or GStreamer.
+//
+// The file starts with a FileHeader in a page of its own, followed by records, each a 64-byte
+// RecordHeader and its payload. A Caps record holds the caps string of the frames after it; a
+// Frame record holds one buffer's bytes, starting on a page boundary so a replayed buffer is the
+// mapped file itself and as aligned as any allocator would make it. The record headers are the
+// index: PTS, size and caps of every frame, found without touching a pixel. The writer publishes a
+// record by moving FileHeader::end past it, so a capture cut short ends at its last complete frame.
+namespace RawCapture {
+
+constexpr std::uint32_t magic = 0x57524751; // "QGRW" in memory on little-endian CPUs.
+constexpr std::uint32_t version = 1;
+constexpr std::uint64_t pageBytes = 4096; // Alignment of frame payloads.
+
+struct FileHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t pageBytes;
+    std::atomic<std::uint64_t> end; // Offset past the last complete record.
+    std::atomic<std::uint64_t> frames; // Frame records before end.
+};
+
+enum class RecordType : std::uint32_t {
+    Caps = 1,
+    Frame = 2,
+};
+
+struct alignas(64) RecordHeader {
+    RecordType type;
+    std::uint32_t caps; // Frame: index of the Caps record that describes it.
+    std::uint64_t payload; // Offset of the payload from the start of the file.
+    std::uint64_t bytes; // Payload size; a caps string includes its terminating zero.
+    std::uint64_t next; // Offset of the next record.
+    std::int64_t pts; // Frame: buffer PTS in nanoseconds, -1 if it had none.
+    std::int64_t duration; // Frame: buffer duration in nanoseconds, -1 if it had none.
+    std::int64_t arrival; // Frame: nanoseconds from the first frame to this one reaching the writer.
+    std::uint64_t sequence; // Frame: its number in the capture, from 0.
+};
+
+static_assert(sizeof(RecordHeader) == 64, "Record headers fill one cache line");
+static_assert(sizeof(FileHeader) <= pageBytes, "The file header fits its page");
+
+constexpr std::uint64_t alignUp(std::uint64_t offset, std::uint64_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Frame: One entry of the index a Reader builds.
+struct Frame {
+    std::uint64_t payload; // Offset of the bytes.
+    std::uint64_t bytes;
+    std::int64_t pts; // -1 if unknown.
+    std::int64_t duration; // -1 if unknown.
+    std::int64_t arrival;
+    std::uint32_t caps; // Index into Reader::caps().
+};
+
+// MappedFile: A file mapped into this process, read-only or growing for writing. Move-only; the
+// destructor unmaps and, for a file being written, cuts it to its used size.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Creates or replaces path, empty, for writing.
+    bool create(const std::string& path);
+    // Maps an existing file read-only.
+    bool open(const std::string& path);
+    // Makes the mapping at least bytes long, extending the file. The data moves, so pointers into
+    // it are stale afterwards. Space is allocated on disk up front: a full disk fails here instead
+    // of faulting on a store into the mapping.
+    bool reserve(std::uint64_t bytes);
+    // Unmaps; a file being written is cut to used bytes first.
+    void close(std::uint64_t used = 0);
+
+    bool isOpen() const { return m_data != nullptr; }
+    std::uint8_t* data() const { return m_data; }
+    std::uint64_t size() const { return m_size; }
+    const std::string& error() const { return m_error; } // Why the last call failed.
+
+    // Hints that [offset, offset + bytes) is wanted soon, so the kernel reads it ahead.
+    void prefetch(std::uint64_t offset, std::uint64_t bytes) const;
+
+private:
+    std::uint8_t* m_data = nullptr;
+    std::uint64_t m_size = 0;
+    int m_fd = -1; // Kept open only while writing.
+    std::string m_error;
+};
+
+// Reader: A capture file mapped read-only, with its index. Safe to share between threads once open.
+class Reader {
+public:
+    bool open(const std::string& path);
+
+    const std::vector<Frame>& frames() const { return m_frames; }
+    const std::vector<std::string>& caps() const { return m_caps; }
+    const std::uint8_t* data(const Frame& frame) const { return m_file.data() + frame.payload; }
+    void prefetch(const Frame& frame) const { m_file.prefetch(frame.payload, frame.bytes); }
+    const std::string& error() const { return m_error; }
+
+private:
+    MappedFile m_file;
+    std::vector<Frame> m_frames;
+    std::vector<std::string> m_caps;
+    std::string m_error;
+};
+
+} // namespace RawCapture
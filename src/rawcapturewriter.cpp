@@ -0,0 +1,170 @@
+#include "rawcapturewriter.h"
+#include "frametracer.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+using namespace RawCapture;
+
+namespace {
+
+// The file grows by this much at a time, a few seconds of 1080p, so growing stays off most frames.
+constexpr std::uint64_t growthBytes = 256ull << 20;
+
+} // namespace
+
+RawCaptureWriter::~RawCaptureWriter() {
+    stop();
+}
+
+// start: The header is written first with no records, so a capture that gets no frames is still a
+// valid, empty file.
+bool RawCaptureWriter::start(const QString& path) {
+    stop();
+    std::lock_guard lock(m_mutex);
+    m_error.clear();
+    if (!m_file.create(path.toStdString()) || !m_file.reserve(pageBytes)) {
+        m_error = m_file.error();
+        m_file.close();
+        return false;
+    }
+    auto* header = new (m_file.data()) FileHeader{};
+    header->magic = magic;
+    header->version = version;
+    header->pageBytes = pageBytes;
+    header->end.store(pageBytes, std::memory_order_release);
+    m_end = pageBytes;
+    m_published = pageBytes;
+    m_last = 0;
+    m_capsCount = 0;
+    m_firstArrival = -1;
+    m_sequence = 0;
+    m_frames.store(0, std::memory_order_relaxed);
+    m_bytes.store(0, std::memory_order_relaxed);
+    m_failed.store(0, std::memory_order_relaxed);
+    m_capturing.store(true, std::memory_order_release);
+    return true;
+}
+
+void RawCaptureWriter::stop() {
+    std::lock_guard lock(m_mutex);
+    if (!m_capturing.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    m_file.close(m_published);
+    gst_caps_replace(&m_caps, nullptr);
+}
+
+// appendRecord: A frame's header goes in the last 64 bytes before the page its payload starts on,
+// so alignment costs at most a page per frame. The previous record is pointed at the new one; a
+// reader sees neither change until publish moves the end.
+RecordHeader* RawCaptureWriter::appendRecord(RecordType type, std::uint64_t bytes, bool aligned) {
+    const std::uint64_t payload = aligned ? alignUp(m_end + sizeof(RecordHeader), pageBytes) : m_end + sizeof(RecordHeader);
+    const std::uint64_t offset = payload - sizeof(RecordHeader);
+    const std::uint64_t next = alignUp(payload + bytes, sizeof(RecordHeader));
+    if (next > m_file.size() && !m_file.reserve(std::max(next, m_file.size() + growthBytes))) {
+        m_error = m_file.error();
+        return nullptr;
+    }
+    if (m_last != 0) {
+        reinterpret_cast<RecordHeader*>(m_file.data() + m_last)->next = offset;
+    }
+    auto* record = new (m_file.data() + offset) RecordHeader{};
+    record->type = type;
+    record->payload = payload;
+    record->bytes = bytes;
+    record->next = next;
+    record->pts = -1;
+    record->duration = -1;
+    m_last = offset;
+    m_end = next;
+    return record;
+}
+
+void RawCaptureWriter::publish(bool frame) {
+    auto* header = reinterpret_cast<FileHeader*>(m_file.data());
+    header->end.store(m_end, std::memory_order_release);
+    if (frame) {
+        header->frames.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_published = m_end;
+}
+
+// fail: Keeps what was captured so far; the file ends at the last frame that was published.
+void RawCaptureWriter::fail() {
+    m_failed.fetch_add(1, std::memory_order_relaxed);
+    m_capturing.store(false, std::memory_order_release);
+    m_file.close(m_published);
+    gst_caps_replace(&m_caps, nullptr);
+}
+
+// append: The buffer is copied as mapped, planes, padding and all, so the replayed buffer matches
+// its caps exactly as the original did.
+void RawCaptureWriter::append(GstSample* sample) {
+    if (!isCapturing()) {
+        return;
+    }
+    const qint64 arrival = FrameTracer::now();
+    GstBuffer* buffer = gst_sample_get_buffer(sample);
+    GstCaps* caps = gst_sample_get_caps(sample);
+    GstMapInfo map{};
+    if (!buffer || !caps || !gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    std::lock_guard lock(m_mutex);
+    if (!m_capturing.load(std::memory_order_relaxed)) {
+        gst_buffer_unmap(buffer, &map);
+        return;
+    }
+    if (!m_caps || !gst_caps_is_equal(caps, m_caps)) {
+        gchar* text = gst_caps_to_string(caps);
+        const std::uint64_t bytes = std::strlen(text) + 1;
+        RecordHeader* record = appendRecord(RecordType::Caps, bytes, false);
+        if (record) {
+            std::memcpy(m_file.data() + record->payload, text, bytes);
+            gst_caps_replace(&m_caps, caps);
+            ++m_capsCount;
+        }
+        g_free(text);
+        if (!record) {
+            gst_buffer_unmap(buffer, &map);
+            fail();
+            return;
+        }
+    }
+
+    RecordHeader* record = appendRecord(RecordType::Frame, map.size, true);
+    if (!record) {
+        gst_buffer_unmap(buffer, &map);
+        fail();
+        return;
+    }
+    if (m_firstArrival < 0) {
+        m_firstArrival = arrival;
+    }
+    record->caps = m_capsCount - 1;
+    record->pts = GST_BUFFER_PTS_IS_VALID(buffer) ? static_cast<std::int64_t>(GST_BUFFER_PTS(buffer)) : -1;
+    record->duration = GST_BUFFER_DURATION_IS_VALID(buffer) ? static_cast<std::int64_t>(GST_BUFFER_DURATION(buffer)) : -1;
+    record->arrival = arrival - m_firstArrival;
+    record->sequence = m_sequence++;
+    std::memcpy(m_file.data() + record->payload, map.data, map.size);
+    gst_buffer_unmap(buffer, &map);
+    publish(true);
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+    m_bytes.fetch_add(map.size, std::memory_order_relaxed);
+}
+
+RawCaptureWriter::Counters RawCaptureWriter::counters() const {
+    Counters counters;
+    counters.frames = m_frames.load(std::memory_order_relaxed);
+    counters.bytes = m_bytes.load(std::memory_order_relaxed);
+    counters.failed = m_failed.load(std::memory_order_relaxed);
+    return counters;
+}
+
+QString RawCaptureWriter::error() const {
+    std::lock_guard lock(m_mutex);
+    return QString::fromStdString(m_error);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "rawcapture.h"
+#include <gst/gst.h>
+#include <QString>
+#include <atomic>
+#include <mutex>
+
+// RawCaptureWriter: Appends the samples an appsink receives to a RawCapture file, bytes and caps
+// untouched, for qtgstreplaysrc to play back. A sample costs one copy into the mapped file, made
+// on the calling thread; the kernel writes the pages back to disk in the background. The caps
+// string is only written when the caps change.
+class RawCaptureWriter {
+public:
+    // Counters: Samples offered to the writer since start.
+    struct Counters {
+        quint64 frames = 0;
+        quint64 bytes = 0; // Payload bytes of the frames.
+        quint64 failed = 0; // Samples that could not be mapped or written; the first write error stops the capture.
+    };
+
+    RawCaptureWriter() = default;
+    ~RawCaptureWriter();
+    RawCaptureWriter(const RawCaptureWriter&) = delete;
+    RawCaptureWriter& operator=(const RawCaptureWriter&) = delete;
+
+    // Creates path, replacing any file there. False, with error() set, if it cannot be written.
+    bool start(const QString& path);
+    // Publishes the last frame and cuts the file to the frames it holds.
+    void stop();
+    bool isCapturing() const { return m_capturing.load(std::memory_order_acquire); }
+
+    // Thread-safe: called on the appsink's streaming thread for every sample.
+    void append(GstSample* sample);
+
+    Counters counters() const;
+    QString error() const; // Why the capture could not start or stopped early.
+
+private:
+    // Appends a record of bytes and returns it, or nullptr if the file cannot grow. The payload
+    // starts on a page boundary if aligned. Called with m_mutex held.
+    RawCapture::RecordHeader* appendRecord(RawCapture::RecordType type, std::uint64_t bytes, bool aligned);
+    void publish(bool frame); // Makes the records up to m_end visible. Called with m_mutex held.
+    void fail(); // Called with m_mutex held.
+
+    mutable std::mutex m_mutex;
+    RawCapture::MappedFile m_file;
+    std::uint64_t m_end = 0; // Where the next record goes.
+    std::uint64_t m_published = 0; // End of the records a reader may see.
+    std::uint64_t m_last = 0; // Offset of the last record, 0 before the first.
+    std::uint32_t m_capsCount = 0;
+    GstCaps* m_caps = nullptr; // Caps of the last frame, referenced.
+    std::int64_t m_firstArrival = -1;
+    std::uint64_t m_sequence = 0;
+    std::string m_error;
+
+    std::atomic<bool> m_capturing{ false };
+    std::atomic<quint64> m_frames{ 0 };
+    std::atomic<quint64> m_bytes{ 0 };
+    std::atomic<quint64> m_failed{ 0 };
+};
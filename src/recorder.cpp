@@ -0,0 +1,340 @@
+#include "recorder.h"
+#include <gst/video/video.h>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QThread>
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+// How long stop() waits for the muxer to finish the last segment.
+constexpr GstClockTime finalizeTimeout = 5 * GST_SECOND;
+
+// releaseImage: Destroy notify of a wrapped buffer; drops the recorder's reference to the pixels.
+void releaseImage(gpointer image) {
+    delete static_cast<QImage*>(image);
+}
+
+} // namespace
+
+// Constructor: GStreamer is initialized by the first start, not here, so a stream's recorder adds
+// nothing to the window's construction.
+Recorder::Recorder(QObject* parent) : QObject(parent) {
+}
+
+// Destructor: Finalizes a recording still in progress.
+Recorder::~Recorder() {
+    stop();
+}
+
+// encoderDescription: The encoder part of the pipeline. The encoder gets half the cores so the
+// effects worker keeps the rest.
+QString Recorder::encoderDescription(const RecorderSettings& settings) {
+    const int threads = std::max(QThread::idealThreadCount() / 2, 1);
+    switch (settings.encoder) {
+    case RecorderSettings::OpenH264:
+        return QStringLiteral("openh264enc bitrate=%1").arg(settings.bitrateKbps * 1000);
+    case RecorderSettings::Lossless:
+        return QStringLiteral("video/x-raw, format=(string)Y444 ! x264enc pass=quant quantizer=0 speed-preset=ultrafast tune=zerolatency threads=%1")
+            .arg(threads);
+    default:
+        return QStringLiteral("x264enc tune=zerolatency speed-preset=ultrafast bitrate=%1 threads=%2")
+            .arg(settings.bitrateKbps).arg(threads);
+    }
+}
+
+// muxerDescription: splitmuxsink for segmented recordings; a muxer and filesink for a single file.
+QString Recorder::muxerDescription(const RecorderSettings& settings) {
+    if (settings.file.isEmpty()) {
+        return QStringLiteral("splitmuxsink name=mux");
+    }
+    const QString suffix = QFileInfo(settings.file).suffix().toLower();
+    const bool mp4 = suffix == QLatin1String("mp4") || suffix == QLatin1String("mov");
+    return QStringLiteral("%1 ! filesink name=mux").arg(mp4 ? QStringLiteral("mp4mux") : QStringLiteral("matroskamux"));
+}
+
+// toVideoFormat: The GStreamer layout of a processed image; the inverse of VideoFrame's mapping.
+GstVideoFormat Recorder::toVideoFormat(QImage::Format format) {
+    switch (format) {
+    case QImage::Format_RGB888:
+        return GST_VIDEO_FORMAT_RGB;
+    case QImage::Format_BGR888:
+        return GST_VIDEO_FORMAT_BGR;
+    case QImage::Format_RGBX8888:
+        return GST_VIDEO_FORMAT_RGBx;
+    case QImage::Format_RGBA8888:
+        return GST_VIDEO_FORMAT_RGBA;
+    case QImage::Format_Grayscale8:
+        return GST_VIDEO_FORMAT_GRAY8;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    case QImage::Format_RGB32:
+        return GST_VIDEO_FORMAT_BGRx;
+    case QImage::Format_ARGB32:
+        return GST_VIDEO_FORMAT_BGRA;
+#else
+    case QImage::Format_RGB32:
+        return GST_VIDEO_FORMAT_xRGB;
+    case QImage::Format_ARGB32:
+        return GST_VIDEO_FORMAT_ARGB;
+#endif
+    default:
+        return GST_VIDEO_FORMAT_UNKNOWN;
+    }
+}
+
+// start: appsrc -> videoconvert -> encoder -> h264parse -> splitmuxsink (or muxer -> filesink),
+// running on its own streaming threads.
+bool Recorder::start(const RecorderSettings& settings) {
+    stop();
+    gst_init(nullptr, nullptr); // Returns at once when the camera pipeline already initialized GStreamer.
+    const QString directory = settings.file.isEmpty() ? settings.directory : QFileInfo(settings.file).absolutePath();
+    if (!QDir().mkpath(directory)) {
+        qDebug() << "Cannot create recording directory" << directory;
+        return false;
+    }
+
+    // The appsrc itself never blocks; with blockWhenFull pushFrame waits for room, so an error can release it.
+    const QByteArray pipelineStr = QStringLiteral("appsrc name=src is-live=%1 format=time do-timestamp=false block=false"
+        " ! videoconvert ! %2 ! h264parse ! %3")
+        .arg(QLatin1String(settings.blockWhenFull ? "false" : "true"), encoderDescription(settings), muxerDescription(settings)).toUtf8();
+    GError* error = nullptr;
+    std::unique_ptr<GstElement, decltype(&gst_object_unref)> pipeline{ gst_parse_launch(pipelineStr.constData(), &error), gst_object_unref };
+    if (error) {
+        qDebug() << "Failed to create recording pipeline: " << error->message;
+        g_error_free(error);
+        return false;
+    }
+
+    std::unique_ptr<GstElement, decltype(&gst_object_unref)> source{ gst_bin_get_by_name(GST_BIN(pipeline.get()), "src"), gst_object_unref };
+    GstElement* mux = gst_bin_get_by_name(GST_BIN(pipeline.get()), "mux");
+    if (!source || !mux) {
+        qDebug() << "Failed to find the recording source or muxer";
+        if (mux) {
+            gst_object_unref(mux);
+        }
+        return false;
+    }
+
+    // Set here rather than in the description so the path needs no quoting.
+    if (settings.file.isEmpty()) {
+        const QByteArray location = QDir(settings.directory).filePath(QStringLiteral("record-%05d.mp4")).toUtf8();
+        g_object_set(mux,
+            "location", location.constData(),
+            "max-size-time", static_cast<guint64>(std::max(settings.segmentSeconds, 0)) * GST_SECOND,
+            "max-size-bytes", static_cast<guint64>(std::max<qint64>(settings.segmentBytes, 0)),
+            nullptr);
+        if (g_object_class_find_property(G_OBJECT_GET_CLASS(mux), "send-keyframe-requests")) {
+            g_object_set(mux, "send-keyframe-requests", TRUE, nullptr); // Cut on time without waiting for a natural keyframe.
+        }
+    } else {
+        const QByteArray location = QFileInfo(settings.file).absoluteFilePath().toUtf8();
+        g_object_set(mux, "location", location.constData(), nullptr);
+    }
+    gst_object_unref(mux);
+
+    GstAppSrcCallbacks callbacks{};
+    callbacks.need_data = &Recorder::needDataCallback;
+    callbacks.enough_data = &Recorder::enoughDataCallback;
+    gst_app_src_set_callbacks(GST_APP_SRC(source.get()), &callbacks, this, nullptr);
+
+    GstBus* bus = gst_element_get_bus(pipeline.get());
+    gst_bus_set_sync_handler(bus, &Recorder::busCallback, this, nullptr);
+    gst_object_unref(bus);
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_settings = settings;
+        m_singleFile.store(!settings.file.isEmpty(), std::memory_order_relaxed);
+        m_size = QSize();
+        m_format = QImage::Format_Invalid;
+        m_firstRunningTime = -1;
+        m_firstSteadyTime = -1;
+        m_lastPts = -1;
+        m_full.store(false, std::memory_order_relaxed);
+        m_failed.store(false, std::memory_order_relaxed);
+        m_recorded.store(0, std::memory_order_relaxed);
+        m_dropped.store(0, std::memory_order_relaxed);
+        m_segments.store(0, std::memory_order_relaxed);
+        m_pipeline = std::move(pipeline);
+        m_source = std::move(source);
+    }
+
+    if (gst_element_set_state(m_pipeline.get(), GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+        qDebug() << "Failed to start the recording pipeline";
+        stop();
+        return false;
+    }
+    m_recording.store(true, std::memory_order_release);
+    return true;
+}
+
+// stop: Detaches the pipeline under the lock so pushFrame stops feeding it, then lets it drain.
+void Recorder::stop() {
+    std::unique_ptr<GstElement, decltype(&gst_object_unref)> pipeline{ nullptr, gst_object_unref };
+    std::unique_ptr<GstElement, decltype(&gst_object_unref)> source{ nullptr, gst_object_unref };
+    {
+        std::lock_guard lock(m_mutex);
+        m_recording.store(false, std::memory_order_release);
+        pipeline = std::move(m_pipeline);
+        source = std::move(m_source);
+    }
+    m_space.notify_all(); // A waiting pushFrame sees the source gone.
+    if (!pipeline) {
+        return;
+    }
+
+    // End-of-stream makes splitmuxsink close the last file properly; wait for it to reach the sink.
+    gst_app_src_end_of_stream(GST_APP_SRC(source.get()));
+    GstBus* bus = gst_element_get_bus(pipeline.get());
+    GstMessage* message = gst_bus_timed_pop_filtered(bus, finalizeTimeout, GstMessageType(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+    if (!message) {
+        qDebug() << "Recording did not finish in time; the last segment may be incomplete";
+    } else {
+        gst_message_unref(message);
+    }
+    gst_object_unref(bus);
+    gst_element_set_state(pipeline.get(), GST_STATE_NULL);
+}
+
+// pushFrame: Wraps the processed image in a GstBuffer without copying. The buffer holds a shallow
+// QImage copy, so pooled pixels return to FrameBufferPool only once the encoder has read them.
+void Recorder::pushFrame(const VideoFrame& frame) {
+    if (!m_recording.load(std::memory_order_acquire)) {
+        return;
+    }
+    const QImage& image = frame.image();
+    if (image.isNull()) {
+        return;
+    }
+
+    std::unique_lock lock(m_mutex);
+    if (m_settings.blockWhenFull) {
+        // Polls as well as waits: the appsrc callbacks cannot take m_mutex, so a wakeup may be missed.
+        while (m_source && m_full.load(std::memory_order_relaxed) && !m_failed.load(std::memory_order_relaxed)) {
+            m_space.wait_for(lock, std::chrono::milliseconds(20));
+        }
+    }
+    if (!m_source) {
+        return;
+    }
+    if (m_full.load(std::memory_order_relaxed) || m_failed.load(std::memory_order_relaxed) || !updateCaps(image)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed); // The encoder is behind; the preview is not held up.
+        return;
+    }
+
+    // Timestamps follow capture, so dropped frames leave gaps instead of speeding up the recording.
+    const qint64 runningTime = frame.timestamps().runningTime;
+    qint64 pts = 0;
+    if (runningTime >= 0) {
+        if (m_firstRunningTime < 0) {
+            m_firstRunningTime = runningTime;
+        }
+        pts = runningTime - m_firstRunningTime;
+    } else {
+        const qint64 now = FrameTracer::now();
+        if (m_firstSteadyTime < 0) {
+            m_firstSteadyTime = now;
+        }
+        pts = now - m_firstSteadyTime;
+    }
+    if (pts <= m_lastPts) {
+        return; // A paused frame re-processed for new settings is not a new frame.
+    }
+    m_lastPts = pts;
+
+    auto* held = new QImage(image); // Shares the pixels; constBits() below does not detach.
+    const gsize size = static_cast<gsize>(held->sizeInBytes());
+    GstBuffer* buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY, const_cast<uchar*>(held->constBits()),
+        size, 0, size, held, &releaseImage);
+    // Pooled images have cache-line aligned rows, so the stride travels with the buffer.
+    gsize offsets[GST_VIDEO_MAX_PLANES] = { 0 };
+    gint strides[GST_VIDEO_MAX_PLANES] = { static_cast<gint>(held->bytesPerLine()) };
+    gst_buffer_add_video_meta_full(buffer, GST_VIDEO_FRAME_FLAG_NONE, toVideoFormat(held->format()),
+        static_cast<guint>(held->width()), static_cast<guint>(held->height()), 1, offsets, strides);
+    GST_BUFFER_PTS(buffer) = static_cast<GstClockTime>(pts);
+
+    gst_app_src_push_buffer(GST_APP_SRC(m_source.get()), buffer); // Takes ownership; never blocks, the appsrc has block=false.
+    m_recorded.fetch_add(1, std::memory_order_relaxed);
+}
+
+// updateCaps: Describes frames of a new size or format to the encoder and sizes the appsrc queue
+// to queueFrames of them. Returns false for formats the recorder cannot describe.
+bool Recorder::updateCaps(const QImage& image) {
+    if (image.size() == m_size && image.format() == m_format) {
+        return true;
+    }
+    const GstVideoFormat format = toVideoFormat(image.format());
+    if (format == GST_VIDEO_FORMAT_UNKNOWN) {
+        return false;
+    }
+
+    GstVideoInfo info;
+    gst_video_info_set_format(&info, format, static_cast<guint>(image.width()), static_cast<guint>(image.height()));
+    GST_VIDEO_INFO_FPS_N(&info) = 0; // Variable frame rate; the timestamps carry the timing.
+    GST_VIDEO_INFO_FPS_D(&info) = 1;
+    GstCaps* caps = gst_video_info_to_caps(&info);
+    gst_app_src_set_caps(GST_APP_SRC(m_source.get()), caps);
+    gst_caps_unref(caps);
+    gst_app_src_set_max_bytes(GST_APP_SRC(m_source.get()),
+        static_cast<guint64>(image.sizeInBytes()) * static_cast<guint64>(std::max(m_settings.queueFrames, 1)));
+
+    m_size = image.size();
+    m_format = image.format();
+    return true;
+}
+
+// counters: Returns the recording counters.
+Recorder::Counters Recorder::counters() const {
+    Counters counters;
+    counters.recorded = m_recorded.load(std::memory_order_relaxed);
+    counters.dropped = m_dropped.load(std::memory_order_relaxed);
+    counters.segments = m_segments.load(std::memory_order_relaxed);
+    return counters;
+}
+
+// busCallback: Runs on the thread that posts the message. Counts finished segments and reports
+// errors; end-of-stream and errors stay on the bus for stop() to wait on.
+GstBusSyncReply Recorder::busCallback(GstBus*, GstMessage* message, gpointer data) {
+    auto* recorder = static_cast<Recorder*>(data);
+    switch (GST_MESSAGE_TYPE(message)) {
+    case GST_MESSAGE_ELEMENT:
+        if (gst_message_has_name(message, "splitmuxsink-fragment-closed")) {
+            recorder->m_segments.fetch_add(1, std::memory_order_relaxed);
+        }
+        return GST_BUS_DROP;
+    case GST_MESSAGE_ERROR: {
+        GError* error = nullptr;
+        gst_message_parse_error(message, &error, nullptr);
+        const QString text = QString::fromUtf8(error ? error->message : "unknown error");
+        if (error) {
+            g_error_free(error);
+        }
+        qDebug() << "Recording error:" << text;
+        recorder->m_failed.store(true, std::memory_order_relaxed); // Drop everything until stopped.
+        recorder->m_space.notify_all();
+        emit recorder->error(text);
+        return GST_BUS_PASS;
+    }
+    case GST_MESSAGE_EOS:
+        if (recorder->m_singleFile.load(std::memory_order_relaxed)) {
+            recorder->m_segments.fetch_add(1, std::memory_order_relaxed); // The single file is complete.
+        }
+        return GST_BUS_PASS;
+    default:
+        return GST_BUS_DROP;
+    }
+}
+
+// enoughDataCallback: The appsrc queue reached max-bytes; frames are dropped until it drains.
+void Recorder::enoughDataCallback(GstAppSrc*, gpointer data) {
+    static_cast<Recorder*>(data)->m_full.store(true, std::memory_order_relaxed);
+}
+
+// needDataCallback: The queue drained below the limit; a blocked pushFrame may continue.
+void Recorder::needDataCallback(GstAppSrc*, guint, gpointer data) {
+    auto* recorder = static_cast<Recorder*>(data);
+    recorder->m_full.store(false, std::memory_order_relaxed);
+    recorder->m_space.notify_all();
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <QImage>
+#include <QObject>
+#include <QSize>
+#include <QString>
+#include "videoframe.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+// RecorderSettings: Where and how the processed stream is archived.
+struct RecorderSettings {
+    enum Encoder {
+        X264, // x264enc, ultrafast and zero-latency.
+        OpenH264, // openh264enc, for builds without x264.
+        Lossless, // x264enc at quantizer 0 on 4:4:4 frames.
+    };
+
+    QString directory; // Segments are written here as record-00000.mp4, record-00001.mp4, ...
+    QString file; // If set, one unsegmented file instead; .mp4 and .mov get mp4mux, anything else Matroska.
+    Encoder encoder = X264;
+    int bitrateKbps = 8000; // Ignored by Lossless.
+    int segmentSeconds = 60; // Starts a new file after this much video; 0 for no time limit.
+    qint64 segmentBytes = 0; // Starts a new file after this many bytes; 0 for no size limit.
+    int queueFrames = 8; // Frames waiting for the encoder before new ones are dropped.
+    bool blockWhenFull = false; // Offline use: pushFrame waits for the encoder instead of dropping.
+};
+
+// Recorder: Encodes processed frames to segmented files on a pipeline of its own.
+// pushFrame hands the frame's pixels to an appsrc by reference and never waits: when the
+// encoder falls behind and the appsrc queue is full, the frame is dropped and counted, so
+// recording cannot slow down the preview or block the capture pipeline. Offline reprocessing sets
+// blockWhenFull instead, so every frame is encoded and the encoder paces the pipeline.
+class Recorder : public QObject {
+    Q_OBJECT
+
+public:
+    // Counters: Frames offered to the recorder during the current or last recording.
+    struct Counters {
+        quint64 recorded = 0; // Frames handed to the encoder.
+        quint64 dropped = 0; // Frames dropped because the encoder was behind.
+        quint64 segments = 0; // Files finished so far.
+    };
+
+    explicit Recorder(QObject* parent = nullptr);
+    ~Recorder() override;
+
+    // Builds and starts the encoding pipeline. Returns false if it could not be created.
+    bool start(const RecorderSettings& settings);
+    // Sends end-of-stream so the last segment is finalized, then tears the pipeline down.
+    void stop();
+    bool isRecording() const { return m_recording.load(std::memory_order_acquire); }
+
+    // Thread-safe and non-blocking: called on the effects worker for every processed frame.
+    void pushFrame(const VideoFrame& frame);
+
+    Counters counters() const;
+
+signals:
+    void error(const QString& message); // Emitted from a GStreamer thread.
+
+private:
+    static QString encoderDescription(const RecorderSettings& settings);
+    static QString muxerDescription(const RecorderSettings& settings);
+    static GstVideoFormat toVideoFormat(QImage::Format format);
+    static GstBusSyncReply busCallback(GstBus* bus, GstMessage* message, gpointer user_data);
+    static void enoughDataCallback(GstAppSrc* appsrc, gpointer user_data);
+    static void needDataCallback(GstAppSrc* appsrc, guint length, gpointer user_data);
+
+    bool updateCaps(const QImage& image); // Called with m_mutex held.
+
+    std::unique_ptr<GstElement, decltype(&gst_object_unref)> m_pipeline{ nullptr, gst_object_unref };
+    std::unique_ptr<GstElement, decltype(&gst_object_unref)> m_source{ nullptr, gst_object_unref }; // The appsrc.
+    std::mutex m_mutex; // Guards the pipeline against start and stop while a frame is pushed.
+    std::condition_variable m_space; // blockWhenFull: signalled when the appsrc wants data or the recording ends.
+    RecorderSettings m_settings; // Guarded by m_mutex.
+    QSize m_size; // Size and format the caps were set for; guarded by m_mutex.
+    QImage::Format m_format = QImage::Format_Invalid;
+    qint64 m_firstRunningTime = -1; // Running time of the first recorded frame; guarded by m_mutex.
+    qint64 m_firstSteadyTime = -1; // Fallback origin for frames without a running time.
+    qint64 m_lastPts = -1; // Keeps timestamps increasing; guarded by m_mutex.
+
+    std::atomic<bool> m_recording{ false };
+    std::atomic<bool> m_full{ false }; // Set by the appsrc when its queue reaches the limit.
+    std::atomic<bool> m_failed{ false }; // The pipeline reported an error.
+    std::atomic<bool> m_singleFile{ false }; // m_settings.file is set; for the bus thread, which cannot take m_mutex.
+    std::atomic<quint64> m_recorded{ 0 };
+    std::atomic<quint64> m_dropped{ 0 };
+    std::atomic<quint64> m_segments{ 0 };
+};
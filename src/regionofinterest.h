@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+
+// RegionOfInterest: The part of the camera's picture that is processed and shown, the digital zoom,
+// in fractions of the whole frame so it holds across changes of resolution. The default is the
+// whole frame. The pipeline crops to it when it can; the effects are restricted to it otherwise.
+struct RegionOfInterest {
+    QRectF area{ 0.0, 0.0, 1.0, 1.0 };
+
+    bool isFull() const { return area.contains(QRectF(0.0, 0.0, 1.0, 1.0)); }
+
+    // inner, in fractions of this region, in fractions of the whole frame: a selection made on a
+    // view that is already zoomed.
+    RegionOfInterest zoomedTo(const QRectF& inner) const {
+        RegionOfInterest zoomed;
+        zoomed.area = QRectF(area.x() + inner.x() * area.width(), area.y() + inner.y() * area.height(),
+            inner.width() * area.width(), inner.height() * area.height()) & area;
+        return zoomed;
+    }
+
+    // In pixels of a frame of size, grown outwards to a grid of alignment pixels and clipped to the
+    // frame; at least one pixel across and down. Empty for an empty size, e.g. before the first caps.
+    QRect toPixels(const QSize& size, int alignment = 1) const {
+        if (size.isEmpty()) {
+            return QRect();
+        }
+        const QRectF scaled(area.x() * size.width(), area.y() * size.height(), area.width() * size.width(), area.height() * size.height());
+        const int left = std::clamp(static_cast<int>(std::floor(scaled.left())) / alignment * alignment, 0, std::max(size.width() - 1, 0));
+        const int top = std::clamp(static_cast<int>(std::floor(scaled.top())) / alignment * alignment, 0, std::max(size.height() - 1, 0));
+        const int right = std::clamp((static_cast<int>(std::ceil(scaled.right())) + alignment - 1) / alignment * alignment, left + 1, size.width());
+        const int bottom = std::clamp((static_cast<int>(std::ceil(scaled.bottom())) + alignment - 1) / alignment * alignment, top + 1, size.height());
+        return QRect(left, top, right - left, bottom - top);
+    }
+
+    // "x,y,w,h" in fractions of the frame, e.g. "0.25,0.25,0.5,0.5"; anything else is the whole frame.
+    static RegionOfInterest fromString(const QString& text) {
+        RegionOfInterest region;
+        const QStringList values = text.split(',');
+        if (values.size() == 4) {
+            const QRectF area = QRectF(values[0].toDouble(), values[1].toDouble(), values[2].toDouble(), values[3].toDouble()) & region.area;
+            if (!area.isEmpty()) {
+                region.area = area;
+            }
+        }
+        return region;
+    }
+
+    QString toString() const {
+        return isFull() ? QStringLiteral("full")
+                        : QStringLiteral("%1,%2,%3,%4").arg(area.x()).arg(area.y()).arg(area.width()).arg(area.height());
+    }
+
+    bool operator==(const RegionOfInterest&) const = default;
+};
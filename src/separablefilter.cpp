@@ -0,0 +1,265 @@
+#include "separablefilter.h"
+#include <cmath>
+#include <cstring>
+#include <optional>
+
+namespace {
+
+namespace Convolution = ImageKernels::Convolution;
+
+constexpr int one = 1 << Convolution::weightBits;
+
+// Rows per band target; more bands than threads keeps the pool balanced.
+constexpr int bandsPerThread = 4;
+
+// Scratch rows start on a cache line.
+int alignedStride(int bytes) {
+    return (bytes + 63) & ~63;
+}
+
+template <typename T>
+void ensureSize(std::vector<T>& buffer, size_t size) {
+    if (buffer.size() < size) {
+        buffer.resize(size); // Never shrinks, so steady-state frames do not allocate.
+    }
+}
+
+} // namespace
+
+// gaussian: Weights are rounded one by one; what rounding leaves over goes to the centre tap, so a
+// flat area stays exactly as bright as it was.
+SeparableKernel SeparableKernel::gaussian(double sigma) {
+    SeparableKernel kernel;
+    if (sigma <= 0) {
+        kernel.weights[0] = one;
+        return kernel;
+    }
+    const int radius = std::min(static_cast<int>(std::ceil(3 * sigma)), (Convolution::maxTaps - 1) / 2);
+    kernel.taps = 2 * radius + 1;
+    double total = 0;
+    for (int k = -radius; k <= radius; ++k) {
+        total += std::exp(-k * k / (2 * sigma * sigma));
+    }
+    int sum = 0;
+    for (int k = -radius; k <= radius; ++k) {
+        const int weight = static_cast<int>(std::lround(one * std::exp(-k * k / (2 * sigma * sigma)) / total));
+        kernel.weights[k + radius] = static_cast<qint16>(weight);
+        sum += weight;
+    }
+    kernel.weights[radius] = static_cast<qint16>(kernel.weights[radius] + one - sum);
+    return kernel;
+}
+
+SeparableKernel SeparableKernel::binomial() {
+    SeparableKernel kernel;
+    kernel.taps = 3;
+    kernel.weights[0] = one / 4;
+    kernel.weights[1] = one / 2;
+    kernel.weights[2] = one / 4;
+    return kernel;
+}
+
+SeparableKernel SeparableKernel::derivative() {
+    SeparableKernel kernel;
+    kernel.taps = 3;
+    kernel.weights[0] = -one / 2;
+    kernel.weights[2] = one / 2;
+    return kernel;
+}
+
+// Constructor: Scratch space is allocated on first use.
+SeparableFilter::SeparableFilter(ThreadPool& pool) : m_pool(pool) {
+}
+
+SeparableKernel SeparableFilter::blurKernel(int blurRadius) {
+    return SeparableKernel::gaussian(blurRadius > 0 ? std::sqrt(blurRadius * (blurRadius + 1.0) / 3.0) : 0.0);
+}
+
+// reach: The radius of the widest kernel; the two passes of edges never stack.
+int SeparableFilter::reach(Detail detail, int radius) {
+    switch (detail) {
+    case Detail::None: return 0;
+    case Detail::Sharpen:
+    case Detail::Edges: return 1;
+    case Detail::UnsharpMask: return blurKernel(std::max(radius, 1)).radius();
+    }
+    return 0;
+}
+
+void SeparableFilter::blur(const uchar* src, int srcStride, uchar* dst, int dstStride, int width, int height, int blurRadius,
+    const ImageProcessing::PointOps* pointOps, PixelFormat::Layout layout, FrameStatsCollector* stats) {
+    Job job;
+    job.rowKernels[0] = blurKernel(blurRadius);
+    job.columnKernels[0] = job.rowKernels[0];
+    m_layout = layout;
+    run(job, src, srcStride, dst, dstStride, width, height, PixelFormat::bytesPerPixel(layout), pointOps, stats);
+}
+
+void SeparableFilter::blurPlane(const uchar* src, int srcStride, uchar* dst, int dstStride, int width, int height,
+    int channels, int radiusX, int radiusY) {
+    Job job;
+    job.rowKernels[0] = blurKernel(radiusX);
+    job.columnKernels[0] = blurKernel(radiusY);
+    run(job, src, srcStride, dst, dstStride, width, height, channels, nullptr, nullptr);
+}
+
+void SeparableFilter::apply(Detail detail, int amount, int radius, const uchar* src, int srcStride, uchar* dst, int dstStride,
+    int width, int height, const ImageProcessing::PointOps* pointOps, PixelFormat::Layout layout, FrameStatsCollector* stats) {
+    if (detail == Detail::None) {
+        return;
+    }
+    int filler = -1;
+    switch (layout) {
+    case PixelFormat::Layout::Rgbx8888: filler = PixelFormat::Rgbx8888::filler; break;
+    case PixelFormat::Layout::Xrgb32: filler = PixelFormat::Xrgb32::filler; break;
+    default: break;
+    }
+    m_layout = layout;
+    run(detailJob(detail, amount, radius, filler), src, srcStride, dst, dstStride, width, height,
+        PixelFormat::bytesPerPixel(layout), pointOps, stats);
+}
+
+void SeparableFilter::applyPlane(Detail detail, int amount, int radius, const uchar* src, int srcStride, uchar* dst, int dstStride,
+    int width, int height, int channels) {
+    if (detail == Detail::None) {
+        return;
+    }
+    run(detailJob(detail, amount, radius, -1), src, srcStride, dst, dstStride, width, height, channels, nullptr, nullptr);
+}
+
+// detailJob: Sharpen is an unsharp mask with the smallest blur there is. Edges are Sobel: the
+// difference across one direction, smoothed along the other.
+SeparableFilter::Job SeparableFilter::detailJob(Detail detail, int amount, int radius, int filler) {
+    Job job;
+    if (detail == Detail::Edges) {
+        job.finish = Finish::Edges;
+        job.frames = 2;
+        job.rowKernels = { SeparableKernel::derivative(), SeparableKernel::binomial() };
+        job.columnKernels = { SeparableKernel::binomial(), SeparableKernel::derivative() };
+        job.filler = filler;
+        return job;
+    }
+    job.finish = Finish::Unsharp;
+    job.rowKernels[0] = detail == Detail::Sharpen ? SeparableKernel::binomial() : blurKernel(std::max(radius, 1));
+    job.columnKernels[0] = job.rowKernels[0];
+    // Percent to 1 / 2^amountBits; ten times the detail is as far as a 16-bit multiplier goes with room.
+    job.amount = (std::clamp(amount, 0, 1000) * (1 << Convolution::amountBits) + 50) / 100;
+    return job;
+}
+
+void SeparableFilter::parallelFor(int count, const std::function<void(int)>& task) {
+    if (!m_singleThreaded) {
+        m_pool.parallelFor(count, task);
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        task(i);
+    }
+}
+
+// run: Row pass by bands into scratch, then column pass by bands into dst. The row pass finishes
+// before the column pass writes, and the column pass reads only the source rows it writes, so src
+// and dst may alias. The point operations are applied as rows are padded, and again to the
+// originals unsharp masking adds the detail to, which is cheaper than keeping a copy of the frame.
+void SeparableFilter::run(const Job& job, const uchar* src, int srcStride, uchar* dst, int dstStride, int width, int height,
+    int channels, const ImageProcessing::PointOps* pointOps, FrameStatsCollector* stats) {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    const bool hasPointOps = pointOps && !pointOps->isIdentity();
+    const int rowBytes = width * channels;
+    const int scratchStride = alignedStride(rowBytes * 2) / 2; // In elements.
+    int pad = 0; // Pixels on either side of a padded row.
+    for (int frame = 0; frame < job.frames; ++frame) {
+        pad = std::max(pad, job.rowKernels[frame].radius());
+    }
+    const int paddedStride = alignedStride((width + 2 * pad) * channels);
+    const int rowStride = alignedStride(rowBytes);
+    const int bands = std::min(height, concurrency() * bandsPerThread);
+    const int rowsPerBand = (height + bands - 1) / bands;
+    for (int frame = 0; frame < job.frames; ++frame) {
+        ensureSize(m_scratch[frame], static_cast<size_t>(scratchStride) * height);
+    }
+    ensureSize(m_paddedRows, static_cast<size_t>(paddedStride) * bands);
+    ensureSize(m_rows, static_cast<size_t>(rowStride) * bands);
+    ensureSize(m_sums, static_cast<size_t>(scratchStride) * 2 * bands);
+
+    // Row pass: each band pads its rows into its own buffer and convolves them into scratch.
+    parallelFor(bands, [&](int band) {
+        uchar* padded = m_paddedRows.data() + static_cast<size_t>(band) * paddedStride;
+        uchar* interior = padded + pad * channels;
+        const int end = std::min((band + 1) * rowsPerBand, height);
+        std::optional<FrameStats> bandStats; // Only bands with sampled rows pay for the histograms.
+        for (int y = band * rowsPerBand; y < end; ++y) {
+            const uchar* row = src + static_cast<ptrdiff_t>(y) * srcStride;
+            if (stats && stats->wantsRow(y)) {
+                (bandStats ? *bandStats : bandStats.emplace()).addRow(row, width, m_layout, stats->step());
+            }
+            if (hasPointOps) {
+                ImageProcessing::pointOpsRow(row, interior, width, *pointOps, m_layout);
+            } else {
+                std::memcpy(interior, row, rowBytes);
+            }
+            for (int x = 1; x <= pad; ++x) {
+                std::memcpy(interior - x * channels, interior, channels);
+                std::memcpy(interior + (width - 1 + x) * channels, interior + (width - 1) * channels, channels);
+            }
+            for (int frame = 0; frame < job.frames; ++frame) {
+                const SeparableKernel& kernel = job.rowKernels[frame];
+                ImageProcessing::convolveRow(interior - kernel.radius() * channels,
+                    m_scratch[frame].data() + static_cast<size_t>(y) * scratchStride, rowBytes, channels, kernel.weights.data(), kernel.taps);
+            }
+        }
+        if (bandStats) {
+            stats->add(*bandStats);
+        }
+    });
+
+    // Column pass: a band's taps are consecutive scratch rows, so they stay in cache from one output row to the next.
+    parallelFor(bands, [&](int band) {
+        qint16* sums[2] = {
+            m_sums.data() + static_cast<size_t>(band) * 2 * scratchStride,
+            m_sums.data() + (static_cast<size_t>(band) * 2 + 1) * scratchStride,
+        };
+        uchar* rowBuffer = m_rows.data() + static_cast<size_t>(band) * rowStride;
+        std::array<const qint16*, Convolution::maxTaps> taps;
+        const int end = std::min((band + 1) * rowsPerBand, height);
+        for (int y = band * rowsPerBand; y < end; ++y) {
+            for (int frame = 0; frame < job.frames; ++frame) {
+                const SeparableKernel& kernel = job.columnKernels[frame];
+                for (int k = 0; k < kernel.taps; ++k) {
+                    const int row = std::clamp(y + k - kernel.radius(), 0, height - 1);
+                    taps[k] = m_scratch[frame].data() + static_cast<size_t>(row) * scratchStride;
+                }
+                ImageProcessing::convolveColumns(taps.data(), sums[frame], rowBytes, kernel.weights.data(), kernel.taps);
+            }
+
+            const uchar* original = src + static_cast<ptrdiff_t>(y) * srcStride;
+            uchar* out = dst + static_cast<ptrdiff_t>(y) * dstStride;
+            switch (job.finish) {
+            case Finish::Pack:
+                ImageProcessing::packRow(sums[0], out, rowBytes);
+                break;
+            case Finish::Unsharp:
+                if (hasPointOps) {
+                    ImageProcessing::pointOpsRow(original, rowBuffer, width, *pointOps, m_layout);
+                    original = rowBuffer;
+                }
+                ImageProcessing::unsharpRow(original, sums[0], out, rowBytes, job.amount);
+                break;
+            case Finish::Edges:
+                if (job.filler < 0) {
+                    ImageProcessing::edgeMagnitudeRow(sums[0], sums[1], out, rowBytes);
+                    break;
+                }
+                // In place, the fourth bytes are still to be read from the row about to be written.
+                ImageProcessing::edgeMagnitudeRow(sums[0], sums[1], rowBuffer, rowBytes);
+                for (int x = job.filler; x < rowBytes; x += channels) {
+                    rowBuffer[x] = original[x];
+                }
+                std::memcpy(out, rowBuffer, rowBytes);
+                break;
+            }
+        }
+    });
+}
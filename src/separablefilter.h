@@ -0,0 +1,92 @@
+#pragma once
+
+#include "imageprocessing.h"
+#include "imagekernels.h"
+#include "framestats.h"
+#include "threadpool.h"
+#include <array>
+#include <vector>
+
+// SeparableKernel: One direction of a separable convolution, an odd number of taps centred on the
+// pixel, in ImageKernels::Convolution fixed point.
+struct SeparableKernel {
+    std::array<qint16, ImageKernels::Convolution::maxTaps> weights{};
+    int taps = 1;
+
+    int radius() const { return taps / 2; }
+
+    // Sampled Gaussian out to three sigma, rounded so the weights add up to exactly one.
+    static SeparableKernel gaussian(double sigma);
+    static SeparableKernel binomial(); // 1 2 1 over 4, the smoothing half of Sobel.
+    static SeparableKernel derivative(); // -1 0 1 over 2, the difference half of Sobel.
+};
+
+// SeparableFilter: Separable convolutions in fixed point, spread over a thread pool. The first pass
+// convolves each row of bands of rows into a 16-bit scratch frame; the second convolves down the
+// columns of that, again by bands of rows, and finishes each row straight into the destination:
+// packed to bytes for a blur, added to the original for unsharp masking, or combined with a second
+// scratch frame into an edge magnitude. Edges are clamped: rows are padded with copies of their end
+// pixels and the column pass repeats the first and last rows. Scratch is reused from call to call.
+class SeparableFilter {
+public:
+    using Detail = ImageProcessing::DetailFilter;
+
+    explicit SeparableFilter(ThreadPool& pool = ThreadPool::global());
+
+    // Runs on the calling thread alone instead of the pool, e.g. to time a single core.
+    void setSingleThreaded(bool singleThreaded) { m_singleThreaded = singleThreaded; }
+
+    // Gaussian blur of src into dst, both in layout, with the variance of a box of blurRadius.
+    // pointOps and stats work as in BoxBlur::apply. src and dst may be the same buffer.
+    void blur(const uchar* src, int srcStride, uchar* dst, int dstStride, int width, int height, int blurRadius,
+        const ImageProcessing::PointOps* pointOps = nullptr, PixelFormat::Layout layout = PixelFormat::Layout::Rgb888,
+        FrameStatsCollector* stats = nullptr);
+    // One plane of channels interleaved bytes per pixel, with separate radii for subsampled planes.
+    void blurPlane(const uchar* src, int srcStride, uchar* dst, int dstStride, int width, int height,
+        int channels, int radiusX, int radiusY);
+
+    // A detail filter of src into dst. amount is in percent of the detail added back by sharpen and
+    // unsharp mask, radius the unsharp mask's blur radius; edges ignore both and write the Sobel
+    // magnitude of every channel, leaving the fourth byte of 32-bit pixels as it was.
+    void apply(Detail detail, int amount, int radius, const uchar* src, int srcStride, uchar* dst, int dstStride,
+        int width, int height, const ImageProcessing::PointOps* pointOps = nullptr,
+        PixelFormat::Layout layout = PixelFormat::Layout::Rgb888, FrameStatsCollector* stats = nullptr);
+    void applyPlane(Detail detail, int amount, int radius, const uchar* src, int srcStride, uchar* dst, int dstStride,
+        int width, int height, int channels);
+
+    // The Gaussian a blur radius stands for, sigma = sqrt(r(r + 1) / 3) as in BoxBlur::passes.
+    static SeparableKernel blurKernel(int blurRadius);
+    // How far, in pixels, a detail filter carries a change.
+    static int reach(Detail detail, int radius);
+
+private:
+    // Finish: What the column pass does with its sums.
+    enum class Finish {
+        Pack,
+        Unsharp,
+        Edges,
+    };
+    // Job: One or two scratch frames, each with its row and column kernel.
+    struct Job {
+        Finish finish = Finish::Pack;
+        int frames = 1;
+        std::array<SeparableKernel, 2> rowKernels;
+        std::array<SeparableKernel, 2> columnKernels;
+        int amount = 0; // Unsharp: in 1 / 2^amountBits.
+        int filler = -1; // Edges: byte of a 32-bit pixel to carry over.
+    };
+
+    static Job detailJob(Detail detail, int amount, int radius, int filler);
+    void run(const Job& job, const uchar* src, int srcStride, uchar* dst, int dstStride, int width, int height,
+        int channels, const ImageProcessing::PointOps* pointOps, FrameStatsCollector* stats);
+    void parallelFor(int count, const std::function<void(int)>& task);
+    int concurrency() const { return m_singleThreaded ? 1 : m_pool.concurrency(); }
+
+    ThreadPool& m_pool;
+    bool m_singleThreaded = false;
+    PixelFormat::Layout m_layout = PixelFormat::Layout::Rgb888; // Of the rows the point operations see.
+    std::array<std::vector<qint16>, 2> m_scratch; // Row pass output, one frame per kernel pair.
+    std::vector<uchar> m_paddedRows; // One edge-padded source row per band.
+    std::vector<uchar> m_rows; // One byte row per band: point-processed originals, edges before the filler goes back.
+    std::vector<qint16> m_sums; // Two column pass rows per band.
+};
@@ -0,0 +1,98 @@
+#include "sharedframereader.h"
+#include <utility>
+
+using namespace SharedFrames;
+
+namespace {
+
+// Attempts at a consistent read before giving up on this call; the writer only laps a reader that
+// is several frames behind, so one retry is almost always enough.
+constexpr int maxAttempts = 4;
+
+} // namespace
+
+SharedFrameReader::SharedFrameReader(std::string name) : m_name(std::move(name)) {
+}
+
+// attach: Maps the ring and checks it was written by this protocol version and is big enough for
+// the geometry it claims.
+bool SharedFrameReader::attach() {
+    if (!m_memory.open(m_name)) {
+        return false;
+    }
+    const RingHeader& ring = header();
+    const bool valid = m_memory.size() >= sizeof(RingHeader)
+        && ring.state.load(std::memory_order_acquire) == State::Live // Orders the geometry below.
+        && ring.magic == magic && ring.version == version && ring.slotCount > 0
+        && ring.slotStride >= sizeof(SlotHeader) + ring.slotBytes
+        && slotOffset(ring, ring.slotCount) <= m_memory.size();
+    if (!valid) {
+        m_memory.close();
+        return false;
+    }
+    m_nextIndex = 0;
+    return true;
+}
+
+const RingHeader& SharedFrameReader::header() const {
+    return *reinterpret_cast<const RingHeader*>(m_memory.data());
+}
+
+const SlotHeader& SharedFrameReader::slot(std::uint64_t index) const {
+    const RingHeader& ring = header();
+    return *reinterpret_cast<const SlotHeader*>(m_memory.data() + slotOffset(ring, index % ring.slotCount));
+}
+
+// next: The slot of the newest frame is read under its sequence lock. If the lock is not at the
+// value frame n leaves behind, the writer is in the slot or has moved past it: start over from
+// the new newest frame.
+SharedFrameReader::Status SharedFrameReader::next(Frame& frame) {
+    if (m_memory.isOpen() && header().state.load(std::memory_order_acquire) != State::Live) {
+        m_memory.close(); // Retired: the writer stopped or made a larger ring under the same name.
+    }
+    if (!m_memory.isOpen() && !attach()) {
+        return Status::NoWriter;
+    }
+
+    const RingHeader& ring = header();
+    for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+        const std::uint64_t written = ring.written.load(std::memory_order_acquire);
+        if (written <= m_nextIndex) {
+            return Status::NoNewFrame;
+        }
+        const std::uint64_t index = written - 1;
+        const SlotHeader& header = slot(index);
+        const std::uint64_t complete = 2 * index + 2;
+        if (header.lock.load(std::memory_order_acquire) != complete) {
+            ++m_retries;
+            continue;
+        }
+        frame.index = index;
+        frame.sequence = header.sequence;
+        frame.pts = header.pts;
+        frame.width = static_cast<int>(header.width);
+        frame.height = static_cast<int>(header.height);
+        frame.stride = static_cast<int>(header.stride);
+        frame.format = header.format;
+        frame.bytes = static_cast<std::size_t>(header.bytes);
+        frame.data = reinterpret_cast<const std::uint8_t*>(&header) + sizeof(SlotHeader);
+        if (!isIntact(frame) || frame.bytes > ring.slotBytes) {
+            ++m_retries;
+            continue;
+        }
+        m_skipped += index - m_nextIndex;
+        m_nextIndex = written;
+        return Status::Ok;
+    }
+    return Status::NoNewFrame;
+}
+
+// isIntact: The acquire fence keeps every read of the slot made before this call ahead of the
+// lock check, the reader's half of the writer's release.
+bool SharedFrameReader::isIntact(const Frame& frame) const {
+    if (!m_memory.isOpen() || !frame.data) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot(frame.index).lock.load(std::memory_order_relaxed) == 2 * frame.index + 2;
+}
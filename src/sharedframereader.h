@@ -0,0 +1,68 @@
+#pragma once
+
+#include "sharedframes.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// SharedFrameReader: Reads the newest frames a SharedFrameWriter in another process publishes.
+// A frame is a view straight into the ring, with no copy. The writer never waits for readers, so
+// after using a view the reader asks isIntact() whether the writer has since reused the slot;
+// with the default four slots that leaves about three frame intervals. A reader that falls
+// behind skips to the newest frame, and the skipped frames are counted.
+//
+//   SharedFrameReader reader("qtgst-camera");
+//   SharedFrameReader::Frame frame;
+//   while (running) {
+//       if (reader.next(frame) == SharedFrameReader::Status::Ok) {
+//           analyze(frame.data, frame.width, frame.height, frame.stride);
+//           if (!reader.isIntact(frame)) { /* discard the result */ }
+//       }
+//   }
+//
+// No Qt and no GStreamer; link the Qt-Gst-Camera-shmreader library. One reader per thread.
+class SharedFrameReader {
+public:
+    enum class Status {
+        Ok, // frame holds a new frame.
+        NoNewFrame, // Nothing published since the last frame returned.
+        NoWriter, // No ring under this name, or its writer stopped.
+    };
+
+    struct Frame {
+        std::uint64_t index = 0; // Position in the ring's publishing order.
+        std::uint64_t sequence = 0; // The frame's number in its camera stream.
+        std::int64_t pts = -1; // Nanoseconds; -1 if unknown.
+        int width = 0;
+        int height = 0;
+        int stride = 0;
+        SharedFrames::Format format = SharedFrames::Format::Unknown;
+        const std::uint8_t* data = nullptr; // Mapped until the next call to next(); see isIntact.
+        std::size_t bytes = 0;
+    };
+
+    explicit SharedFrameReader(std::string name);
+
+    // The newest frame not returned before. Opens the ring on first use and again after the writer
+    // replaced it, so a reader can start before the writer and outlive a restart.
+    Status next(Frame& frame);
+    // True while the slot still holds frame: what was read from frame.data up to now is consistent.
+    bool isIntact(const Frame& frame) const;
+
+    // Frames published while this reader was looking elsewhere.
+    std::uint64_t skipped() const { return m_skipped; }
+    // Reads that raced the writer and were retried.
+    std::uint64_t retries() const { return m_retries; }
+    const std::string& error() const { return m_memory.error(); }
+
+private:
+    bool attach();
+    const SharedFrames::RingHeader& header() const;
+    const SharedFrames::SlotHeader& slot(std::uint64_t index) const;
+
+    std::string m_name;
+    SharedFrames::SharedMemory m_memory;
+    std::uint64_t m_nextIndex = 0; // Frames before this were returned or skipped.
+    std::uint64_t m_skipped = 0;
+    std::uint64_t m_retries = 0;
+};
@@ -0,0 +1,149 @@
+#include "sharedframes.h"
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace SharedFrames {
+
+const char* formatName(Format format) {
+    switch (format) {
+    case Format::Rgb888: return "RGB";
+    case Format::Rgbx8888: return "RGBx";
+    case Format::Rgba8888: return "RGBA";
+    case Format::Bgrx8888: return "BGRx";
+    case Format::Bgra8888: return "BGRA";
+    case Format::Gray8: return "GRAY8";
+    case Format::Unknown: break;
+    }
+    return "unknown";
+}
+
+namespace {
+
+#ifndef _WIN32
+std::string objectName(const std::string& name) {
+    return name.empty() || name.front() != '/' ? '/' + name : name;
+}
+
+std::string systemError(const char* call) {
+    return std::string(call) + ": " + std::strerror(errno);
+}
+#endif
+
+} // namespace
+
+SharedMemory::~SharedMemory() {
+    close();
+}
+
+SharedMemory::SharedMemory(SharedMemory&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)), m_error(std::move(other.m_error)) {
+}
+
+SharedMemory& SharedMemory::operator=(SharedMemory&& other) noexcept {
+    if (this != &other) {
+        close();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_error = std::move(other.m_error);
+    }
+    return *this;
+}
+
+#ifndef _WIN32
+
+// create: Unlinks first, so a ring left behind by a writer that crashed is never reused; O_EXCL
+// then guarantees the object is fresh and zero-filled.
+bool SharedMemory::create(const std::string& name, std::size_t bytes) {
+    close();
+    const std::string path = objectName(name);
+    ::shm_unlink(path.c_str());
+    const int fd = ::shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        m_error = systemError("shm_open");
+        return false;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        m_error = systemError("ftruncate");
+        ::close(fd);
+        ::shm_unlink(path.c_str());
+        return false;
+    }
+    void* data = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the object alive.
+    if (data == MAP_FAILED) {
+        m_error = systemError("mmap");
+        ::shm_unlink(path.c_str());
+        return false;
+    }
+    m_data = static_cast<std::uint8_t*>(data);
+    m_size = bytes;
+    return true;
+}
+
+// open: Read-only, so a reader cannot disturb the writer or other readers.
+bool SharedMemory::open(const std::string& name) {
+    close();
+    const int fd = ::shm_open(objectName(name).c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        m_error = systemError("shm_open");
+        return false;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+        m_error = info.st_size <= 0 ? std::string("empty object") : systemError("fstat");
+        ::close(fd);
+        return false;
+    }
+    const auto bytes = static_cast<std::size_t>(info.st_size);
+    void* data = ::mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        m_error = systemError("mmap");
+        return false;
+    }
+    m_data = static_cast<std::uint8_t*>(data);
+    m_size = bytes;
+    return true;
+}
+
+void SharedMemory::close() {
+    if (m_data) {
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
+void SharedMemory::remove(const std::string& name) {
+    ::shm_unlink(objectName(name).c_str());
+}
+
+#else
+
+bool SharedMemory::create(const std::string&, std::size_t) {
+    m_error = "POSIX shared memory is not available on this platform";
+    return false;
+}
+
+bool SharedMemory::open(const std::string&) {
+    m_error = "POSIX shared memory is not available on this platform";
+    return false;
+}
+
+void SharedMemory::close() {
+}
+
+void SharedMemory::remove(const std::string&) {
+}
+
+#endif
+
+} // namespace SharedFrames
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// SharedFrames: The layout of a ring of processed frames in POSIX shared memory, written by one
+// SharedFrameWriter and read by any number of SharedFrameReaders in other processes. Plain C++ with
+// no Qt or GStreamer, so consumers can link the reader alone.
+//
+// The object starts with a RingHeader, followed by slotCount slots of slotStride bytes, each a
+// SlotHeader and then the pixels. Frame n goes to slot n % slotCount. Every slot is guarded by a
+// sequence lock: the writer sets it to 2n + 1, writes the header and pixels, then sets it to
+// 2n + 2 and bumps written to n + 1. A reader checks the lock before and after using a slot and
+// discards what it saw if the lock moved, so readers never take a lock and never hold up the writer.
+namespace SharedFrames {
+
+constexpr std::uint32_t magic = 0x46534751; // "QGSF" in memory on little-endian CPUs.
+constexpr std::uint32_t version = 1;
+
+// Format: Byte order of a pixel in memory, independent of the CPU.
+enum class Format : std::uint32_t {
+    Unknown,
+    Rgb888, // R G B.
+    Rgbx8888, // R G B X.
+    Rgba8888, // R G B A, not premultiplied.
+    Bgrx8888, // B G R X.
+    Bgra8888, // B G R A, not premultiplied.
+    Gray8,
+};
+
+constexpr int bytesPerPixel(Format format) {
+    switch (format) {
+    case Format::Rgb888: return 3;
+    case Format::Rgbx8888:
+    case Format::Rgba8888:
+    case Format::Bgrx8888:
+    case Format::Bgra8888: return 4;
+    case Format::Gray8: return 1;
+    case Format::Unknown: break;
+    }
+    return 0;
+}
+
+const char* formatName(Format format);
+
+// State: A ring is Initializing until its geometry is written, and Retired once the writer stopped
+// or replaced it with a larger one; readers then open the name again.
+enum class State : std::uint32_t {
+    Initializing,
+    Live,
+    Retired,
+};
+
+static_assert(std::atomic<State>::is_always_lock_free && std::atomic<std::uint64_t>::is_always_lock_free,
+    "The ring needs address-free atomics to be shared between processes");
+
+struct alignas(64) RingHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::atomic<State> state;
+    std::uint32_t slotCount;
+    std::uint64_t slotBytes; // Pixel capacity of a slot.
+    std::uint64_t slotStride; // Distance between slot headers.
+    alignas(64) std::atomic<std::uint64_t> written; // Frames published; the newest is written - 1. Own cache line.
+};
+
+struct alignas(64) SlotHeader {
+    std::atomic<std::uint64_t> lock; // 2n + 1 while frame n is written, 2n + 2 once it is complete.
+    std::uint64_t sequence; // The frame's number in its camera stream.
+    std::int64_t pts; // Presentation time in nanoseconds, -1 if unknown.
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t stride; // Bytes from one row to the next.
+    Format format;
+    std::uint64_t bytes; // stride * height, at most slotBytes.
+};
+
+constexpr std::uint64_t slotOffset(const RingHeader& header, std::uint64_t slot) {
+    return sizeof(RingHeader) + slot * header.slotStride;
+}
+
+// SharedMemory: A named shared-memory object mapped into this process. Names are given without the
+// leading slash POSIX wants. Move-only; the destructor unmaps but does not remove the name.
+class SharedMemory {
+public:
+    SharedMemory() = default;
+    ~SharedMemory();
+    SharedMemory(SharedMemory&& other) noexcept;
+    SharedMemory& operator=(SharedMemory&& other) noexcept;
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    // Replaces any object of this name with a new zeroed one of bytes, mapped for writing. Readers
+    // that still map the old object keep it until they let go.
+    bool create(const std::string& name, std::size_t bytes);
+    // Maps an existing object read-only.
+    bool open(const std::string& name);
+    void close();
+    // Removes the name, so the next open finds nothing until it is created again.
+    static void remove(const std::string& name);
+
+    bool isOpen() const { return m_data != nullptr; }
+    std::uint8_t* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+    const std::string& error() const { return m_error; } // Why the last create or open failed.
+
+private:
+    std::uint8_t* m_data = nullptr;
+    std::size_t m_size = 0;
+    std::string m_error;
+};
+
+} // namespace SharedFrames
@@ -0,0 +1,134 @@
+#include "sharedframewriter.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+using namespace SharedFrames;
+
+SharedFrameWriter::~SharedFrameWriter() {
+    stop();
+}
+
+void SharedFrameWriter::start(const QString& name, int slotCount) {
+    stop();
+    std::lock_guard lock(m_mutex);
+    m_name = name.toStdString();
+    m_slotCount = std::max(slotCount, 2); // One slot would always be the one being rewritten.
+    m_written = 0;
+    m_error.clear();
+    m_published.store(0, std::memory_order_relaxed);
+    m_skipped.store(0, std::memory_order_relaxed);
+    m_publishing.store(true, std::memory_order_release);
+}
+
+void SharedFrameWriter::stop() {
+    std::lock_guard lock(m_mutex);
+    if (!m_publishing.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    retire();
+    SharedMemory::remove(m_name);
+}
+
+// retire: Readers that still map the ring see it is no longer written and open the name again.
+void SharedFrameWriter::retire() {
+    if (m_header) {
+        m_header->state.store(State::Retired, std::memory_order_release);
+        m_header = nullptr;
+    }
+    m_memory.close();
+}
+
+// ensureCapacity: A new ring replaces the old one under the same name. Its geometry is written
+// before the state turns Live, which is what readers check first.
+bool SharedFrameWriter::ensureCapacity(quint64 bytes) {
+    if (m_header && m_header->slotBytes >= bytes) {
+        return true;
+    }
+    retire();
+    const quint64 slotBytes = (bytes + 63) & ~quint64(63);
+    const quint64 slotStride = sizeof(SlotHeader) + slotBytes;
+    if (!m_memory.create(m_name, sizeof(RingHeader) + slotStride * m_slotCount)) {
+        m_error = m_memory.error();
+        return false;
+    }
+    // The object is zero-filled; the headers are constructed in place over it.
+    m_header = new (m_memory.data()) RingHeader{};
+    m_header->magic = magic;
+    m_header->version = version;
+    m_header->slotCount = static_cast<std::uint32_t>(m_slotCount);
+    m_header->slotBytes = slotBytes;
+    m_header->slotStride = slotStride;
+    for (int slot = 0; slot < m_slotCount; ++slot) {
+        new (m_memory.data() + slotOffset(*m_header, slot)) SlotHeader{};
+    }
+    m_written = 0;
+    m_header->state.store(State::Live, std::memory_order_release);
+    return true;
+}
+
+// pushFrame: One sequence-locked write into slot n % slotCount. The release fence after marking
+// the slot busy keeps the header and pixel stores from being seen before the mark.
+void SharedFrameWriter::pushFrame(const VideoFrame& frame) {
+    if (!isPublishing()) {
+        return;
+    }
+    const QImage& image = frame.image();
+    const Format format = toSharedFormat(image.format());
+    if (format == Format::Unknown) {
+        m_skipped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    const quint64 bytes = static_cast<quint64>(image.bytesPerLine()) * image.height();
+
+    std::lock_guard lock(m_mutex);
+    if (!m_publishing.load(std::memory_order_relaxed) || !ensureCapacity(bytes)) {
+        m_skipped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    const quint64 index = m_written;
+    auto* slot = reinterpret_cast<SlotHeader*>(m_memory.data() + slotOffset(*m_header, index % m_header->slotCount));
+    slot->lock.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->sequence = frame.sequence();
+    slot->pts = GST_CLOCK_TIME_IS_VALID(frame.pts()) ? static_cast<std::int64_t>(frame.pts()) : -1;
+    slot->width = static_cast<std::uint32_t>(image.width());
+    slot->height = static_cast<std::uint32_t>(image.height());
+    slot->stride = static_cast<std::uint32_t>(image.bytesPerLine());
+    slot->format = format;
+    slot->bytes = bytes;
+    std::memcpy(reinterpret_cast<uchar*>(slot) + sizeof(SlotHeader), image.constBits(), bytes);
+
+    slot->lock.store(2 * index + 2, std::memory_order_release);
+    m_written = index + 1;
+    m_header->written.store(m_written, std::memory_order_release);
+    m_published.fetch_add(1, std::memory_order_relaxed);
+}
+
+SharedFrameWriter::Counters SharedFrameWriter::counters() const {
+    Counters counters;
+    counters.published = m_published.load(std::memory_order_relaxed);
+    counters.skipped = m_skipped.load(std::memory_order_relaxed);
+    return counters;
+}
+
+QString SharedFrameWriter::error() const {
+    std::lock_guard lock(m_mutex);
+    return QString::fromStdString(m_error);
+}
+
+// toSharedFormat: RGB32 and ARGB32 are 0xAARRGGBB words, so their byte order depends on the CPU.
+Format SharedFrameWriter::toSharedFormat(QImage::Format format) {
+    switch (format) {
+    case QImage::Format_RGB888: return Format::Rgb888;
+    case QImage::Format_RGBX8888: return Format::Rgbx8888;
+    case QImage::Format_RGBA8888: return Format::Rgba8888;
+    case QImage::Format_Grayscale8: return Format::Gray8;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    case QImage::Format_RGB32: return Format::Bgrx8888;
+    case QImage::Format_ARGB32: return Format::Bgra8888;
+#endif
+    default: return Format::Unknown;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "sharedframes.h"
+#include "videoframe.h"
+#include <QImage>
+#include <QString>
+#include <atomic>
+#include <mutex>
+
+// SharedFrameWriter: Publishes processed frames into a SharedFrames ring in POSIX shared memory, so
+// analytics in other processes on this machine can read them without opening the camera.
+// pushFrame copies the pixels into the next slot (the only copy a frame takes) and never waits
+// for readers, whose progress it does not track. The ring is sized for the first frame and
+// replaced by a larger one when a bigger frame arrives; readers follow on their own.
+// Packed RGB and gray frames are published; YUV frames are skipped and counted.
+class SharedFrameWriter {
+public:
+    // Counters: Frames offered to the writer since start.
+    struct Counters {
+        quint64 published = 0;
+        quint64 skipped = 0; // YUV or other formats the ring does not describe, or no ring could be made.
+    };
+
+    SharedFrameWriter() = default;
+    ~SharedFrameWriter();
+    SharedFrameWriter(const SharedFrameWriter&) = delete;
+    SharedFrameWriter& operator=(const SharedFrameWriter&) = delete;
+
+    // Publishes under name (a POSIX shared-memory name without the slash, e.g. "qtgst-camera0")
+    // with slotCount slots. The ring itself is created with the first frame.
+    void start(const QString& name, int slotCount = 4);
+    // Retires the ring, so readers see the writer is gone, and removes the name.
+    void stop();
+    bool isPublishing() const { return m_publishing.load(std::memory_order_acquire); }
+
+    // Thread-safe and non-blocking: called on the effects worker for every processed frame.
+    void pushFrame(const VideoFrame& frame);
+
+    Counters counters() const;
+    QString error() const; // Why the ring could not be created, if it could not.
+
+    // The ring's byte order for a QImage format; Unknown for formats it does not describe.
+    static SharedFrames::Format toSharedFormat(QImage::Format format);
+
+private:
+    bool ensureCapacity(quint64 bytes); // Called with m_mutex held.
+    void retire(); // Called with m_mutex held.
+
+    mutable std::mutex m_mutex; // Serializes writers; readers never take it.
+    std::string m_name;
+    int m_slotCount = 4;
+    SharedFrames::SharedMemory m_memory;
+    SharedFrames::RingHeader* m_header = nullptr;
+    quint64 m_written = 0; // Guarded by m_mutex.
+    std::string m_error;
+
+    std::atomic<bool> m_publishing{ false };
+    std::atomic<quint64> m_published{ 0 };
+    std::atomic<quint64> m_skipped{ 0 };
+};
@@ -0,0 +1,112 @@
+#include "snapshotencoder.h"
+#include "effectchain.h"
+#include <QDebug>
+#include <QDir>
+#include <QImageWriter>
+#include <algorithm>
+
+SnapshotEncoder::SnapshotEncoder(int threadCount, QObject* parent)
+    : QObject(parent), m_pool(std::max(threadCount, 1)) {
+}
+
+SnapshotEncoder::~SnapshotEncoder() {
+    waitForIdle();
+}
+
+void SnapshotEncoder::setSettings(const SnapshotSettings& settings) {
+    std::lock_guard lock(m_mutex);
+    m_settings = settings;
+}
+
+SnapshotSettings SnapshotEncoder::settings() const {
+    std::lock_guard lock(m_mutex);
+    return m_settings;
+}
+
+// submit: The job holds the frame, and with it the buffer, until the still is written. The
+// settings are copied with it, so a still is written the way it was asked for.
+bool SnapshotEncoder::submit(const VideoFrame& frame) {
+    SnapshotSettings settings;
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_queued >= std::max(m_settings.queueCapacity, 1)) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        ++m_queued;
+        m_highWater = std::max(m_highWater, m_queued);
+        settings = m_settings;
+    }
+    m_pool.post([this, frame, settings] {
+        encode(frame, settings);
+        finished();
+    });
+    return true;
+}
+
+void SnapshotEncoder::finished() {
+    std::lock_guard lock(m_mutex);
+    if (--m_queued == 0) {
+        m_idle.notify_all();
+    }
+}
+
+void SnapshotEncoder::waitForIdle() {
+    std::unique_lock lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_queued == 0; });
+}
+
+// encode: Runs on a pool worker. Effects run non-incrementally, since stills are not consecutive frames.
+void SnapshotEncoder::encode(const VideoFrame& frame, const SnapshotSettings& settings) {
+    const qint64 begin = FrameTracer::now();
+    const QString path = QDir(settings.directory).filePath(QStringLiteral("%1-%2.%3")
+        .arg(settings.prefix).arg(frame.sequence(), 6, 10, QLatin1Char('0')).arg(settings.format));
+    if (frame.isYuv() || !QDir().mkpath(settings.directory)) {
+        qDebug() << "Cannot write still" << path;
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+        emit failed(path);
+        return;
+    }
+
+    QImage image = frame.image();
+    if (settings.applyEffects) {
+        EffectSettings effects = settings.effects;
+        effects.incremental = false;
+        EffectChain chain;
+        chain.configure(effects);
+        image = chain.process(image);
+    }
+    QImageWriter writer(path, settings.format.toLatin1());
+    writer.setQuality(settings.quality);
+    if (!writer.write(image)) {
+        qDebug() << "Cannot write still" << path << writer.errorString();
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+        emit failed(path);
+        return;
+    }
+
+    const qint64 elapsed = FrameTracer::now() - begin;
+    m_lastEncodeNs.store(elapsed, std::memory_order_relaxed);
+    m_totalEncodeNs.fetch_add(elapsed, std::memory_order_relaxed);
+    qint64 longest = m_maxEncodeNs.load(std::memory_order_relaxed);
+    while (elapsed > longest && !m_maxEncodeNs.compare_exchange_weak(longest, elapsed, std::memory_order_relaxed)) {
+    }
+    m_saved.fetch_add(1, std::memory_order_relaxed);
+    emit saved(path, elapsed);
+}
+
+SnapshotEncoder::Counters SnapshotEncoder::counters() const {
+    Counters counters;
+    {
+        std::lock_guard lock(m_mutex);
+        counters.queued = m_queued;
+        counters.highWater = m_highWater;
+    }
+    counters.saved = m_saved.load(std::memory_order_relaxed);
+    counters.failed = m_failed.load(std::memory_order_relaxed);
+    counters.dropped = m_dropped.load(std::memory_order_relaxed);
+    counters.lastEncodeNs = m_lastEncodeNs.load(std::memory_order_relaxed);
+    counters.maxEncodeNs = m_maxEncodeNs.load(std::memory_order_relaxed);
+    counters.totalEncodeNs = m_totalEncodeNs.load(std::memory_order_relaxed);
+    return counters;
+}
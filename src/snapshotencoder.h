@@ -0,0 +1,80 @@
+#pragma once
+
+#include "effectsettings.h"
+#include "threadpool.h"
+#include "videoframe.h"
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+// SnapshotSettings: Where and how stills are written.
+struct SnapshotSettings {
+    QString directory; // Stills are written here as <prefix>-<sequence>.<format>.
+    QString prefix = QStringLiteral("still");
+    QString format = QStringLiteral("png"); // Any format QImageWriter writes, e.g. png or jpg.
+    int quality = -1; // QImageWriter quality, -1 for the format's default.
+    bool applyEffects = false; // Runs effects over the full-resolution still before encoding.
+    EffectSettings effects;
+    // Stills waiting for an encoder before new ones are dropped. Each one holds a full-resolution
+    // frame, about 24 MB at 4K in RGB888, so the default fits a 30-frame burst in under 1 GB.
+    int queueCapacity = 32;
+};
+
+// SnapshotEncoder: Encodes stills to image files on a small pool of its own. submit takes the frame
+// by reference and never waits: when the queue is full the still is dropped and counted, so a burst
+// cannot stall the streaming thread that delivers it or the GUI. Each encoded still reports how long
+// it took, and the counters keep the deepest the queue has been.
+class SnapshotEncoder : public QObject {
+    Q_OBJECT
+
+public:
+    // Counters: Stills offered since the encoder was created.
+    struct Counters {
+        quint64 saved = 0;
+        quint64 failed = 0; // The file could not be written.
+        quint64 dropped = 0; // The queue was full.
+        int queued = 0; // Waiting or being encoded right now.
+        int highWater = 0; // Most stills ever waiting or being encoded at once.
+        qint64 lastEncodeNs = 0; // Effects and encoding of the last still saved.
+        qint64 maxEncodeNs = 0;
+        qint64 totalEncodeNs = 0; // Divide by saved for the mean.
+    };
+
+    explicit SnapshotEncoder(int threadCount = 2, QObject* parent = nullptr);
+    ~SnapshotEncoder() override; // Waits for the stills already queued.
+
+    // Applies to stills submitted from now on.
+    void setSettings(const SnapshotSettings& settings);
+    SnapshotSettings settings() const;
+
+    // Thread-safe and non-blocking. Returns false if the still was dropped.
+    bool submit(const VideoFrame& frame);
+    // Blocks until every still submitted so far is written.
+    void waitForIdle();
+
+    Counters counters() const;
+
+signals:
+    // Emitted from an encoder thread.
+    void saved(const QString& path, qint64 encodeNs);
+    void failed(const QString& path);
+
+private:
+    void encode(const VideoFrame& frame, const SnapshotSettings& settings);
+    void finished();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_idle;
+    SnapshotSettings m_settings;
+    int m_queued = 0; // Guarded by m_mutex.
+    int m_highWater = 0;
+    std::atomic<quint64> m_saved{ 0 };
+    std::atomic<quint64> m_failed{ 0 };
+    std::atomic<quint64> m_dropped{ 0 };
+    std::atomic<qint64> m_lastEncodeNs{ 0 };
+    std::atomic<qint64> m_maxEncodeNs{ 0 };
+    std::atomic<qint64> m_totalEncodeNs{ 0 };
+    ThreadPool m_pool; // Declared last: its workers are joined before anything they use is destroyed.
+};
@@ -0,0 +1,107 @@
+#include "threadpool.h"
+#include <algorithm>
+
+// Constructor: Starts the worker threads; always at least one, so posted tasks never run on the poster's thread.
+ThreadPool::ThreadPool(int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::thread::hardware_concurrency()) - 1; // The caller is the extra thread.
+    }
+    threadCount = std::max(threadCount, 1);
+    m_workers.reserve(threadCount);
+    for (int i = 0; i < threadCount; ++i) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+// Destructor: Lets the workers drain and joins them.
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wakeup.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+// global: Lazily created pool sized to the machine.
+ThreadPool& ThreadPool::global() {
+    static ThreadPool pool;
+    return pool;
+}
+
+// parallelFor: Publishes a batch, works on it from the calling thread and waits for the stragglers.
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& task) {
+    if (count <= 0) {
+        return;
+    }
+    if (count == 1) {
+        task(0); // Not worth waking anyone.
+        return;
+    }
+
+    auto batch = std::make_shared<Batch>();
+    batch->task = &task;
+    batch->count = count;
+    batch->remaining.store(count, std::memory_order_relaxed);
+    {
+        std::lock_guard lock(m_mutex);
+        m_batches.push_back(batch);
+    }
+    m_wakeup.notify_all();
+
+    runTasks(*batch); // The caller takes indices like any worker.
+
+    std::unique_lock lock(batch->mutex);
+    batch->finished.wait(lock, [&] { return batch->remaining.load(std::memory_order_acquire) == 0; });
+}
+
+// post: Queues a batch of one index that owns its task; nobody waits for it.
+void ThreadPool::post(std::function<void()> task) {
+    auto batch = std::make_shared<Batch>();
+    batch->owned = [task = std::move(task)](int) { task(); };
+    batch->task = &batch->owned;
+    batch->count = 1;
+    batch->remaining.store(1, std::memory_order_relaxed);
+    {
+        std::lock_guard lock(m_mutex);
+        m_batches.push_back(std::move(batch));
+    }
+    m_wakeup.notify_one();
+}
+
+// runTasks: Claims indices from the batch until none are left.
+void ThreadPool::runTasks(Batch& batch) {
+    for (;;) {
+        const int index = batch.next.fetch_add(1, std::memory_order_relaxed);
+        if (index >= batch.count) {
+            return;
+        }
+        (*batch.task)(index);
+        if (batch.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard lock(batch.mutex); // Pairs with the waiter's predicate check.
+            batch.finished.notify_all();
+        }
+    }
+}
+
+// workerLoop: Picks the oldest batch with work left; exhausted batches are removed from the queue.
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::shared_ptr<Batch> batch;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wakeup.wait(lock, [this] { return m_stopping || !m_batches.empty(); });
+            if (m_batches.empty()) {
+                return; // Stopping and nothing left to do.
+            }
+            batch = m_batches.front();
+            if (batch->next.load(std::memory_order_relaxed) >= batch->count) {
+                m_batches.pop_front(); // Every index is handed out; running ones finish on their own.
+                continue;
+            }
+        }
+        runTasks(*batch);
+    }
+}
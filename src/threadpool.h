@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ThreadPool: Fixed set of worker threads for data-parallel frame processing.
+// parallelFor splits work into indexed tasks; the calling thread works on its own batch too,
+// so a pool of N threads keeps N + 1 cores busy and nested or concurrent calls cannot deadlock.
+// post runs a single task asynchronously, e.g. one camera's next frame. Idle workers always take
+// from the oldest batch with work left, so camera tasks and the loops they fan out share the cores.
+// This is one shared FIFO of batches rather than per-worker deques with stealing, on purpose: every
+// thread claims a batch's indices from one atomic counter, which balances uneven bands the way
+// stealing would, and the queue lock is only taken once per batch. A caller never waits on queued
+// work it could be doing itself, because it runs its own batch until no index is left and then
+// only waits for indices already running; posted tasks are never joined at all.
+class ThreadPool {
+public:
+    // 0 uses one worker per core, minus the caller. There is always at least one worker, so a posted
+    // task never runs on, or blocks, the thread that posted it.
+    explicit ThreadPool(int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of threads that can work on a batch at once, including the caller.
+    int concurrency() const { return static_cast<int>(m_workers.size()) + 1; }
+
+    // Runs task(index) for every index in [0, count) and returns when all of them have finished.
+    void parallelFor(int count, const std::function<void(int)>& task);
+
+    // Runs task once on a worker and returns immediately. Tasks are started oldest first.
+    void post(std::function<void()> task);
+
+    // Pool shared by everything that processes frames.
+    static ThreadPool& global();
+
+private:
+    struct Batch {
+        const std::function<void(int)>* task = nullptr;
+        std::function<void(int)> owned; // Storage for posted tasks; task points here.
+        int count = 0;
+        std::atomic<int> next{ 0 }; // Next index to hand out.
+        std::atomic<int> remaining{ 0 }; // Indices not finished yet.
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    void workerLoop();
+    static void runTasks(Batch& batch);
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::deque<std::shared_ptr<Batch>> m_batches; // Batches that still have indices to hand out.
+    bool m_stopping = false;
+};
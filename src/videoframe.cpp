@@ -0,0 +1,138 @@
+#include "videoframe.h"
+#include <gst/video/video.h>
+#include <QDebug>
+
+namespace {
+
+// Mapping: Owns the sample reference and the buffer mapping behind a QImage view.
+struct Mapping {
+    GstSample* sample = nullptr;
+    GstBuffer* buffer = nullptr;
+    GstMapInfo map{};
+
+    ~Mapping() {
+        if (buffer) {
+            gst_buffer_unmap(buffer, &map); // Release the mapping before dropping the sample.
+        }
+        gst_sample_unref(sample); // Drops our reference; GStreamer may now recycle the buffer.
+    }
+};
+
+} // namespace
+
+// fromSample: Maps the sample's buffer and wraps it in a QImage that shares the mapped memory.
+VideoFrame VideoFrame::fromSample(GstSample* sample, quint64 sequence) {
+    VideoFrame frame;
+    frame.m_sequence = sequence;
+    if (!sample) {
+        return frame; // Nothing to wrap.
+    }
+
+    GstVideoInfo info;
+    // Parses the negotiated caps to get the real format and row stride.
+    if (!gst_video_info_from_caps(&info, gst_sample_get_caps(sample))) {
+        qDebug() << "Failed to parse sample caps";
+        return frame;
+    }
+
+    const QImage::Format format = toImageFormat(GST_VIDEO_INFO_FORMAT(&info));
+    const YuvImage::Format yuvFormat = toYuvFormat(GST_VIDEO_INFO_FORMAT(&info));
+    if (format == QImage::Format_Invalid && yuvFormat == YuvImage::Format::Invalid) {
+        qDebug() << "Unsupported video format:" << GST_VIDEO_INFO_NAME(&info);
+        return frame;
+    }
+
+    auto* mapping = new Mapping;
+    mapping->sample = gst_sample_ref(sample); // Keeps the buffer alive for the lifetime of the view.
+    mapping->buffer = gst_sample_get_buffer(sample);
+    if (!mapping->buffer || !gst_buffer_map(mapping->buffer, &mapping->map, GST_MAP_READ)) {
+        qDebug() << "Failed to map sample buffer";
+        mapping->buffer = nullptr; // Nothing was mapped, so the destructor only drops the sample.
+        delete mapping;
+        return frame;
+    }
+
+    if (yuvFormat != YuvImage::Format::Invalid) {
+        // Plane views into the mapped memory; the shared owner releases the mapping with the last view.
+        std::array<const uchar*, 3> planes{};
+        std::array<int, 3> strides{};
+        for (guint plane = 0; plane < GST_VIDEO_INFO_N_PLANES(&info) && plane < 3; ++plane) {
+            planes[plane] = mapping->map.data + GST_VIDEO_INFO_PLANE_OFFSET(&info, plane);
+            strides[plane] = GST_VIDEO_INFO_PLANE_STRIDE(&info, plane);
+        }
+        frame.m_yuv = YuvImage::wrap(yuvFormat, GST_VIDEO_INFO_WIDTH(&info), GST_VIDEO_INFO_HEIGHT(&info), planes, strides,
+            std::shared_ptr<const void>(mapping, [](const void* info) { releaseMapping(const_cast<void*>(info)); }));
+        frame.m_pts = GST_BUFFER_PTS(mapping->buffer);
+        return frame;
+    }
+
+    // The QImage points at the mapped memory and calls releaseMapping when its last copy goes away.
+    // Passing const data keeps the view read-only, so effects detach instead of writing into the buffer.
+    frame.m_image = QImage(static_cast<const uchar*>(mapping->map.data),
+        GST_VIDEO_INFO_WIDTH(&info),
+        GST_VIDEO_INFO_HEIGHT(&info),
+        GST_VIDEO_INFO_PLANE_STRIDE(&info, 0),
+        format,
+        &VideoFrame::releaseMapping,
+        mapping);
+    frame.m_pts = GST_BUFFER_PTS(mapping->buffer); // Presentation timestamp of the captured frame.
+
+    return frame;
+}
+
+// withImage: Keeps the capture metadata but swaps in new pixels (e.g. an effect output).
+VideoFrame VideoFrame::withImage(const QImage& image, quint64 effectGeneration) const {
+    VideoFrame frame = *this;
+    frame.m_image = image;
+    frame.m_effectGeneration = effectGeneration;
+    frame.m_yuv = YuvImage(); // Processed YUV frames are converted to RGB for display.
+    return frame;
+}
+
+// toImageFormat: Maps a GStreamer raw video format to the matching QImage layout.
+QImage::Format VideoFrame::toImageFormat(GstVideoFormat format) {
+    switch (format) {
+    case GST_VIDEO_FORMAT_RGB:
+        return QImage::Format_RGB888;
+    case GST_VIDEO_FORMAT_BGR:
+        return QImage::Format_BGR888;
+    case GST_VIDEO_FORMAT_RGBx:
+        return QImage::Format_RGBX8888;
+    case GST_VIDEO_FORMAT_RGBA:
+        return QImage::Format_RGBA8888;
+    case GST_VIDEO_FORMAT_GRAY8:
+        return QImage::Format_Grayscale8;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    case GST_VIDEO_FORMAT_BGRx: // 0xffRRGGBB words.
+        return QImage::Format_RGB32;
+    case GST_VIDEO_FORMAT_BGRA:
+        return QImage::Format_ARGB32;
+#else
+    case GST_VIDEO_FORMAT_xRGB:
+        return QImage::Format_RGB32;
+    case GST_VIDEO_FORMAT_ARGB:
+        return QImage::Format_ARGB32;
+#endif
+    default:
+        return QImage::Format_Invalid;
+    }
+}
+
+// toYuvFormat: The native camera layouts the effects can work on without a conversion.
+YuvImage::Format VideoFrame::toYuvFormat(GstVideoFormat format) {
+    switch (format) {
+    case GST_VIDEO_FORMAT_YUY2:
+        return YuvImage::Format::YUY2;
+    case GST_VIDEO_FORMAT_NV12:
+        return YuvImage::Format::NV12;
+    case GST_VIDEO_FORMAT_I420:
+        return YuvImage::Format::I420;
+    default:
+        return YuvImage::Format::Invalid;
+    }
+}
+
+// releaseMapping: QImage cleanup function (and YuvImage owner deleter), invoked on whichever thread drops the last view.
+void VideoFrame::releaseMapping(void* info) {
+    delete static_cast<Mapping*>(info);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <gst/gst.h>
+#include <QImage>
+#include <QMetaType>
+#include "frametracer.h"
+#include "yuvimage.h"
+
+// VideoFrame: A refcounted handle to a decoded camera frame.
+// The frame keeps its GstSample referenced and its GstBuffer mapped for as long as
+// any QImage view obtained from image() is alive, so frames can travel from the
+// appsink callback to the widget without copying the pixel data.
+// RGB and gray formats are exposed as a QImage; the camera's native YUV formats as a YuvImage.
+class VideoFrame {
+public:
+    VideoFrame() = default;
+
+    // Wraps a sample pulled from an appsink. Takes an additional reference on the sample.
+    // sequence numbers the frames of a stream, starting at 1.
+    static VideoFrame fromSample(GstSample* sample, quint64 sequence = 0);
+
+    bool isValid() const { return !m_image.isNull() || !m_yuv.isNull(); }
+    bool isYuv() const { return !m_yuv.isNull(); }
+
+    int width() const { return isYuv() ? m_yuv.width() : m_image.width(); }
+    int height() const { return isYuv() ? m_yuv.height() : m_image.height(); }
+    QSize size() const { return QSize(width(), height()); }
+    int stride() const { return isYuv() ? m_yuv.stride(0) : static_cast<int>(m_image.bytesPerLine()); }
+    QImage::Format format() const { return m_image.format(); } // Format_Invalid for YUV frames.
+    GstClockTime pts() const { return m_pts; }
+    quint64 sequence() const { return m_sequence; }
+    quint64 effectGeneration() const { return m_effectGeneration; } // Settings the pixels were processed with.
+
+    // Where the frame has been so far; copies made downstream carry their own stamps.
+    const FrameTimestamps& timestamps() const { return m_timestamps; }
+    void stamp(FrameTimestamps::Point point, qint64 time = FrameTracer::now()) { m_timestamps.at[point] = time; }
+    void setRunningTime(qint64 runningTime) { m_timestamps.runningTime = runningTime; }
+
+    // Returns a frame with the same metadata whose pixels come from a processed image.
+    VideoFrame withImage(const QImage& image, quint64 effectGeneration = 0) const;
+
+    // Read-only view of the mapped buffer. Writing through the view detaches it into a private copy.
+    // Null for YUV frames.
+    const QImage& image() const { return m_image; }
+
+    // Read-only planes of a YUV frame; null for RGB frames.
+    const YuvImage& yuv() const { return m_yuv; }
+
+private:
+    static QImage::Format toImageFormat(GstVideoFormat format);
+    static YuvImage::Format toYuvFormat(GstVideoFormat format);
+    static void releaseMapping(void* info);
+
+    QImage m_image;
+    YuvImage m_yuv;
+    GstClockTime m_pts = GST_CLOCK_TIME_NONE;
+    quint64 m_sequence = 0;
+    quint64 m_effectGeneration = 0;
+    FrameTimestamps m_timestamps;
+};
+
+Q_DECLARE_METATYPE(VideoFrame)
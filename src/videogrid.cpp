@@ -0,0 +1,37 @@
+#include "videogrid.h"
+#include <algorithm>
+#include <cmath>
+
+// Constructor for the VideoGrid. Tiles touch each other; the window provides the margin.
+VideoGrid::VideoGrid(QWidget* parent)
+    : QWidget(parent), grid(new QGridLayout(this)) {
+    grid->setContentsMargins(0, 0, 0, 0);
+    grid->setSpacing(2);
+}
+
+// Default destructor; the tiles are child widgets.
+VideoGrid::~VideoGrid() = default;
+
+// Adds a tile and re-arranges the grid for the new count.
+VideoPlayer* VideoGrid::addPlayer() {
+    auto* player = new VideoPlayer(this);
+    tiles.append(player);
+    arrange();
+    return player;
+}
+
+// Places the tiles in ceil(sqrt(n)) columns with equal stretch, so every tile gets the same size.
+void VideoGrid::arrange() {
+    const int columns = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(tiles.size())))));
+    for (int i = 0; i < tiles.size(); ++i) {
+        grid->removeWidget(tiles[i]);
+        grid->addWidget(tiles[i], i / columns, i % columns);
+    }
+    const int rows = (static_cast<int>(tiles.size()) + columns - 1) / columns;
+    for (int column = 0; column < columns; ++column) {
+        grid->setColumnStretch(column, 1);
+    }
+    for (int row = 0; row < rows; ++row) {
+        grid->setRowStretch(row, 1);
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QWidget>
+#include <QGridLayout>
+#include <QList>
+#include "videoplayer.h"
+
+// VideoGrid: Lays out one VideoPlayer per camera in a near-square grid of equal tiles.
+class VideoGrid : public QWidget
+{
+	Q_OBJECT
+
+public:
+	VideoGrid(QWidget *parent = nullptr);
+	~VideoGrid();
+
+	// Creates a tile and takes ownership of it; tiles fill the grid row by row.
+	VideoPlayer* addPlayer();
+
+	const QList<VideoPlayer*>& players() const { return tiles; }
+
+private:
+	void arrange();
+
+	QGridLayout* grid;
+	QList<VideoPlayer*> tiles;
+};
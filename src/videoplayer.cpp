@@ -1,5 +1,13 @@
 #include "videoplayer.h"
-#include "imageprocessing.h"
+#include "framebufferpool.h"
+#include <QMouseEvent>
+
+namespace {
+
+// Drags shorter than this either way are taken for clicks.
+constexpr int minSelection = 8;
+
+} // namespace
 
 // Constructor for the VideoPlayer. Initializes the QWidget with the provided parent.
 VideoPlayer::VideoPlayer(QWidget* parent)
@@ -9,78 +17,155 @@ VideoPlayer::VideoPlayer(QWidget* parent)
 // Default destructor.
 VideoPlayer::~VideoPlayer() = default;
 
-// Sets the current image to be displayed and triggers a UI update.
-void VideoPlayer::setImage(const QImage& newImage) {
-    image = newImage; // Update the current image with the new image.
+// Sets the current frame to be displayed and triggers a UI update.
+void VideoPlayer::setImage(const VideoFrame& newFrame) {
+    frame = newFrame; // Hold the frame handle so its buffer stays mapped.
+    frame.stamp(FrameTimestamps::Delivered);
+    image = frame.image(); // Zero-copy view of the processed frame.
+    framePending = true;
+    emit frameDelivered();
     update(); // Request a repaint of the widget.
 }
 
+// Replaces the cached frame with a copy re-processed after a settings change, sent outside the mailbox.
+// The frame was traced and counted when it first arrived, so this only redraws it.
+void VideoPlayer::refreshImage(const VideoFrame& refreshed) {
+    frame = refreshed;
+    image = frame.image();
+    framePending = false; // A live frame not painted yet is replaced by its own, newer, rendition.
+    emit frameDelivered();
+    update();
+}
+
 // Custom paint event handler to draw the image on the VideoPlayer widget.
 void VideoPlayer::paintEvent(QPaintEvent* event) {
     QPainter painter(this); // Create a QPainter to draw on the widget.
-    QSize fixedSize(800, 600); // Specify a fixed size for the image.
-    QImage processedImage = applyEffects(image); // Apply visual effects to the image.
-    drawImage(painter, processedImage, fixedSize); // Draw the processed image.
+    drawImage(painter, image, displaySize()); // Effects were already applied on the processing thread.
+    if (framePending) {
+        framePending = false;
+        frame.stamp(FrameTimestamps::Painted);
+        tracer->record(frame.timestamps(), frame.sequence());
+        emit framePainted(); // Repaints of the same frame are not counted.
+    }
+    if (selecting) {
+        painter.setPen(QPen(Qt::white, 1, Qt::DashLine));
+        painter.drawRect(QRect(selectionStart, selectionEnd).normalized());
+    }
+    if (overlayEnabled) {
+        drawOverlay(painter);
+    }
 }
 
-// Draws an image on the widget, scaling it to a specified size.
-void VideoPlayer::drawImage(QPainter& painter, const QImage& image, const QSize& size) {
-    if (!image.isNull()) {
-        // Scale the image to fit within the specified size, maintaining aspect ratio.
-        QImage scaledImage = image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        painter.drawImage(QPoint(0, 0), scaledImage); // Draw the scaled image at the widget's origin.
+// Sets the digital zoom and reports it, so the stream crops to it; setting the same region again does nothing.
+void VideoPlayer::setRegionOfInterest(const RegionOfInterest& newRegion) {
+    if (newRegion == region) {
+        return;
     }
-    else {
-        // Fill the widget with a cyan color if there's no image to draw.
-        painter.fillRect(rect(), Qt::cyan);
+    region = newRegion;
+    emit regionOfInterestChanged(region);
+}
+
+// Starts a selection with the left button; the right button goes back to the whole frame.
+void VideoPlayer::mousePressEvent(QMouseEvent* event) {
+    if (event->button() == Qt::LeftButton && !scaledImage.isNull()) {
+        selecting = true;
+        selectionStart = selectionEnd = event->position().toPoint();
+    } else if (event->button() == Qt::RightButton) {
+        setRegionOfInterest(RegionOfInterest());
     }
 }
 
-// Applies enabled visual effects to the image.
-QImage VideoPlayer::applyEffects(const QImage& image) {
-    QImage processedImage = image; // Start with the original image.
-    if (grayscaleEnabled) {
-        // Apply grayscale effect if enabled.
-        processedImage = ImageProcessing::applyGrayscale(processedImage);
+// Follows the drag and repaints so the selection rectangle tracks the pointer.
+void VideoPlayer::mouseMoveEvent(QMouseEvent* event) {
+    if (selecting) {
+        selectionEnd = event->position().toPoint();
+        update();
     }
-    if (brightnessEnabled) {
-        // Adjust brightness if enabled.
-        processedImage = ImageProcessing::adjustBrightness(processedImage, brightnessValue);
+}
+
+// mouseReleaseEvent: The selection is taken within the image as drawn, which shows the current
+// region, so a selection on a zoomed view zooms further in.
+void VideoPlayer::mouseReleaseEvent(QMouseEvent* event) {
+    if (!selecting || event->button() != Qt::LeftButton) {
+        return;
     }
-    if (blurEnabled) {
-        // Apply blur effect if enabled.
-        processedImage = ImageProcessing::applyBoxBlur(processedImage, blurValue);
+    selecting = false;
+    update();
+    const QRect drawn(QPoint(0, 0), scaledImage.size());
+    const QRect selected = QRect(selectionStart, event->position().toPoint()).normalized() & drawn;
+    if (selected.width() < minSelection || selected.height() < minSelection) {
+        return;
     }
-    return processedImage; // Return the image with all applied effects.
+    setRegionOfInterest(region.zoomedTo(QRectF(
+        double(selected.x()) / drawn.width(), double(selected.y()) / drawn.height(),
+        double(selected.width()) / drawn.width(), double(selected.height()) / drawn.height())));
 }
 
-// Enables or disables the grayscale effect and triggers a UI update.
-void VideoPlayer::setGrayscale(bool enabled) {
-    grayscaleEnabled = enabled;
-    update(); // Request a repaint to apply changes.
+// Abandons any selection and goes back to the whole frame.
+void VideoPlayer::mouseDoubleClickEvent(QMouseEvent*) {
+    selecting = false;
+    setRegionOfInterest(RegionOfInterest());
 }
 
-// Sets the brightness level and triggers a UI update.
-void VideoPlayer::setBrightness(int value) {
-    brightnessValue = value;
-    update(); // Request a repaint to apply changes.
+// Turns the fps and latency overlay on or off and repaints with or without it.
+void VideoPlayer::setOverlayEnabled(bool enabled) {
+    overlayEnabled = enabled;
+    update();
 }
 
-// Enables or disables brightness adjustment and triggers a UI update.
-void VideoPlayer::setBrightnessEnabled(bool enabled) {
-    brightnessEnabled = enabled;
-    brightnessValue = 0;
-    update(); // Request a repaint to apply changes.
+// Reports the new size so frames can be produced at it.
+void VideoPlayer::resizeEvent(QResizeEvent* event) {
+    QWidget::resizeEvent(event);
+    emit displaySizeChanged(size());
 }
 
-// Sets the blur level and triggers a UI update.
-void VideoPlayer::setBlur(int value) {
-    blurValue = value;
-    update(); // Request a repaint to apply changes.
+// Draws an image on the widget, scaling it to a specified size.
+void VideoPlayer::drawImage(QPainter& painter, const QImage& image, const QSize& size) {
+    if (!image.isNull()) {
+        // Scale only when the frame, its effects or the target changed; exposes and repaints reuse the result.
+        const ScaledKey key{ frame.sequence(), frame.effectGeneration(), size };
+        if (scaledImage.isNull() || key != scaledKey) {
+            const QSize fitted = image.size().scaled(size, Qt::KeepAspectRatio);
+            scaledImage = QImage(); // Hand the previous buffer back before taking one.
+            if (fitted == image.size()) {
+                scaledImage = image; // Frames delivered at display size are drawn as they are.
+            } else {
+                // Smooth-scale into a pooled 32-bit buffer, the format the raster engine blits fastest.
+                scaledImage = FrameBufferPool::global().acquire(fitted, QImage::Format_RGB32);
+                QPainter scaler(&scaledImage);
+                scaler.setRenderHint(QPainter::SmoothPixmapTransform);
+                scaler.drawImage(scaledImage.rect(), image);
+            }
+            scaledKey = key;
+        }
+        painter.drawImage(QPoint(0, 0), scaledImage); // Draw the scaled image at the widget's origin.
+    }
+    else {
+        // Fill the widget with a cyan color if there's no image to draw.
+        painter.fillRect(rect(), Qt::cyan);
+    }
 }
 
-// Enables or disables the blur effect and triggers a UI update.
-void VideoPlayer::setBlurEnabled(bool enabled) {
-    blurEnabled = enabled;
-    update(); // Request a repaint to apply changes.
+// Draws fps and the p50/p99 latency of each stage in the top-left corner.
+void VideoPlayer::drawOverlay(QPainter& painter) {
+    QStringList lines;
+    lines << QStringLiteral("%1 fps").arg(tracer->fps(), 0, 'f', 1);
+    for (int stage = 0; stage < FrameTracer::StageCount; ++stage) {
+        const LatencyHistogram& histogram = tracer->histogram(FrameTracer::Stage(stage));
+        lines << QStringLiteral("%1  p50 %2  p99 %3 ms")
+                     .arg(QLatin1String(FrameTracer::stageName(FrameTracer::Stage(stage))), -8)
+                     .arg(histogram.percentile(50) / 1e6, 6, 'f', 2)
+                     .arg(histogram.percentile(99) / 1e6, 6, 'f', 2);
+    }
+
+    painter.save();
+    QFont font(QStringLiteral("monospace"));
+    font.setStyleHint(QFont::Monospace);
+    painter.setFont(font);
+    const QString text = lines.join(QLatin1Char('\n'));
+    const QRect bounds = painter.boundingRect(QRect(8, 8, width(), height()), Qt::AlignLeft | Qt::AlignTop, text);
+    painter.fillRect(bounds.adjusted(-4, -4, 4, 4), QColor(0, 0, 0, 160));
+    painter.setPen(Qt::white);
+    painter.drawText(bounds, Qt::AlignLeft | Qt::AlignTop, text);
+    painter.restore();
 }
@@ -3,6 +3,8 @@
 #include <QWidget>
 #include <QPainter>
 #include <QImage>
+#include "videoframe.h"
+#include "regionofinterest.h"
 
 class VideoPlayer : public QWidget
 {
@@ -12,25 +14,59 @@ public:
 	VideoPlayer(QWidget *parent = nullptr);
 	~VideoPlayer();
 
-	void setImage(const QImage& newImage);
+	void setImage(const VideoFrame& newFrame);
+	// Shows the current frame re-processed after a settings change. It is not traced or counted as painted again.
+	void refreshImage(const VideoFrame& refreshed);
 
-	QImage applyEffects(const QImage& image);
+	// Size frames are drawn at: the widget's own size. Frames are fitted into it keeping their aspect ratio.
+	QSize displaySize() const { return size(); }
 
-	void setGrayscale(bool enabled);
-	void setBrightness(int value);
-	void setBrightnessEnabled(bool enabled);
-	void setBlur(int value);
-	void setBlurEnabled(bool enabled);
+	// Tracer painted frames are recorded into; FrameTracer::global() unless the stream has its own.
+	void setTracer(FrameTracer* frameTracer) { tracer = frameTracer; }
+
+	// Shows fps and per-stage latency percentiles from the tracer over the video.
+	void setOverlayEnabled(bool enabled);
+	bool isOverlayEnabled() const { return overlayEnabled; }
+
+	// Digital zoom. Dragging a rectangle over the video zooms into it, also when already zoomed;
+	// a double click or a right click goes back to the whole frame.
+	void setRegionOfInterest(const RegionOfInterest& newRegion);
+	RegionOfInterest regionOfInterest() const { return region; }
+
+signals:
+	void framePainted();
+	void frameDelivered(); // A processed frame reached the GUI thread; lets the processor send the next one.
+	void displaySizeChanged(const QSize& size); // Lets the pipeline deliver frames at the new size.
+	void regionOfInterestChanged(const RegionOfInterest& region); // Lets the stream crop to the new region.
 
 protected:
 	void paintEvent(QPaintEvent* event) override;
+	void resizeEvent(QResizeEvent* event) override;
+	void mousePressEvent(QMouseEvent* event) override;
+	void mouseMoveEvent(QMouseEvent* event) override;
+	void mouseReleaseEvent(QMouseEvent* event) override;
+	void mouseDoubleClickEvent(QMouseEvent* event) override;
 	void drawImage(QPainter& painter, const QImage& image, const QSize& size);
+	void drawOverlay(QPainter& painter);
 
 private:
+	// ScaledKey: What the cached scaled image was made from. A repaint with the same key is a plain blit.
+	struct ScaledKey {
+		quint64 sequence = 0; // Frame number from the handler.
+		quint64 generation = 0; // Effect settings the frame was processed with.
+		QSize size; // Size it was fitted into.
+		bool operator==(const ScaledKey&) const = default;
+	};
+
+	VideoFrame frame; // Already-processed frame; keeps its buffer alive while it is displayed.
 	QImage image;
-	bool grayscaleEnabled = false;
-	int brightnessValue;
-	bool brightnessEnabled = false;
-	int blurValue = 0;
-	bool blurEnabled = false;
+	bool framePending = false; // Set when a new frame arrived and has not been painted yet.
+	QImage scaledImage; // image fitted to the widget; shares image when no scaling was needed.
+	ScaledKey scaledKey;
+	bool overlayEnabled = false;
+	RegionOfInterest region; // Of the camera's whole frame; the frames shown are cropped to it.
+	bool selecting = false; // A drag is under way, from selectionStart to selectionEnd in widget pixels.
+	QPoint selectionStart;
+	QPoint selectionEnd;
+	FrameTracer* tracer = &FrameTracer::global();
 };
@@ -0,0 +1,98 @@
+#include "yuvconverter.h"
+#include "imageprocessing.h"
+#include "framebufferpool.h"
+#include <cstring>
+
+// Constructor: Binds the converter to a pool; buffers are allocated on first use.
+YuvConverter::YuvConverter(ThreadPool& pool) : m_pool(pool) {
+}
+
+// convert: Samples and converts row bands in parallel into a pooled RGB888 image.
+QImage YuvConverter::convert(const YuvImage& image, const QSize& target) {
+    if (image.isNull()) {
+        return QImage();
+    }
+    QSize size = target.isEmpty() ? image.size() : image.size().scaled(target, Qt::KeepAspectRatio);
+    size = size.expandedTo(QSize(1, 1));
+    const int width = size.width();
+    const int height = size.height();
+    const bool sameWidth = width == image.width();
+
+    // Pixel centres of the output mapped onto the source.
+    m_columns.resize(width);
+    for (int x = 0; x < width; ++x) {
+        m_columns[x] = static_cast<int>((2 * static_cast<qint64>(x) + 1) * image.width() / (2 * static_cast<qint64>(width)));
+    }
+
+    const int bands = std::min(height, m_pool.concurrency());
+    const int rowsPerBand = (height + bands - 1) / bands;
+    const size_t sampleStride = (static_cast<size_t>(width) + 63) & ~size_t{ 63 };
+    if (m_samples.size() < sampleStride * 3 * bands) {
+        m_samples.resize(sampleStride * 3 * bands);
+    }
+
+    QImage output = FrameBufferPool::global().acquire(size, QImage::Format_RGB888);
+    uchar* outputBits = output.bits(); // Not shared, so this does not detach.
+    const qsizetype outputStride = output.bytesPerLine();
+    const int* columns = m_columns.data();
+
+    m_pool.parallelFor(bands, [&](int band) {
+        uchar* ySamples = m_samples.data() + sampleStride * 3 * band;
+        uchar* uSamples = ySamples + sampleStride;
+        uchar* vSamples = uSamples + sampleStride;
+        if (image.format() == YuvImage::Format::Gray8) {
+            std::memset(uSamples, 128, width); // Neutral chroma.
+            std::memset(vSamples, 128, width);
+        }
+
+        const int end = std::min((band + 1) * rowsPerBand, height);
+        for (int y = band * rowsPerBand; y < end; ++y) {
+            const int sourceY = static_cast<int>((2 * static_cast<qint64>(y) + 1) * image.height() / (2 * static_cast<qint64>(height)));
+            const uchar* luma = ySamples;
+            switch (image.format()) {
+            case YuvImage::Format::Gray8:
+            case YuvImage::Format::NV12:
+            case YuvImage::Format::I420: {
+                const uchar* yRow = image.constPlane(0) + static_cast<ptrdiff_t>(sourceY) * image.stride(0);
+                if (sameWidth) {
+                    luma = yRow; // Full-width rows need no sampling.
+                } else {
+                    for (int x = 0; x < width; ++x) {
+                        ySamples[x] = yRow[columns[x]];
+                    }
+                }
+                if (image.format() == YuvImage::Format::NV12) {
+                    const uchar* uvRow = image.constPlane(1) + static_cast<ptrdiff_t>(sourceY / 2) * image.stride(1);
+                    for (int x = 0; x < width; ++x) {
+                        const uchar* pair = uvRow + (columns[x] >> 1) * 2;
+                        uSamples[x] = pair[0];
+                        vSamples[x] = pair[1];
+                    }
+                } else if (image.format() == YuvImage::Format::I420) {
+                    const uchar* uRow = image.constPlane(1) + static_cast<ptrdiff_t>(sourceY / 2) * image.stride(1);
+                    const uchar* vRow = image.constPlane(2) + static_cast<ptrdiff_t>(sourceY / 2) * image.stride(2);
+                    for (int x = 0; x < width; ++x) {
+                        uSamples[x] = uRow[columns[x] >> 1];
+                        vSamples[x] = vRow[columns[x] >> 1];
+                    }
+                }
+                break;
+            }
+            case YuvImage::Format::YUY2: {
+                const uchar* row = image.constPlane(0) + static_cast<ptrdiff_t>(sourceY) * image.stride(0);
+                for (int x = 0; x < width; ++x) {
+                    const uchar* macropixel = row + (columns[x] >> 1) * 4;
+                    ySamples[x] = row[columns[x] * 2];
+                    uSamples[x] = macropixel[1];
+                    vSamples[x] = macropixel[3];
+                }
+                break;
+            }
+            case YuvImage::Format::Invalid:
+                break;
+            }
+            ImageProcessing::yuvToRgbRow(luma, uSamples, vSamples, outputBits + y * outputStride, width);
+        }
+    });
+    return output;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "yuvimage.h"
+#include "threadpool.h"
+#include <QImage>
+#include <vector>
+
+// YuvConverter: Turns a processed YUV frame into RGB888 for display, at display resolution.
+// Each output row samples the source planes (nearest neighbour) into per-pixel Y, U and V rows
+// that the SIMD kernel converts, so the cost follows the size on screen, not the camera's.
+class YuvConverter {
+public:
+    explicit YuvConverter(ThreadPool& pool = ThreadPool::global());
+
+    // Converts to the largest size that fits target with the frame's aspect ratio.
+    // An empty target converts at the frame's own size.
+    QImage convert(const YuvImage& image, const QSize& target);
+
+private:
+    ThreadPool& m_pool;
+    std::vector<int> m_columns; // Source column of every output column.
+    std::vector<uchar> m_samples; // Y, U and V sample rows, one set per band.
+};
@@ -0,0 +1,132 @@
+#include "yuvimage.h"
+#include <vector>
+
+// Constructor: Lays out every plane in one allocation, each row on a 64-byte boundary.
+YuvImage::YuvImage(Format format, int width, int height)
+    : m_format(width > 0 && height > 0 ? format : Format::Invalid), m_width(width), m_height(height) {
+    if (m_format == Format::Invalid) {
+        return;
+    }
+    std::array<size_t, 3> offsets{};
+    size_t total = 0;
+    for (int plane = 0; plane < planeCount(); ++plane) {
+        const QSize size = planeSize(plane);
+        m_strides[plane] = (size.width() * planeChannels(plane) + 63) & ~63;
+        offsets[plane] = total;
+        total += static_cast<size_t>(m_strides[plane]) * size.height();
+    }
+
+    auto storage = std::make_shared<std::vector<uchar>>(total + 64);
+    // Align the first plane; the others start on row boundaries and stay aligned.
+    const auto base = reinterpret_cast<uintptr_t>(storage->data());
+    uchar* aligned = storage->data() + ((64 - base % 64) % 64);
+    for (int plane = 0; plane < planeCount(); ++plane) {
+        m_planes[plane] = aligned + offsets[plane];
+    }
+    m_owner = std::move(storage);
+    m_writable = true;
+}
+
+// wrap: A read-only view of planes owned elsewhere.
+YuvImage YuvImage::wrap(Format format, int width, int height, const std::array<const uchar*, 3>& planes,
+    const std::array<int, 3>& strides, std::shared_ptr<const void> owner) {
+    YuvImage image;
+    if (format == Format::Invalid || width <= 0 || height <= 0) {
+        return image;
+    }
+    image.m_format = format;
+    image.m_width = width;
+    image.m_height = height;
+    image.m_planes = planes;
+    image.m_strides = strides;
+    image.m_owner = std::move(owner);
+    return image;
+}
+
+// wrapWritable: A writable view without an owner; the caller's mapping bounds its lifetime.
+YuvImage YuvImage::wrapWritable(Format format, int width, int height, const std::array<uchar*, 3>& planes,
+    const std::array<int, 3>& strides) {
+    YuvImage image = wrap(format, width, height, { planes[0], planes[1], planes[2] }, strides, nullptr);
+    image.m_writable = !image.isNull();
+    return image;
+}
+
+// planeSize: Chroma planes of 4:2:0 formats round up, so odd sizes keep their last column and row.
+QSize YuvImage::planeSize(int plane) const {
+    const QSize chroma((m_width + 1) / 2, (m_height + 1) / 2);
+    switch (m_format) {
+    case Format::Gray8:
+        return size();
+    case Format::YUY2:
+        return QSize((m_width + 1) / 2, m_height);
+    case Format::NV12:
+    case Format::I420:
+        return plane == 0 ? size() : chroma;
+    case Format::Invalid:
+        break;
+    }
+    return QSize();
+}
+
+int YuvImage::planeChannels(int plane) const {
+    switch (m_format) {
+    case Format::YUY2:
+        return 4;
+    case Format::NV12:
+        return plane == 0 ? 1 : 2;
+    default:
+        return 1;
+    }
+}
+
+uchar* YuvImage::plane(int plane) {
+    Q_ASSERT(m_writable); // Mapped camera buffers are read-only.
+    return const_cast<uchar*>(m_planes[plane]);
+}
+
+// lumaView: Grayscale is free on planar formats: the Y plane already is the grayscale image.
+YuvImage YuvImage::lumaView() const {
+    if (m_format == Format::Invalid || m_format == Format::YUY2) {
+        return YuvImage();
+    }
+    YuvImage luma = *this;
+    luma.m_format = Format::Gray8;
+    luma.m_planes = { m_planes[0], nullptr, nullptr };
+    luma.m_strides = { m_strides[0], 0, 0 };
+    return luma;
+}
+
+// region: Chroma planes and YUY2 macropixels cover two pixels across, and 4:2:0 chroma two rows down.
+YuvImage YuvImage::region(const QRect& rect) const {
+    Q_ASSERT(rect.x() % 2 == 0 && rect.y() % 2 == 0);
+    Q_ASSERT(QRect(0, 0, m_width, m_height).contains(rect));
+    if (m_format == Format::Invalid || rect.isEmpty()) {
+        return YuvImage();
+    }
+    YuvImage view = *this;
+    view.m_width = rect.width();
+    view.m_height = rect.height();
+    for (int plane = 0; plane < planeCount(); ++plane) {
+        const bool halfWidth = m_format == Format::YUY2 || plane > 0;
+        const bool halfHeight = plane > 0; // Gray8 and YUY2 have a single plane.
+        const int column = halfWidth ? rect.x() / 2 : rect.x();
+        const int row = halfHeight ? rect.y() / 2 : rect.y();
+        view.m_planes[plane] = m_planes[plane] + static_cast<ptrdiff_t>(row) * m_strides[plane] + column * planeChannels(plane);
+    }
+    return view;
+}
+
+int YuvImage::planeCount(Format format) {
+    switch (format) {
+    case Format::Gray8:
+    case Format::YUY2:
+        return 1;
+    case Format::NV12:
+        return 2;
+    case Format::I420:
+        return 3;
+    case Format::Invalid:
+        break;
+    }
+    return 0;
+}
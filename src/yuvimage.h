@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QRect>
+#include <QSize>
+#include <QtGlobal>
+#include <array>
+#include <memory>
+
+// YuvImage: A frame in one of the camera's native YUV layouts, as up to three planes.
+// Like QImage it is a cheap, shared handle: a view of a mapped GStreamer buffer keeps the
+// buffer alive through its owner, and images allocated here own their storage.
+class YuvImage {
+public:
+    enum class Format {
+        Invalid,
+        Gray8, // Y plane only; what grayscale leaves of any format.
+        YUY2, // Packed 4:2:2, Y0 U Y1 V per two pixels.
+        NV12, // Y plane, then one interleaved UV plane at half resolution.
+        I420, // Y, U and V planes, chroma at half resolution.
+    };
+
+    YuvImage() = default;
+
+    // Allocates a new image with cache-line aligned rows.
+    YuvImage(Format format, int width, int height);
+
+    // Wraps external planes; owner keeps them alive for as long as any copy of the view exists.
+    static YuvImage wrap(Format format, int width, int height, const std::array<const uchar*, 3>& planes,
+        const std::array<int, 3>& strides, std::shared_ptr<const void> owner);
+
+    // Wraps external planes the caller may write, e.g. a GStreamer buffer mapped for writing.
+    // The view does not keep them alive; it must not outlive the mapping.
+    static YuvImage wrapWritable(Format format, int width, int height, const std::array<uchar*, 3>& planes,
+        const std::array<int, 3>& strides);
+
+    bool isNull() const { return m_format == Format::Invalid; }
+    Format format() const { return m_format; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    QSize size() const { return QSize(m_width, m_height); }
+
+    int planeCount() const { return planeCount(m_format); }
+    // Plane size in elements and the bytes per element: YUY2 elements are 4-byte macropixels,
+    // NV12 chroma elements are UV pairs.
+    QSize planeSize(int plane) const;
+    int planeChannels(int plane) const;
+    int stride(int plane) const { return m_strides[plane]; }
+    const uchar* constPlane(int plane) const { return m_planes[plane]; }
+    uchar* plane(int plane); // Only for images allocated here.
+
+    // The Y plane as a Gray8 image sharing this image's memory. Not available for packed YUY2.
+    YuvImage lumaView() const;
+
+    // The pixels inside rect as an image sharing this image's memory, and writable if this one is.
+    // rect must lie inside the image and start on even coordinates, so chroma samples line up.
+    YuvImage region(const QRect& rect) const;
+
+    // True if no other handle shares the storage, so it can be written or reused.
+    bool isDetached() const { return m_owner && m_owner.use_count() == 1; }
+
+    static int planeCount(Format format);
+
+private:
+    Format m_format = Format::Invalid;
+    int m_width = 0;
+    int m_height = 0;
+    std::array<const uchar*, 3> m_planes{};
+    std::array<int, 3> m_strides{};
+    std::shared_ptr<const void> m_owner; // Mapped buffer or owned storage.
+    bool m_writable = false;
+};
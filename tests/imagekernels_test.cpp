@@ -0,0 +1,195 @@
+// imagekernels_test: Every SIMD kernel table must match the scalar one byte for byte.
+//
+//   imagekernels_test      checks each table the CPU supports; exits non-zero on any mismatch
+//
+// Widths run across the vector sizes of every instruction set, so each ragged tail and the switch
+// from vector to scalar code is covered. Tables the build or the CPU lacks are reported as skipped.
+
+#include "imagekernels.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Noise: Deterministic bytes, so a failure reproduces and nothing collapses to a constant.
+std::vector<uchar> noise(size_t size, quint32 seed) {
+    std::vector<uchar> bytes(size);
+    quint32 state = 0x12345678u + seed;
+    for (auto& byte : bytes) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        byte = static_cast<uchar>(state >> 24);
+    }
+    return bytes;
+}
+
+// Checker: Counts the mismatching cases of one table and names the first few.
+struct Checker {
+    const char* table;
+    int mismatches = 0;
+
+    void expect(bool equal, const char* kernel, int width, int detail = 0) {
+        if (equal) {
+            return;
+        }
+        if (++mismatches <= 10) {
+            std::printf("  %s: %s differs at width %d (%d)\n", table, kernel, width, detail);
+        }
+    }
+
+    template <typename T>
+    void expectSame(const std::vector<T>& expected, const std::vector<T>& actual, const char* kernel, int width, int detail = 0) {
+        expect(expected == actual, kernel, width, detail);
+    }
+};
+
+const int widths[] = { 1, 2, 3, 5, 7, 8, 15, 16, 17, 31, 32, 33, 47, 63, 64, 65, 95, 100, 129, 333 };
+const int height = 9;
+
+void checkPointOps(const ImageKernels::KernelTable& scalar, const ImageKernels::KernelTable& table, Checker& checker) {
+    for (int width : widths) {
+        const std::vector<uchar> input = noise(static_cast<size_t>(width) * 4, width);
+        for (int layout = 0; layout < PixelFormat::layoutCount; ++layout) {
+            const size_t bytes = static_cast<size_t>(width) * PixelFormat::bytesPerPixel(static_cast<PixelFormat::Layout>(layout));
+            for (bool gray : { false, true }) {
+                for (int brightness : { -300, -40, 0, 17, 255 }) {
+                    const auto ops = ImageProcessing::PointOps::create(gray, brightness);
+                    // Pre-filled with noise so the untouched fourth byte of 32-bit layouts is checked too.
+                    std::vector<uchar> expected = noise(bytes, 7);
+                    std::vector<uchar> actual = expected;
+                    scalar.pointOpsRow[layout](input.data(), expected.data(), width, ops);
+                    table.pointOpsRow[layout](input.data(), actual.data(), width, ops);
+                    checker.expectSame(expected, actual, "pointOpsRow", width, layout);
+                }
+            }
+        }
+        for (int brightness : { -40, 17 }) {
+            const auto ops = ImageProcessing::PointOps::create(false, brightness);
+            std::vector<uchar> expected(input.size());
+            std::vector<uchar> actual(input.size());
+            scalar.lutRow(input.data(), expected.data(), width, ops);
+            table.lutRow(input.data(), actual.data(), width, ops);
+            checker.expectSame(expected, actual, "lutRow", width, brightness);
+        }
+    }
+}
+
+// One to four channels cover Y planes, NV12 chroma, RGB888 and YUY2 or 32-bit rows.
+void checkBoxBlur(const ImageKernels::KernelTable& scalar, const ImageKernels::KernelTable& table, Checker& checker) {
+    for (int width : widths) {
+        for (int channels : { 1, 2, 3, 4 }) {
+            const int stride = width * channels;
+            const std::vector<uchar> input = noise(static_cast<size_t>(stride) * height, width + channels);
+            for (int radius : { 1, 2, 5, 16, 60 }) {
+                std::vector<uchar> expected(input.size());
+                std::vector<uchar> actual(input.size());
+                scalar.horizontalBlurRow(input.data(), expected.data(), width, radius, channels);
+                table.horizontalBlurRow(input.data(), actual.data(), width, radius, channels);
+                checker.expectSame(expected, actual, "horizontalBlurRow", width, radius);
+
+                std::vector<int> sums(static_cast<size_t>(stride));
+                scalar.verticalBlur(input.data(), stride, expected.data(), stride, width, height, radius, sums.data(), channels);
+                table.verticalBlur(input.data(), stride, actual.data(), stride, width, height, radius, sums.data(), channels);
+                checker.expectSame(expected, actual, "verticalBlur", width, radius);
+            }
+        }
+    }
+}
+
+void checkYuv(const ImageKernels::KernelTable& scalar, const ImageKernels::KernelTable& table, Checker& checker) {
+    for (int width : widths) {
+        const std::vector<uchar> planes = noise(static_cast<size_t>(width) * 3, width);
+        std::vector<uchar> expected(static_cast<size_t>(width) * 3);
+        std::vector<uchar> actual(expected.size());
+        scalar.yuvToRgbRow(planes.data(), planes.data() + width, planes.data() + 2 * width, expected.data(), width);
+        table.yuvToRgbRow(planes.data(), planes.data() + width, planes.data() + 2 * width, actual.data(), width);
+        checker.expectSame(expected, actual, "yuvToRgbRow", width);
+
+        const std::vector<uchar> other = noise(planes.size(), width + 1);
+        const int count = static_cast<int>(planes.size());
+        checker.expect(scalar.sumAbsDiff(planes.data(), other.data(), count) == table.sumAbsDiff(planes.data(), other.data(), count),
+            "sumAbsDiff", width);
+    }
+}
+
+// Symmetric, antisymmetric and lopsided kernels up to maxTaps, with absolute weights adding up to at
+// most one as ImageKernels::Convolution requires.
+void checkConvolution(const ImageKernels::KernelTable& scalar, const ImageKernels::KernelTable& table, Checker& checker) {
+    using namespace ImageKernels::Convolution;
+    std::vector<std::vector<qint16>> kernels{ { 1024, 2048, 1024 }, { -2048, 0, 2048 }, { 700, -1300, 1500, 590 } };
+    std::vector<qint16> wide(maxTaps, static_cast<qint16>(maxWeightSum / maxTaps));
+    wide[maxTaps / 2] += static_cast<qint16>(maxWeightSum % maxTaps);
+    kernels.push_back(wide);
+
+    for (int width : widths) {
+        for (const auto& weights : kernels) {
+            const int taps = static_cast<int>(weights.size());
+            for (int step : { 1, 2, 3, 4 }) {
+                const int count = width * step;
+                const std::vector<uchar> padded = noise(static_cast<size_t>(count + taps * step), width + taps);
+                std::vector<qint16> expected(static_cast<size_t>(count));
+                std::vector<qint16> actual(expected.size());
+                scalar.convolveRow(padded.data(), expected.data(), count, step, weights.data(), taps);
+                table.convolveRow(padded.data(), actual.data(), count, step, weights.data(), taps);
+                checker.expectSame(expected, actual, "convolveRow", width, taps);
+            }
+
+            // Rows of the row pass's range feed the column pass; its sums every way of finishing a row.
+            const int count = width * 3;
+            std::vector<std::vector<qint16>> rows(static_cast<size_t>(taps));
+            std::vector<const qint16*> pointers;
+            for (size_t k = 0; k < rows.size(); ++k) {
+                const std::vector<uchar> bytes = noise(static_cast<size_t>(count) * 2, width * 31 + static_cast<int>(k));
+                for (int i = 0; i < count; ++i) {
+                    rows[k].push_back(static_cast<qint16>(((bytes[2 * i] << 8) | bytes[2 * i + 1]) % 32641 - 16320));
+                }
+                pointers.push_back(rows[k].data());
+            }
+            std::vector<qint16> expected(static_cast<size_t>(count));
+            std::vector<qint16> actual(expected.size());
+            scalar.convolveColumns(pointers.data(), expected.data(), count, weights.data(), taps);
+            table.convolveColumns(pointers.data(), actual.data(), count, weights.data(), taps);
+            checker.expectSame(expected, actual, "convolveColumns", width, taps);
+
+            const std::vector<qint16>& sums = expected;
+            const std::vector<uchar> original = noise(static_cast<size_t>(count), width + 5);
+            std::vector<uchar> expectedBytes(static_cast<size_t>(count));
+            std::vector<uchar> actualBytes(expectedBytes.size());
+            scalar.packRow(sums.data(), expectedBytes.data(), count);
+            table.packRow(sums.data(), actualBytes.data(), count);
+            checker.expectSame(expectedBytes, actualBytes, "packRow", width, taps);
+            scalar.edgeMagnitudeRow(sums.data(), rows[0].data(), expectedBytes.data(), count);
+            table.edgeMagnitudeRow(sums.data(), rows[0].data(), actualBytes.data(), count);
+            checker.expectSame(expectedBytes, actualBytes, "edgeMagnitudeRow", width, taps);
+            for (int amount : { 0, 256, 2560 }) {
+                scalar.unsharpRow(original.data(), sums.data(), expectedBytes.data(), count, amount);
+                table.unsharpRow(original.data(), sums.data(), actualBytes.data(), count, amount);
+                checker.expectSame(expectedBytes, actualBytes, "unsharpRow", width, amount);
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    const auto& scalar = ImageKernels::scalarKernels();
+    int failed = 0;
+    for (auto isa : { ImageKernels::Isa::SSE2, ImageKernels::Isa::SSSE3, ImageKernels::Isa::AVX2 }) {
+        const auto* table = ImageKernels::forIsa(isa);
+        if (!table) {
+            std::printf("isa %d: skipped, not supported by this build or CPU\n", static_cast<int>(isa));
+            continue;
+        }
+        Checker checker{ table->name };
+        checkPointOps(scalar, *table, checker);
+        checkBoxBlur(scalar, *table, checker);
+        checkYuv(scalar, *table, checker);
+        checkConvolution(scalar, *table, checker);
+        std::printf("%s: %s\n", table->name, checker.mismatches == 0 ? "ok" : "FAILED");
+        failed += checker.mismatches;
+    }
+    return failed == 0 ? 0 : 1;
+}